@@ -390,27 +390,101 @@ TEST (state_block, hashing)
 	nano::state_block block (key.pub, 0, key.pub, 0, 0, key.prv, key.pub, 0);
 	auto hash (block.hash ());
 	block.hashables.account.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.account.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_EQ (hash, block.hash ());
 	block.hashables.previous.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.previous.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_EQ (hash, block.hash ());
 	block.hashables.representative.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.representative.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_EQ (hash, block.hash ());
 	block.hashables.balance.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.balance.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_EQ (hash, block.hash ());
 	block.hashables.link.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_NE (hash, block.hash ());
 	block.hashables.link.bytes[0] ^= 0x1;
+	block.hash_invalidate ();
 	ASSERT_EQ (hash, block.hash ());
 }
 
+TEST (block, hash_cache)
+{
+	nano::keypair key;
+	nano::state_block block (key.pub, 0, key.pub, 0, 0, key.prv, key.pub, 0);
+	auto hash (block.hash ());
+	auto full_hash (block.full_hash ());
+	// Signature and work only feed the full hash
+	block.signature_set (nano::signature (1));
+	ASSERT_EQ (hash, block.hash ());
+	ASSERT_NE (full_hash, block.full_hash ());
+	full_hash = block.full_hash ();
+	block.block_work_set (1);
+	ASSERT_NE (full_hash, block.full_hash ());
+	// Copies recompute rather than inherit the digest
+	auto copy (block);
+	copy.hashables.balance = 1;
+	ASSERT_NE (hash, copy.hash ());
+	ASSERT_EQ (hash, block.hash ());
+	std::vector<uint8_t> bytes;
+	{
+		nano::vectorstream stream (bytes);
+		copy.serialize (stream);
+	}
+	nano::bufferstream stream (bytes.data (), bytes.size ());
+	ASSERT_FALSE (block.deserialize (stream));
+	ASSERT_EQ (copy.hash (), block.hash ());
+	ASSERT_EQ (copy.full_hash (), block.full_hash ());
+	nano::block_builder builder;
+	auto & state_builder (builder.state ());
+	state_builder.account (key.pub).previous (0).representative (key.pub).balance (0).link (0).sign (key.prv, key.pub);
+	// Changing a field after signing must not leave the signing hash behind
+	state_builder.balance (1).work (0);
+	auto built (state_builder.build ());
+	ASSERT_EQ (copy.hash (), built->hash ());
+}
+
+TEST (block, hash_cache_concurrent)
+{
+	nano::keypair key;
+	auto block (std::make_shared<nano::state_block> (key.pub, 0, key.pub, 0, 0, key.prv, key.pub, 0));
+	auto expected (nano::state_block (*block).hash ());
+	auto expected_full (nano::state_block (*block).full_hash ());
+	block->hash_invalidate ();
+	std::atomic<bool> error (false);
+	std::vector<std::thread> threads;
+	for (auto i (0); i < 4; ++i)
+	{
+		threads.emplace_back ([block, expected, expected_full, &error]() {
+			for (auto j (0); j < 1000; ++j)
+			{
+				if (block->hash () != expected || block->full_hash () != expected_full)
+				{
+					error = true;
+				}
+			}
+		});
+	}
+	for (auto & thread : threads)
+	{
+		thread.join ();
+	}
+	ASSERT_FALSE (error);
+}
+
 TEST (block_uniquer, null)
 {
 	nano::block_uniquer uniquer;
@@ -454,6 +528,32 @@ TEST (block_uniquer, cleanup)
 	}
 }
 
+TEST (block_uniquer, bounded)
+{
+	nano::keypair key;
+	nano::block_uniquer uniquer (nano::block_uniquer::shard_count);
+	std::vector<std::shared_ptr<nano::block>> blocks;
+	for (auto i (0); i < 100; ++i)
+	{
+		auto block (std::make_shared<nano::state_block> (0, 0, 0, 0, 0, key.prv, key.pub, i));
+		blocks.push_back (block);
+		ASSERT_EQ (block, uniquer.unique (block));
+	}
+	// Live entries are evicted once a shard is full
+	ASSERT_GE (nano::block_uniquer::shard_count, uniquer.size ());
+	auto counters1 (uniquer.take_counters ());
+	ASSERT_EQ (0, counters1.hits);
+	ASSERT_EQ (100, counters1.misses);
+	ASSERT_EQ (100 - uniquer.size (), counters1.evictions);
+	auto block1 (std::make_shared<nano::state_block> (0, 0, 0, 0, 0, key.prv, key.pub, 100));
+	auto block2 (std::make_shared<nano::state_block> (*block1));
+	ASSERT_EQ (block1, uniquer.unique (block1));
+	ASSERT_EQ (block1, uniquer.unique (block2));
+	auto counters2 (uniquer.take_counters ());
+	ASSERT_EQ (1, counters2.hits);
+	ASSERT_EQ (1, counters2.misses);
+}
+
 TEST (block_builder, zeroed_state_block)
 {
 	std::error_code ec;
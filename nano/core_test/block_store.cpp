@@ -2,6 +2,7 @@
 #include <nano/lib/utility.hpp>
 #include <nano/node/common.hpp>
 #include <nano/node/node.hpp>
+#include <nano/node/testing.hpp>
 #include <nano/secure/versioning.hpp>
 
 #include <fstream>
@@ -65,6 +66,195 @@ TEST (block_store, add_item)
 	ASSERT_EQ (nullptr, latest3);
 }
 
+TEST (block_store, block_serialize)
+{
+	nano::logging logging;
+	bool init (false);
+	nano::mdb_store store (init, logging, nano::unique_path ());
+	ASSERT_TRUE (!init);
+	nano::genesis genesis;
+	auto transaction (store.tx_begin (true));
+	store.initialize (transaction, genesis);
+	nano::send_block send (genesis.hash (), 0, 0, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
+	nano::block_sideband sideband1 (nano::block_type::send, nano::test_genesis_key.pub, 0, 0, 2, 0);
+	store.block_put (transaction, send.hash (), send, sideband1);
+	nano::state_block state (nano::test_genesis_key.pub, send.hash (), 0, 0, 0, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
+	nano::block_sideband sideband2 (nano::block_type::state, nano::test_genesis_key.pub, 0, 0, 3, 0);
+	store.block_put (transaction, state.hash (), state, sideband2);
+	std::vector<uint8_t> buffer;
+	nano::block_hash previous (1);
+	ASSERT_TRUE (store.block_serialize (transaction, 1, buffer, previous));
+	ASSERT_TRUE (buffer.empty ());
+	// Blocks are appended to the buffer exactly as they'd be sent on the network
+	ASSERT_FALSE (store.block_serialize (transaction, state.hash (), buffer, previous));
+	ASSERT_EQ (send.hash (), previous);
+	ASSERT_FALSE (store.block_serialize (transaction, send.hash (), buffer, previous));
+	ASSERT_EQ (genesis.hash (), previous);
+	ASSERT_FALSE (store.block_serialize (transaction, genesis.hash (), buffer, previous));
+	ASSERT_TRUE (previous.is_zero ());
+	std::vector<uint8_t> expected;
+	{
+		nano::vectorstream stream (expected);
+		nano::serialize_block (stream, state);
+		nano::serialize_block (stream, send);
+		nano::serialize_block (stream, *genesis.open);
+	}
+	ASSERT_EQ (expected, buffer);
+}
+
+TEST (block_store, read_transaction_pool)
+{
+	nano::logging logging;
+	bool init (false);
+	nano::mdb_store store (init, logging, nano::unique_path ());
+	ASSERT_TRUE (!init);
+	auto counts1 (store.tx_counts ());
+	{
+		auto transaction (store.tx_begin_read ());
+	}
+	{
+		// Reset transactions are renewed rather than started again
+		auto transaction (store.tx_begin_read ());
+	}
+	auto counts2 (store.tx_counts ());
+	ASSERT_LT (counts1.renew, counts2.renew);
+	nano::open_block block (0, 1, 0, nano::keypair ().prv, 0, 0);
+	auto transaction (store.tx_begin_read ());
+	{
+		auto transaction (store.tx_begin_write ());
+		nano::block_sideband sideband (nano::block_type::open, 0, 0, 0, 0, 0);
+		store.block_put (transaction, block.hash (), block, sideband);
+	}
+	ASSERT_FALSE (store.block_exists (transaction, block.hash ()));
+	transaction.refresh (std::chrono::hours (1));
+	ASSERT_FALSE (store.block_exists (transaction, block.hash ()));
+	transaction.refresh ();
+	ASSERT_TRUE (store.block_exists (transaction, block.hash ()));
+	ASSERT_EQ (counts2.refresh + 1, store.tx_counts ().refresh);
+}
+
+TEST (block_store, block_cache)
+{
+	nano::logging logging;
+	bool init (false);
+	nano::block_uniquer uniquer;
+	nano::mdb_store store (init, logging, nano::unique_path (), 128, 1024 * 1024, &uniquer);
+	ASSERT_TRUE (!init);
+	nano::open_block block1 (0, 1, 0, nano::keypair ().prv, 0, 0);
+	nano::send_block block2 (block1.hash (), 1, 2, nano::keypair ().prv, 4, 5);
+	{
+		auto transaction (store.tx_begin_write ());
+		nano::block_sideband sideband (nano::block_type::open, 0, 0, 0, 0, 0);
+		store.block_put (transaction, block1.hash (), block1, sideband);
+		// Writes may still be aborted so their reads aren't cached
+		ASSERT_NE (nullptr, store.block_get (transaction, block1.hash ()));
+	}
+	ASSERT_EQ (0, store.block_cache.size ());
+	auto transaction (store.tx_begin_read ());
+	auto block3 (store.block_get (transaction, block1.hash ()));
+	ASSERT_EQ (1, store.block_cache.size ());
+	ASSERT_EQ (block3, uniquer.unique (std::make_shared<nano::open_block> (block1)));
+	nano::block_sideband sideband1;
+	ASSERT_EQ (block3, store.block_get (transaction, block1.hash (), &sideband1));
+	ASSERT_EQ (nano::block_type::open, sideband1.type);
+	ASSERT_TRUE (sideband1.successor.is_zero ());
+	auto counters1 (store.block_cache_counters ());
+	ASSERT_EQ (1, counters1.hits);
+	ASSERT_EQ (1, counters1.misses);
+	{
+		// Putting a successor rewrites the sideband of its predecessor
+		auto transaction (store.tx_begin_write ());
+		nano::block_sideband sideband (nano::block_type::send, 0, 0, 0, 0, 0);
+		store.block_put (transaction, block2.hash (), block2, sideband);
+	}
+	ASSERT_EQ (0, store.block_cache.size ());
+	// The older snapshot still reads its own view but can't cache it
+	nano::block_sideband sideband2;
+	ASSERT_NE (nullptr, store.block_get (transaction, block1.hash (), &sideband2));
+	ASSERT_TRUE (sideband2.successor.is_zero ());
+	ASSERT_EQ (0, store.block_cache.size ());
+	transaction.refresh ();
+	ASSERT_NE (nullptr, store.block_get (transaction, block1.hash (), &sideband2));
+	ASSERT_EQ (block2.hash (), sideband2.successor);
+	ASSERT_NE (nullptr, store.block_get (transaction, block2.hash ()));
+	ASSERT_EQ (2, store.block_cache.size ());
+	{
+		auto transaction (store.tx_begin_write ());
+		store.block_del (transaction, block2.hash ());
+		store.block_successor_clear (transaction, block1.hash ());
+	}
+	ASSERT_EQ (0, store.block_cache.size ());
+	transaction.refresh ();
+	ASSERT_EQ (nullptr, store.block_get (transaction, block2.hash ()));
+	nano::block_sideband sideband3;
+	ASSERT_NE (nullptr, store.block_get (transaction, block1.hash (), &sideband3));
+	ASSERT_TRUE (sideband3.successor.is_zero ());
+	ASSERT_EQ (1, store.block_cache.size ());
+	// Inserting a new block in the same shard doesn't stop older snapshots from caching the blocks they read
+	nano::keypair key;
+	std::unique_ptr<nano::open_block> block4;
+	for (uint64_t i (2); block4 == nullptr || block4->hash ().qwords[0] % nano::block_cache::shard_count != block1.hash ().qwords[0] % nano::block_cache::shard_count; ++i)
+	{
+		block4 = std::make_unique<nano::open_block> (i, 1, i, key.prv, key.pub, 0);
+	}
+	store.block_cache.erase (block1.hash (), 0);
+	ASSERT_EQ (0, store.block_cache.size ());
+	{
+		auto transaction (store.tx_begin_write ());
+		nano::block_sideband sideband (nano::block_type::open, 0, 0, 0, 0, 0);
+		store.block_put (transaction, block4->hash (), *block4, sideband);
+	}
+	ASSERT_NE (nullptr, store.block_get (transaction, block1.hash ()));
+	ASSERT_EQ (1, store.block_cache.size ());
+}
+
+TEST (block_store, account_cache)
+{
+	nano::logging logging;
+	bool init (false);
+	nano::mdb_store store (init, logging, nano::unique_path (), 128, 0, nullptr, 1024 * 1024);
+	ASSERT_TRUE (!init);
+	nano::account account (1);
+	nano::account_info info1 (2, 3, 4, 5, 6, 7, nano::epoch::epoch_1);
+	auto transaction (store.tx_begin_read ());
+	{
+		auto transaction (store.tx_begin_write ());
+		store.account_put (transaction, account, info1);
+		// Writes are seen by their own transaction but only published once committed
+		nano::account_info info2;
+		ASSERT_FALSE (store.account_get (transaction, account, info2));
+		ASSERT_EQ (info1, info2);
+		ASSERT_EQ (0, store.account_cache.size ());
+	}
+	ASSERT_EQ (1, store.account_cache.size ());
+	// Snapshots from before the commit don't see the published info
+	nano::account_info info3;
+	ASSERT_TRUE (store.account_get (transaction, account, info3));
+	transaction.refresh ();
+	ASSERT_FALSE (store.account_get (transaction, account, info3));
+	ASSERT_EQ (info1, info3);
+	auto counters1 (store.account_cache_counters ());
+	ASSERT_EQ (1, counters1.hits);
+	ASSERT_EQ (1, counters1.misses);
+	// Readers fill the cache on a miss
+	store.account_cache.clear (0);
+	ASSERT_FALSE (store.account_get (transaction, account, info3));
+	ASSERT_EQ (1, store.account_cache.size ());
+	ASSERT_EQ (nano::epoch::epoch_1, info3.epoch);
+	{
+		auto transaction (store.tx_begin_write ());
+		store.account_del (transaction, account);
+		ASSERT_EQ (0, store.account_cache.size ());
+		nano::account_info info4;
+		ASSERT_TRUE (store.account_get (transaction, account, info4));
+	}
+	ASSERT_EQ (0, store.account_cache.size ());
+	ASSERT_FALSE (store.account_get (transaction, account, info3));
+	transaction.refresh ();
+	ASSERT_TRUE (store.account_get (transaction, account, info3));
+	ASSERT_EQ (0, store.account_count (transaction));
+}
+
 TEST (block_store, clear_successor)
 {
 	nano::logging logging;
@@ -123,6 +313,7 @@ TEST (block_store, add_two_items)
 	ASSERT_EQ (nullptr, latest1);
 	nano::open_block block2 (0, 1, 3, nano::keypair ().prv, 0, 0);
 	block2.hashables.account = 3;
+	block2.hash_invalidate ();
 	nano::uint256_union hash2 (block2.hash ());
 	block2.signature = nano::sign_message (key1.prv, key1.pub, hash2);
 	auto latest2 (store.block_get (transaction, hash2));
@@ -291,6 +482,51 @@ TEST (representation, changes)
 	ASSERT_EQ (2, store.representation_get (transaction, key1.pub));
 }
 
+TEST (representation, reload)
+{
+	auto path (nano::unique_path ());
+	nano::keypair key1;
+	nano::keypair key2;
+	{
+		nano::logging logging;
+		bool init (false);
+		nano::mdb_store store (init, logging, path);
+		ASSERT_TRUE (!init);
+		auto transaction (store.tx_begin (true));
+		store.representation_put (transaction, key1.pub, 1);
+		store.representation_put (transaction, key2.pub, 2);
+		store.representation_put (transaction, key2.pub, 0);
+	}
+	nano::logging logging;
+	bool init (false);
+	nano::mdb_store store (init, logging, path);
+	ASSERT_TRUE (!init);
+	auto transaction (store.tx_begin_read ());
+	ASSERT_EQ (1, store.representation_get (transaction, key1.pub));
+	ASSERT_EQ (0, store.representation_get (transaction, key2.pub));
+	// Zero weights are not held in memory
+	ASSERT_EQ (1, store.representation_cache.size ());
+}
+
+TEST (representation, commit)
+{
+	nano::logging logging;
+	bool init (false);
+	nano::mdb_store store (init, logging, nano::unique_path ());
+	ASSERT_TRUE (!init);
+	nano::keypair key1;
+	auto transaction (store.tx_begin_read ());
+	{
+		auto transaction (store.tx_begin_write ());
+		store.representation_put (transaction, key1.pub, 1);
+		// Weights are seen by their own transaction but only published once committed
+		ASSERT_EQ (1, store.representation_get (transaction, key1.pub));
+		ASSERT_EQ (0, store.representation_cache.size ());
+	}
+	ASSERT_EQ (1, store.representation_cache.size ());
+	ASSERT_EQ (1, store.representation_get (transaction, key1.pub));
+}
+
 TEST (bootstrap, simple)
 {
 	nano::logging logging;
@@ -513,6 +749,7 @@ TEST (block_store, two_block)
 	ASSERT_TRUE (!init);
 	nano::open_block block1 (0, 1, 1, nano::keypair ().prv, 0, 0);
 	block1.hashables.account = 1;
+	block1.hash_invalidate ();
 	std::vector<nano::block_hash> hashes;
 	std::vector<nano::open_block> blocks;
 	hashes.push_back (block1.hash ());
@@ -723,13 +960,18 @@ TEST (block_store, block_count)
 	bool init (false);
 	nano::mdb_store store (init, logging, nano::unique_path ());
 	ASSERT_TRUE (!init);
-	auto transaction (store.tx_begin (true));
-	ASSERT_EQ (0, store.block_count (transaction).sum ());
 	nano::open_block block (0, 1, 0, nano::keypair ().prv, 0, 0);
 	nano::uint256_union hash1 (block.hash ());
-	nano::block_sideband sideband (nano::block_type::open, 0, 0, 0, 0, 0);
-	store.block_put (transaction, hash1, block, sideband);
-	ASSERT_EQ (1, store.block_count (transaction).sum ());
+	{
+		auto transaction (store.tx_begin (true));
+		ASSERT_EQ (0, store.block_count (transaction).sum ());
+		nano::block_sideband sideband (nano::block_type::open, 0, 0, 0, 0, 0);
+		store.block_put (transaction, hash1, block, sideband);
+		ASSERT_EQ (1, store.block_count (transaction).sum ());
+	}
+	// Counts changed by a transaction are written when it commits
+	auto transaction (store.tx_begin_read ());
+	ASSERT_EQ (1, store.block_count (transaction).open);
 }
 
 TEST (block_store, account_count)
@@ -799,6 +1041,7 @@ TEST (block_store, upgrade_v2_v3)
 		ASSERT_EQ (0, ledger.weight (transaction, nano::test_genesis_key.pub));
 		ASSERT_EQ (nano::genesis_amount, ledger.weight (transaction, key1.pub));
 		store.version_put (transaction, 2);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		store.representation_put (transaction, key1.pub, 7);
 		ASSERT_EQ (7, ledger.weight (transaction, key1.pub));
 		ASSERT_EQ (2, store.version_get (transaction));
@@ -840,6 +1083,7 @@ TEST (block_store, upgrade_v3_v4)
 		store.stop ();
 		auto transaction (store.tx_begin (true));
 		store.version_put (transaction, 3);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		nano::pending_info_v3 info (key1.pub, 100, key2.pub);
 		auto status (mdb_put (store.env.tx (transaction), store.pending_v0, nano::mdb_val (key3.pub), info.val (), 0));
 		ASSERT_EQ (0, status);
@@ -878,6 +1122,7 @@ TEST (block_store, upgrade_v4_v5)
 		nano::ledger ledger (store, stats);
 		store.initialize (transaction, genesis);
 		store.version_put (transaction, 4);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		nano::account_info info;
 		store.account_get (transaction, nano::test_genesis_key.pub, info);
 		nano::keypair key0;
@@ -929,6 +1174,7 @@ TEST (block_store, upgrade_v5_v6)
 		nano::genesis genesis;
 		store.initialize (transaction, genesis);
 		store.version_put (transaction, 5);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		nano::account_info info;
 		store.account_get (transaction, nano::test_genesis_key.pub, info);
 		nano::account_info_v5 info_old (info.head, info.rep_block, info.open_block, info.balance, info.modified);
@@ -958,6 +1204,7 @@ TEST (block_store, upgrade_v6_v7)
 		nano::genesis genesis;
 		store.initialize (transaction, genesis);
 		store.version_put (transaction, 6);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		auto send1 (std::make_shared<nano::send_block> (0, 0, 0, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0));
 		store.unchecked_put (transaction, send1->hash (), send1);
 		store.flush (transaction);
@@ -1029,6 +1276,7 @@ TEST (block_store, upgrade_v7_v8)
 		ASSERT_EQ (0, mdb_drop (store.env.tx (transaction), store.unchecked, 1));
 		ASSERT_EQ (0, mdb_dbi_open (store.env.tx (transaction), "unchecked", MDB_CREATE, &store.unchecked));
 		store.version_put (transaction, 7);
+		nano::store_downgrade::block_tables_split (store, transaction);
 	}
 	nano::logging logging;
 	bool init (false);
@@ -1104,6 +1352,7 @@ TEST (block_store, upgrade_v8_v9)
 		uint64_t sequence (10);
 		ASSERT_EQ (0, mdb_put (store.env.tx (transaction), store.vote, nano::mdb_val (key.pub), nano::mdb_val (sizeof (sequence), &sequence), 0));
 		store.version_put (transaction, 8);
+		nano::store_downgrade::block_tables_split (store, transaction);
 	}
 	nano::logging logging;
 	bool init (false);
@@ -1177,6 +1426,7 @@ TEST (block_store, upgrade_sideband_genesis)
 		store.stop ();
 		auto transaction (store.tx_begin (true));
 		store.version_put (transaction, 11);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		store.initialize (transaction, genesis);
 		nano::block_sideband sideband;
 		auto genesis_block (store.block_get (transaction, genesis.hash (), &sideband));
@@ -1222,6 +1472,7 @@ TEST (block_store, upgrade_sideband_two_blocks)
 		nano::ledger ledger (store, stat);
 		auto transaction (store.tx_begin (true));
 		store.version_put (transaction, 11);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		store.initialize (transaction, genesis);
 		nano::state_block block (nano::test_genesis_key.pub, genesis.hash (), nano::test_genesis_key.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.pub, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
 		hash2 = block.hash ();
@@ -1270,6 +1521,7 @@ TEST (block_store, upgrade_sideband_two_accounts)
 		nano::ledger ledger (store, stat);
 		auto transaction (store.tx_begin (true));
 		store.version_put (transaction, 11);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		store.initialize (transaction, genesis);
 		nano::state_block block1 (nano::test_genesis_key.pub, genesis.hash (), nano::test_genesis_key.pub, nano::genesis_amount - nano::Gxrb_ratio, key.pub, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
 		hash2 = block1.hash ();
@@ -1321,6 +1573,7 @@ TEST (block_store, insert_after_legacy)
 	nano::ledger ledger (store, stat);
 	auto transaction (store.tx_begin (true));
 	store.version_put (transaction, 11);
+	nano::store_downgrade::block_tables_split (store, transaction);
 	store.initialize (transaction, genesis);
 	write_legacy_sideband (store, transaction, *genesis.open, 0, store.open_blocks);
 	nano::state_block block (nano::test_genesis_key.pub, genesis.hash (), nano::test_genesis_key.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.pub, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
@@ -1339,6 +1592,7 @@ TEST (block_store, upgrade_sideband_rollback_old)
 	nano::ledger ledger (store, stat);
 	auto transaction (store.tx_begin (true));
 	store.version_put (transaction, 11);
+	nano::store_downgrade::block_tables_split (store, transaction);
 	store.initialize (transaction, genesis);
 	nano::send_block block1 (genesis.hash (), nano::test_genesis_key.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
 	ASSERT_EQ (nano::process_result::progress, ledger.process (transaction, block1).code);
@@ -1366,6 +1620,7 @@ TEST (block_store, legacy_account_computed)
 	auto transaction (store.tx_begin (true));
 	store.initialize (transaction, genesis);
 	store.version_put (transaction, 11);
+	nano::store_downgrade::block_tables_split (store, transaction);
 	write_legacy_sideband (store, transaction, *genesis.open, 0, store.open_blocks);
 	ASSERT_EQ (nano::genesis_account, ledger.account (transaction, genesis.hash ()));
 }
@@ -1385,6 +1640,7 @@ TEST (block_store, upgrade_sideband_epoch)
 		nano::ledger ledger (store, stat, 42, nano::test_genesis_key.pub);
 		auto transaction (store.tx_begin (true));
 		store.version_put (transaction, 11);
+		nano::store_downgrade::block_tables_split (store, transaction);
 		store.initialize (transaction, genesis);
 		nano::state_block block1 (nano::test_genesis_key.pub, genesis.hash (), nano::test_genesis_key.pub, nano::genesis_amount, 42, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
 		hash2 = block1.hash ();
@@ -1417,3 +1673,164 @@ TEST (block_store, upgrade_sideband_epoch)
 	ASSERT_EQ (nano::process_result::progress, ledger.process (transaction, block2).code);
 	ASSERT_EQ (nano::epoch::epoch_1, store.block_version (transaction, block2.hash ()));
 }
+
+TEST (block_store, upgrade_v13_v14)
+{
+	bool error (false);
+	nano::genesis genesis;
+	nano::block_hash hash2;
+	nano::block_hash hash3;
+	auto path (nano::unique_path ());
+	{
+		nano::logging logging;
+		nano::mdb_store store (error, logging, path);
+		ASSERT_FALSE (error);
+		nano::stat stat;
+		nano::ledger ledger (store, stat, 42, nano::test_genesis_key.pub);
+		auto transaction (store.tx_begin (true));
+		store.version_put (transaction, 13);
+		nano::store_downgrade::block_tables_split (store, transaction);
+		store.initialize (transaction, genesis);
+		nano::send_block block1 (genesis.hash (), nano::test_genesis_key.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
+		hash2 = block1.hash ();
+		ASSERT_EQ (nano::process_result::progress, ledger.process (transaction, block1).code);
+		nano::state_block block2 (nano::test_genesis_key.pub, hash2, nano::genesis_account, nano::genesis_amount - nano::Gxrb_ratio, 42, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
+		hash3 = block2.hash ();
+		ASSERT_EQ (nano::process_result::progress, ledger.process (transaction, block2).code);
+		MDB_stat send_stats;
+		ASSERT_EQ (0, mdb_stat (store.env.tx (transaction), store.send_blocks, &send_stats));
+		ASSERT_EQ (1, send_stats.ms_entries);
+	}
+	nano::logging logging;
+	nano::mdb_store store (error, logging, path);
+	ASSERT_FALSE (error);
+	nano::stat stat;
+	nano::ledger ledger (store, stat, 42, nano::test_genesis_key.pub);
+	auto transaction (store.tx_begin (true));
+	ASSERT_EQ (14, store.version_get (transaction));
+	MDB_stat send_stats;
+	ASSERT_EQ (0, mdb_stat (store.env.tx (transaction), store.send_blocks, &send_stats));
+	ASSERT_EQ (0, send_stats.ms_entries);
+	ASSERT_TRUE (store.block_exists (transaction, genesis.hash ()));
+	ASSERT_TRUE (store.block_exists (transaction, nano::block_type::send, hash2));
+	ASSERT_FALSE (store.block_exists (transaction, nano::block_type::receive, hash2));
+	ASSERT_FALSE (store.block_exists (transaction, nano::block_hash (1)));
+	ASSERT_EQ (nano::epoch::epoch_1, store.block_version (transaction, hash3));
+	ASSERT_EQ (hash2, store.block_successor (transaction, genesis.hash ()));
+	nano::block_sideband sideband;
+	auto block2 (store.block_get (transaction, hash2, &sideband));
+	ASSERT_NE (nullptr, block2);
+	ASSERT_EQ (hash3, sideband.successor);
+	auto counts (store.block_count (transaction));
+	ASSERT_EQ (1, counts.open);
+	ASSERT_EQ (1, counts.send);
+	ASSERT_EQ (1, counts.state_v1);
+	ASSERT_EQ (3, counts.sum ());
+	ledger.rollback (transaction, hash3);
+	ASSERT_FALSE (store.block_exists (transaction, hash3));
+	ASSERT_EQ (0, store.block_count (transaction).state_v1);
+	ASSERT_TRUE (store.block_successor (transaction, hash2).is_zero ());
+}
+
+TEST (block_store, snapshot_round_trip)
+{
+	bool error (false);
+	nano::genesis genesis;
+	nano::keypair key1;
+	auto snapshot_path (nano::unique_path ());
+	nano::block_hash hash1;
+	nano::block_hash hash2;
+	{
+		nano::logging logging;
+		nano::mdb_store store (error, logging, nano::unique_path ());
+		ASSERT_FALSE (error);
+		nano::stat stat;
+		nano::ledger ledger (store, stat);
+		{
+			auto transaction (store.tx_begin_write ());
+			store.initialize (transaction, genesis);
+			nano::send_block send (genesis.hash (), key1.pub, nano::genesis_amount - 100, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
+			hash1 = send.hash ();
+			ASSERT_EQ (nano::process_result::progress, ledger.process (transaction, send).code);
+			nano::open_block open (hash1, key1.pub, key1.pub, key1.prv, key1.pub, 0);
+			hash2 = open.hash ();
+			ASSERT_EQ (nano::process_result::progress, ledger.process (transaction, open).code);
+			store.get_node_id (transaction);
+		}
+		ASSERT_FALSE (store.snapshot_export (snapshot_path));
+	}
+	nano::logging logging;
+	nano::mdb_store store (error, logging, nano::unique_path ());
+	ASSERT_FALSE (error);
+	nano::raw_key node_id;
+	{
+		auto transaction (store.tx_begin_write ());
+		node_id = store.get_node_id (transaction);
+	}
+	ASSERT_FALSE (store.snapshot_import (snapshot_path, 2));
+	auto transaction (store.tx_begin_write ());
+	ASSERT_EQ (3, store.block_count (transaction).sum ());
+	ASSERT_EQ (2, store.account_count (transaction));
+	ASSERT_EQ (hash2, store.block_successor (transaction, hash1));
+	nano::account_info info;
+	ASSERT_FALSE (store.account_get (transaction, key1.pub, info));
+	ASSERT_EQ (hash2, info.head);
+	ASSERT_EQ (100, store.representation_get (transaction, key1.pub));
+	ASSERT_EQ (100, store.representation_cache.representation_get (key1.pub));
+	ASSERT_EQ (nano::genesis_account, store.frontier_get (transaction, hash1));
+	ASSERT_EQ (key1.pub, store.frontier_get (transaction, hash2));
+	// Node IDs belong to the exporting node and aren't carried over
+	ASSERT_EQ (node_id, store.get_node_id (transaction));
+}
+
+TEST (block_store, snapshot_node_id)
+{
+	bool error (false);
+	nano::genesis genesis;
+	auto snapshot_path (nano::unique_path ());
+	nano::logging logging;
+	nano::mdb_store store (error, logging, nano::unique_path ());
+	ASSERT_FALSE (error);
+	nano::raw_key node_id;
+	{
+		auto transaction (store.tx_begin_write ());
+		store.initialize (transaction, genesis);
+		node_id = store.get_node_id (transaction);
+	}
+	ASSERT_FALSE (store.snapshot_export (snapshot_path));
+	std::ifstream stream (snapshot_path.string (), std::ios::binary);
+	std::vector<uint8_t> contents ((std::istreambuf_iterator<char> (stream)), std::istreambuf_iterator<char> ());
+	ASSERT_FALSE (contents.empty ());
+	// The private node ID key must never end up in a distributable file
+	ASSERT_EQ (contents.end (), std::search (contents.begin (), contents.end (), node_id.data.bytes.begin (), node_id.data.bytes.end ()));
+}
+
+TEST (block_store, snapshot_corrupt)
+{
+	bool error (false);
+	nano::genesis genesis;
+	auto snapshot_path (nano::unique_path ());
+	{
+		nano::logging logging;
+		nano::mdb_store store (error, logging, nano::unique_path ());
+		ASSERT_FALSE (error);
+		{
+			auto transaction (store.tx_begin_write ());
+			store.initialize (transaction, genesis);
+		}
+		ASSERT_FALSE (store.snapshot_export (snapshot_path));
+	}
+	{
+		std::fstream stream (snapshot_path.string (), std::ios::in | std::ios::out | std::ios::binary);
+		stream.seekp (64);
+		stream.put (0x55);
+	}
+	nano::logging logging;
+	nano::mdb_store store (error, logging, nano::unique_path ());
+	ASSERT_FALSE (error);
+	ASSERT_TRUE (store.snapshot_import (snapshot_path, 2));
+	// Missing files are reported the same way
+	ASSERT_TRUE (store.snapshot_import (nano::unique_path (), 2));
+	auto transaction (store.tx_begin_read ());
+	ASSERT_EQ (0, store.block_count (transaction).sum ());
+}
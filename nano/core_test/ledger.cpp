@@ -817,6 +817,42 @@ TEST (votes, add_existing)
 	ASSERT_EQ (*send2, *winner.second);
 }
 
+// Changing a vote moves its weight between blocks without recomputing the tally
+TEST (votes, incremental_tally)
+{
+	nano::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	nano::genesis genesis;
+	nano::keypair key1;
+	auto send1 (std::make_shared<nano::send_block> (genesis.hash (), key1.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0));
+	node1.work_generate_blocking (*send1);
+	auto transaction (node1.store.tx_begin (true));
+	ASSERT_EQ (nano::process_result::progress, node1.ledger.process (transaction, *send1).code);
+	node1.active.start (send1);
+	auto votes1 (node1.active.roots.find (nano::uint512_union (send1->previous (), send1->root ()))->election);
+	auto weight (node1.ledger.weight (transaction, nano::test_genesis_key.pub));
+	auto vote1 (std::make_shared<nano::vote> (nano::test_genesis_key.pub, nano::test_genesis_key.prv, 1, send1));
+	ASSERT_FALSE (node1.active.vote (vote1));
+	ASSERT_EQ (weight, votes1->last_tally[send1->hash ()]);
+	ASSERT_EQ (weight, votes1->tally_sum);
+	nano::keypair key2;
+	auto send2 (std::make_shared<nano::send_block> (genesis.hash (), key2.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0));
+	auto vote2 (std::make_shared<nano::vote> (nano::test_genesis_key.pub, nano::test_genesis_key.prv, 2, send2));
+	votes1->last_votes[nano::test_genesis_key.pub].time = std::chrono::steady_clock::now () - std::chrono::seconds (20);
+	ASSERT_FALSE (node1.active.vote (vote2));
+	// The block voted for is not part of the election yet, so it is not counted in the total
+	ASSERT_EQ (0, votes1->last_tally[send1->hash ()]);
+	ASSERT_EQ (weight, votes1->last_tally[send2->hash ()]);
+	ASSERT_EQ (0, votes1->tally_sum);
+	ASSERT_FALSE (node1.active.publish (send2));
+	ASSERT_EQ (weight, votes1->tally_sum);
+	// A full recompute agrees with the incremental tally
+	auto winner (*votes1->tally (transaction).begin ());
+	ASSERT_EQ (*send2, *winner.second);
+	ASSERT_EQ (weight, winner.first);
+	ASSERT_EQ (weight, votes1->tally_sum);
+}
+
 // Lower sequence numbers are ignored
 TEST (votes, add_old)
 {
@@ -192,3 +192,32 @@ TEST (message_parser, exact_keepalive_size)
 	ASSERT_EQ (1, visitor.keepalive_count);
 	ASSERT_NE (parser.status, nano::message_parser::parse_status::success);
 }
+
+TEST (message_parser, deferred_work)
+{
+	nano::system system (24000, 1);
+	test_visitor visitor;
+	nano::block_uniquer block_uniquer;
+	nano::vote_uniquer vote_uniquer (block_uniquer);
+	uint64_t work (0);
+	while (!nano::work_validate (1, work))
+	{
+		++work;
+	}
+	auto block (std::make_shared<nano::send_block> (1, 1, 2, nano::keypair ().prv, 4, work));
+	nano::publish message (std::move (block));
+	std::vector<uint8_t> bytes;
+	{
+		nano::vectorstream stream (bytes);
+		message.serialize (stream);
+	}
+	nano::message_parser parser1 (block_uniquer, vote_uniquer, visitor, system.work);
+	parser1.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (nano::message_parser::parse_status::insufficient_work, parser1.status);
+	ASSERT_EQ (0, visitor.publish_count);
+	// Without work validation the visitor gets the message and has to check the work itself
+	nano::message_parser parser2 (block_uniquer, vote_uniquer, visitor, system.work, false);
+	parser2.deserialize_buffer (bytes.data (), bytes.size ());
+	ASSERT_EQ (nano::message_parser::parse_status::success, parser2.status);
+	ASSERT_EQ (1, visitor.publish_count);
+}
@@ -62,6 +62,39 @@ TEST (network, self_discard)
 	ASSERT_EQ (1, system.nodes[0]->stats.count (nano::stat::type::error, nano::stat::detail::bad_sender));
 }
 
+TEST (network, receive_batch_work)
+{
+	nano::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	nano::genesis genesis;
+	nano::keypair key1;
+	auto send1 (std::make_shared<nano::send_block> (genesis.hash (), key1.pub, nano::genesis_amount - 100, nano::test_genesis_key.prv, nano::test_genesis_key.pub, system.work.generate (genesis.hash ())));
+	uint64_t bad_work (0);
+	while (!nano::work_validate (genesis.hash (), bad_work))
+	{
+		++bad_work;
+	}
+	auto send2 (std::make_shared<nano::send_block> (genesis.hash (), key1.pub, nano::genesis_amount - 200, nano::test_genesis_key.prv, nano::test_genesis_key.pub, bad_work));
+	auto bytes1 (nano::publish (send1).to_bytes ());
+	auto bytes2 (nano::publish (send2).to_bytes ());
+	auto bytes3 (nano::keepalive ().to_bytes ());
+	std::array<nano::udp_data, 3> data;
+	data[0] = { bytes1->data (), bytes1->size (), nano::endpoint (boost::asio::ip::address_v6::loopback (), 10000) };
+	data[1] = { bytes2->data (), bytes2->size (), data[0].endpoint };
+	data[2] = { bytes3->data (), bytes3->size (), data[0].endpoint };
+	std::array<nano::udp_data *, 3> pointers{ { &data[0], &data[1], &data[2] } };
+	node1.network.receive_action (pointers.data (), pointers.size ());
+	ASSERT_EQ (1, node1.stats.count (nano::stat::type::message, nano::stat::detail::publish, nano::stat::dir::in));
+	ASSERT_EQ (1, node1.stats.count (nano::stat::type::message, nano::stat::detail::keepalive, nano::stat::dir::in));
+	ASSERT_EQ (1, node1.stats.count (nano::stat::type::error, nano::stat::detail::insufficient_work));
+	system.deadline_set (10s);
+	while (!node1.ledger.block_exists (send1->hash ()))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_FALSE (node1.ledger.block_exists (send2->hash ()));
+}
+
 TEST (network, send_node_id_handshake)
 {
 	nano::system system (24000, 1);
@@ -470,6 +503,7 @@ TEST (bulk_pull, end_not_owned)
 	open.hashables.account = key2.pub;
 	open.hashables.representative = key2.pub;
 	open.hashables.source = latest;
+	open.hash_invalidate ();
 	open.signature = nano::sign_message (key2.prv, key2.pub, open.hash ());
 	ASSERT_EQ (nano::process_result::progress, system.nodes[0]->process (open).code);
 	auto connection (std::make_shared<nano::bootstrap_server> (nullptr, system.nodes[0]));
@@ -641,6 +675,60 @@ TEST (bootstrap_processor, process_two)
 	node1->stop ();
 }
 
+// Chains longer than the pull split count are pulled in several pieces
+TEST (bootstrap_processor, split_long_chain)
+{
+	nano::system system (24000, 1);
+	system.wallet (0)->insert_adhoc (nano::test_genesis_key.prv);
+	for (auto i (0); i < 10; ++i)
+	{
+		ASSERT_NE (nullptr, system.wallet (0)->send_action (nano::test_genesis_key.pub, nano::test_genesis_key.pub, 10));
+	}
+	nano::node_init init1;
+	auto node1 (std::make_shared<nano::node> (init1, system.io_ctx, 24001, nano::unique_path (), system.alarm, system.logging, system.work));
+	ASSERT_FALSE (init1.error ());
+	node1->bootstrap_initiator.bootstrap (system.nodes[0]->network.endpoint ());
+	system.deadline_set (10s);
+	while (node1->latest (nano::test_genesis_key.pub) != system.nodes[0]->latest (nano::test_genesis_key.pub))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	{
+		auto transaction (node1->store.tx_begin_read ());
+		ASSERT_EQ (11, node1->store.block_count (transaction).sum ());
+	}
+	node1->stop ();
+}
+
+TEST (bootstrap_processor, peer_score)
+{
+	nano::system system (24000, 1);
+	auto node (system.nodes[0]);
+	auto attempt (std::make_shared<nano::bootstrap_attempt> (node));
+	auto fast (std::make_shared<nano::bootstrap_client> (node, attempt, nano::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24001)));
+	auto slow (std::make_shared<nano::bootstrap_client> (node, attempt, nano::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24002)));
+	auto failing (std::make_shared<nano::bootstrap_client> (node, attempt, nano::tcp_endpoint (boost::asio::ip::address_v6::loopback (), 24003)));
+	fast->pull_finished (1000, std::chrono::seconds (1), false);
+	slow->pull_finished (100, std::chrono::seconds (1), false);
+	failing->pull_finished (2000, std::chrono::seconds (1), true);
+	failing->pull_finished (2000, std::chrono::seconds (1), true);
+	ASSERT_EQ (1000.0, fast->recent_rate);
+	// Failed pulls weigh a peer down even when it is quick
+	ASSERT_GT (fast->score (), failing->score ());
+	ASSERT_GT (fast->score (), slow->score ());
+	// Rates move gradually towards newer pulls
+	slow->pull_finished (2000, std::chrono::seconds (1), false);
+	ASSERT_GT (slow->recent_rate, 100.0);
+	ASSERT_LT (slow->recent_rate, 2000.0);
+	std::unique_lock<std::mutex> lock (attempt->mutex);
+	attempt->idle.push_back (slow);
+	attempt->idle.push_back (fast);
+	attempt->idle.push_back (failing);
+	ASSERT_EQ (fast, attempt->connection (lock, true));
+	ASSERT_EQ (failing, attempt->connection (lock));
+	ASSERT_EQ (1, attempt->idle.size ());
+}
+
 // Bootstrap can pull universal blocks
 TEST (bootstrap_processor, process_state)
 {
@@ -1391,3 +1479,163 @@ TEST (bulk_pull_account, basics)
 		ASSERT_EQ (nullptr, block_data.second.get ());
 	}
 }
+
+TEST (udp_ring_buffer, one_buffer)
+{
+	nano::stat stats;
+	nano::udp_ring_buffer buffer (stats, 512, 1);
+	auto buffer1 (buffer.allocate ());
+	ASSERT_NE (nullptr, buffer1);
+	buffer.enqueue (buffer1);
+	auto buffer2 (buffer.dequeue ());
+	ASSERT_EQ (buffer1, buffer2);
+	buffer.release (buffer2);
+	auto buffer3 (buffer.allocate ());
+	ASSERT_EQ (buffer1, buffer3);
+}
+
+TEST (udp_ring_buffer, two_overflow)
+{
+	nano::stat stats;
+	nano::udp_ring_buffer buffer (stats, 512, 2);
+	auto buffer1 (buffer.allocate ());
+	ASSERT_NE (nullptr, buffer1);
+	buffer.enqueue (buffer1);
+	auto buffer2 (buffer.allocate ());
+	ASSERT_NE (nullptr, buffer2);
+	ASSERT_NE (buffer1, buffer2);
+	buffer.enqueue (buffer2);
+	auto buffer3 (buffer.allocate ());
+	ASSERT_EQ (buffer1, buffer3);
+	auto buffer4 (buffer.allocate ());
+	ASSERT_EQ (buffer2, buffer4);
+	ASSERT_EQ (2, stats.count (nano::stat::type::udp, nano::stat::detail::overflow));
+}
+
+TEST (udp_ring_buffer, batch)
+{
+	nano::stat stats;
+	nano::udp_ring_buffer buffer (stats, 512, 4);
+	std::array<nano::udp_data *, 8> items;
+	ASSERT_EQ (4, buffer.allocate (items.data (), items.size ()));
+	buffer.enqueue (items.data (), 3);
+	std::array<nano::udp_data *, 8> dequeued;
+	ASSERT_EQ (3, buffer.dequeue (dequeued.data (), dequeued.size ()));
+	ASSERT_TRUE (std::equal (items.begin (), items.begin () + 3, dequeued.begin ()));
+	buffer.release (dequeued.data (), 3);
+	buffer.release (items.data () + 3, 1);
+	ASSERT_EQ (4, buffer.allocate (items.data (), items.size ()));
+	buffer.stop ();
+	ASSERT_EQ (0, buffer.dequeue (dequeued.data (), dequeued.size ()));
+	ASSERT_EQ (0, buffer.allocate (items.data (), items.size ()));
+}
+
+TEST (udp_ring_buffer, shard_by_endpoint)
+{
+	nano::stat stats;
+	nano::udp_ring_buffer buffer (stats, 512, 64, 4);
+	std::array<size_t, 4> expected{ 0 };
+	for (auto i (0); i < 64; ++i)
+	{
+		auto item (buffer.allocate ());
+		ASSERT_NE (nullptr, item);
+		item->endpoint = nano::endpoint (boost::asio::ip::address_v6::loopback (), 24000 + i % 16);
+		++expected[buffer.shard (item->endpoint)];
+		buffer.enqueue (item);
+	}
+	for (size_t shard (0); shard < buffer.shards; ++shard)
+	{
+		std::array<nano::udp_data *, 64> items;
+		ASSERT_EQ (expected[shard], buffer.dequeue (items.data (), expected[shard], shard));
+		for (size_t i (0); i < expected[shard]; ++i)
+		{
+			ASSERT_EQ (shard, buffer.shard (items[i]->endpoint));
+		}
+		buffer.release (items.data (), expected[shard]);
+	}
+}
+
+TEST (udp_ring_buffer, many_buffers_multithreaded)
+{
+	nano::stat stats;
+	nano::udp_ring_buffer buffer (stats, 512, 16, 4);
+	std::vector<boost::thread> threads;
+	std::atomic<size_t> serviced (0);
+	for (size_t i (0); i < buffer.shards; ++i)
+	{
+		threads.push_back (boost::thread ([&buffer, &serviced, i]() {
+			std::array<nano::udp_data *, 4> items;
+			size_t count;
+			while ((count = buffer.dequeue (items.data (), items.size (), i)) > 0)
+			{
+				for (size_t j (0); j < count; ++j)
+				{
+					// Every datagram from a peer is serviced by the thread owning its shard
+					EXPECT_EQ (i, buffer.shard (items[j]->endpoint));
+				}
+				serviced += count;
+				buffer.release (items.data (), count);
+			}
+		}));
+	}
+	std::vector<boost::thread> producers;
+	for (auto i (0); i < 4; ++i)
+	{
+		producers.push_back (boost::thread ([&buffer, i]() {
+			for (auto j (0); j < 1000; ++j)
+			{
+				auto item (buffer.allocate ());
+				ASSERT_NE (nullptr, item);
+				item->endpoint = nano::endpoint (boost::asio::ip::address_v6::loopback (), 24000 + (i * 1000 + j) % 64);
+				buffer.enqueue (item);
+			}
+		}));
+	}
+	for (auto & i : producers)
+	{
+		i.join ();
+	}
+	// Each datagram is either serviced or overwritten when no buffers were free
+	auto deadline (std::chrono::steady_clock::now () + 10s);
+	while (serviced + stats.count (nano::stat::type::udp, nano::stat::detail::overflow) < 4000 && std::chrono::steady_clock::now () < deadline)
+	{
+		std::this_thread::yield ();
+	}
+	buffer.stop ();
+	for (auto & i : threads)
+	{
+		i.join ();
+	}
+	ASSERT_EQ (4000, serviced + stats.count (nano::stat::type::udp, nano::stat::detail::overflow));
+}
+
+TEST (network, keepalive_batched)
+{
+	nano::system system (24000, 1);
+	nano::node_init init1;
+	auto path (nano::unique_path ());
+	nano::node_config config;
+	config.peering_port = 24001;
+	config.logging.init (path);
+	config.udp_batch_size = 16;
+	auto node1 (std::make_shared<nano::node> (init1, system.io_ctx, path, system.alarm, config, system.work));
+	node1->start ();
+	system.nodes.push_back (node1);
+	node1->send_keepalive (system.nodes[0]->network.endpoint ());
+	system.deadline_set (10s);
+	// The reply from node 0 arrives through the batched receive path when it is supported
+	while (node1->stats.count (nano::stat::type::message, nano::stat::detail::keepalive, nano::stat::dir::in) == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	// Linux builds use recvmmsg, make sure the reply didn't fall back to the single datagram path
+	if (nano::udp_batch::supported ())
+	{
+		auto batches (false);
+		node1->stats.histograms ([&batches](std::string const & type_a, std::string const & detail_a, nano::stat_histogram const & histogram_a) {
+			batches = batches || (type_a == "udp" && detail_a == "receive_batch" && histogram_a.count > 0);
+		});
+		ASSERT_TRUE (batches);
+	}
+	node1->stop ();
+}
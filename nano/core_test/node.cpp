@@ -7,6 +7,8 @@
 #include <boost/make_shared.hpp>
 #include <boost/polymorphic_cast.hpp>
 
+#include <future>
+
 using namespace std::chrono_literals;
 
 namespace
@@ -515,6 +517,17 @@ TEST (node_config, serialization)
 	config1.callback_port = 10;
 	config1.callback_target = "test";
 	config1.lmdb_max_dbs = 256;
+	config1.signature_checker_threads = 99;
+	config1.uniquer_memory_max_mb = 3;
+	config1.block_cache_max_mb = 7;
+	config1.account_cache_max_mb = 9;
+	config1.write_batch_max_time = std::chrono::milliseconds (11);
+	config1.write_batch_max_size = 12;
+	config1.callback_connections = 2;
+	config1.callback_queue_max = 5;
+	config1.callback_batch_max = 6;
+	config1.udp_batch_size = 7;
+	config1.udp_shard_by_endpoint = true;
 	nano::jsonconfig tree;
 	config1.serialize_json (tree);
 	nano::logging logging2;
@@ -532,6 +545,17 @@ TEST (node_config, serialization)
 	ASSERT_NE (config2.callback_port, config1.callback_port);
 	ASSERT_NE (config2.callback_target, config1.callback_target);
 	ASSERT_NE (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
+	ASSERT_NE (config2.signature_checker_threads, config1.signature_checker_threads);
+	ASSERT_NE (config2.uniquer_memory_max_mb, config1.uniquer_memory_max_mb);
+	ASSERT_NE (config2.block_cache_max_mb, config1.block_cache_max_mb);
+	ASSERT_NE (config2.account_cache_max_mb, config1.account_cache_max_mb);
+	ASSERT_NE (config2.write_batch_max_time, config1.write_batch_max_time);
+	ASSERT_NE (config2.write_batch_max_size, config1.write_batch_max_size);
+	ASSERT_NE (config2.callback_connections, config1.callback_connections);
+	ASSERT_NE (config2.callback_queue_max, config1.callback_queue_max);
+	ASSERT_NE (config2.callback_batch_max, config1.callback_batch_max);
+	ASSERT_NE (config2.udp_batch_size, config1.udp_batch_size);
+	ASSERT_NE (config2.udp_shard_by_endpoint, config1.udp_shard_by_endpoint);
 
 	ASSERT_FALSE (tree.get_optional<std::string> ("epoch_block_link"));
 	ASSERT_FALSE (tree.get_optional<std::string> ("epoch_block_signer"));
@@ -550,6 +574,33 @@ TEST (node_config, serialization)
 	ASSERT_EQ (config2.callback_port, config1.callback_port);
 	ASSERT_EQ (config2.callback_target, config1.callback_target);
 	ASSERT_EQ (config2.lmdb_max_dbs, config1.lmdb_max_dbs);
+	ASSERT_EQ (config2.signature_checker_threads, config1.signature_checker_threads);
+	ASSERT_EQ (config2.uniquer_memory_max_mb, config1.uniquer_memory_max_mb);
+	ASSERT_EQ (config2.block_cache_max_mb, config1.block_cache_max_mb);
+	ASSERT_EQ (config2.account_cache_max_mb, config1.account_cache_max_mb);
+	ASSERT_EQ (config2.write_batch_max_time, config1.write_batch_max_time);
+	ASSERT_EQ (config2.write_batch_max_size, config1.write_batch_max_size);
+	ASSERT_EQ (config2.callback_connections, config1.callback_connections);
+	ASSERT_EQ (config2.callback_queue_max, config1.callback_queue_max);
+	ASSERT_EQ (config2.callback_batch_max, config1.callback_batch_max);
+	ASSERT_EQ (config2.udp_batch_size, config1.udp_batch_size);
+	ASSERT_EQ (config2.udp_shard_by_endpoint, config1.udp_shard_by_endpoint);
+}
+
+TEST (node_config, callback_connections_zero)
+{
+	auto path (nano::unique_path ());
+	nano::logging logging1;
+	logging1.init (path);
+	nano::node_config config1 (100, logging1);
+	config1.callback_connections = 0;
+	nano::jsonconfig tree;
+	config1.serialize_json (tree);
+	nano::logging logging2;
+	logging2.init (path);
+	nano::node_config config2 (50, logging2);
+	bool upgraded (false);
+	ASSERT_TRUE (config2.deserialize_json (upgraded, tree));
 }
 
 TEST (node_config, v1_v2_upgrade)
@@ -656,6 +707,32 @@ TEST (node_config, v15_v16_upgrade)
 	test_upgrade ("rai-beta.raiblocks.net", "peering-beta.nano.org");
 }
 
+TEST (node_config, v16_v17_upgrade)
+{
+	nano::jsonconfig tree;
+	add_required_children_node_config_tree (tree);
+	tree.put ("version", "16");
+	auto path (nano::unique_path ());
+	auto upgraded (false);
+	nano::node_config config;
+	config.logging.init (path);
+	ASSERT_FALSE (tree.get_optional<unsigned> ("signature_checker_threads"));
+	config.deserialize_json (upgraded, tree);
+	ASSERT_TRUE (upgraded);
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("signature_checker_threads"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("uniquer_memory_max_mb"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("block_cache_max_mb"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("account_cache_max_mb"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("write_batch_max_time"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("write_batch_max_size"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("callback_connections"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("callback_queue_max"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("callback_batch_max"));
+	ASSERT_TRUE (!!tree.get_optional<unsigned> ("udp_batch_size"));
+	ASSERT_TRUE (!!tree.get_optional<bool> ("udp_shard_by_endpoint"));
+	ASSERT_EQ (17, tree.get<unsigned> ("version"));
+}
+
 TEST (node_config, allow_local_peers)
 {
 	nano::jsonconfig tree;
@@ -1570,6 +1647,64 @@ TEST (node, send_callback)
 	ASSERT_EQ (std::numeric_limits<nano::uint128_t>::max () - system.nodes[0]->config.receive_minimum.number (), system.nodes[0]->balance (nano::test_genesis_key.pub));
 }
 
+TEST (node, callback_pool)
+{
+	nano::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	node1.config.callback_address = "127.0.0.1";
+	node1.config.callback_port = 24100;
+	node1.config.callback_target = "/";
+	node1.config.callback_connections = 1;
+	node1.config.callback_batch_max = 2;
+	boost::asio::io_context server_ctx;
+	boost::asio::ip::tcp::acceptor acceptor (server_ctx, boost::asio::ip::tcp::endpoint (boost::asio::ip::address_v4::loopback (), 24100));
+	std::vector<std::string> bodies;
+	std::atomic<bool> done (false);
+	// Only one connection is accepted, both requests have to arrive on it
+	std::thread server ([&]() {
+		boost::asio::ip::tcp::socket sock (server_ctx);
+		acceptor.accept (sock);
+		boost::beast::flat_buffer buffer;
+		boost::system::error_code ec;
+		while (!ec && bodies.size () < 2)
+		{
+			boost::beast::http::request<boost::beast::http::string_body> request;
+			boost::beast::http::read (sock, buffer, request, ec);
+			if (!ec)
+			{
+				bodies.push_back (request.body ());
+				boost::beast::http::response<boost::beast::http::string_body> response (boost::beast::http::status::ok, 11);
+				response.keep_alive (true);
+				response.prepare_payload ();
+				boost::beast::http::write (sock, response, ec);
+			}
+		}
+		done = true;
+	});
+	// The first callback opens the connection, the other two wait and are posted together
+	ASSERT_FALSE (node1.http_callbacks.add ("{\"n\": \"1\"}\n"));
+	ASSERT_FALSE (node1.http_callbacks.add ("{\"n\": \"2\"}\n"));
+	ASSERT_FALSE (node1.http_callbacks.add ("{\"n\": \"3\"}\n"));
+	system.deadline_set (10s);
+	while (!done || node1.stats.count (nano::stat::type::http_callback, nano::stat::detail::initiate, nano::stat::dir::out) < 3)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	server.join ();
+	ASSERT_EQ (2, bodies.size ());
+	ASSERT_EQ ("{\"n\": \"1\"}\n", bodies[0]);
+	boost::property_tree::ptree batch;
+	std::stringstream stream (bodies[1]);
+	boost::property_tree::read_json (stream, batch);
+	ASSERT_EQ (2, batch.size ());
+	ASSERT_EQ ("2", batch.front ().second.get<std::string> ("n"));
+	ASSERT_EQ ("3", batch.back ().second.get<std::string> ("n"));
+	ASSERT_EQ (0, node1.stats.count (nano::stat::type::error, nano::stat::detail::http_callback, nano::stat::dir::out));
+	node1.config.callback_queue_max = 0;
+	ASSERT_TRUE (node1.http_callbacks.add ("{}\n"));
+	ASSERT_EQ (1, node1.stats.count (nano::stat::type::http_callback, nano::stat::detail::overflow, nano::stat::dir::out));
+}
+
 // Check that votes get replayed back to nodes if they sent an old sequence number.
 // This helps representatives continue from their last sequence number if their node is reinitialized and the old sequence number is lost
 TEST (node, vote_replay)
@@ -1633,27 +1768,31 @@ TEST (node, balance_observer)
 	}
 }
 
-// ASSERT_NE (nullptr, attempt) sometimes fails
-TEST (node, DISABLED_bootstrap_connection_scaling)
+TEST (node, bootstrap_connection_scaling)
 {
 	nano::system system (24000, 1);
 	auto & node1 (*system.nodes[0]);
-	node1.bootstrap_initiator.bootstrap ();
-	auto attempt (node1.bootstrap_initiator.current_attempt ());
-	ASSERT_NE (nullptr, attempt);
-	ASSERT_EQ (34, attempt->target_connections (25000));
-	ASSERT_EQ (4, attempt->target_connections (0));
-	ASSERT_EQ (64, attempt->target_connections (50000));
-	ASSERT_EQ (64, attempt->target_connections (10000000000));
+	auto attempt (std::make_shared<nano::bootstrap_attempt> (system.nodes[0]));
+	ASSERT_EQ (4, attempt->target_connections ());
+	// Connections are added while aggregate throughput keeps improving
+	attempt->adjust_target_connections (100.0, 1000);
+	ASSERT_EQ (6, attempt->target_connections ());
+	attempt->adjust_target_connections (200.0, 1000);
+	ASSERT_EQ (8, attempt->target_connections ());
+	attempt->adjust_target_connections (200.0, 1000);
+	ASSERT_EQ (8, attempt->target_connections ());
+	// and given back once they stop helping
+	attempt->adjust_target_connections (100.0, 1000);
+	ASSERT_EQ (7, attempt->target_connections ());
+	// Not scaled past the number of pulls left
+	attempt->adjust_target_connections (200.0, 5);
+	ASSERT_EQ (7, attempt->target_connections ());
 	node1.config.bootstrap_connections = 128;
-	ASSERT_EQ (64, attempt->target_connections (0));
-	ASSERT_EQ (64, attempt->target_connections (50000));
+	ASSERT_EQ (64, attempt->target_connections ());
 	node1.config.bootstrap_connections_max = 256;
-	ASSERT_EQ (128, attempt->target_connections (0));
-	ASSERT_EQ (256, attempt->target_connections (50000));
+	ASSERT_EQ (128, attempt->target_connections ());
 	node1.config.bootstrap_connections_max = 0;
-	ASSERT_EQ (1, attempt->target_connections (0));
-	ASSERT_EQ (1, attempt->target_connections (50000));
+	ASSERT_EQ (1, attempt->target_connections ());
 }
 
 // Test stat counting at both type and detail levels
@@ -2038,6 +2177,30 @@ TEST (node, block_processor_signatures)
 	ASSERT_FALSE (node1.store.block_exists (transaction, receive3->hash ()));
 }
 
+TEST (node, block_processor_pipeline_stats)
+{
+	nano::system system0 (24000, 1);
+	auto & node1 (*system0.nodes[0]);
+	nano::genesis genesis;
+	nano::keypair key1;
+	auto send1 (std::make_shared<nano::send_block> (genesis.hash (), key1.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0));
+	node1.work_generate_blocking (*send1);
+	auto send2 (std::make_shared<nano::state_block> (nano::test_genesis_key.pub, send1->hash (), nano::test_genesis_key.pub, nano::genesis_amount - 2 * nano::Gxrb_ratio, key1.pub, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0));
+	node1.work_generate_blocking (*send2);
+	node1.block_processor.add (send1, std::chrono::steady_clock::time_point ());
+	node1.block_processor.flush ();
+	node1.block_processor.add (send2, std::chrono::steady_clock::time_point ());
+	node1.block_processor.flush ();
+	auto transaction (node1.store.tx_begin_read ());
+	ASSERT_TRUE (node1.store.block_exists (transaction, send1->hash ()));
+	ASSERT_TRUE (node1.store.block_exists (transaction, send2->hash ()));
+	// Only the state block passes through signature verification, both are applied to the ledger
+	ASSERT_EQ (1, node1.stats.count (nano::stat::type::block_processor, nano::stat::detail::signature_verification, nano::stat::dir::in));
+	ASSERT_EQ (1, node1.stats.count (nano::stat::type::block_processor, nano::stat::detail::signature_verification, nano::stat::dir::out));
+	ASSERT_EQ (2, node1.stats.count (nano::stat::type::block_processor, nano::stat::detail::ledger_apply, nano::stat::dir::in));
+	ASSERT_EQ (2, node1.stats.count (nano::stat::type::block_processor, nano::stat::detail::ledger_apply, nano::stat::dir::out));
+}
+
 /*
  *  State blocks go through a different signature path, ensure invalidly signed state blocks are rejected
  */
@@ -2115,6 +2278,178 @@ TEST (node, confirm_back)
 	}
 }
 
+TEST (node, work_cache_frontier)
+{
+	nano::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	nano::genesis genesis;
+	system.wallet (0)->insert_adhoc (nano::test_genesis_key.prv);
+	system.deadline_set (10s);
+	while (!node.work_cache.get (genesis.hash ()))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	nano::keypair key;
+	auto send (system.wallet (0)->send_action (nano::test_genesis_key.pub, key.pub, 1));
+	ASSERT_NE (nullptr, send);
+	// Confirmation of the send moves the cached root to the new frontier
+	system.deadline_set (10s);
+	while (!node.work_cache.get (send->hash ()))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_FALSE (node.work_cache.get (genesis.hash ()));
+	ASSERT_EQ (1, node.work_cache.size ());
+	// Wallet store is kept up to date with the cache
+	system.deadline_set (10s);
+	auto again (true);
+	while (again)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+		auto transaction (node.wallets.tx_begin_read ());
+		uint64_t work (0);
+		again = system.wallet (0)->store.work_get (transaction, nano::test_genesis_key.pub, work) || nano::work_validate (send->hash (), work);
+	}
+}
+
+TEST (node, work_cache_wallet_accounts)
+{
+	nano::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	nano::keypair key;
+	ASSERT_EQ (0, node.work_cache.wallet_accounts.count (key.pub));
+	system.wallet (0)->insert_adhoc (key.prv, false);
+	ASSERT_EQ (1, node.work_cache.wallet_accounts.count (key.pub));
+	{
+		auto transaction (node.wallets.tx_begin_write ());
+		system.wallet (0)->store.erase (transaction, key.pub);
+	}
+	// Removals are picked up by reloading in the background
+	node.work_cache.wallets_changed ();
+	system.deadline_set (10s);
+	while (node.work_cache.wallet_accounts.count (key.pub) != 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+}
+
+TEST (node, work_cache_prune)
+{
+	nano::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	nano::keypair key;
+	system.wallet (0)->insert_adhoc (key.prv);
+	system.deadline_set (10s);
+	while (!node.work_cache.get (key.pub))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	{
+		auto transaction (node.wallets.tx_begin_write ());
+		system.wallet (0)->store.erase (transaction, key.pub);
+	}
+	// The entry of an account no longer in any wallet is dropped on reload
+	node.work_cache.wallets_changed ();
+	system.deadline_set (10s);
+	while (node.work_cache.size () != 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_FALSE (node.work_cache.get (key.pub));
+}
+
+TEST (node, work_cache_persist)
+{
+	nano::system system (24000, 1);
+	nano::keypair key;
+	auto path (nano::unique_path ());
+	uint64_t work (0);
+	{
+		nano::node_init init1;
+		auto node1 (std::make_shared<nano::node> (init1, system.io_ctx, 24001, path, system.alarm, system.logging, system.work));
+		ASSERT_FALSE (init1.error ());
+		node1->start ();
+		node1->work_cache.watch (key.pub);
+		// Unopened accounts use their own public key as root
+		system.deadline_set (10s);
+		while (!node1->work_cache.get (key.pub))
+		{
+			ASSERT_NO_ERROR (system.poll ());
+		}
+		work = *node1->work_cache.get (key.pub);
+		node1->stop ();
+	}
+	nano::node_init init2;
+	auto node2 (std::make_shared<nano::node> (init2, system.io_ctx, 24002, path, system.alarm, system.logging, system.work));
+	ASSERT_FALSE (init2.error ());
+	auto watched (node2->work_cache.watched ());
+	ASSERT_EQ (1, watched.size ());
+	ASSERT_EQ (key.pub, watched[0]);
+	ASSERT_EQ (work, *node2->work_cache.get (key.pub));
+	node2->work_cache.unwatch (key.pub);
+	ASSERT_EQ (0, node2->work_cache.size ());
+	node2->stop ();
+}
+
+TEST (node, write_scheduler)
+{
+	nano::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	std::promise<void> blocked;
+	std::promise<void> release;
+	auto release_future (release.get_future ().share ());
+	// Hold the writer so the following writes queue up behind it
+	node.write_scheduler.add (nano::write_priority::maintenance, [&blocked, release_future](nano::transaction const &) {
+		blocked.set_value ();
+		release_future.wait ();
+	});
+	blocked.get_future ().wait ();
+	std::vector<nano::write_priority> order;
+	for (auto priority : { nano::write_priority::maintenance, nano::write_priority::bootstrap, nano::write_priority::live })
+	{
+		node.write_scheduler.add (priority, [&order, priority](nano::transaction const &) {
+			order.push_back (priority);
+		});
+	}
+	ASSERT_EQ (3, node.write_scheduler.size ());
+	release.set_value ();
+	// Writes nested inside a group share its transaction instead of waiting on the queue
+	auto nested (false);
+	node.write_scheduler.run (nano::write_priority::maintenance, [&node, &nested](nano::transaction const & transaction_a) {
+		node.write_scheduler.run (nano::write_priority::live, [&nested, &transaction_a](nano::transaction const & inner_a) {
+			nested = &inner_a == &transaction_a;
+		});
+	});
+	ASSERT_TRUE (nested);
+	ASSERT_EQ ((std::vector<nano::write_priority>{ nano::write_priority::live, nano::write_priority::bootstrap, nano::write_priority::maintenance }), order);
+	auto batches (false);
+	node.stats.histograms ([&batches](std::string const & type_a, std::string const & detail_a, nano::stat_histogram const & histogram_a) {
+		batches = batches || (type_a == "write_scheduler" && detail_a == "batch_size" && histogram_a.count > 0);
+	});
+	ASSERT_TRUE (batches);
+	// Blocks submitted through the node are written by the scheduler
+	nano::genesis genesis;
+	nano::keypair key;
+	nano::send_block send (genesis.hash (), key.pub, nano::genesis_amount - 1, nano::test_genesis_key.prv, nano::test_genesis_key.pub, system.work.generate (genesis.hash ()));
+	ASSERT_EQ (nano::process_result::progress, node.process (send).code);
+	auto transaction (node.store.tx_begin_read ());
+	ASSERT_TRUE (node.store.block_exists (transaction, send.hash ()));
+	// Once stopped writes run on their caller, nested ones share the caller's transaction
+	node.write_scheduler.stop ();
+	auto stopped_nested (false);
+	auto done (false);
+	node.write_scheduler.add (nano::write_priority::maintenance, [&node, &stopped_nested](nano::transaction const & transaction_a) {
+		node.write_scheduler.run (nano::write_priority::live, [&stopped_nested, &transaction_a](nano::transaction const & inner_a) {
+			stopped_nested = &inner_a == &transaction_a;
+		});
+	},
+	[&done]() {
+		done = true;
+	});
+	ASSERT_TRUE (stopped_nested);
+	ASSERT_TRUE (done);
+}
+
 namespace
 {
 void add_required_children_node_config_tree (nano::jsonconfig & tree)
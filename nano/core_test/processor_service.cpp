@@ -131,3 +131,65 @@ TEST (alarm, top_execution)
 	io_ctx.stop ();
 	thread.join ();
 }
+
+TEST (alarm, cancel)
+{
+	boost::asio::io_context io_ctx;
+	nano::alarm alarm (io_ctx);
+	std::atomic<int> value (0);
+	std::promise<bool> promise;
+	auto handle1 (alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (10), [&value]() { value += 1; }));
+	alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (20), [&]() {
+		value += 2;
+		promise.set_value (false);
+	});
+	ASSERT_FALSE (alarm.cancel (handle1));
+	// Cancelling again, or with a handle that was never issued, fails
+	ASSERT_TRUE (alarm.cancel (handle1));
+	ASSERT_TRUE (alarm.cancel (nano::alarm_handle ()));
+	boost::asio::io_context::work work (io_ctx);
+	boost::thread thread ([&io_ctx]() {
+		io_ctx.run ();
+	});
+	promise.get_future ().get ();
+	ASSERT_EQ (2, value);
+	io_ctx.stop ();
+	thread.join ();
+}
+
+TEST (alarm, wheel_levels)
+{
+	boost::asio::io_context io_ctx;
+	nano::alarm alarm (io_ctx);
+	std::atomic<int> count (0);
+	std::atomic<int> early (0);
+	std::promise<bool> promise;
+	// Delays span the first two levels of the wheel and several cascades
+	auto total (100);
+	for (auto i (0); i < total; ++i)
+	{
+		auto wakeup (std::chrono::steady_clock::now () + std::chrono::milliseconds (i * 7));
+		alarm.add (wakeup, [&, wakeup, total]() {
+			if (std::chrono::steady_clock::now () < wakeup)
+			{
+				++early;
+			}
+			if (++count == total)
+			{
+				promise.set_value (false);
+			}
+		});
+	}
+	boost::asio::io_context::work work (io_ctx);
+	boost::thread thread ([&io_ctx]() {
+		io_ctx.run ();
+	});
+	promise.get_future ().get ();
+	ASSERT_EQ (0, early);
+	auto lateness (alarm.lateness ());
+	// The operation due immediately is posted without entering the wheel
+	ASSERT_LT (0, lateness.count);
+	ASSERT_GE (total - 1, lateness.count);
+	io_ctx.stop ();
+	thread.join ();
+}
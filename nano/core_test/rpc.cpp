@@ -6,9 +6,11 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/thread.hpp>
 #include <nano/core_test/testutil.hpp>
+#include <nano/lib/json_writer.hpp>
 #include <nano/lib/jsonconfig.hpp>
 #include <nano/node/common.hpp>
 #include <nano/node/rpc.hpp>
+#include <nano/node/stats.hpp>
 #include <nano/node/testing.hpp>
 
 using namespace std::chrono_literals;
@@ -1644,6 +1646,9 @@ TEST (rpc_config, serialization)
 	config1.enable_control = true;
 	config1.frontier_request_limit = 8192;
 	config1.chain_request_limit = 4096;
+	config1.keep_alive_timeout = std::chrono::seconds (5);
+	config1.max_requests_per_connection = 10;
+	config1.max_idle_connections = 4;
 	nano::jsonconfig tree;
 	config1.serialize_json (tree);
 	nano::rpc_config config2;
@@ -1652,12 +1657,98 @@ TEST (rpc_config, serialization)
 	ASSERT_NE (config2.enable_control, config1.enable_control);
 	ASSERT_NE (config2.frontier_request_limit, config1.frontier_request_limit);
 	ASSERT_NE (config2.chain_request_limit, config1.chain_request_limit);
+	ASSERT_NE (config2.keep_alive_timeout, config1.keep_alive_timeout);
+	ASSERT_NE (config2.max_requests_per_connection, config1.max_requests_per_connection);
+	ASSERT_NE (config2.max_idle_connections, config1.max_idle_connections);
 	config2.deserialize_json (tree);
 	ASSERT_EQ (config2.address, config1.address);
 	ASSERT_EQ (config2.port, config1.port);
 	ASSERT_EQ (config2.enable_control, config1.enable_control);
 	ASSERT_EQ (config2.frontier_request_limit, config1.frontier_request_limit);
 	ASSERT_EQ (config2.chain_request_limit, config1.chain_request_limit);
+	ASSERT_EQ (config2.keep_alive_timeout, config1.keep_alive_timeout);
+	ASSERT_EQ (config2.max_requests_per_connection, config1.max_requests_per_connection);
+	ASSERT_EQ (config2.max_idle_connections, config1.max_idle_connections);
+}
+
+TEST (rpc, keep_alive_pipelining)
+{
+	nano::system system (24000, 1);
+	nano::rpc_config config (true);
+	config.max_requests_per_connection = 3;
+	nano::rpc rpc (system.io_ctx, *system.nodes[0], config);
+	rpc.start ();
+	std::atomic<bool> done (false);
+	std::vector<boost::beast::http::response<boost::beast::http::string_body>> responses;
+	boost::system::error_code read_error;
+	std::thread client ([&]() {
+		boost::asio::io_context io_ctx;
+		boost::asio::ip::tcp::socket sock (io_ctx);
+		sock.connect (nano::tcp_endpoint (boost::asio::ip::address_v6::loopback (), rpc.config.port));
+		// Send every request before reading any response
+		std::vector<std::string> actions{ "version", "block_count", "version", "block_count" };
+		for (auto & action : actions)
+		{
+			boost::beast::http::request<boost::beast::http::string_body> req;
+			req.method (boost::beast::http::verb::post);
+			req.target ("/");
+			req.version (11);
+			req.body () = "{\"action\": \"" + action + "\"}";
+			req.prepare_payload ();
+			boost::beast::http::write (sock, req);
+		}
+		boost::beast::flat_buffer buffer;
+		for (auto i (0); i < actions.size () && !read_error; ++i)
+		{
+			boost::beast::http::response<boost::beast::http::string_body> resp;
+			boost::beast::http::read (sock, buffer, resp, read_error);
+			if (!read_error)
+			{
+				responses.push_back (resp);
+			}
+		}
+		done = true;
+	});
+	system.deadline_set (10s);
+	while (!done)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	client.join ();
+	// The connection is closed after max_requests_per_connection, the remaining pipelined request is dropped
+	ASSERT_EQ (3, responses.size ());
+	ASSERT_TRUE (responses[0].keep_alive ());
+	ASSERT_TRUE (responses[1].keep_alive ());
+	ASSERT_FALSE (responses[2].keep_alive ());
+	boost::property_tree::ptree json;
+	std::vector<std::string> expected{ "rpc_version", "count", "rpc_version" };
+	for (auto i (0); i < responses.size (); ++i)
+	{
+		std::stringstream body (responses[i].body ());
+		boost::property_tree::read_json (body, json);
+		ASSERT_TRUE (json.get_optional<std::string> (expected[i]).is_initialized ());
+	}
+	ASSERT_NE (boost::system::errc::success, read_error.value ());
+}
+
+TEST (rpc, keep_alive_idle_limit)
+{
+	nano::system system (24000, 1);
+	nano::rpc_config config (true);
+	config.max_idle_connections = 0;
+	nano::rpc rpc (system.io_ctx, *system.nodes[0], config);
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "version");
+	test_response response (request, rpc, system.io_ctx);
+	system.deadline_set (5s);
+	while (response.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response.status);
+	ASSERT_FALSE (response.resp.keep_alive ());
+	ASSERT_TRUE (rpc.idle_connections.empty ());
 }
 
 TEST (rpc, search_pending)
@@ -1780,6 +1871,94 @@ TEST (rpc, work_cancel)
 	}
 }
 
+TEST (rpc, work_queue)
+{
+	nano::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	nano::rpc rpc (system.io_ctx, node1, nano::rpc_config (true));
+	rpc.start ();
+	nano::block_hash hash1 (1);
+	// High enough that it's still queued when the RPC runs
+	system.work.generate (hash1, [](boost::optional<uint64_t> const &) {}, 0xffffffffffff0000, nano::work_priority::background);
+	boost::property_tree::ptree request1;
+	request1.put ("action", "work_queue");
+	test_response response1 (request1, rpc, system.io_ctx);
+	system.deadline_set (5s);
+	while (response1.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response1.status);
+	auto & queue (response1.json.get_child ("queue"));
+	ASSERT_EQ (1, queue.size ());
+	auto & entry (queue.begin ()->second);
+	ASSERT_EQ (hash1.to_string (), entry.get<std::string> ("root"));
+	ASSERT_EQ ("background", entry.get<std::string> ("priority"));
+	ASSERT_EQ ("1", response1.json.get<std::string> ("background.depth"));
+	ASSERT_EQ ("0", response1.json.get<std::string> ("interactive.depth"));
+	system.work.cancel (hash1);
+}
+
+TEST (rpc, work_watch)
+{
+	nano::system system (24000, 1);
+	auto & node1 (*system.nodes[0]);
+	nano::keypair key;
+	nano::rpc rpc (system.io_ctx, node1, nano::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request1;
+	request1.put ("action", "work_watch_add");
+	request1.put ("account", key.pub.to_account ());
+	test_response response1 (request1, rpc, system.io_ctx);
+	system.deadline_set (5s);
+	while (response1.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response1.status);
+	system.deadline_set (10s);
+	while (!node1.work_cache.get (key.pub))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	// Served from the cache without generating
+	boost::property_tree::ptree request2;
+	request2.put ("action", "work_generate");
+	request2.put ("hash", key.pub.to_string ());
+	test_response response2 (request2, rpc, system.io_ctx);
+	system.deadline_set (5s);
+	while (response2.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response2.status);
+	ASSERT_EQ (nano::to_string_hex (*node1.work_cache.get (key.pub)), response2.json.get<std::string> ("work"));
+	boost::property_tree::ptree request3;
+	request3.put ("action", "work_watch_list");
+	test_response response3 (request3, rpc, system.io_ctx);
+	system.deadline_set (5s);
+	while (response3.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response3.status);
+	auto & accounts (response3.json.get_child ("accounts"));
+	ASSERT_EQ (1, accounts.size ());
+	ASSERT_EQ (key.pub.to_account (), accounts.begin ()->second.get<std::string> (""));
+	boost::property_tree::ptree request4;
+	request4.put ("action", "work_watch_remove");
+	request4.put ("account", key.pub.to_account ());
+	test_response response4 (request4, rpc, system.io_ctx);
+	system.deadline_set (5s);
+	while (response4.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response4.status);
+	ASSERT_TRUE (node1.work_cache.watched ().empty ());
+	ASSERT_FALSE (node1.work_cache.get (key.pub));
+}
+
 TEST (rpc, work_peer_bad)
 {
 	nano::system system (24000, 2);
@@ -1794,8 +1973,8 @@ TEST (rpc, work_peer_bad)
 	node2.config.work_peers.push_back (std::make_pair (boost::asio::ip::address_v6::any ().to_string (), 0));
 	nano::block_hash hash1 (1);
 	std::atomic<uint64_t> work (0);
-	node2.work_generate (hash1, [&work](uint64_t work_a) {
-		work = work_a;
+	node2.work_generate (hash1, [&work](boost::optional<uint64_t> const & work_a) {
+		work = *work_a;
 	});
 	system.deadline_set (5s);
 	while (nano::work_validate (hash1, work))
@@ -1818,8 +1997,8 @@ TEST (rpc, work_peer_one)
 	node2.config.work_peers.push_back (std::make_pair (node1.network.endpoint ().address ().to_string (), rpc.config.port));
 	nano::keypair key1;
 	uint64_t work (0);
-	node2.work_generate (key1.pub, [&work](uint64_t work_a) {
-		work = work_a;
+	node2.work_generate (key1.pub, [&work](boost::optional<uint64_t> const & work_a) {
+		work = *work_a;
 	});
 	system.deadline_set (5s);
 	while (nano::work_validate (key1.pub, work))
@@ -1859,8 +2038,8 @@ TEST (rpc, work_peer_many)
 	{
 		nano::keypair key1;
 		uint64_t work (0);
-		node1.work_generate (key1.pub, [&work](uint64_t work_a) {
-			work = work_a;
+		node1.work_generate (key1.pub, [&work](boost::optional<uint64_t> const & work_a) {
+			work = *work_a;
 		});
 		while (nano::work_validate (key1.pub, work))
 		{
@@ -2921,7 +3100,12 @@ TEST (rpc, work_get)
 {
 	nano::system system (24000, 1);
 	system.wallet (0)->insert_adhoc (nano::test_genesis_key.prv);
-	system.wallet (0)->work_cache_blocking (nano::test_genesis_key.pub, system.nodes[0]->latest (nano::test_genesis_key.pub));
+	// The node's work cache generates work for the wallet account and stores it in the wallet
+	system.deadline_set (10s);
+	while (!system.nodes[0]->work_cache.get (system.nodes[0]->latest (nano::test_genesis_key.pub)))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
 	nano::rpc rpc (system.io_ctx, *system.nodes[0], nano::rpc_config (true));
 	rpc.start ();
 	boost::property_tree::ptree request;
@@ -2946,7 +3130,12 @@ TEST (rpc, wallet_work_get)
 {
 	nano::system system (24000, 1);
 	system.wallet (0)->insert_adhoc (nano::test_genesis_key.prv);
-	system.wallet (0)->work_cache_blocking (nano::test_genesis_key.pub, system.nodes[0]->latest (nano::test_genesis_key.pub));
+	// The node's work cache generates work for the wallet account and stores it in the wallet
+	system.deadline_set (10s);
+	while (!system.nodes[0]->work_cache.get (system.nodes[0]->latest (nano::test_genesis_key.pub)))
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
 	nano::rpc rpc (system.io_ctx, *system.nodes[0], nano::rpc_config (true));
 	rpc.start ();
 	boost::property_tree::ptree request;
@@ -4150,3 +4339,126 @@ TEST (rpc, uptime)
 	ASSERT_EQ (200, response.status);
 	ASSERT_LE (1, response.json.get<int> ("seconds"));
 }
+
+TEST (json_writer, property_tree_format)
+{
+	std::string escaped ("a/b\"c\\d\n\t\x01 \xc3\xa9");
+	boost::property_tree::ptree tree;
+	boost::property_tree::ptree blocks;
+	boost::property_tree::ptree hashes;
+	boost::property_tree::ptree entry;
+	entry.put ("", "h1");
+	hashes.push_back (std::make_pair ("", entry));
+	hashes.push_back (std::make_pair ("", entry));
+	blocks.add_child ("hashes", hashes);
+	blocks.add_child ("empty", boost::property_tree::ptree ());
+	boost::property_tree::ptree object;
+	object.put ("amount", "1");
+	object.put ("escaped", escaped);
+	blocks.add_child ("object", object);
+	tree.add_child ("blocks", blocks);
+	tree.put ("key" + escaped, "value");
+	tree.add_child ("none", boost::property_tree::ptree ());
+	std::stringstream expected;
+	boost::property_tree::write_json (expected, tree);
+	std::string json;
+	nano::json_writer writer (json);
+	writer.begin_object ("blocks");
+	writer.begin_array ("hashes");
+	writer.push_back ("h1");
+	writer.push_back ("h1");
+	ASSERT_EQ (2, writer.size ());
+	writer.end ();
+	writer.begin_object ("empty");
+	writer.end ();
+	writer.begin_object ("object");
+	writer.put ("amount", "1");
+	writer.put ("escaped", escaped);
+	writer.end ();
+	writer.end ();
+	writer.put ("key" + escaped, "value");
+	writer.begin_array ("none");
+	writer.end ();
+	writer.end ();
+	ASSERT_EQ (expected.str (), json);
+	std::stringstream expected_empty;
+	boost::property_tree::write_json (expected_empty, boost::property_tree::ptree ());
+	std::string json_empty;
+	nano::json_writer writer_empty (json_empty);
+	writer_empty.end ();
+	ASSERT_EQ (expected_empty.str (), json_empty);
+}
+
+TEST (rpc, stats_histograms)
+{
+	nano::system system (24000, 1);
+	nano::rpc rpc (system.io_ctx, *system.nodes[0], nano::rpc_config (true));
+	rpc.start ();
+	boost::property_tree::ptree request;
+	request.put ("action", "block_count");
+	for (auto i (0); i < 2; ++i)
+	{
+		test_response response (request, rpc, system.io_ctx);
+		system.deadline_set (5s);
+		while (response.status == 0)
+		{
+			ASSERT_NO_ERROR (system.poll ());
+		}
+		ASSERT_EQ (200, response.status);
+	}
+	boost::property_tree::ptree request1;
+	request1.put ("action", "stats");
+	request1.put ("type", "histograms");
+	test_response response1 (request1, rpc, system.io_ctx);
+	system.deadline_set (5s);
+	while (response1.status == 0)
+	{
+		ASSERT_NO_ERROR (system.poll ());
+	}
+	ASSERT_EQ (200, response1.status);
+	ASSERT_EQ ("histograms", response1.json.get<std::string> ("type"));
+	auto found (false);
+	auto found_alarm (false);
+	for (auto & entry : response1.json.get_child ("entries"))
+	{
+		if (entry.second.get<std::string> ("detail") == "block_count")
+		{
+			found = true;
+			ASSERT_EQ ("rpc", entry.second.get<std::string> ("type"));
+			ASSERT_EQ (2, entry.second.get<uint64_t> ("count"));
+			ASSERT_LE (entry.second.get<uint64_t> ("p50"), entry.second.get<uint64_t> ("p99"));
+			ASSERT_LE (entry.second.get<uint64_t> ("p99"), entry.second.get<uint64_t> ("max"));
+		}
+		found_alarm = found_alarm || entry.second.get<std::string> ("type") == "alarm";
+	}
+	ASSERT_TRUE (found);
+	ASSERT_TRUE (found_alarm);
+}
+
+TEST (stat_histogram, percentiles)
+{
+	nano::stat_histogram histogram;
+	ASSERT_EQ (0, histogram.percentile (0.5));
+	for (uint64_t i (1); i <= 1000; ++i)
+	{
+		histogram.add (i);
+	}
+	ASSERT_EQ (1000, histogram.count);
+	ASSERT_EQ (1000, histogram.max);
+	// Buckets are at most 25% wide so every percentile is within that of the exact value
+	ASSERT_GE (histogram.percentile (0.5), 500);
+	ASSERT_LE (histogram.percentile (0.5), 625);
+	ASSERT_GE (histogram.percentile (0.99), 990);
+	ASSERT_EQ (1000, histogram.percentile (1.0));
+	std::vector<uint64_t> values{ 0, 3, 4, 7, 8, 100, uint64_t (1) << 40, std::numeric_limits<uint64_t>::max () };
+	for (auto value : values)
+	{
+		auto bucket (nano::stat_histogram::bucket_of (value));
+		ASSERT_LT (bucket, nano::stat_histogram::bucket_count);
+		ASSERT_GE (nano::stat_histogram::bucket_upper (bucket), value);
+		if (bucket > 0)
+		{
+			ASSERT_LT (nano::stat_histogram::bucket_upper (bucket - 1), value);
+		}
+	}
+}
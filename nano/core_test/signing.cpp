@@ -31,7 +31,7 @@ TEST (signature_checker, many)
 	signatures.reserve (size);
 	std::vector<int> verifications;
 	verifications.resize (size);
-	for (auto i (0); i < size; ++i)
+	for (size_t i (0); i < size; ++i)
 	{
 		hashes.push_back (block.hash ());
 		messages.push_back (hashes.back ().bytes.data ());
@@ -58,7 +58,7 @@ TEST (signature_checker, one)
 	std::vector<int> verifications;
 	size_t size (1);
 	verifications.resize (size);
-	for (auto i (0); i < size; ++i)
+	for (size_t i (0); i < size; ++i)
 	{
 		hashes.push_back (block.hash ());
 		messages.push_back (hashes.back ().bytes.data ());
@@ -70,3 +70,73 @@ TEST (signature_checker, one)
 	checker.add (check);
 	promise.get_future ().wait ();
 }
+
+TEST (signature_checker, multi_threaded_chunks)
+{
+	nano::keypair key;
+	nano::state_block block (key.pub, 0, key.pub, 0, 0, key.prv, key.pub, 0);
+	nano::signature_checker checker (4);
+	nano::signature invalid (block.signature);
+	invalid.bytes[31] ^= 1;
+	size_t size (nano::signature_checker::batch_size * 4 + 1);
+	std::vector<nano::uint256_union> hashes (size, block.hash ());
+	std::vector<unsigned char const *> messages;
+	std::vector<size_t> lengths (size, sizeof (decltype (hashes)::value_type));
+	std::vector<unsigned char const *> pub_keys;
+	std::vector<unsigned char const *> signatures;
+	std::vector<int> verifications (size, -1);
+	for (size_t i (0); i < size; ++i)
+	{
+		messages.push_back (hashes[i].bytes.data ());
+		pub_keys.push_back (block.hashables.account.bytes.data ());
+		// Place an invalid signature at the end of every chunk
+		signatures.push_back ((i % nano::signature_checker::batch_size == nano::signature_checker::batch_size - 1) ? invalid.bytes.data () : block.signature.bytes.data ());
+	}
+	std::promise<void> promise;
+	nano::signature_check_set check = { size, messages.data (), lengths.data (), pub_keys.data (), signatures.data (), verifications.data (), &promise };
+	checker.add (check);
+	promise.get_future ().wait ();
+	for (size_t i (0); i < size; ++i)
+	{
+		ASSERT_EQ ((i % nano::signature_checker::batch_size == nano::signature_checker::batch_size - 1) ? 0 : 1, verifications[i]);
+	}
+	checker.flush ();
+}
+
+TEST (signature_checker, no_threads)
+{
+	nano::keypair key;
+	nano::state_block block (key.pub, 0, key.pub, 0, 0, key.prv, key.pub, 0);
+	nano::signature_checker checker (0);
+	auto hash (block.hash ());
+	unsigned char const * message (hash.bytes.data ());
+	size_t length (sizeof (hash));
+	unsigned char const * pub_key (block.hashables.account.bytes.data ());
+	unsigned char const * signature (block.signature.bytes.data ());
+	int verification (-1);
+	std::promise<void> promise;
+	nano::signature_check_set check = { 1, &message, &length, &pub_key, &signature, &verification, &promise };
+	checker.add (check);
+	promise.get_future ().wait ();
+	ASSERT_EQ (1, verification);
+}
+
+TEST (signature_checker, stopped)
+{
+	nano::keypair key;
+	nano::state_block block (key.pub, 0, key.pub, 0, 0, key.prv, key.pub, 0);
+	nano::signature_checker checker (4);
+	checker.stop ();
+	auto hash (block.hash ());
+	unsigned char const * message (hash.bytes.data ());
+	size_t length (sizeof (hash));
+	unsigned char const * pub_key (block.hashables.account.bytes.data ());
+	unsigned char const * signature (block.signature.bytes.data ());
+	int verification (-1);
+	std::promise<void> promise;
+	nano::signature_check_set check = { 1, &message, &length, &pub_key, &signature, &verification, &promise };
+	// Checks added after stopping are verified on the caller instead of being left in the queue
+	checker.add (check);
+	promise.get_future ().wait ();
+	ASSERT_EQ (1, verification);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <nano/node/testing.hpp>
 #include <nano/secure/blockstore.hpp>
 #include <nano/secure/versioning.hpp>
 
@@ -21,6 +22,7 @@ TEST (versioning, account_info_v1)
 		auto status (mdb_put (store.env.tx (transaction), store.accounts_v0, nano::mdb_val (account), v1.val (), 0));
 		ASSERT_EQ (0, status);
 		store.version_put (transaction, 1);
+		nano::store_downgrade::block_tables_split (store, transaction);
 	}
 	{
 		nano::logging logging;
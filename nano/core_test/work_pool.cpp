@@ -26,6 +26,110 @@ TEST (work, validate)
 	ASSERT_LT (nano::work_pool::publish_threshold, difficulty);
 }
 
+TEST (work, hashers)
+{
+	auto & hashers (nano::work_hashers ());
+	ASSERT_FALSE (hashers.empty ());
+	ASSERT_EQ (1, hashers.back ().lanes);
+	nano::block_hash root;
+	std::array<uint64_t, nano::work_hasher::lanes_max> works;
+	std::array<uint64_t, nano::work_hasher::lanes_max> outputs;
+	for (auto i (0); i < 100; ++i)
+	{
+		nano::random_pool.GenerateBlock (root.bytes.data (), root.bytes.size ());
+		nano::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (works.data ()), works.size () * sizeof (works[0]));
+		for (auto & hasher : hashers)
+		{
+			ASSERT_LE (hasher.lanes, nano::work_hasher::lanes_max);
+			hasher.hash (root.bytes.data (), works.data (), outputs.data ());
+			for (size_t j (0); j < hasher.lanes; ++j)
+			{
+				ASSERT_EQ (nano::work_value (root, works[j]), outputs[j]) << hasher.name;
+			}
+			std::array<nano::block_hash, nano::work_hasher::lanes_max> roots;
+			nano::random_pool.GenerateBlock (roots[0].bytes.data (), roots.size () * sizeof (roots[0]));
+			hasher.hash_roots (roots[0].bytes.data (), works.data (), outputs.data ());
+			for (size_t j (0); j < hasher.lanes; ++j)
+			{
+				ASSERT_EQ (nano::work_value (roots[j], works[j]), outputs[j]) << hasher.name;
+			}
+		}
+	}
+}
+
+TEST (work, validate_batch)
+{
+	nano::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	// Odd count so the last chunk has to be padded for every hasher
+	std::vector<nano::block_hash> roots (19);
+	std::vector<uint64_t> works (roots.size ());
+	for (size_t i (0); i < roots.size (); ++i)
+	{
+		roots[i] = nano::block_hash (i + 1);
+		works[i] = i % 3 == 0 ? pool.generate (roots[i]) : 0;
+	}
+	std::unique_ptr<bool[]> errors (new bool[roots.size ()]);
+	nano::work_validate_batch (roots.data (), works.data (), roots.size (), errors.get ());
+	for (size_t i (0); i < roots.size (); ++i)
+	{
+		ASSERT_EQ (nano::work_validate (roots[i], works[i]), errors[i]);
+	}
+	ASSERT_FALSE (errors[0]);
+	ASSERT_FALSE (errors[18]);
+}
+
+TEST (work, priority_order)
+{
+	nano::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	// High enough that nothing is solved while the queue is inspected
+	uint64_t difficulty (0xffffffffffff0000);
+	auto now (std::chrono::steady_clock::now ());
+	std::atomic<unsigned> cancelled (0);
+	auto callback ([&cancelled](boost::optional<uint64_t> const & work_a) {
+		if (!work_a)
+		{
+			++cancelled;
+		}
+	});
+	pool.generate (1, callback, difficulty, nano::work_priority::background);
+	pool.generate (2, callback, difficulty, nano::work_priority::interactive, now + std::chrono::seconds (10));
+	pool.generate (3, callback, difficulty, nano::work_priority::interactive, now);
+	{
+		std::lock_guard<std::mutex> lock (pool.mutex);
+		std::vector<nano::uint256_union> order;
+		for (auto & item : pool.pending.get<0> ())
+		{
+			order.push_back (item->item);
+		}
+		ASSERT_EQ (3, order.size ());
+		ASSERT_EQ (nano::uint256_union (3), order[0]);
+		ASSERT_EQ (nano::uint256_union (2), order[1]);
+		ASSERT_EQ (nano::uint256_union (1), order[2]);
+	}
+	pool.cancel (1);
+	pool.cancel (2);
+	pool.cancel (3);
+	ASSERT_EQ (3, cancelled);
+	ASSERT_EQ (0, pool.size ());
+	std::lock_guard<std::mutex> lock (pool.mutex);
+	ASSERT_EQ (2, pool.metrics[static_cast<size_t> (nano::work_priority::interactive)].cancelled);
+	ASSERT_EQ (1, pool.metrics[static_cast<size_t> (nano::work_priority::background)].cancelled);
+}
+
+TEST (work, metrics)
+{
+	nano::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
+	pool.generate (nano::uint256_union (1));
+	pool.generate (nano::uint256_union (2), nano::work_pool::publish_threshold, nano::work_priority::background);
+	std::lock_guard<std::mutex> lock (pool.mutex);
+	auto & interactive (pool.metrics[static_cast<size_t> (nano::work_priority::interactive)]);
+	auto & background (pool.metrics[static_cast<size_t> (nano::work_priority::background)]);
+	ASSERT_EQ (1, interactive.solved);
+	ASSERT_EQ (1, background.solved);
+	ASSERT_LE (interactive.max.count (), interactive.total.count ());
+	ASSERT_TRUE (pool.pending.empty ());
+}
+
 TEST (work, cancel)
 {
 	nano::work_pool pool (std::numeric_limits<unsigned>::max (), nullptr);
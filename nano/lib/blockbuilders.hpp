@@ -52,6 +52,8 @@ public:
 			static_cast<BUILDER *> (this)->validate ();
 		}
 		assert (!ec);
+		// Fields may have changed after sign () hashed the block
+		block->hash_invalidate ();
 		return std::move (block);
 	}
 
@@ -63,6 +65,7 @@ public:
 			static_cast<BUILDER *> (this)->validate ();
 		}
 		ec = this->ec;
+		block->hash_invalidate ();
 		return std::move (block);
 	}
 
@@ -77,6 +80,7 @@ public:
 	/** Sign the block using the \p private_key and \p public_key */
 	inline abstract_builder & sign (nano::raw_key const & private_key, nano::public_key const & public_key)
 	{
+		block->hash_invalidate ();
 		block->signature = nano::sign_message (private_key, public_key, block->hash ());
 		build_state |= build_flags::signature_present;
 		return *this;
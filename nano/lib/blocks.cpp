@@ -91,29 +91,80 @@ size_t nano::block::size (nano::block_type type_a)
 nano::block_hash nano::block::hash () const
 {
 	nano::uint256_union result;
-	blake2b_state hash_l;
-	auto status (blake2b_init (&hash_l, sizeof (result.bytes)));
-	assert (status == 0);
-	hash (hash_l);
-	status = blake2b_final (&hash_l, result.bytes.data (), sizeof (result.bytes));
-	assert (status == 0);
+	if (hash_cache.get (result))
+	{
+		blake2b_state hash_l;
+		auto status (blake2b_init (&hash_l, sizeof (result.bytes)));
+		assert (status == 0);
+		hash (hash_l);
+		status = blake2b_final (&hash_l, result.bytes.data (), sizeof (result.bytes));
+		assert (status == 0);
+		hash_cache.set (result);
+	}
 	return result;
 }
 
 nano::block_hash nano::block::full_hash () const
 {
 	nano::block_hash result;
-	blake2b_state state;
-	blake2b_init (&state, sizeof (result.bytes));
-	blake2b_update (&state, hash ().bytes.data (), sizeof (hash ()));
-	auto signature (block_signature ());
-	blake2b_update (&state, signature.bytes.data (), sizeof (signature));
-	auto work (block_work ());
-	blake2b_update (&state, &work, sizeof (work));
-	blake2b_final (&state, result.bytes.data (), sizeof (result.bytes));
+	if (full_hash_cache.get (result))
+	{
+		auto hash_l (hash ());
+		blake2b_state state;
+		blake2b_init (&state, sizeof (result.bytes));
+		blake2b_update (&state, hash_l.bytes.data (), sizeof (hash_l));
+		auto signature (block_signature ());
+		blake2b_update (&state, signature.bytes.data (), sizeof (signature));
+		auto work (block_work ());
+		blake2b_update (&state, &work, sizeof (work));
+		blake2b_final (&state, result.bytes.data (), sizeof (result.bytes));
+		full_hash_cache.set (result);
+	}
+	return result;
+}
+
+void nano::block::hash_invalidate ()
+{
+	hash_cache.clear ();
+	full_hash_cache.clear ();
+}
+
+nano::cached_hash::cached_hash (nano::cached_hash const &)
+{
+}
+
+nano::cached_hash & nano::cached_hash::operator= (nano::cached_hash const &)
+{
+	clear ();
+	return *this;
+}
+
+bool nano::cached_hash::get (nano::block_hash & hash_a) const
+{
+	auto result (state.load (std::memory_order_acquire) != ready);
+	if (!result)
+	{
+		hash_a = value;
+	}
 	return result;
 }
 
+void nano::cached_hash::set (nano::block_hash const & hash_a) const
+{
+	// Readers racing to fill the cache computed the same digest, only the first one stores it
+	uint8_t expected (empty);
+	if (state.compare_exchange_strong (expected, filling, std::memory_order_acquire))
+	{
+		value = hash_a;
+		state.store (ready, std::memory_order_release);
+	}
+}
+
+void nano::cached_hash::clear ()
+{
+	state.store (empty, std::memory_order_release);
+}
+
 nano::account nano::block::representative () const
 {
 	return 0;
@@ -151,6 +202,7 @@ uint64_t nano::send_block::block_work () const
 
 void nano::send_block::block_work_set (uint64_t work_a)
 {
+	full_hash_cache.clear ();
 	work = work_a;
 }
 
@@ -238,6 +290,7 @@ void nano::send_block::serialize_json (std::string & string_a) const
 
 bool nano::send_block::deserialize (nano::stream & stream_a)
 {
+	hash_invalidate ();
 	auto error (false);
 	error = read (stream_a, hashables.previous.bytes);
 	if (!error)
@@ -261,6 +314,7 @@ bool nano::send_block::deserialize (nano::stream & stream_a)
 
 bool nano::send_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	hash_invalidate ();
 	auto error (false);
 	try
 	{
@@ -388,6 +442,7 @@ nano::signature nano::send_block::block_signature () const
 
 void nano::send_block::signature_set (nano::uint512_union const & signature_a)
 {
+	full_hash_cache.clear ();
 	signature = signature_a;
 }
 
@@ -503,6 +558,7 @@ uint64_t nano::open_block::block_work () const
 
 void nano::open_block::block_work_set (uint64_t work_a)
 {
+	full_hash_cache.clear ();
 	work = work_a;
 }
 
@@ -544,6 +600,7 @@ void nano::open_block::serialize_json (std::string & string_a) const
 
 bool nano::open_block::deserialize (nano::stream & stream_a)
 {
+	hash_invalidate ();
 	auto error (read (stream_a, hashables.source));
 	if (!error)
 	{
@@ -566,6 +623,7 @@ bool nano::open_block::deserialize (nano::stream & stream_a)
 
 bool nano::open_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	hash_invalidate ();
 	auto error (false);
 	try
 	{
@@ -647,6 +705,7 @@ nano::signature nano::open_block::block_signature () const
 
 void nano::open_block::signature_set (nano::uint512_union const & signature_a)
 {
+	full_hash_cache.clear ();
 	signature = signature_a;
 }
 
@@ -743,6 +802,7 @@ uint64_t nano::change_block::block_work () const
 
 void nano::change_block::block_work_set (uint64_t work_a)
 {
+	full_hash_cache.clear ();
 	work = work_a;
 }
 
@@ -776,6 +836,7 @@ void nano::change_block::serialize_json (std::string & string_a) const
 
 bool nano::change_block::deserialize (nano::stream & stream_a)
 {
+	hash_invalidate ();
 	auto error (read (stream_a, hashables.previous));
 	if (!error)
 	{
@@ -794,6 +855,7 @@ bool nano::change_block::deserialize (nano::stream & stream_a)
 
 bool nano::change_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	hash_invalidate ();
 	auto error (false);
 	try
 	{
@@ -878,6 +940,7 @@ nano::signature nano::change_block::block_signature () const
 
 void nano::change_block::signature_set (nano::uint512_union const & signature_a)
 {
+	full_hash_cache.clear ();
 	signature = signature_a;
 }
 
@@ -1015,6 +1078,7 @@ uint64_t nano::state_block::block_work () const
 
 void nano::state_block::block_work_set (uint64_t work_a)
 {
+	full_hash_cache.clear ();
 	work = work_a;
 }
 
@@ -1060,6 +1124,7 @@ void nano::state_block::serialize_json (std::string & string_a) const
 
 bool nano::state_block::deserialize (nano::stream & stream_a)
 {
+	hash_invalidate ();
 	auto error (read (stream_a, hashables.account));
 	if (!error)
 	{
@@ -1091,6 +1156,7 @@ bool nano::state_block::deserialize (nano::stream & stream_a)
 
 bool nano::state_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	hash_invalidate ();
 	auto error (false);
 	try
 	{
@@ -1182,6 +1248,7 @@ nano::signature nano::state_block::block_signature () const
 
 void nano::state_block::signature_set (nano::uint512_union const & signature_a)
 {
+	full_hash_cache.clear ();
 	signature = signature_a;
 }
 
@@ -1338,6 +1405,7 @@ bool nano::receive_block::operator== (nano::receive_block const & other_a) const
 
 bool nano::receive_block::deserialize (nano::stream & stream_a)
 {
+	hash_invalidate ();
 	auto error (false);
 	error = read (stream_a, hashables.previous.bytes);
 	if (!error)
@@ -1357,6 +1425,7 @@ bool nano::receive_block::deserialize (nano::stream & stream_a)
 
 bool nano::receive_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
+	hash_invalidate ();
 	auto error (false);
 	try
 	{
@@ -1467,6 +1536,7 @@ uint64_t nano::receive_block::block_work () const
 
 void nano::receive_block::block_work_set (uint64_t work_a)
 {
+	full_hash_cache.clear ();
 	work = work_a;
 }
 
@@ -1515,6 +1585,7 @@ nano::signature nano::receive_block::block_signature () const
 
 void nano::receive_block::signature_set (nano::uint512_union const & signature_a)
 {
+	full_hash_cache.clear ();
 	signature = signature_a;
 }
 
@@ -1561,49 +1632,3 @@ void nano::receive_hashables::hash (blake2b_state & hash_a) const
 	blake2b_update (&hash_a, previous.bytes.data (), sizeof (previous.bytes));
 	blake2b_update (&hash_a, source.bytes.data (), sizeof (source.bytes));
 }
-
-std::shared_ptr<nano::block> nano::block_uniquer::unique (std::shared_ptr<nano::block> block_a)
-{
-	auto result (block_a);
-	if (result != nullptr)
-	{
-		nano::uint256_union key (block_a->full_hash ());
-		std::lock_guard<std::mutex> lock (mutex);
-		auto & existing (blocks[key]);
-		if (auto block_l = existing.lock ())
-		{
-			result = block_l;
-		}
-		else
-		{
-			existing = block_a;
-		}
-		for (auto i (0); i < cleanup_count && blocks.size () > 0; ++i)
-		{
-			auto random_offset (nano::random_pool.GenerateWord32 (0, blocks.size () - 1));
-			auto existing (std::next (blocks.begin (), random_offset));
-			if (existing == blocks.end ())
-			{
-				existing = blocks.begin ();
-			}
-			if (existing != blocks.end ())
-			{
-				if (auto block_l = existing->second.lock ())
-				{
-					// Still live
-				}
-				else
-				{
-					blocks.erase (existing);
-				}
-			}
-		}
-	}
-	return result;
-}
-
-size_t nano::block_uniquer::size ()
-{
-	std::lock_guard<std::mutex> lock (mutex);
-	return blocks.size ();
-}
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <nano/lib/numbers.hpp>
+#include <nano/lib/uniquer.hpp>
 
 #include <boost/property_tree/json_parser.hpp>
+#include <atomic>
 #include <cassert>
 #include <crypto/blake2/blake2.h>
 #include <streambuf>
@@ -30,6 +32,28 @@ void write (nano::stream & stream_a, T const & value)
 	assert (amount_written == sizeof (value));
 }
 class block_visitor;
+/**
+ * Digest computed on first use, safe to fill from concurrent readers.
+ * Copies start out empty so a copied block that's then modified can't carry a stale digest.
+ */
+class cached_hash
+{
+public:
+	cached_hash () = default;
+	cached_hash (nano::cached_hash const &);
+	nano::cached_hash & operator= (nano::cached_hash const &);
+	// Returns true if nothing is cached
+	bool get (nano::block_hash &) const;
+	void set (nano::block_hash const &) const;
+	void clear ();
+
+private:
+	static uint8_t constexpr empty = 0;
+	static uint8_t constexpr filling = 1;
+	static uint8_t constexpr ready = 2;
+	mutable std::atomic<uint8_t> state{ empty };
+	mutable nano::block_hash value;
+};
 enum class block_type : uint8_t
 {
 	invalid = 0,
@@ -47,6 +71,8 @@ public:
 	nano::block_hash hash () const;
 	// Return a digest of hashables and non-hashables in this block.
 	nano::block_hash full_hash () const;
+	// Drop cached digests, needed after writing hashables directly rather than through setters or deserialize
+	void hash_invalidate ();
 	std::string to_json () const;
 	virtual void hash (blake2b_state &) const = 0;
 	virtual uint64_t block_work () const = 0;
@@ -71,6 +97,10 @@ public:
 	virtual ~block () = default;
 	virtual bool valid_predecessor (nano::block const &) const = 0;
 	static size_t size (nano::block_type);
+
+protected:
+	nano::cached_hash hash_cache;
+	nano::cached_hash full_hash_cache;
 };
 class send_hashables
 {
@@ -319,17 +349,7 @@ public:
 /**
  * This class serves to find and return unique variants of a block in order to minimize memory usage
  */
-class block_uniquer
-{
-public:
-	std::shared_ptr<nano::block> unique (std::shared_ptr<nano::block>);
-	size_t size ();
-
-private:
-	std::mutex mutex;
-	std::unordered_map<nano::uint256_union, std::weak_ptr<nano::block>> blocks;
-	static unsigned constexpr cleanup_count = 2;
-};
+using block_uniquer = nano::uniquer<nano::block>;
 std::shared_ptr<nano::block> deserialize_block (nano::stream &, nano::block_uniquer * = nullptr);
 std::shared_ptr<nano::block> deserialize_block (nano::stream &, nano::block_type, nano::block_uniquer * = nullptr);
 std::shared_ptr<nano::block> deserialize_block_json (boost::property_tree::ptree const &, nano::block_uniquer * = nullptr);
@@ -0,0 +1,159 @@
+#include <nano/lib/json_writer.hpp>
+
+#include <cassert>
+
+nano::json_writer::json_writer (std::string & out_a) :
+out (out_a)
+{
+	out.push_back ('{');
+	levels.push_back ({ false, 0 });
+}
+
+void nano::json_writer::begin_object (std::string const & key_a)
+{
+	assert (!levels.empty () && !levels.back ().array);
+	child (&key_a);
+	levels.push_back ({ false, 0 });
+}
+
+void nano::json_writer::begin_object ()
+{
+	assert (!levels.empty () && levels.back ().array);
+	child (nullptr);
+	levels.push_back ({ false, 0 });
+}
+
+void nano::json_writer::begin_array (std::string const & key_a)
+{
+	assert (!levels.empty () && !levels.back ().array);
+	child (&key_a);
+	levels.push_back ({ true, 0 });
+}
+
+void nano::json_writer::end ()
+{
+	assert (!levels.empty ());
+	auto level_l (levels.back ());
+	levels.pop_back ();
+	if (level_l.children > 0)
+	{
+		out.push_back ('\n');
+		indent (levels.size ());
+		out.push_back (level_l.array ? ']' : '}');
+	}
+	else if (!levels.empty ())
+	{
+		// property_tree can't tell an empty object or array from an empty value
+		out.append ("\"\"");
+	}
+	else
+	{
+		out.append ("\n}");
+	}
+	if (levels.empty ())
+	{
+		out.push_back ('\n');
+	}
+}
+
+void nano::json_writer::put (std::string const & key_a, std::string const & value_a)
+{
+	assert (!levels.empty () && !levels.back ().array);
+	child (&key_a);
+	out.push_back ('"');
+	escape (out, value_a);
+	out.push_back ('"');
+}
+
+void nano::json_writer::push_back (std::string const & value_a)
+{
+	assert (!levels.empty () && levels.back ().array);
+	child (nullptr);
+	out.push_back ('"');
+	escape (out, value_a);
+	out.push_back ('"');
+}
+
+size_t nano::json_writer::size () const
+{
+	assert (!levels.empty ());
+	return levels.back ().children;
+}
+
+void nano::json_writer::child (std::string const * key_a)
+{
+	auto & level_l (levels.back ());
+	if (level_l.children == 0)
+	{
+		// Opening brackets of nested levels are deferred until their first child so empty levels can be written as ""
+		if (levels.size () > 1)
+		{
+			out.push_back (level_l.array ? '[' : '{');
+		}
+		out.push_back ('\n');
+	}
+	else
+	{
+		out.append (",\n");
+	}
+	++level_l.children;
+	indent (levels.size ());
+	if (key_a != nullptr)
+	{
+		out.push_back ('"');
+		escape (out, *key_a);
+		out.append ("\": ");
+	}
+}
+
+void nano::json_writer::indent (size_t depth_a)
+{
+	out.append (4 * depth_a, ' ');
+}
+
+void nano::json_writer::escape (std::string & out_a, std::string const & value_a)
+{
+	static char const * hexdigits ("0123456789ABCDEF");
+	for (auto i : value_a)
+	{
+		auto c (static_cast<unsigned char> (i));
+		if (c == 0x20 || c == 0x21 || (c >= 0x23 && c <= 0x2e) || (c >= 0x30 && c <= 0x5b) || c >= 0x5d)
+		{
+			out_a.push_back (i);
+		}
+		else
+		{
+			out_a.push_back ('\\');
+			switch (i)
+			{
+				case '\b':
+					out_a.push_back ('b');
+					break;
+				case '\f':
+					out_a.push_back ('f');
+					break;
+				case '\n':
+					out_a.push_back ('n');
+					break;
+				case '\r':
+					out_a.push_back ('r');
+					break;
+				case '\t':
+					out_a.push_back ('t');
+					break;
+				case '/':
+				case '"':
+				case '\\':
+					out_a.push_back (i);
+					break;
+				default:
+					out_a.push_back ('u');
+					out_a.push_back ('0');
+					out_a.push_back ('0');
+					out_a.push_back (hexdigits[c >> 4]);
+					out_a.push_back (hexdigits[c & 0xf]);
+					break;
+			}
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace nano
+{
+/**
+ * Writes JSON text directly into a string without building a boost::property_tree first.
+ * The output is identical to boost::property_tree::write_json with pretty printing: every value is a string,
+ * children are indented by four spaces and objects or arrays left without children are written as "".
+ * The root object is opened on construction and closed by the matching end ().
+ */
+class json_writer
+{
+public:
+	json_writer (std::string &);
+	/** Opens an object as the value of key_a in the current object */
+	void begin_object (std::string const & key_a);
+	/** Opens an object as the next element of the current array */
+	void begin_object ();
+	/** Opens an array as the value of key_a in the current object */
+	void begin_array (std::string const & key_a);
+	/** Closes the innermost open object or array */
+	void end ();
+	/** Writes key_a with value_a in the current object */
+	void put (std::string const & key_a, std::string const & value_a);
+	/** Writes value_a as the next element of the current array */
+	void push_back (std::string const & value_a);
+	/** Number of children written to the innermost open object or array */
+	size_t size () const;
+	/** Escapes a string the way property_tree does, which includes escaping '/' and non-printable characters */
+	static void escape (std::string &, std::string const &);
+
+private:
+	class level
+	{
+	public:
+		bool array;
+		size_t children;
+	};
+	void child (std::string const * key_a);
+	void indent (size_t);
+	std::string & out;
+	std::vector<level> levels;
+};
+}
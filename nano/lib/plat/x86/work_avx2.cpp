@@ -0,0 +1,61 @@
+#include <nano/lib/plat/x86/work_lanes.hpp>
+
+#include <immintrin.h>
+
+namespace
+{
+class avx2
+{
+public:
+	using vector = __m256i;
+	static vector load (uint64_t const * a)
+	{
+		return _mm256_loadu_si256 (reinterpret_cast<__m256i const *> (a));
+	}
+	static void store (uint64_t * a, vector v)
+	{
+		_mm256_storeu_si256 (reinterpret_cast<__m256i *> (a), v);
+	}
+	static vector set1 (uint64_t a)
+	{
+		return _mm256_set1_epi64x (static_cast<long long> (a));
+	}
+	static vector add (vector a, vector b)
+	{
+		return _mm256_add_epi64 (a, b);
+	}
+	static vector bit_xor (vector a, vector b)
+	{
+		return _mm256_xor_si256 (a, b);
+	}
+	static vector rotr32 (vector a)
+	{
+		return _mm256_shuffle_epi32 (a, _MM_SHUFFLE (2, 3, 0, 1));
+	}
+	static vector rotr24 (vector a)
+	{
+		return _mm256_shuffle_epi8 (a, _mm256_setr_epi8 (3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10));
+	}
+	static vector rotr16 (vector a)
+	{
+		return _mm256_shuffle_epi8 (a, _mm256_setr_epi8 (2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9));
+	}
+	static vector rotr63 (vector a)
+	{
+		return _mm256_xor_si256 (_mm256_srli_epi64 (a, 63), _mm256_add_epi64 (a, a));
+	}
+};
+}
+
+namespace nano
+{
+void work_hash_avx2 (uint8_t const * root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	work_lanes_hash<avx2> (root_a, nonces_a, values_a);
+}
+
+void work_hash_roots_avx2 (uint8_t const * roots_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	work_lanes_hash_roots<avx2> (roots_a, nonces_a, values_a);
+}
+}
@@ -0,0 +1,61 @@
+#include <nano/lib/plat/x86/work_lanes.hpp>
+
+#include <immintrin.h>
+
+namespace
+{
+class avx512
+{
+public:
+	using vector = __m512i;
+	static vector load (uint64_t const * a)
+	{
+		return _mm512_loadu_si512 (a);
+	}
+	static void store (uint64_t * a, vector v)
+	{
+		_mm512_storeu_si512 (a, v);
+	}
+	static vector set1 (uint64_t a)
+	{
+		return _mm512_set1_epi64 (static_cast<long long> (a));
+	}
+	static vector add (vector a, vector b)
+	{
+		return _mm512_add_epi64 (a, b);
+	}
+	static vector bit_xor (vector a, vector b)
+	{
+		return _mm512_xor_si512 (a, b);
+	}
+	static vector rotr32 (vector a)
+	{
+		return _mm512_ror_epi64 (a, 32);
+	}
+	static vector rotr24 (vector a)
+	{
+		return _mm512_ror_epi64 (a, 24);
+	}
+	static vector rotr16 (vector a)
+	{
+		return _mm512_ror_epi64 (a, 16);
+	}
+	static vector rotr63 (vector a)
+	{
+		return _mm512_ror_epi64 (a, 63);
+	}
+};
+}
+
+namespace nano
+{
+void work_hash_avx512 (uint8_t const * root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	work_lanes_hash<avx512> (root_a, nonces_a, values_a);
+}
+
+void work_hash_roots_avx512 (uint8_t const * roots_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	work_lanes_hash_roots<avx512> (roots_a, nonces_a, values_a);
+}
+}
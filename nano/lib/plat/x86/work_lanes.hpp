@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Blake2b specialized for work values: a single 40 byte block made of an 8 byte nonce followed by a 32 byte root, hashed to an 8 byte digest.
+ * Each SIMD lane hashes a different nonce. V supplies the vector type and operations for one instruction set.
+ * Everything is in an anonymous namespace so each translation unit keeps its own copy compiled for its own instruction set,
+ * otherwise the linker could pick e.g. the AVX2 instantiation for code running on a CPU without it.
+ */
+namespace
+{
+uint64_t const work_lanes_iv[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+uint8_t const work_lanes_sigma[12][16] = {
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+	{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+	{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+	{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+	{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+	{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+	{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+	{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+	{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
+template <typename V>
+inline void work_lanes_g (typename V::vector * v_a, size_t a, size_t b, size_t c, size_t d, typename V::vector const & x, typename V::vector const & y)
+{
+	v_a[a] = V::add (V::add (v_a[a], v_a[b]), x);
+	v_a[d] = V::rotr32 (V::bit_xor (v_a[d], v_a[a]));
+	v_a[c] = V::add (v_a[c], v_a[d]);
+	v_a[b] = V::rotr24 (V::bit_xor (v_a[b], v_a[c]));
+	v_a[a] = V::add (V::add (v_a[a], v_a[b]), y);
+	v_a[d] = V::rotr16 (V::bit_xor (v_a[d], v_a[a]));
+	v_a[c] = V::add (v_a[c], v_a[d]);
+	v_a[b] = V::rotr63 (V::bit_xor (v_a[b], v_a[c]));
+}
+
+template <typename V>
+inline void work_lanes_compress (typename V::vector const * root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	using vector = typename V::vector;
+	// Parameter block for an unkeyed 8 byte digest: digest length 8, fanout 1, depth 1
+	auto h0 (work_lanes_iv[0] ^ 0x01010008ULL);
+	vector m[16];
+	m[0] = V::load (nonces_a);
+	for (size_t i (0); i < 4; ++i)
+	{
+		m[i + 1] = root_a[i];
+	}
+	for (size_t i (5); i < 16; ++i)
+	{
+		m[i] = V::set1 (0);
+	}
+	vector v[16];
+	v[0] = V::set1 (h0);
+	for (size_t i (1); i < 8; ++i)
+	{
+		v[i] = V::set1 (work_lanes_iv[i]);
+	}
+	for (size_t i (0); i < 8; ++i)
+	{
+		v[i + 8] = V::set1 (work_lanes_iv[i]);
+	}
+	// 40 bytes hashed and this is the final block
+	v[12] = V::set1 (work_lanes_iv[4] ^ 40);
+	v[14] = V::set1 (~work_lanes_iv[6]);
+	for (size_t round (0); round < 12; ++round)
+	{
+		auto s (work_lanes_sigma[round]);
+		work_lanes_g<V> (v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+		work_lanes_g<V> (v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+		work_lanes_g<V> (v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+		work_lanes_g<V> (v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+		work_lanes_g<V> (v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+		work_lanes_g<V> (v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+		work_lanes_g<V> (v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+		work_lanes_g<V> (v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+	}
+	// Only the first word of the state is needed for an 8 byte digest
+	V::store (values_a, V::bit_xor (V::bit_xor (V::set1 (h0), v[0]), v[8]));
+}
+
+// One root shared by every lane, used when generating
+template <typename V>
+inline void work_lanes_hash (uint8_t const * root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	typename V::vector root[4];
+	for (size_t i (0); i < 4; ++i)
+	{
+		uint64_t word;
+		std::memcpy (&word, root_a + i * sizeof (word), sizeof (word));
+		root[i] = V::set1 (word);
+	}
+	work_lanes_compress<V> (root, nonces_a, values_a);
+}
+
+// A different 32 byte root per lane, stored one after another, used when validating
+template <typename V>
+inline void work_lanes_hash_roots (uint8_t const * roots_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	size_t constexpr lanes (sizeof (typename V::vector) / sizeof (uint64_t));
+	// Transpose so word i of every lane's root is contiguous
+	uint64_t words[4][lanes];
+	for (size_t lane (0); lane < lanes; ++lane)
+	{
+		for (size_t i (0); i < 4; ++i)
+		{
+			std::memcpy (&words[i][lane], roots_a + lane * 32 + i * sizeof (uint64_t), sizeof (uint64_t));
+		}
+	}
+	typename V::vector root[4];
+	for (size_t i (0); i < 4; ++i)
+	{
+		root[i] = V::load (words[i]);
+	}
+	work_lanes_compress<V> (root, nonces_a, values_a);
+}
+}
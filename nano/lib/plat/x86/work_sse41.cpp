@@ -0,0 +1,61 @@
+#include <nano/lib/plat/x86/work_lanes.hpp>
+
+#include <immintrin.h>
+
+namespace
+{
+class sse41
+{
+public:
+	using vector = __m128i;
+	static vector load (uint64_t const * a)
+	{
+		return _mm_loadu_si128 (reinterpret_cast<__m128i const *> (a));
+	}
+	static void store (uint64_t * a, vector v)
+	{
+		_mm_storeu_si128 (reinterpret_cast<__m128i *> (a), v);
+	}
+	static vector set1 (uint64_t a)
+	{
+		return _mm_set1_epi64x (static_cast<long long> (a));
+	}
+	static vector add (vector a, vector b)
+	{
+		return _mm_add_epi64 (a, b);
+	}
+	static vector bit_xor (vector a, vector b)
+	{
+		return _mm_xor_si128 (a, b);
+	}
+	static vector rotr32 (vector a)
+	{
+		return _mm_shuffle_epi32 (a, _MM_SHUFFLE (2, 3, 0, 1));
+	}
+	static vector rotr24 (vector a)
+	{
+		return _mm_shuffle_epi8 (a, _mm_setr_epi8 (3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10));
+	}
+	static vector rotr16 (vector a)
+	{
+		return _mm_shuffle_epi8 (a, _mm_setr_epi8 (2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9));
+	}
+	static vector rotr63 (vector a)
+	{
+		return _mm_xor_si128 (_mm_srli_epi64 (a, 63), _mm_add_epi64 (a, a));
+	}
+};
+}
+
+namespace nano
+{
+void work_hash_sse41 (uint8_t const * root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	work_lanes_hash<sse41> (root_a, nonces_a, values_a);
+}
+
+void work_hash_roots_sse41 (uint8_t const * roots_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	work_lanes_hash_roots<sse41> (roots_a, nonces_a, values_a);
+}
+}
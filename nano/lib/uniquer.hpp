@@ -0,0 +1,195 @@
+#pragma once
+
+#include <nano/lib/numbers.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nano
+{
+/** Activity of a uniquer since its counters were last taken */
+class uniquer_counters
+{
+public:
+	uint64_t hits{ 0 };
+	uint64_t misses{ 0 };
+	uint64_t evictions{ 0 };
+};
+
+/**
+ * Maps the full hash of an object to a single live instance so identical objects received from the network share memory.
+ * Entries are spread over independently locked shards. Each shard is bounded and evicts with the CLOCK algorithm,
+ * so an insert and the cleanup of expired entries are O(1) regardless of how many entries are held.
+ */
+template <typename T>
+class uniquer
+{
+public:
+	uniquer (size_t max_entries_a = default_max_entries) :
+	shard_capacity (std::max<size_t> (1, max_entries_a / shard_count))
+	{
+	}
+	std::shared_ptr<T> unique (std::shared_ptr<T> value_a)
+	{
+		auto result (value_a);
+		if (result != nullptr)
+		{
+			nano::uint256_union key (value_a->full_hash ());
+			{
+				auto & shard (shards[key.qwords[0] % shard_count]);
+				std::lock_guard<std::mutex> lock (shard.mutex);
+				auto existing (shard.index.find (key));
+				if (existing != shard.index.end ())
+				{
+					auto & entry (shard.entries[existing->second]);
+					entry.referenced = true;
+					if (auto value_l = entry.value.lock ())
+					{
+						result = value_l;
+						++hits;
+					}
+					else
+					{
+						entry.value = value_a;
+						++misses;
+					}
+				}
+				else
+				{
+					if (shard.entries.size () >= shard_capacity)
+					{
+						evict (shard);
+					}
+					shard.index[key] = shard.entries.size ();
+					shard.entries.push_back ({ key, value_a, false });
+					++misses;
+				}
+			}
+			// Shards take turns advancing their hand a few entries so expired entries don't accumulate below capacity
+			auto & shard (shards[cleanup_shard++ % shard_count]);
+			std::unique_lock<std::mutex> lock (shard.mutex, std::try_to_lock);
+			if (lock.owns_lock ())
+			{
+				for (auto i (0); i < cleanup_count && !shard.entries.empty (); ++i)
+				{
+					if (shard.hand >= shard.entries.size ())
+					{
+						shard.hand = 0;
+					}
+					if (shard.entries[shard.hand].value.expired ())
+					{
+						erase (shard, shard.hand);
+					}
+					else
+					{
+						++shard.hand;
+					}
+				}
+			}
+		}
+		return result;
+	}
+	size_t size ()
+	{
+		size_t result (0);
+		for (auto & shard : shards)
+		{
+			std::lock_guard<std::mutex> lock (shard.mutex);
+			result += shard.entries.size ();
+		}
+		return result;
+	}
+	/** Returns the counters accumulated since the last call and resets them */
+	nano::uniquer_counters take_counters ()
+	{
+		nano::uniquer_counters result;
+		result.hits = hits.exchange (0);
+		result.misses = misses.exchange (0);
+		result.evictions = evictions.exchange (0);
+		return result;
+	}
+	/** Number of entries which fit in bytes_a when each held value takes roughly value_size_a bytes */
+	static size_t entries_for (size_t bytes_a, size_t value_size_a)
+	{
+		// Map node with key and slot index, plus the allocation kept alive by the weak pointer after the value expires
+		auto entry_size (sizeof (entry) + sizeof (nano::uint256_union) + sizeof (size_t) + 2 * sizeof (void *) + value_size_a);
+		return bytes_a / entry_size;
+	}
+	static size_t constexpr default_max_entries = 64 * 1024;
+	static size_t constexpr shard_count = 16;
+	static unsigned constexpr cleanup_count = 2;
+
+private:
+	class entry
+	{
+	public:
+		nano::uint256_union key;
+		std::weak_ptr<T> value;
+		bool referenced;
+	};
+	class shard
+	{
+	public:
+		std::mutex mutex;
+		std::unordered_map<nano::uint256_union, size_t> index;
+		std::vector<entry> entries;
+		size_t hand{ 0 };
+	};
+	void evict (shard & shard_a)
+	{
+		// Entries referenced since the hand last passed get a second chance, so this ends within two sweeps
+		auto done (false);
+		while (!done)
+		{
+			if (shard_a.hand >= shard_a.entries.size ())
+			{
+				shard_a.hand = 0;
+			}
+			auto & entry (shard_a.entries[shard_a.hand]);
+			auto expired (entry.value.expired ());
+			if (expired || !entry.referenced)
+			{
+				if (!expired)
+				{
+					++evictions;
+				}
+				erase (shard_a, shard_a.hand);
+				done = true;
+			}
+			else
+			{
+				entry.referenced = false;
+				++shard_a.hand;
+			}
+		}
+	}
+	void erase (shard & shard_a, size_t position_a)
+	{
+		shard_a.index.erase (shard_a.entries[position_a].key);
+		if (position_a != shard_a.entries.size () - 1)
+		{
+			shard_a.entries[position_a] = std::move (shard_a.entries.back ());
+			shard_a.index[shard_a.entries[position_a].key] = position_a;
+		}
+		shard_a.entries.pop_back ();
+	}
+	std::array<shard, shard_count> shards;
+	size_t const shard_capacity;
+	std::atomic<size_t> cleanup_shard{ 0 };
+	std::atomic<uint64_t> hits{ 0 };
+	std::atomic<uint64_t> misses{ 0 };
+	std::atomic<uint64_t> evictions{ 0 };
+};
+
+template <typename T>
+size_t constexpr nano::uniquer<T>::default_max_entries;
+template <typename T>
+size_t constexpr nano::uniquer<T>::shard_count;
+template <typename T>
+unsigned constexpr nano::uniquer<T>::cleanup_count;
+}
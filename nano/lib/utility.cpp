@@ -43,6 +43,9 @@ namespace thread_role
 			case nano::thread_role::name::block_processing:
 				thread_role_name_string = "Blck processing";
 				break;
+			case nano::thread_role::name::block_verification:
+				thread_role_name_string = "Blck verifying";
+				break;
 			case nano::thread_role::name::request_loop:
 				thread_role_name_string = "Request loop";
 				break;
@@ -61,6 +64,9 @@ namespace thread_role
 			case nano::thread_role::name::slow_db_upgrade:
 				thread_role_name_string = "Slow db upgrade";
 				break;
+			case nano::thread_role::name::store_writer:
+				thread_role_name_string = "Store writer";
+				break;
 		}
 
 		/*
@@ -37,12 +37,14 @@ namespace thread_role
 		alarm,
 		vote_processing,
 		block_processing,
+		block_verification,
 		request_loop,
 		wallet_actions,
 		bootstrap_initiator,
 		voting,
 		signature_checking,
 		slow_db_upgrade,
+		store_writer,
 	};
 	/*
 	 * Get/Set the identifier for the current thread
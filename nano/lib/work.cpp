@@ -5,6 +5,90 @@
 
 #include <future>
 
+#if NANO_WORK_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace nano
+{
+void work_hash_sse41 (uint8_t const *, uint64_t const *, uint64_t *);
+void work_hash_avx2 (uint8_t const *, uint64_t const *, uint64_t *);
+void work_hash_avx512 (uint8_t const *, uint64_t const *, uint64_t *);
+void work_hash_roots_sse41 (uint8_t const *, uint64_t const *, uint64_t *);
+void work_hash_roots_avx2 (uint8_t const *, uint64_t const *, uint64_t *);
+void work_hash_roots_avx512 (uint8_t const *, uint64_t const *, uint64_t *);
+}
+#endif
+
+namespace
+{
+void work_hash_scalar (uint8_t const * root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	blake2b_state hash;
+	blake2b_init (&hash, sizeof (*values_a));
+	blake2b_update (&hash, reinterpret_cast<uint8_t const *> (nonces_a), sizeof (*nonces_a));
+	blake2b_update (&hash, root_a, sizeof (nano::block_hash));
+	blake2b_final (&hash, reinterpret_cast<uint8_t *> (values_a), sizeof (*values_a));
+}
+
+#if NANO_WORK_X86
+class cpu_features
+{
+public:
+	cpu_features ()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid (info, 1);
+		sse41 = (info[2] & (1 << 19)) != 0;
+		// The OS has to save the wider registers on context switches as well as the CPU supporting them
+		auto xcr0 ((info[2] & (1 << 27)) != 0 ? _xgetbv (0) : 0);
+		__cpuidex (info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+		avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+#else
+		__builtin_cpu_init ();
+		sse41 = __builtin_cpu_supports ("sse4.1");
+		avx2 = __builtin_cpu_supports ("avx2");
+		avx512 = __builtin_cpu_supports ("avx512f");
+#endif
+	}
+	bool sse41;
+	bool avx2;
+	bool avx512;
+};
+#endif
+}
+
+size_t constexpr nano::work_hasher::lanes_max;
+
+std::vector<nano::work_hasher> const & nano::work_hashers ()
+{
+	static std::vector<nano::work_hasher> const result ([]() {
+		std::vector<nano::work_hasher> hashers;
+#if NANO_WORK_X86
+		cpu_features features;
+		if (features.avx512)
+		{
+			hashers.push_back ({ "avx512", 8, nano::work_hash_avx512, nano::work_hash_roots_avx512 });
+		}
+		if (features.avx2)
+		{
+			hashers.push_back ({ "avx2", 4, nano::work_hash_avx2, nano::work_hash_roots_avx2 });
+		}
+		if (features.sse41)
+		{
+			hashers.push_back ({ "sse4.1", 2, nano::work_hash_sse41, nano::work_hash_roots_sse41 });
+		}
+#endif
+		// With a single lane there's no difference between one root and a root per lane
+		hashers.push_back ({ "scalar", 1, work_hash_scalar, work_hash_scalar });
+		return hashers;
+	}());
+	return result;
+}
+
 bool nano::work_validate (nano::block_hash const & root_a, uint64_t work_a, uint64_t * difficulty_a)
 {
 	auto value (nano::work_value (root_a, work_a));
@@ -20,6 +104,38 @@ bool nano::work_validate (nano::block const & block_a, uint64_t * difficulty_a)
 	return work_validate (block_a.root (), block_a.block_work (), difficulty_a);
 }
 
+void nano::work_validate_batch (nano::block_hash const * roots_a, uint64_t const * works_a, size_t count_a, bool * errors_a)
+{
+	static_assert (sizeof (nano::block_hash) == 32, "Roots are hashed directly out of the array");
+	auto & hasher (nano::work_hashers ().front ());
+	std::array<nano::block_hash, nano::work_hasher::lanes_max> roots;
+	std::array<uint64_t, nano::work_hasher::lanes_max> works;
+	std::array<uint64_t, nano::work_hasher::lanes_max> values;
+	for (size_t i (0); i < count_a; i += hasher.lanes)
+	{
+		auto lanes (std::min (hasher.lanes, count_a - i));
+		if (lanes == hasher.lanes)
+		{
+			hasher.hash_roots (roots_a[i].bytes.data (), works_a + i, values.data ());
+		}
+		else
+		{
+			// Pad the tail of the batch by repeating its last pair
+			for (size_t j (0); j < hasher.lanes; ++j)
+			{
+				auto k (i + std::min (j, lanes - 1));
+				roots[j] = roots_a[k];
+				works[j] = works_a[k];
+			}
+			hasher.hash_roots (roots[0].bytes.data (), works.data (), values.data ());
+		}
+		for (size_t j (0); j < lanes; ++j)
+		{
+			errors_a[i + j] = values[j] < nano::work_pool::publish_threshold;
+		}
+	}
+}
+
 uint64_t nano::work_value (nano::block_hash const & root_a, uint64_t work_a)
 {
 	uint64_t result;
@@ -31,10 +147,31 @@ uint64_t nano::work_value (nano::block_hash const & root_a, uint64_t work_a)
 	return result;
 }
 
+nano::work_item::work_item (nano::uint256_union const & item_a, std::function<void(boost::optional<uint64_t> const &)> const & callback_a, uint64_t difficulty_a, nano::work_priority priority_a, std::chrono::steady_clock::time_point deadline_a, uint64_t sequence_a) :
+item (item_a),
+callback (callback_a),
+difficulty (difficulty_a),
+priority (priority_a),
+deadline (deadline_a),
+queued (std::chrono::steady_clock::now ()),
+sequence (sequence_a),
+workers (0),
+finished (false)
+{
+}
+
+std::tuple<nano::work_priority, std::chrono::steady_clock::time_point, uint64_t> nano::work_item::order () const
+{
+	return std::make_tuple (priority, deadline, sequence);
+}
+
 nano::work_pool::work_pool (unsigned max_threads_a, std::function<boost::optional<uint64_t> (nano::uint256_union const &)> opencl_a) :
 ticket (0),
 done (false),
-opencl (opencl_a)
+sequence (0),
+background_workers (0),
+opencl (opencl_a),
+hasher (nano::work_hashers ().front ())
 {
 	static_assert (ATOMIC_INT_LOCK_FREE == 2, "Atomic int needed");
 	boost::thread::attributes attrs;
@@ -60,6 +197,58 @@ nano::work_pool::~work_pool ()
 	}
 }
 
+unsigned nano::work_pool::background_reserve () const
+{
+	// A quarter of the threads keep precaching while interactive requests are queued, unless there's only one thread
+	return threads.size () > 1 ? std::max<unsigned> (1, threads.size () / 4) : 0;
+}
+
+std::shared_ptr<nano::work_item> nano::work_pool::select ()
+{
+	assert (!pending.empty ());
+	std::shared_ptr<nano::work_item> result;
+	auto & ordered (pending.get<0> ());
+	auto background (ordered.lower_bound (std::make_tuple (nano::work_priority::background, std::chrono::steady_clock::time_point::min (), uint64_t (0))));
+	if (ordered.begin () != background && (background == ordered.end () || background_workers >= background_reserve ()))
+	{
+		// Most urgent interactive request
+		result = *ordered.begin ();
+	}
+	else
+	{
+		// Background request with the fewest threads, there can't be more busy threads than the number of threads so only that many requests need to be looked at
+		auto limit (threads.size ());
+		for (auto i (background), n (ordered.end ()); i != n && limit > 0; ++i, --limit)
+		{
+			if (result == nullptr || (*i)->workers < result->workers)
+			{
+				result = *i;
+			}
+		}
+	}
+	return result;
+}
+
+void nano::work_pool::erase (std::shared_ptr<nano::work_item> const & item_a)
+{
+	auto & roots (pending.get<1> ());
+	auto range (roots.equal_range (item_a->item));
+	for (auto i (range.first); i != range.second; ++i)
+	{
+		if (*i == item_a)
+		{
+			roots.erase (i);
+			break;
+		}
+	}
+}
+
+size_t nano::work_pool::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return pending.size ();
+}
+
 void nano::work_pool::loop (uint64_t thread)
 {
 	// Quick RNG for work attempts.
@@ -67,8 +256,8 @@ void nano::work_pool::loop (uint64_t thread)
 	nano::random_pool.GenerateBlock (reinterpret_cast<uint8_t *> (rng.s.data ()), rng.s.size () * sizeof (decltype (rng.s)::value_type));
 	uint64_t work;
 	uint64_t output;
-	blake2b_state hash;
-	blake2b_init (&hash, sizeof (output));
+	std::array<uint64_t, nano::work_hasher::lanes_max> works;
+	std::array<uint64_t, nano::work_hasher::lanes_max> outputs;
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!done || !pending.empty ())
 	{
@@ -80,43 +269,60 @@ void nano::work_pool::loop (uint64_t thread)
 		}
 		if (!empty)
 		{
-			auto current_l (pending.front ());
+			auto current_l (select ());
+			auto background (current_l->priority == nano::work_priority::background);
+			++current_l->workers;
+			background_workers += background ? 1 : 0;
 			int ticket_l (ticket);
 			lock.unlock ();
 			output = 0;
-			// ticket != ticket_l indicates a different thread found a solution and we should stop
-			while (ticket == ticket_l && output < current_l.difficulty)
+			// ticket != ticket_l indicates the queue changed and this thread may be needed on a different item
+			while (ticket == ticket_l && !current_l->finished && output < current_l->difficulty)
 			{
 				// Don't query main memory every iteration in order to reduce memory bus traffic
 				// All operations here operate on stack memory
 				// Count iterations down to zero since comparing to zero is easier than comparing to another number
 				unsigned iteration (256);
-				while (iteration && output < current_l.difficulty)
+				while (iteration && output < current_l->difficulty)
 				{
-					work = rng.next ();
-					blake2b_update (&hash, reinterpret_cast<uint8_t *> (&work), sizeof (work));
-					blake2b_update (&hash, current_l.item.bytes.data (), current_l.item.bytes.size ());
-					blake2b_final (&hash, reinterpret_cast<uint8_t *> (&output), sizeof (output));
-					blake2b_init (&hash, sizeof (output));
+					// Each iteration tries one nonce per hasher lane
+					for (size_t i (0); i < hasher.lanes; ++i)
+					{
+						works[i] = rng.next ();
+					}
+					hasher.hash (current_l->item.bytes.data (), works.data (), outputs.data ());
+					for (size_t i (0); i < hasher.lanes && output < current_l->difficulty; ++i)
+					{
+						work = works[i];
+						output = outputs[i];
+					}
 					iteration -= 1;
 				}
 			}
 			lock.lock ();
-			if (ticket == ticket_l)
+			--current_l->workers;
+			background_workers -= background ? 1 : 0;
+			if (output >= current_l->difficulty && !current_l->finished)
 			{
-				// If the ticket matches what we started with, we're the ones that found the solution
+				// We're the ones that found the solution
 				assert (output >= nano::work_pool::publish_threshold);
-				assert (work_value (current_l.item, work) == output);
-				// Signal other threads to stop their work next time they check ticket
+				assert (work_value (current_l->item, work) == output);
+				// Signal other threads on this item to stop next time they check
+				current_l->finished = true;
+				erase (current_l);
 				++ticket;
-				pending.pop_front ();
+				auto & metrics_l (metrics[static_cast<size_t> (current_l->priority)]);
+				auto elapsed (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - current_l->queued));
+				++metrics_l.solved;
+				metrics_l.total += elapsed;
+				metrics_l.max = std::max (metrics_l.max, elapsed);
 				lock.unlock ();
-				current_l.callback (work);
+				current_l->callback (work);
 				lock.lock ();
 			}
 			else
 			{
-				// A different thread found a solution
+				// A different thread found a solution, the item was cancelled or the queue changed
 			}
 		}
 		else
@@ -130,26 +336,20 @@ void nano::work_pool::loop (uint64_t thread)
 void nano::work_pool::cancel (nano::uint256_union const & root_a)
 {
 	std::lock_guard<std::mutex> lock (mutex);
-	if (!pending.empty ())
+	auto & roots (pending.get<1> ());
+	auto range (roots.equal_range (root_a));
+	if (range.first != range.second)
 	{
-		if (pending.front ().item == root_a)
+		for (auto i (range.first); i != range.second; ++i)
 		{
-			++ticket;
+			auto & item (*i);
+			item->finished = true;
+			++metrics[static_cast<size_t> (item->priority)].cancelled;
+			item->callback (boost::none);
 		}
+		roots.erase (range.first, range.second);
+		++ticket;
 	}
-	pending.remove_if ([&root_a](decltype (pending)::value_type const & item_a) {
-		bool result;
-		if (item_a.item == root_a)
-		{
-			item_a.callback (boost::none);
-			result = true;
-		}
-		else
-		{
-			result = false;
-		}
-		return result;
-	});
 }
 
 void nano::work_pool::stop ()
@@ -161,7 +361,7 @@ void nano::work_pool::stop ()
 	producer_condition.notify_all ();
 }
 
-void nano::work_pool::generate (nano::uint256_union const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, uint64_t difficulty_a)
+void nano::work_pool::generate (nano::uint256_union const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, uint64_t difficulty_a, nano::work_priority priority_a, std::chrono::steady_clock::time_point deadline_a)
 {
 	assert (!root_a.is_zero ());
 	boost::optional<uint64_t> result;
@@ -173,7 +373,9 @@ void nano::work_pool::generate (nano::uint256_union const & root_a, std::functio
 	{
 		{
 			std::lock_guard<std::mutex> lock (mutex);
-			pending.push_back ({ root_a, callback_a, difficulty_a });
+			auto deadline (deadline_a != std::chrono::steady_clock::time_point () ? deadline_a : std::chrono::steady_clock::now ());
+			pending.insert (std::make_shared<nano::work_item> (root_a, callback_a, difficulty_a, priority_a, deadline, sequence++));
+			++ticket;
 		}
 		producer_condition.notify_all ();
 	}
@@ -183,13 +385,13 @@ void nano::work_pool::generate (nano::uint256_union const & root_a, std::functio
 	}
 }
 
-uint64_t nano::work_pool::generate (nano::uint256_union const & hash_a, uint64_t difficulty_a)
+uint64_t nano::work_pool::generate (nano::uint256_union const & hash_a, uint64_t difficulty_a, nano::work_priority priority_a)
 {
 	std::promise<boost::optional<uint64_t>> work;
 	generate (hash_a, [&work](boost::optional<uint64_t> work_a) {
 		work.set_value (work_a);
 	},
-	difficulty_a);
+	difficulty_a, priority_a);
 	auto result (work.get_future ().get ());
 	return result.value ();
 }
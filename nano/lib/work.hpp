@@ -1,15 +1,24 @@
 #pragma once
 
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/mem_fun.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index_container.hpp>
 #include <boost/optional.hpp>
 #include <boost/thread/thread.hpp>
 #include <nano/lib/config.hpp>
 #include <nano/lib/numbers.hpp>
 #include <nano/lib/utility.hpp>
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <thread>
+#include <tuple>
+#include <vector>
 
 namespace nano
 {
@@ -17,14 +26,65 @@ class block;
 bool work_validate (nano::block_hash const &, uint64_t, uint64_t * = nullptr);
 bool work_validate (nano::block const &, uint64_t * = nullptr);
 uint64_t work_value (nano::block_hash const &, uint64_t);
+// Validates count (root, work) pairs several at a time, errors[i] is set as work_validate would for pair i
+void work_validate_batch (nano::block_hash const *, uint64_t const *, size_t, bool *);
+/**
+ * Computes work_value for several nonces at once, one nonce per SIMD lane.
+ * Results are bit-exact with work_value.
+ */
+class work_hasher
+{
+public:
+	char const * name;
+	size_t lanes;
+	// Root bytes, lanes nonces in, lanes work values out
+	void (*hash) (uint8_t const *, uint64_t const *, uint64_t *);
+	// Lanes roots stored back to back, lanes nonces in, lanes work values out
+	void (*hash_roots) (uint8_t const *, uint64_t const *, uint64_t *);
+	static size_t constexpr lanes_max = 8;
+};
+// Every implementation this CPU supports, widest first, the scalar implementation is always last
+std::vector<nano::work_hasher> const & work_hashers ();
 class opencl_work;
+enum class work_priority : uint8_t
+{
+	// Someone is waiting on the block, e.g. a send from the wallet or RPC
+	interactive,
+	// Precaching work for the next block of an account
+	background
+};
 class work_item
 {
 public:
+	work_item (nano::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)> const &, uint64_t, nano::work_priority, std::chrono::steady_clock::time_point, uint64_t);
+	std::tuple<nano::work_priority, std::chrono::steady_clock::time_point, uint64_t> order () const;
 	nano::uint256_union item;
 	std::function<void(boost::optional<uint64_t> const &)> callback;
 	uint64_t difficulty;
+	nano::work_priority priority;
+	std::chrono::steady_clock::time_point deadline;
+	std::chrono::steady_clock::time_point queued;
+	// Breaks ties between equal deadlines in arrival order
+	uint64_t sequence;
+	// Threads currently hashing this item, guarded by work_pool::mutex
+	unsigned workers;
+	// Set once the item is solved or cancelled so threads still hashing it move on
+	std::atomic<bool> finished;
 };
+class work_metrics
+{
+public:
+	uint64_t solved{ 0 };
+	uint64_t cancelled{ 0 };
+	// Time from being queued to being solved
+	std::chrono::microseconds total{ 0 };
+	std::chrono::microseconds max{ 0 };
+};
+/**
+ * Requests are ordered by priority and then deadline.
+ * Interactive requests get every thread except a share kept for background requests, all threads pile on to the most urgent one to minimize its latency.
+ * Background requests are spread over threads so work for many roots is generated concurrently.
+ */
 class work_pool
 {
 public:
@@ -33,19 +93,37 @@ public:
 	void loop (uint64_t);
 	void stop ();
 	void cancel (nano::uint256_union const &);
-	void generate (nano::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)>, uint64_t = nano::work_pool::publish_threshold);
-	uint64_t generate (nano::uint256_union const &, uint64_t = nano::work_pool::publish_threshold);
+	/** A default deadline is the time the request is queued, so requests without one are served in arrival order */
+	void generate (nano::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)>, uint64_t = nano::work_pool::publish_threshold, nano::work_priority = nano::work_priority::interactive, std::chrono::steady_clock::time_point = std::chrono::steady_clock::time_point ());
+	uint64_t generate (nano::uint256_union const &, uint64_t = nano::work_pool::publish_threshold, nano::work_priority = nano::work_priority::interactive);
+	size_t size ();
+	// Incremented whenever the queue changes so threads pick their item again
 	std::atomic<int> ticket;
 	bool done;
 	std::vector<boost::thread> threads;
-	std::list<nano::work_item> pending;
+	boost::multi_index_container<
+	std::shared_ptr<nano::work_item>,
+	boost::multi_index::indexed_by<
+	boost::multi_index::ordered_non_unique<boost::multi_index::const_mem_fun<nano::work_item, std::tuple<nano::work_priority, std::chrono::steady_clock::time_point, uint64_t>, &nano::work_item::order>>,
+	boost::multi_index::hashed_non_unique<boost::multi_index::member<nano::work_item, nano::uint256_union, &nano::work_item::item>, std::hash<nano::uint256_union>>>>
+	pending;
+	uint64_t sequence;
+	// Threads hashing background items
+	unsigned background_workers;
+	std::array<nano::work_metrics, 2> metrics;
 	std::mutex mutex;
 	std::condition_variable producer_condition;
 	std::function<boost::optional<uint64_t> (nano::uint256_union const &)> opencl;
+	nano::work_hasher const & hasher;
 	nano::observer_set<bool> work_observers;
 	// Local work threshold for rate-limiting publishing blocks. ~5 seconds of work.
 	static uint64_t const publish_test_threshold = 0xff00000000000000;
 	static uint64_t const publish_full_threshold = 0xffffffc000000000;
 	static uint64_t const publish_threshold = nano::nano_network == nano::nano_networks::nano_test_network ? publish_test_threshold : publish_full_threshold;
+
+private:
+	std::shared_ptr<nano::work_item> select ();
+	void erase (std::shared_ptr<nano::work_item> const &);
+	unsigned background_reserve () const;
 };
 }
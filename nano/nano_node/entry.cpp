@@ -41,6 +41,7 @@ int main (int argc, char * const * argv)
 		("debug_verify_profile_batch", "Profile batch signature verification")
 		("debug_profile_bootstrap", "Profile bootstrap style blocks processing (at least 10GB of free storage space required)")
 		("debug_profile_sign", "Profile signature generation")
+		("debug_profile_block_hash", "Profile block hashing with and without cached digests")
 		("debug_profile_process", "Profile active blocks processing (only for nano_test_network)")
 		("debug_profile_votes", "Profile votes processing (only for nano_test_network)")
 		("debug_rpc", "Read an RPC command from stdin and invoke it. Network operations will have no effect.")
@@ -208,9 +209,30 @@ int main (int argc, char * const * argv)
 		}
 		else if (vm.count ("debug_profile_generate"))
 		{
+			// Single thread hash rate of each work hasher this CPU supports
+			for (auto & hasher : nano::work_hashers ())
+			{
+				nano::block_hash root (1);
+				std::array<uint64_t, nano::work_hasher::lanes_max> works{ { 0 } };
+				std::array<uint64_t, nano::work_hasher::lanes_max> outputs;
+				uint64_t hashes (0);
+				auto begin (std::chrono::steady_clock::now ());
+				auto end (begin + std::chrono::seconds (1));
+				while (std::chrono::steady_clock::now () < end)
+				{
+					for (auto i (0); i < 4096; ++i)
+					{
+						works[0] += 1;
+						hasher.hash (root.bytes.data (), works.data (), outputs.data ());
+					}
+					hashes += 4096 * hasher.lanes;
+				}
+				auto elapsed (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - begin));
+				std::cerr << boost::str (boost::format ("%1% (%2% lanes): %3% H/s per thread\n") % hasher.name % hasher.lanes % (hashes * 1000000 / elapsed.count ()));
+			}
 			nano::work_pool work (std::numeric_limits<unsigned>::max (), nullptr);
 			nano::change_block block (0, 0, nano::keypair ().prv, 0, 0);
-			std::cerr << "Starting generation profiling\n";
+			std::cerr << boost::str (boost::format ("Starting generation profiling with %1% work hasher\n") % work.hasher.name);
 			while (true)
 			{
 				block.hashables.previous.qwords[0] += 1;
@@ -381,6 +403,52 @@ int main (int argc, char * const * argv)
 				std::cerr << boost::str (boost::format ("%|1$ 12d|\n") % std::chrono::duration_cast<std::chrono::microseconds> (end1 - begin1).count ());
 			}
 		}
+		else if (vm.count ("debug_profile_block_hash"))
+		{
+			// Roughly how often a live block is hashed between block_processor::add and republishing
+			size_t const hash_calls (12);
+			size_t const full_hash_calls (2);
+			size_t const count (100000);
+			nano::keypair key;
+			std::vector<nano::state_block> blocks;
+			blocks.reserve (count);
+			for (uint64_t i (0); i < count; ++i)
+			{
+				blocks.emplace_back (key.pub, 0, key.pub, i, 0, key.prv, key.pub, 0);
+			}
+			std::cerr << boost::str (boost::format ("Hashing %1% blocks, %2% hash and %3% full_hash calls each\n") % count % hash_calls % full_hash_calls);
+			for (auto cached : { false, true })
+			{
+				for (auto & block : blocks)
+				{
+					block.hash_invalidate ();
+				}
+				auto begin (std::chrono::high_resolution_clock::now ());
+				for (auto & block : blocks)
+				{
+					for (size_t i (0); i < hash_calls; ++i)
+					{
+						if (!cached)
+						{
+							block.hash_invalidate ();
+						}
+						block.hash ();
+					}
+					for (size_t i (0); i < full_hash_calls; ++i)
+					{
+						if (!cached)
+						{
+							block.hash_invalidate ();
+						}
+						block.full_hash ();
+					}
+				}
+				auto end (std::chrono::high_resolution_clock::now ());
+				// Uncached, full_hash also rehashes the hashables
+				auto blake2b_calls (cached ? 2 : hash_calls + 2 * full_hash_calls);
+				std::cerr << boost::str (boost::format ("%1%: %2% blake2b calls per block, %3% ns per block\n") % (cached ? "Cached" : "Uncached") % blake2b_calls % (std::chrono::duration_cast<std::chrono::nanoseconds> (end - begin).count () / count));
+			}
+		}
 		else if (vm.count ("debug_profile_process"))
 		{
 			if (nano::nano_network == nano::nano_networks::nano_test_network)
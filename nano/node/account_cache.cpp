@@ -0,0 +1,120 @@
+#include <nano/node/account_cache.hpp>
+
+#include <algorithm>
+
+size_t constexpr nano::account_cache::shard_count;
+size_t constexpr nano::account_cache::entry_size;
+
+nano::account_cache::account_cache (size_t max_bytes_a) :
+shard_capacity (max_bytes_a / entry_size / shard_count)
+{
+}
+
+nano::account_cache::shard & nano::account_cache::shard_for (nano::account const & account_a)
+{
+	return shards[account_a.qwords[0] % shard_count];
+}
+
+bool nano::account_cache::get (nano::account const & account_a, uint64_t version_a, nano::account_info & info_a)
+{
+	auto result (true);
+	if (shard_capacity > 0)
+	{
+		auto & shard (shard_for (account_a));
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		auto existing (shard.index.find (account_a));
+		if (existing != shard.index.end () && existing->second->version <= version_a)
+		{
+			shard.entries.splice (shard.entries.begin (), shard.entries, existing->second);
+			info_a = existing->second->info;
+			result = false;
+		}
+		if (!result)
+		{
+			++hits;
+		}
+		else
+		{
+			++misses;
+		}
+	}
+	return result;
+}
+
+void nano::account_cache::put (nano::account const & account_a, uint64_t version_a, nano::account_info const & info_a, bool latest_a)
+{
+	if (shard_capacity > 0)
+	{
+		auto & shard (shard_for (account_a));
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		// A snapshot older than the last erase may have read the account before it was modified
+		if (latest_a || version_a >= shard.erased)
+		{
+			auto existing (shard.index.find (account_a));
+			if (existing != shard.index.end ())
+			{
+				existing->second->info = info_a;
+				existing->second->version = version_a;
+				shard.entries.splice (shard.entries.begin (), shard.entries, existing->second);
+			}
+			else
+			{
+				shard.entries.push_front (entry{ account_a, info_a, version_a });
+				shard.index[account_a] = shard.entries.begin ();
+				while (shard.entries.size () > shard_capacity)
+				{
+					shard.index.erase (shard.entries.back ().account);
+					shard.entries.pop_back ();
+					++evictions;
+				}
+			}
+		}
+	}
+}
+
+void nano::account_cache::erase (nano::account const & account_a, uint64_t version_a)
+{
+	if (shard_capacity > 0)
+	{
+		auto & shard (shard_for (account_a));
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		shard.erased = std::max (shard.erased, version_a);
+		auto existing (shard.index.find (account_a));
+		if (existing != shard.index.end ())
+		{
+			shard.entries.erase (existing->second);
+			shard.index.erase (existing);
+		}
+	}
+}
+
+void nano::account_cache::clear (uint64_t version_a)
+{
+	for (auto & shard : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		shard.erased = std::max (shard.erased, version_a);
+		shard.entries.clear ();
+		shard.index.clear ();
+	}
+}
+
+size_t nano::account_cache::size ()
+{
+	size_t result (0);
+	for (auto & shard : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		result += shard.entries.size ();
+	}
+	return result;
+}
+
+nano::uniquer_counters nano::account_cache::take_counters ()
+{
+	nano::uniquer_counters result;
+	result.hits = hits.exchange (0);
+	result.misses = misses.exchange (0);
+	result.evictions = evictions.exchange (0);
+	return result;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <nano/lib/numbers.hpp>
+#include <nano/lib/uniquer.hpp>
+#include <nano/secure/common.hpp>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace nano
+{
+/**
+ * Account info of recently used accounts, including the epoch so lookups don't have to probe both account tables.
+ * Entries are spread over independently locked shards, each holding an equal part of the memory budget in LRU order.
+ *
+ * Versions follow the same rules as the block cache: entries are tagged with the snapshot they were read at and a
+ * reader is only served entries at or before its own snapshot. Writers erase accounts as they modify them and
+ * publish the new info once their transaction commits.
+ */
+class account_cache
+{
+public:
+	account_cache (size_t max_bytes_a);
+	/** Returns true if the account isn't cached for the given snapshot version */
+	bool get (nano::account const &, uint64_t, nano::account_info &);
+	/**
+	 * Caches account info read at the given snapshot version.
+	 * Latest is set by the write transaction for accounts it hasn't modified, its reads can't be stale as it holds the write lock.
+	 */
+	void put (nano::account const &, uint64_t, nano::account_info const &, bool latest_a = false);
+	/** Drops the account as it's being modified by the write transaction with the given version */
+	void erase (nano::account const &, uint64_t);
+	void clear (uint64_t);
+	size_t size ();
+	/** Returns the counters accumulated since the last call and resets them */
+	nano::uniquer_counters take_counters ();
+	static size_t constexpr shard_count = 16;
+	/** Per entry estimate covering the account info and index overhead */
+	static size_t constexpr entry_size = sizeof (nano::account) + sizeof (nano::account_info) + 8 * sizeof (void *) + sizeof (uint64_t);
+
+private:
+	class entry
+	{
+	public:
+		nano::account account;
+		nano::account_info info;
+		uint64_t version;
+	};
+	class shard
+	{
+	public:
+		std::mutex mutex;
+		/** Most recently used at the front */
+		std::list<entry> entries;
+		std::unordered_map<nano::account, std::list<entry>::iterator> index;
+		/** Version of the latest write that erased from this shard */
+		uint64_t erased{ 0 };
+	};
+	shard & shard_for (nano::account const &);
+	std::array<shard, shard_count> shards;
+	size_t const shard_capacity;
+	std::atomic<uint64_t> hits{ 0 };
+	std::atomic<uint64_t> misses{ 0 };
+	std::atomic<uint64_t> evictions{ 0 };
+};
+}
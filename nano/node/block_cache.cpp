@@ -0,0 +1,117 @@
+#include <nano/node/block_cache.hpp>
+
+#include <algorithm>
+
+size_t constexpr nano::block_cache::shard_count;
+size_t constexpr nano::block_cache::entry_size;
+
+nano::block_cache::block_cache (size_t max_bytes_a, nano::block_uniquer * uniquer_a) :
+shard_capacity (max_bytes_a / entry_size / shard_count),
+uniquer (uniquer_a)
+{
+}
+
+nano::block_cache::shard & nano::block_cache::shard_for (nano::block_hash const & hash_a)
+{
+	return shards[hash_a.qwords[0] % shard_count];
+}
+
+std::shared_ptr<nano::block> nano::block_cache::get (nano::block_hash const & hash_a, uint64_t version_a, nano::block_sideband * sideband_a)
+{
+	std::shared_ptr<nano::block> result;
+	if (shard_capacity > 0)
+	{
+		auto & shard (shard_for (hash_a));
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		auto existing (shard.index.find (hash_a));
+		// Entries cached by a newer snapshot may describe a block this reader can't see yet
+		if (existing != shard.index.end () && existing->second->version <= version_a)
+		{
+			shard.entries.splice (shard.entries.begin (), shard.entries, existing->second);
+			result = existing->second->block;
+			if (sideband_a != nullptr)
+			{
+				*sideband_a = existing->second->sideband;
+			}
+		}
+		if (result != nullptr)
+		{
+			++hits;
+		}
+		else
+		{
+			++misses;
+		}
+	}
+	return result;
+}
+
+std::shared_ptr<nano::block> nano::block_cache::put (nano::block_hash const & hash_a, uint64_t version_a, std::shared_ptr<nano::block> block_a, nano::block_sideband const & sideband_a)
+{
+	auto result (uniquer != nullptr ? uniquer->unique (block_a) : block_a);
+	if (shard_capacity > 0)
+	{
+		auto & shard (shard_for (hash_a));
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		// A snapshot older than the last erase may have read the block before it was modified
+		if (version_a >= shard.erased && shard.index.find (hash_a) == shard.index.end ())
+		{
+			shard.entries.push_front (entry{ hash_a, result, sideband_a, version_a });
+			shard.index[hash_a] = shard.entries.begin ();
+			while (shard.entries.size () > shard_capacity)
+			{
+				shard.index.erase (shard.entries.back ().hash);
+				shard.entries.pop_back ();
+				++evictions;
+			}
+		}
+	}
+	return result;
+}
+
+void nano::block_cache::erase (nano::block_hash const & hash_a, uint64_t version_a)
+{
+	if (shard_capacity > 0)
+	{
+		auto & shard (shard_for (hash_a));
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		shard.erased = std::max (shard.erased, version_a);
+		auto existing (shard.index.find (hash_a));
+		if (existing != shard.index.end ())
+		{
+			shard.entries.erase (existing->second);
+			shard.index.erase (existing);
+		}
+	}
+}
+
+void nano::block_cache::clear (uint64_t version_a)
+{
+	for (auto & shard : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		shard.erased = std::max (shard.erased, version_a);
+		shard.entries.clear ();
+		shard.index.clear ();
+	}
+}
+
+size_t nano::block_cache::size ()
+{
+	size_t result (0);
+	for (auto & shard : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard.mutex);
+		result += shard.entries.size ();
+	}
+	return result;
+}
+
+nano::uniquer_counters nano::block_cache::take_counters ()
+{
+	nano::uniquer_counters result;
+	result.hits = hits.exchange (0);
+	result.misses = misses.exchange (0);
+	result.evictions = evictions.exchange (0);
+	return result;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <nano/lib/blocks.hpp>
+#include <nano/secure/blockstore.hpp>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace nano
+{
+/**
+ * Recently read blocks and their sideband, kept deserialized so repeated reads skip both the B-tree walk and parsing.
+ * Entries are spread over independently locked shards, each holding an equal part of the memory budget in LRU order.
+ *
+ * Entries are tagged with the snapshot version they were read at. A reader is only served entries at or before its own
+ * snapshot, and a hash erased by a writer can't be re-inserted by readers whose snapshot predates that write.
+ */
+class block_cache
+{
+public:
+	block_cache (size_t max_bytes_a, nano::block_uniquer * uniquer_a = nullptr);
+	std::shared_ptr<nano::block> get (nano::block_hash const &, uint64_t, nano::block_sideband * = nullptr);
+	/** Caches a block read at the given snapshot version, returning the instance shared through the uniquer */
+	std::shared_ptr<nano::block> put (nano::block_hash const &, uint64_t, std::shared_ptr<nano::block>, nano::block_sideband const &);
+	/** Drops the hash as it's being modified by the write transaction with the given version */
+	void erase (nano::block_hash const &, uint64_t);
+	void clear (uint64_t);
+	size_t size ();
+	/** Returns the counters accumulated since the last call and resets them */
+	nano::uniquer_counters take_counters ();
+	static size_t constexpr shard_count = 16;
+	/** Per entry estimate covering the block object, sideband and index overhead */
+	static size_t constexpr entry_size = sizeof (nano::state_block) + sizeof (nano::block_sideband) + sizeof (nano::block_hash) + 8 * sizeof (void *) + sizeof (uint64_t);
+
+private:
+	class entry
+	{
+	public:
+		nano::block_hash hash;
+		std::shared_ptr<nano::block> block;
+		nano::block_sideband sideband;
+		uint64_t version;
+	};
+	class shard
+	{
+	public:
+		std::mutex mutex;
+		/** Most recently used at the front */
+		std::list<entry> entries;
+		std::unordered_map<nano::block_hash, std::list<entry>::iterator> index;
+		/** Version of the latest write that erased from this shard */
+		uint64_t erased{ 0 };
+	};
+	shard & shard_for (nano::block_hash const &);
+	std::array<shard, shard_count> shards;
+	size_t const shard_capacity;
+	nano::block_uniquer * uniquer;
+	std::atomic<uint64_t> hits{ 0 };
+	std::atomic<uint64_t> misses{ 0 };
+	std::atomic<uint64_t> evictions{ 0 };
+};
+}
@@ -5,16 +5,19 @@
 
 #include <boost/log/trivial.hpp>
 
-constexpr double bootstrap_connection_scale_target_blocks = 50000.0;
 constexpr double bootstrap_connection_warmup_time_sec = 5.0;
 constexpr double bootstrap_minimum_blocks_per_sec = 10.0;
 constexpr double bootstrap_minimum_frontier_blocks_per_sec = 1000.0;
 constexpr unsigned bootstrap_frontier_retry_limit = 16;
 constexpr double bootstrap_minimum_termination_time_sec = 30.0;
 constexpr unsigned bootstrap_max_new_connections = 10;
+constexpr std::chrono::seconds bootstrap_connection_adjust_interval (5);
+constexpr double bootstrap_connection_rate_gain = 0.05;
+constexpr double bootstrap_recent_rate_weight = 0.3;
 constexpr unsigned bulk_push_cost_limit = 200;
 
 size_t constexpr nano::frontier_req_client::size_frontier;
+size_t constexpr nano::bulk_pull_server::send_buffer_size;
 
 nano::socket::socket (std::shared_ptr<nano::node> node_a) :
 socket_m (node_a->io_ctx),
@@ -128,7 +131,10 @@ endpoint (endpoint_a),
 start_time (std::chrono::steady_clock::now ()),
 block_count (0),
 pending_stop (false),
-hard_stop (false)
+hard_stop (false),
+recent_rate (0.0),
+pulls_succeeded (0),
+pulls_failed (0)
 {
 	++attempt->connections;
 	receive_buffer->resize (256);
@@ -150,6 +156,31 @@ double nano::bootstrap_client::elapsed_seconds () const
 	return std::chrono::duration_cast<std::chrono::duration<double>> (std::chrono::steady_clock::now () - start_time).count ();
 }
 
+void nano::bootstrap_client::pull_finished (uint64_t blocks_a, std::chrono::steady_clock::duration duration_a, bool failed_a)
+{
+	auto seconds (std::chrono::duration_cast<std::chrono::duration<double>> (duration_a).count ());
+	if (seconds > 0.0)
+	{
+		auto rate (blocks_a / seconds);
+		recent_rate = (pulls_succeeded + pulls_failed == 0) ? rate : recent_rate + bootstrap_recent_rate_weight * (rate - recent_rate);
+	}
+	if (failed_a)
+	{
+		++pulls_failed;
+	}
+	else
+	{
+		++pulls_succeeded;
+	}
+}
+
+double nano::bootstrap_client::score () const
+{
+	// Peers which haven't finished a pull yet are ranked by their overall rate
+	auto rate (pulls_succeeded + pulls_failed == 0 ? block_rate () : recent_rate);
+	return rate * (pulls_succeeded + 1) / (pulls_succeeded + pulls_failed + 1);
+}
+
 void nano::bootstrap_client::stop (bool force)
 {
 	pending_stop = true;
@@ -421,22 +452,34 @@ unexpected_count (0)
 
 nano::bulk_pull_client::~bulk_pull_client ()
 {
+	// Count limited pulls stop short by design, the rest of the chain is pulled as a continuation
+	auto limited (pull.count != 0 && total_blocks >= pull.count);
+	auto failed (expected != pull.end && !limited);
 	// If received end block is not expected end block
 	if (expected != pull.end)
 	{
 		pull.head = expected;
-		if (connection->attempt->mode != nano::bootstrap_mode::legacy)
+		if (connection->attempt->mode != nano::bootstrap_mode::legacy || limited)
 		{
 			pull.account = expected;
 		}
-		connection->attempt->requeue_pull (pull);
-		if (connection->node->config.logging.bulk_pull_logging ())
+		if (limited)
+		{
+			pull.processed += total_blocks;
+			connection->attempt->continue_pull (pull);
+		}
+		else
 		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull end block is not expected %1% for account %2%") % pull.end.to_string () % pull.account.to_account ());
+			connection->attempt->requeue_pull (pull);
+			if (connection->node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull end block is not expected %1% for account %2%") % pull.end.to_string () % pull.account.to_account ());
+			}
 		}
 	}
 	{
 		std::lock_guard<std::mutex> mutex (connection->attempt->mutex);
+		connection->pull_finished (total_blocks, std::chrono::steady_clock::now () - start_time, failed);
 		--connection->attempt->pulling;
 	}
 	connection->attempt->condition.notify_all ();
@@ -445,6 +488,7 @@ nano::bulk_pull_client::~bulk_pull_client ()
 void nano::bulk_pull_client::request ()
 {
 	expected = pull.head;
+	start_time = std::chrono::steady_clock::now ();
 	nano::bulk_pull req;
 	req.start = pull.account;
 	req.end = pull.end;
@@ -544,7 +588,7 @@ void nano::bulk_pull_client::received_type ()
 		case nano::block_type::not_a_block:
 		{
 			// Avoid re-using slow peers, or peers that sent the wrong blocks.
-			if (!connection->pending_stop && expected == pull.end)
+			if (!connection->pending_stop && (expected == pull.end || (pull.count != 0 && total_blocks >= pull.count)))
 			{
 				connection->attempt->pool_connection (connection);
 			}
@@ -881,7 +925,8 @@ nano::pull_info::pull_info () :
 account (0),
 end (0),
 count (0),
-attempts (0)
+attempts (0),
+processed (0)
 {
 }
 
@@ -890,7 +935,8 @@ account (account_a),
 head (head_a),
 end (end_a),
 count (count_a),
-attempts (0)
+attempts (0),
+processed (0)
 {
 }
 
@@ -901,6 +947,10 @@ pulling (0),
 node (node_a),
 account_count (0),
 total_blocks (0),
+connections_target (node_a->config.bootstrap_connections),
+connections_rate (0.0),
+connections_blocks (0),
+connections_adjusted (std::chrono::steady_clock::now ()),
 stopped (false),
 mode (nano::bootstrap_mode::legacy),
 lazy_stopped (0)
@@ -966,7 +1016,8 @@ bool nano::bootstrap_attempt::request_frontier (std::unique_lock<std::mutex> & l
 
 void nano::bootstrap_attempt::request_pull (std::unique_lock<std::mutex> & lock_a)
 {
-	auto connection_l (connection (lock_a));
+	// Continuations of long chains go to the best scoring peer
+	auto connection_l (connection (lock_a, !pulls.empty () && pulls.front ().processed != 0));
 	if (connection_l)
 	{
 		auto pull (pulls.front ());
@@ -982,6 +1033,10 @@ void nano::bootstrap_attempt::request_pull (std::unique_lock<std::mutex> & lock_
 				pulls.pop_front ();
 			}
 		}
+		else if (pull.count == 0)
+		{
+			pull.count = pull_split_count;
+		}
 		++pulling;
 		// The bulk_pull_client destructor attempt to requeue_pull which can cause a deadlock if this is the last reference
 		// Dispatch request in an external thread in case it needs to be destroyed
@@ -1095,7 +1150,7 @@ void nano::bootstrap_attempt::run ()
 	idle.clear ();
 }
 
-std::shared_ptr<nano::bootstrap_client> nano::bootstrap_attempt::connection (std::unique_lock<std::mutex> & lock_a)
+std::shared_ptr<nano::bootstrap_client> nano::bootstrap_attempt::connection (std::unique_lock<std::mutex> & lock_a, bool best_a)
 {
 	while (!stopped && idle.empty ())
 	{
@@ -1104,8 +1159,19 @@ std::shared_ptr<nano::bootstrap_client> nano::bootstrap_attempt::connection (std
 	std::shared_ptr<nano::bootstrap_client> result;
 	if (!idle.empty ())
 	{
-		result = idle.back ();
-		idle.pop_back ();
+		if (best_a)
+		{
+			auto best (std::max_element (idle.begin (), idle.end (), [](std::shared_ptr<nano::bootstrap_client> const & lhs, std::shared_ptr<nano::bootstrap_client> const & rhs) {
+				return lhs->score () < rhs->score ();
+			}));
+			result = *best;
+			idle.erase (best);
+		}
+		else
+		{
+			result = idle.back ();
+			idle.pop_back ();
+		}
 	}
 	return result;
 }
@@ -1132,17 +1198,33 @@ struct block_rate_cmp
 	}
 };
 
-unsigned nano::bootstrap_attempt::target_connections (size_t pulls_remaining)
+unsigned nano::bootstrap_attempt::target_connections ()
 {
 	if (node->config.bootstrap_connections >= node->config.bootstrap_connections_max)
 	{
 		return std::max (1U, node->config.bootstrap_connections_max);
 	}
 
-	// Only scale up to bootstrap_connections_max for large pulls.
-	double step = std::min (1.0, std::max (0.0, (double)pulls_remaining / bootstrap_connection_scale_target_blocks));
-	double target = (double)node->config.bootstrap_connections + (double)(node->config.bootstrap_connections_max - node->config.bootstrap_connections) * step;
-	return std::max (1U, (unsigned)(target + 0.5f));
+	auto target (std::min (node->config.bootstrap_connections_max, std::max (node->config.bootstrap_connections, connections_target.load ())));
+	return std::max (1U, target);
+}
+
+void nano::bootstrap_attempt::adjust_target_connections (double rate_a, size_t pulls_remaining_a)
+{
+	// Keep adding connections while they raise aggregate throughput and there's work for them, back off once they stop helping
+	auto target (target_connections ());
+	if (rate_a > connections_rate * (1.0 + bootstrap_connection_rate_gain))
+	{
+		if (pulls_remaining_a > target)
+		{
+			connections_target = target + std::max (2U, target / 4);
+		}
+	}
+	else if (rate_a < connections_rate * (1.0 - bootstrap_connection_rate_gain))
+	{
+		connections_target = target - 1;
+	}
+	connections_rate = rate_a;
 }
 
 void nano::bootstrap_attempt::populate_connections ()
@@ -1183,9 +1265,17 @@ void nano::bootstrap_attempt::populate_connections ()
 		}
 		// Cleanup expired clients
 		clients.swap (new_clients);
+		auto now (std::chrono::steady_clock::now ());
+		if (now - connections_adjusted >= bootstrap_connection_adjust_interval)
+		{
+			auto blocks (total_blocks.load ());
+			adjust_target_connections ((blocks - connections_blocks) / std::chrono::duration_cast<std::chrono::duration<double>> (now - connections_adjusted).count (), num_pulls);
+			connections_blocks = blocks;
+			connections_adjusted = now;
+		}
 	}
 
-	auto target = target_connections (num_pulls);
+	auto target = target_connections ();
 
 	// We only want to drop slow peers when more than 2/3 are active. 2/3 because 1/2 is too aggressive, and 100% rarely happens.
 	// Probably needs more tuning.
@@ -1344,6 +1434,16 @@ void nano::bootstrap_attempt::requeue_pull (nano::pull_info const & pull_a)
 	}
 }
 
+void nano::bootstrap_attempt::continue_pull (nano::pull_info const & pull_a)
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		// Pulled next so the chain can be processed before its newest blocks pile up in unchecked
+		pulls.push_front (pull_a);
+	}
+	condition.notify_all ();
+}
+
 void nano::bootstrap_attempt::add_bulk_push_target (nano::block_hash const & head, nano::block_hash const & end)
 {
 	std::lock_guard<std::mutex> lock (mutex);
@@ -1513,7 +1613,7 @@ bool nano::bootstrap_attempt::process_block (std::shared_ptr<nano::block> block_
 			if (!node->store.block_exists (transaction, block_a->type (), hash))
 			{
 				nano::uint128_t balance (std::numeric_limits<nano::uint128_t>::max ());
-				node->block_processor.add (block_a, std::chrono::steady_clock::time_point ());
+				node->block_processor.add (block_a, std::chrono::steady_clock::time_point (), true);
 				// Search for new dependencies
 				if (!block_a->source ().is_zero () && !node->store.block_exists (transaction, block_a->source ()))
 				{
@@ -1647,7 +1747,7 @@ bool nano::bootstrap_attempt::process_block (std::shared_ptr<nano::block> block_
 	}
 	else
 	{
-		node->block_processor.add (block_a, std::chrono::steady_clock::time_point ());
+		node->block_processor.add (block_a, std::chrono::steady_clock::time_point (), true);
 	}
 	return stop_pull;
 }
@@ -2305,19 +2405,32 @@ void nano::bulk_pull_server::set_current_end ()
 
 void nano::bulk_pull_server::send_next ()
 {
-	auto block (get_next ());
-	if (block != nullptr)
+	send_buffer->clear ();
+	auto finished (false);
 	{
+		// Raw block bytes are copied from the store under one transaction so many blocks go out in each write
+		auto transaction (connection->node->store.tx_begin_read ());
+		while (!finished && send_buffer->size () < send_buffer_size)
 		{
-			send_buffer->clear ();
-			nano::vectorstream stream (*send_buffer);
-			nano::serialize_block (stream, *block);
+			auto last (false);
+			finished = !current_included (last);
+			if (!finished)
+			{
+				auto hash (current);
+				nano::block_hash previous (0);
+				finished = connection->node->store.block_serialize (transaction, hash, *send_buffer, previous);
+				advance (!finished, previous, last);
+				if (!finished && connection->node->config.logging.bulk_pull_logging ())
+				{
+					BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % hash.to_string ());
+				}
+			}
+			include_start = false;
 		}
+	}
+	if (!finished)
+	{
 		auto this_l (shared_from_this ());
-		if (connection->node->config.logging.bulk_pull_logging ())
-		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % block->hash ().to_string ());
-		}
 		connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
 			this_l->sent_action (ec, size_a);
 		});
@@ -2328,67 +2441,61 @@ void nano::bulk_pull_server::send_next ()
 	}
 }
 
-std::shared_ptr<nano::block> nano::bulk_pull_server::get_next ()
+/*
+ * Determine if we should reply with the block under the cursor
+ *
+ * If our cursor is on the final block, we should signal that we
+ * are done by returning false.
+ *
+ * Unless we are including the "start" member and this is the
+ * start member, then include it anyway and set last_a so the
+ * cursor moves to the end afterwards.
+ *
+ * Account for how many blocks we have provided.  If this
+ * exceeds the requested maximum, signal the end of results
+ */
+bool nano::bulk_pull_server::current_included (bool & last_a)
 {
-	std::shared_ptr<nano::block> result;
-	bool send_current = false, set_current_to_end = false;
-
-	/*
-	 * Determine if we should reply with a block
-	 *
-	 * If our cursor is on the final block, we should signal that we
-	 * are done by returning a null result.
-	 *
-	 * Unless we are including the "start" member and this is the
-	 * start member, then include it anyway.
-	 */
+	auto result (false);
+	last_a = false;
 	if (current != request->end)
 	{
-		send_current = true;
+		result = true;
 	}
-	else if (current == request->end && include_start == true)
+	else if (include_start)
 	{
-		send_current = true;
-
-		/*
-		 * We also need to ensure that the next time
-		 * are invoked that we return a null result
-		 */
-		set_current_to_end = true;
+		result = true;
+		last_a = true;
 	}
-
-	/*
-	 * Account for how many blocks we have provided.  If this
-	 * exceeds the requested maximum, return an empty object
-	 * to signal the end of results
-	 */
 	if (max_count != 0 && sent_count >= max_count)
 	{
-		send_current = false;
+		result = false;
 	}
+	return result;
+}
 
-	if (send_current)
+void nano::bulk_pull_server::advance (bool found_a, nano::block_hash const & previous_a, bool last_a)
+{
+	if (found_a && !last_a && !previous_a.is_zero ())
+	{
+		current = previous_a;
+	}
+	else
+	{
+		current = request->end;
+	}
+	sent_count++;
+}
+
+std::shared_ptr<nano::block> nano::bulk_pull_server::get_next ()
+{
+	std::shared_ptr<nano::block> result;
+	auto last (false);
+	if (current_included (last))
 	{
 		auto transaction (connection->node->store.tx_begin_read ());
 		result = connection->node->store.block_get (transaction, current);
-		if (result != nullptr && set_current_to_end == false)
-		{
-			auto previous (result->previous ());
-			if (!previous.is_zero ())
-			{
-				current = previous;
-			}
-			else
-			{
-				current = request->end;
-			}
-		}
-		else
-		{
-			current = request->end;
-		}
-
-		sent_count++;
+		advance (result != nullptr, result != nullptr ? result->previous () : nano::block_hash (0), last);
 	}
 
 	/*
@@ -2417,7 +2524,7 @@ void nano::bulk_pull_server::sent_action (boost::system::error_code const & ec,
 
 void nano::bulk_pull_server::send_finished ()
 {
-	send_buffer->clear ();
+	// Terminates whatever blocks are still in the buffer from the last batch
 	send_buffer->push_back (static_cast<uint8_t> (nano::block_type::not_a_block));
 	auto this_l (shared_from_this ());
 	if (connection->node->config.logging.bulk_pull_logging ())
@@ -2433,7 +2540,7 @@ void nano::bulk_pull_server::no_block_sent (boost::system::error_code const & ec
 {
 	if (!ec)
 	{
-		assert (size_a == 1);
+		assert (size_a == send_buffer->size ());
 		connection->finish_request ();
 	}
 	else
@@ -2901,7 +3008,7 @@ void nano::bulk_push_server::received_block (boost::system::error_code const & e
 		auto block (nano::deserialize_block (stream, type_a));
 		if (block != nullptr && !nano::work_validate (*block))
 		{
-			connection->node->process_active (std::move (block));
+			connection->node->process_active (std::move (block), true);
 			receive ();
 		}
 		else
@@ -61,6 +61,8 @@ public:
 	nano::block_hash end;
 	count_t count;
 	unsigned attempts;
+	/** Blocks already pulled from earlier pieces of a long chain */
+	uint64_t processed;
 };
 enum class bootstrap_mode
 {
@@ -77,7 +79,7 @@ public:
 	bootstrap_attempt (std::shared_ptr<nano::node> node_a);
 	~bootstrap_attempt ();
 	void run ();
-	std::shared_ptr<nano::bootstrap_client> connection (std::unique_lock<std::mutex> &);
+	std::shared_ptr<nano::bootstrap_client> connection (std::unique_lock<std::mutex> &, bool = false);
 	bool consume_future (std::future<bool> &);
 	void populate_connections ();
 	bool request_frontier (std::unique_lock<std::mutex> &);
@@ -87,9 +89,11 @@ public:
 	void pool_connection (std::shared_ptr<nano::bootstrap_client>);
 	void stop ();
 	void requeue_pull (nano::pull_info const &);
+	void continue_pull (nano::pull_info const &);
 	void add_pull (nano::pull_info const &);
 	bool still_pulling ();
-	unsigned target_connections (size_t pulls_remaining);
+	unsigned target_connections ();
+	void adjust_target_connections (double, size_t);
 	bool should_log ();
 	void add_bulk_push_target (nano::block_hash const &, nano::block_hash const &);
 	bool process_block (std::shared_ptr<nano::block>, uint64_t, bool);
@@ -116,6 +120,14 @@ public:
 	std::shared_ptr<nano::node> node;
 	std::atomic<unsigned> account_count;
 	std::atomic<uint64_t> total_blocks;
+	/** Connection count being aimed for, adjusted by adjust_target_connections */
+	std::atomic<unsigned> connections_target;
+	/** Aggregate blocks per second measured at the last adjustment */
+	double connections_rate;
+	uint64_t connections_blocks;
+	std::chrono::steady_clock::time_point connections_adjusted;
+	/** Legacy pulls are requested in pieces of this many blocks so long chains can move to faster peers */
+	nano::pull_info::count_t pull_split_count = (nano::nano_network == nano::nano_networks::nano_test_network) ? 4 : 16384;
 	std::vector<std::pair<nano::block_hash, nano::block_hash>> bulk_push_targets;
 	bool stopped;
 	nano::bootstrap_mode mode;
@@ -172,6 +184,7 @@ public:
 	nano::pull_info pull;
 	uint64_t total_blocks;
 	uint64_t unexpected_count;
+	std::chrono::steady_clock::time_point start_time;
 };
 class bootstrap_client : public std::enable_shared_from_this<bootstrap_client>
 {
@@ -183,6 +196,8 @@ public:
 	void stop (bool force);
 	double block_rate () const;
 	double elapsed_seconds () const;
+	void pull_finished (uint64_t, std::chrono::steady_clock::duration, bool);
+	double score () const;
 	std::shared_ptr<nano::node> node;
 	std::shared_ptr<nano::bootstrap_attempt> attempt;
 	std::shared_ptr<nano::socket> socket;
@@ -192,6 +207,10 @@ public:
 	std::atomic<uint64_t> block_count;
 	std::atomic<bool> pending_stop;
 	std::atomic<bool> hard_stop;
+	/** Blocks per second over recent pulls, guarded by the attempt mutex along with the pull counts */
+	double recent_rate;
+	unsigned pulls_succeeded;
+	unsigned pulls_failed;
 };
 class bulk_push_client : public std::enable_shared_from_this<nano::bulk_push_client>
 {
@@ -289,6 +308,8 @@ class bulk_pull_server : public std::enable_shared_from_this<nano::bulk_pull_ser
 public:
 	bulk_pull_server (std::shared_ptr<nano::bootstrap_server> const &, std::unique_ptr<nano::bulk_pull>);
 	void set_current_end ();
+	bool current_included (bool &);
+	void advance (bool, nano::block_hash const &, bool);
 	std::shared_ptr<nano::block> get_next ();
 	void send_next ();
 	void sent_action (boost::system::error_code const &, size_t);
@@ -301,6 +322,8 @@ public:
 	bool include_start;
 	nano::bulk_pull::count_t max_count;
 	nano::bulk_pull::count_t sent_count;
+	/** Blocks are batched until a write reaches this many bytes */
+	static size_t constexpr send_buffer_size = 128 * 1024;
 };
 class bulk_pull_account;
 class bulk_pull_account_server : public std::enable_shared_from_this<nano::bulk_pull_account_server>
@@ -3,6 +3,8 @@
 #include <nano/node/common.hpp>
 #include <nano/node/node.hpp>
 
+#include <boost/polymorphic_cast.hpp>
+
 std::string nano::error_cli_messages::message (int ev) const
 {
 	switch (static_cast<nano::error_cli> (ev))
@@ -29,6 +31,8 @@ void nano::add_node_options (boost::program_options::options_description & descr
 	("account_key", "Get the public key for <account>")
 	("vacuum", "Compact database. If data_path is missing, the database in data directory is compacted.")
 	("snapshot", "Compact database and create snapshot, functions similar to vacuum but does not replace the existing database")
+	("snapshot_export", "Write the ledger to a checksummed snapshot <file> which can be imported by new nodes")
+	("snapshot_import", "Bulk load the ledger from a snapshot <file> in to an empty data directory. Only block hashes are checked, the account, pending and weight tables are trusted as is so only import snapshots from a trusted source")
 	("unchecked_clear", "Clear unchecked blocks")
 	("data_path", boost::program_options::value<std::string> (), "Use the supplied path as the data directory")
 	("delete_node_id", "Delete the node ID in the database")
@@ -242,6 +246,81 @@ std::error_code nano::handle_node_options (boost::program_options::variables_map
 			std::cerr << "Snapshot Failed (unknown reason)" << std::endl;
 		}
 	}
+	else if (vm.count ("snapshot_export"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			boost::filesystem::path snapshot_path (vm["file"].as<std::string> ());
+			std::cout << "Exporting ledger in " << data_path << " to " << snapshot_path << std::endl;
+			std::cout << "This may take a while..." << std::endl;
+			inactive_node node (data_path);
+			auto error (boost::polymorphic_downcast<nano::mdb_store *> (node.node->store_impl.get ())->snapshot_export (snapshot_path));
+			if (!error)
+			{
+				std::cout << "Snapshot export completed" << std::endl;
+			}
+			else
+			{
+				std::cerr << "Snapshot export failed, the database needs to be upgraded to the current version first" << std::endl;
+				ec = nano::error_cli::generic;
+			}
+		}
+		else
+		{
+			std::cerr << "snapshot_export requires one <file> option\n";
+			ec = nano::error_cli::invalid_arguments;
+		}
+	}
+	else if (vm.count ("snapshot_import"))
+	{
+		if (vm.count ("file") == 1)
+		{
+			boost::filesystem::path snapshot_path (vm["file"].as<std::string> ());
+			auto source_path = data_path / "data.ldb";
+			auto import_path = data_path / "import.ldb";
+			// lmdb creates a -lock suffixed file for its MDB_NOSUBDIR databases
+			auto import_lock_path (import_path);
+			import_lock_path += "-lock";
+			if (!boost::filesystem::exists (source_path))
+			{
+				std::cout << "Importing snapshot " << snapshot_path << " in to " << data_path << std::endl;
+				std::cout << "Only block hashes are verified, the snapshot must come from a trusted source" << std::endl;
+				std::cout << "This may take a while..." << std::endl;
+				boost::filesystem::remove (import_path);
+				auto error (false);
+				{
+					// Scope the store so the environment is closed before the file is moved in place
+					nano::logging logging;
+					logging.init (data_path);
+					nano::mdb_store store (error, logging, import_path);
+					error = error || store.snapshot_import (snapshot_path, std::max (1u, std::thread::hardware_concurrency ()));
+				}
+				if (!error)
+				{
+					boost::filesystem::rename (import_path, source_path);
+					boost::filesystem::remove (import_lock_path);
+					std::cout << "Snapshot import completed" << std::endl;
+				}
+				else
+				{
+					boost::filesystem::remove (import_path);
+					boost::filesystem::remove (import_lock_path);
+					std::cerr << "Snapshot import failed, the file is corrupt or from a different database version" << std::endl;
+					ec = nano::error_cli::generic;
+				}
+			}
+			else
+			{
+				std::cerr << "Snapshot import requires an empty data directory, " << source_path << " already exists\n";
+				ec = nano::error_cli::invalid_arguments;
+			}
+		}
+		else
+		{
+			std::cerr << "snapshot_import requires one <file> option\n";
+			ec = nano::error_cli::invalid_arguments;
+		}
+	}
 	else if (vm.count ("unchecked_clear"))
 	{
 		boost::filesystem::path data_path = vm.count ("data_path") ? boost::filesystem::path (vm["data_path"].as<std::string> ()) : nano::working_path ();
@@ -181,11 +181,12 @@ std::string nano::message_parser::status_string ()
 	return "[unknown parse_status]";
 }
 
-nano::message_parser::message_parser (nano::block_uniquer & block_uniquer_a, nano::vote_uniquer & vote_uniquer_a, nano::message_visitor & visitor_a, nano::work_pool & pool_a) :
+nano::message_parser::message_parser (nano::block_uniquer & block_uniquer_a, nano::vote_uniquer & vote_uniquer_a, nano::message_visitor & visitor_a, nano::work_pool & pool_a, bool validate_work_a) :
 block_uniquer (block_uniquer_a),
 vote_uniquer (vote_uniquer_a),
 visitor (visitor_a),
 pool (pool_a),
+validate_work (validate_work_a),
 status (parse_status::success)
 {
 }
@@ -281,7 +282,7 @@ void nano::message_parser::deserialize_publish (nano::stream & stream_a, nano::m
 	nano::publish incoming (error, stream_a, header_a, &block_uniquer);
 	if (!error && at_end (stream_a))
 	{
-		if (!nano::work_validate (*incoming.block))
+		if (!validate_work || !nano::work_validate (*incoming.block))
 		{
 			visitor.publish (incoming);
 		}
@@ -302,7 +303,7 @@ void nano::message_parser::deserialize_confirm_req (nano::stream & stream_a, nan
 	nano::confirm_req incoming (error, stream_a, header_a, &block_uniquer);
 	if (!error && at_end (stream_a))
 	{
-		if (!nano::work_validate (*incoming.block))
+		if (!validate_work || !nano::work_validate (*incoming.block))
 		{
 			visitor.confirm_req (incoming);
 		}
@@ -323,15 +324,18 @@ void nano::message_parser::deserialize_confirm_ack (nano::stream & stream_a, nan
 	nano::confirm_ack incoming (error, stream_a, header_a, &vote_uniquer);
 	if (!error && at_end (stream_a))
 	{
-		for (auto & vote_block : incoming.vote->blocks)
+		if (validate_work)
 		{
-			if (!vote_block.which ())
+			for (auto & vote_block : incoming.vote->blocks)
 			{
-				auto block (boost::get<std::shared_ptr<nano::block>> (vote_block));
-				if (nano::work_validate (*block))
+				if (!vote_block.which ())
 				{
-					status = parse_status::insufficient_work;
-					break;
+					auto block (boost::get<std::shared_ptr<nano::block>> (vote_block));
+					if (nano::work_validate (*block))
+					{
+						status = parse_status::insufficient_work;
+						break;
+					}
 				}
 			}
 		}
@@ -254,7 +254,8 @@ public:
 		invalid_magic,
 		invalid_network
 	};
-	message_parser (nano::block_uniquer &, nano::vote_uniquer &, nano::message_visitor &, nano::work_pool &);
+	/** When work validation is off the visitor is responsible for checking the work of publish, confirm_req and confirm_ack blocks, e.g. in batches with nano::work_validate_batch */
+	message_parser (nano::block_uniquer &, nano::vote_uniquer &, nano::message_visitor &, nano::work_pool &, bool = true);
 	void deserialize_buffer (uint8_t const *, size_t);
 	void deserialize_keepalive (nano::stream &, nano::message_header const &);
 	void deserialize_publish (nano::stream &, nano::message_header const &);
@@ -266,6 +267,7 @@ public:
 	nano::vote_uniquer & vote_uniquer;
 	nano::message_visitor & visitor;
 	nano::work_pool & pool;
+	bool validate_work;
 	parse_status status;
 	std::string status_string ();
 	static const size_t max_safe_udp_message_size;
@@ -0,0 +1,326 @@
+#include <nano/node/http_callbacks.hpp>
+
+#include <nano/node/node.hpp>
+
+nano::http_callback_connection::http_callback_connection (nano::node & node_a) :
+node (node_a),
+resolver (node_a.io_ctx),
+socket (node_a.io_ctx),
+timer (node_a.io_ctx),
+connected (false),
+reused (false),
+timed_out (false)
+{
+}
+
+std::chrono::seconds constexpr nano::http_callback_connection::timeout;
+
+void nano::http_callback_connection::send (std::vector<nano::http_callback_item> batch_a)
+{
+	batch = std::move (batch_a);
+	std::string body;
+	if (batch.size () == 1)
+	{
+		body = std::move (batch.front ().body);
+	}
+	else
+	{
+		body.push_back ('[');
+		for (auto & i : batch)
+		{
+			if (body.size () > 1)
+			{
+				body.push_back (',');
+			}
+			body.append (i.body);
+		}
+		body.append ("]\n");
+	}
+	request = {};
+	request.method (boost::beast::http::verb::post);
+	request.target (node.config.callback_target);
+	request.version (11);
+	request.insert (boost::beast::http::field::host, node.config.callback_address);
+	request.insert (boost::beast::http::field::content_type, "application/json");
+	request.keep_alive (true);
+	request.body () = std::move (body);
+	request.prepare_payload ();
+	timed_out = false;
+	deadline ();
+	if (connected)
+	{
+		reused = true;
+		write ();
+	}
+	else
+	{
+		connect ();
+	}
+}
+
+void nano::http_callback_connection::connect ()
+{
+	auto this_l (shared_from_this ());
+	auto node_l (node.shared ());
+	resolver.async_resolve (boost::asio::ip::tcp::resolver::query (node.config.callback_address, std::to_string (node.config.callback_port)), [this_l, node_l](boost::system::error_code const & ec, boost::asio::ip::tcp::resolver::iterator i_a) {
+		if (!ec)
+		{
+			this_l->connect (i_a);
+		}
+		else
+		{
+			this_l->failed ("Error resolving callback", ec);
+		}
+	});
+}
+
+void nano::http_callback_connection::connect (boost::asio::ip::tcp::resolver::iterator i_a)
+{
+	if (i_a != boost::asio::ip::tcp::resolver::iterator{})
+	{
+		auto this_l (shared_from_this ());
+		auto node_l (node.shared ());
+		socket.async_connect (i_a->endpoint (), [this_l, node_l, i_a](boost::system::error_code const & ec) mutable {
+			if (!ec)
+			{
+				this_l->connected = true;
+				this_l->reused = false;
+				this_l->write ();
+			}
+			else
+			{
+				if (node_l->config.logging.callback_logging ())
+				{
+					BOOST_LOG (node_l->log) << boost::str (boost::format ("Unable to connect to callback address: %1%:%2%: %3%") % node_l->config.callback_address % node_l->config.callback_port % ec.message ());
+				}
+				if (!this_l->timed_out)
+				{
+					boost::system::error_code ignored;
+					this_l->socket.close (ignored);
+					++i_a;
+					this_l->connect (i_a);
+				}
+				else
+				{
+					this_l->failed ("Callback timed out connecting", ec);
+				}
+			}
+		});
+	}
+	else
+	{
+		finish (true);
+	}
+}
+
+void nano::http_callback_connection::write ()
+{
+	auto this_l (shared_from_this ());
+	auto node_l (node.shared ());
+	boost::beast::http::async_write (socket, request, [this_l, node_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		if (!ec)
+		{
+			this_l->response = {};
+			boost::beast::http::async_read (this_l->socket, this_l->buffer, this_l->response, [this_l, node_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+				if (!ec)
+				{
+					auto ok (this_l->response.result () == boost::beast::http::status::ok);
+					if (!ok && node_l->config.logging.callback_logging ())
+					{
+						BOOST_LOG (node_l->log) << boost::str (boost::format ("Callback to %1%:%2% failed with status: %3%") % node_l->config.callback_address % node_l->config.callback_port % this_l->response.result ());
+					}
+					if (!this_l->response.keep_alive ())
+					{
+						this_l->close ();
+					}
+					this_l->finish (!ok);
+				}
+				else
+				{
+					this_l->failed ("Unable complete callback", ec);
+				}
+			});
+		}
+		else
+		{
+			this_l->failed ("Unable to send callback", ec);
+		}
+	});
+}
+
+void nano::http_callback_connection::deadline ()
+{
+	auto this_l (shared_from_this ());
+	timer.expires_after (timeout);
+	timer.async_wait ([this_l](boost::system::error_code const & ec) {
+		// A timer cancelled or re-armed after its expiry was queued must not abort the next request
+		if (ec != boost::asio::error::operation_aborted && this_l->timer.expiry () <= std::chrono::steady_clock::now () && !this_l->batch.empty ())
+		{
+			this_l->timed_out = true;
+			this_l->resolver.cancel ();
+			boost::system::error_code ignored;
+			this_l->socket.close (ignored);
+		}
+	});
+}
+
+void nano::http_callback_connection::failed (char const * what_a, boost::system::error_code const & ec)
+{
+	close ();
+	if (timed_out)
+	{
+		node.stats.inc (nano::stat::type::http_callback, nano::stat::detail::timeout, nano::stat::dir::out);
+	}
+	if (reused && !timed_out)
+	{
+		// The receiver may have timed out the idle connection, the batch is sent once more on a new one
+		reused = false;
+		deadline ();
+		connect ();
+	}
+	else
+	{
+		if (node.config.logging.callback_logging ())
+		{
+			BOOST_LOG (node.log) << boost::str (boost::format ("%1%: %2%:%3%: %4%") % what_a % node.config.callback_address % node.config.callback_port % ec.message ());
+		}
+		finish (true);
+	}
+}
+
+void nano::http_callback_connection::finish (bool error_a)
+{
+	timer.cancel ();
+	auto now (std::chrono::steady_clock::now ());
+	for (auto & i : batch)
+	{
+		if (!error_a)
+		{
+			node.stats.inc (nano::stat::type::http_callback, nano::stat::detail::initiate, nano::stat::dir::out);
+		}
+		else
+		{
+			node.stats.inc (nano::stat::type::error, nano::stat::detail::http_callback, nano::stat::dir::out);
+		}
+		node.stats.add_histogram (nano::stat::type::http_callback, "latency", std::chrono::duration_cast<std::chrono::microseconds> (now - i.queued).count ());
+	}
+	batch.clear ();
+	auto next (node.http_callbacks.next (shared_from_this ()));
+	if (!next.empty ())
+	{
+		send (std::move (next));
+	}
+}
+
+void nano::http_callback_connection::close ()
+{
+	connected = false;
+	boost::system::error_code ignored;
+	socket.shutdown (boost::asio::ip::tcp::socket::shutdown_both, ignored);
+	socket.close (ignored);
+	timer.cancel ();
+	buffer.consume (buffer.size ());
+}
+
+nano::http_callbacks::http_callbacks (nano::node & node_a) :
+node (node_a),
+connections (0),
+stopped (false)
+{
+}
+
+bool nano::http_callbacks::add (std::string const & body_a)
+{
+	auto result (false);
+	std::shared_ptr<nano::http_callback_connection> connection;
+	std::vector<nano::http_callback_item> batch_l;
+	{
+		std::unique_lock<std::mutex> lock (mutex);
+		if (!stopped && queue.size () < node.config.callback_queue_max)
+		{
+			queue.push_back ({ body_a, std::chrono::steady_clock::now () });
+			node.stats.add_histogram (nano::stat::type::http_callback, "queue_depth", queue.size ());
+			if (!idle.empty ())
+			{
+				connection = idle.back ();
+				idle.pop_back ();
+			}
+			else if (connections < node.config.callback_connections)
+			{
+				connection = std::make_shared<nano::http_callback_connection> (node);
+				++connections;
+			}
+			if (connection != nullptr)
+			{
+				batch_l = batch (lock);
+			}
+		}
+		else
+		{
+			result = true;
+		}
+	}
+	if (result)
+	{
+		node.stats.inc (nano::stat::type::http_callback, nano::stat::detail::overflow, nano::stat::dir::out);
+	}
+	else if (connection != nullptr)
+	{
+		connection->send (std::move (batch_l));
+	}
+	return result;
+}
+
+std::vector<nano::http_callback_item> nano::http_callbacks::next (std::shared_ptr<nano::http_callback_connection> connection_a)
+{
+	std::vector<nano::http_callback_item> result;
+	std::unique_lock<std::mutex> lock (mutex);
+	if (stopped)
+	{
+		connection_a->close ();
+	}
+	else if (queue.empty ())
+	{
+		idle.push_back (connection_a);
+	}
+	else
+	{
+		result = batch (lock);
+	}
+	return result;
+}
+
+std::vector<nano::http_callback_item> nano::http_callbacks::batch (std::unique_lock<std::mutex> & lock_a)
+{
+	assert (lock_a.owns_lock ());
+	std::vector<nano::http_callback_item> result;
+	auto count (std::min<size_t> (queue.size (), std::max (1U, node.config.callback_batch_max)));
+	result.reserve (count);
+	for (size_t i (0); i < count; ++i)
+	{
+		result.push_back (std::move (queue.front ()));
+		queue.pop_front ();
+	}
+	return result;
+}
+
+void nano::http_callbacks::stop ()
+{
+	decltype (idle) idle_l;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+		queue.clear ();
+		idle.swap (idle_l);
+	}
+	for (auto & i : idle_l)
+	{
+		i->close ();
+	}
+}
+
+size_t nano::http_callbacks::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return queue.size ();
+}
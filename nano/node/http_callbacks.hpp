@@ -0,0 +1,82 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nano
+{
+class node;
+/** A callback body waiting to be posted */
+class http_callback_item
+{
+public:
+	std::string body;
+	std::chrono::steady_clock::time_point queued;
+};
+/**
+ * One persistent HTTP/1.1 connection to the callback receiver.
+ * It posts the batches handed out by nano::http_callbacks one at a time and reconnects when the receiver closed it.
+ * A request which does not complete within timeout is aborted and fails its batch.
+ */
+class http_callback_connection : public std::enable_shared_from_this<nano::http_callback_connection>
+{
+public:
+	http_callback_connection (nano::node &);
+	void send (std::vector<nano::http_callback_item>);
+	void close ();
+
+private:
+	void connect ();
+	void connect (boost::asio::ip::tcp::resolver::iterator);
+	void write ();
+	/** Starts the deadline for the request in flight, when it expires the pending resolve, connect, write or read is aborted */
+	void deadline ();
+	void failed (char const *, boost::system::error_code const &);
+	void finish (bool);
+	nano::node & node;
+	boost::asio::ip::tcp::resolver resolver;
+	boost::asio::ip::tcp::socket socket;
+	boost::asio::steady_timer timer;
+	boost::beast::flat_buffer buffer;
+	boost::beast::http::request<boost::beast::http::string_body> request;
+	boost::beast::http::response<boost::beast::http::string_body> response;
+	std::vector<nano::http_callback_item> batch;
+	bool connected;
+	/** The connection served an earlier request, so a failure may just mean the receiver closed it while idle */
+	bool reused;
+	bool timed_out;
+	static std::chrono::seconds constexpr timeout = std::chrono::seconds (15);
+};
+/**
+ * Posts block confirmations to the configured callback receiver over at most node_config::callback_connections persistent connections.
+ * Bodies wait in a queue bounded by node_config::callback_queue_max, when it's full new bodies are dropped.
+ * A connection takes up to node_config::callback_batch_max queued bodies per request, several bodies are posted as a JSON array.
+ */
+class http_callbacks
+{
+public:
+	http_callbacks (nano::node &);
+	/** Queues a body, returns true if the queue is full and the body was dropped */
+	bool add (std::string const &);
+	/** Returns the next batch for a connection which finished its request, an empty batch parks the connection as idle */
+	std::vector<nano::http_callback_item> next (std::shared_ptr<nano::http_callback_connection>);
+	void stop ();
+	size_t size ();
+	nano::node & node;
+
+private:
+	std::vector<nano::http_callback_item> batch (std::unique_lock<std::mutex> &);
+	std::mutex mutex;
+	std::deque<nano::http_callback_item> queue;
+	std::vector<std::shared_ptr<nano::http_callback_connection>> idle;
+	size_t connections;
+	bool stopped;
+};
+}
@@ -4,9 +4,16 @@
 #include <nano/node/common.hpp>
 #include <nano/secure/versioning.hpp>
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/polymorphic_cast.hpp>
 
+#include <fstream>
 #include <queue>
+#include <unordered_map>
+
+size_t constexpr nano::mdb_env::read_pool_size;
+size_t constexpr nano::mdb_store::account_writes_max;
 
 nano::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs, size_t map_size_a)
 {
@@ -23,6 +30,9 @@ nano::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a,
 			release_assert (status2 == 0);
 			auto status3 (mdb_env_set_mapsize (environment, map_size_a));
 			release_assert (status3 == 0);
+			// Pooled read transactions keep their reader slot while reset, leave the default 126 free for active ones
+			auto status5 (mdb_env_set_maxreaders (environment, 126 + read_pools.size () * read_pool_size));
+			release_assert (status5 == 0);
 			// It seems if there's ever more threads than mdb_env_set_maxreaders has read slots available, we get failures on transaction creation unless MDB_NOTLS is specified
 			// This can happen if something like 256 io_threads are specified in the node config
 			// MDB_NORDAHEAD will allow platforms that support it to load the DB in memory as needed.
@@ -45,6 +55,13 @@ nano::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a,
 
 nano::mdb_env::~mdb_env ()
 {
+	for (auto & pool : read_pools)
+	{
+		for (auto txn : pool.txns)
+		{
+			mdb_txn_abort (txn);
+		}
+	}
 	if (environment != nullptr)
 	{
 		mdb_env_close (environment);
@@ -68,6 +85,61 @@ MDB_txn * nano::mdb_env::tx (nano::transaction const & transaction_a) const
 	return *result;
 }
 
+MDB_txn * nano::mdb_env::read_acquire () const
+{
+	MDB_txn * result (nullptr);
+	auto & pool (read_pools[std::hash<std::thread::id> () (std::this_thread::get_id ()) % read_pools.size ()]);
+	{
+		std::lock_guard<std::mutex> lock (pool.mutex);
+		if (!pool.txns.empty ())
+		{
+			result = pool.txns.back ();
+			pool.txns.pop_back ();
+		}
+	}
+	if (result != nullptr)
+	{
+		auto status (mdb_txn_renew (result));
+		release_assert (status == 0);
+		++read_renews;
+	}
+	else
+	{
+		auto status (mdb_txn_begin (environment, nullptr, MDB_RDONLY, &result));
+		release_assert (status == 0);
+		++read_begins;
+	}
+	return result;
+}
+
+void nano::mdb_env::read_release (MDB_txn * txn_a) const
+{
+	mdb_txn_reset (txn_a);
+	auto pooled (false);
+	auto & pool (read_pools[std::hash<std::thread::id> () (std::this_thread::get_id ()) % read_pools.size ()]);
+	{
+		std::lock_guard<std::mutex> lock (pool.mutex);
+		if (pool.txns.size () < read_pool_size)
+		{
+			pool.txns.push_back (txn_a);
+			pooled = true;
+		}
+	}
+	if (!pooled)
+	{
+		mdb_txn_abort (txn_a);
+	}
+}
+
+nano::transaction_counts nano::mdb_env::read_counts () const
+{
+	nano::transaction_counts result;
+	result.begin = read_begins;
+	result.renew = read_renews;
+	result.refresh = read_refreshes;
+	return result;
+}
+
 nano::mdb_val::mdb_val (nano::epoch epoch_a) :
 value ({ 0, nullptr }),
 epoch (epoch_a)
@@ -280,16 +352,56 @@ nano::mdb_val::operator MDB_val const & () const
 	return value;
 }
 
-nano::mdb_txn::mdb_txn (nano::mdb_env const & environment_a, bool write_a)
+nano::mdb_txn::mdb_txn (nano::mdb_env const & environment_a, bool write_a) :
+env (&environment_a),
+write (write_a),
+start (std::chrono::steady_clock::now ())
 {
-	auto status (mdb_txn_begin (environment_a, nullptr, write_a ? 0 : MDB_RDONLY, &handle));
-	release_assert (status == 0);
+	if (write_a)
+	{
+		auto status (mdb_txn_begin (environment_a, nullptr, 0, &handle));
+		release_assert (status == 0);
+	}
+	else
+	{
+		handle = environment_a.read_acquire ();
+	}
 }
 
 nano::mdb_txn::~mdb_txn ()
 {
-	auto status (mdb_txn_commit (handle));
-	release_assert (status == 0);
+	if (write)
+	{
+		// A failed commit aborts, so nothing published here ever needs rolling back
+		for (auto & callback : precommit_callbacks)
+		{
+			callback ();
+		}
+		auto status (mdb_txn_commit (handle));
+		release_assert (status == 0);
+		for (auto & callback : commit_callbacks)
+		{
+			callback ();
+		}
+	}
+	else
+	{
+		env->read_release (handle);
+	}
+}
+
+void nano::mdb_txn::refresh (std::chrono::milliseconds max_age_a)
+{
+	// Write transactions always see their own changes, there's nothing to refresh
+	auto now (std::chrono::steady_clock::now ());
+	if (!write && now - start >= max_age_a)
+	{
+		mdb_txn_reset (handle);
+		auto status (mdb_txn_renew (handle));
+		release_assert (status == 0);
+		start = now;
+		++env->read_refreshes;
+	}
 }
 
 nano::mdb_txn::operator MDB_txn * () const
@@ -315,12 +427,12 @@ public:
 	{
 		auto hash (block_a.hash ());
 		nano::block_type type;
-		auto value (store.block_raw_get (transaction, block_a.previous (), type));
-		auto version (store.block_version (transaction, block_a.previous ()));
+		nano::epoch version;
+		auto value (store.block_raw_get (transaction, block_a.previous (), type, version));
 		assert (value.mv_size != 0);
 		std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
 		std::copy (hash.bytes.begin (), hash.bytes.end (), data.begin () + store.block_successor_offset (transaction, value, type));
-		store.block_raw_put (transaction, store.block_database (type, version), block_a.previous (), nano::mdb_val (data.size (), data.data ()));
+		store.block_raw_put (transaction, block_a.previous (), type, version, nano::mdb_val (data.size (), data.data ()));
 	}
 	void send_block (nano::send_block const & block_a) override
 	{
@@ -699,9 +811,11 @@ nano::store_iterator<nano::account, std::shared_ptr<nano::vote>> nano::mdb_store
 	return nano::store_iterator<nano::account, std::shared_ptr<nano::vote>> (nullptr);
 }
 
-nano::mdb_store::mdb_store (bool & error_a, nano::logging & logging_a, boost::filesystem::path const & path_a, int lmdb_max_dbs) :
+nano::mdb_store::mdb_store (bool & error_a, nano::logging & logging_a, boost::filesystem::path const & path_a, int lmdb_max_dbs, size_t block_cache_max_bytes, nano::block_uniquer * block_uniquer_a, size_t account_cache_max_bytes) :
 logging (logging_a),
 env (error_a, path_a, lmdb_max_dbs),
+block_cache (block_cache_max_bytes, block_uniquer_a),
+account_cache (account_cache_max_bytes),
 frontiers (0),
 accounts_v0 (0),
 accounts_v1 (0),
@@ -711,6 +825,7 @@ open_blocks (0),
 change_blocks (0),
 state_blocks_v0 (0),
 state_blocks_v1 (0),
+blocks (0),
 pending_v0 (0),
 pending_v1 (0),
 blocks_info (0),
@@ -718,12 +833,15 @@ representation (0),
 unchecked (0),
 vote (0),
 meta (0),
+single_block_table (false),
 stopped (false)
 {
 	auto slow_upgrade (false);
 	if (!error_a)
 	{
 		auto transaction (tx_begin_write ());
+		// A store without a meta table has never been opened and starts out with the current layout
+		auto fresh (mdb_dbi_open (env.tx (transaction), "meta", 0, &meta) != 0);
 		error_a |= mdb_dbi_open (env.tx (transaction), "frontiers", MDB_CREATE, &frontiers) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "accounts", MDB_CREATE, &accounts_v0) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "accounts_v1", MDB_CREATE, &accounts_v1) != 0;
@@ -733,19 +851,33 @@ stopped (false)
 		error_a |= mdb_dbi_open (env.tx (transaction), "change", MDB_CREATE, &change_blocks) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "state", MDB_CREATE, &state_blocks_v0) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "state_v1", MDB_CREATE, &state_blocks_v1) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "blocks", MDB_CREATE, &blocks) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "pending", MDB_CREATE, &pending_v0) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "pending_v1", MDB_CREATE, &pending_v1) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "representation", MDB_CREATE, &representation) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "unchecked", MDB_CREATE, &unchecked) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "vote", MDB_CREATE, &vote) != 0;
 		error_a |= mdb_dbi_open (env.tx (transaction), "meta", MDB_CREATE, &meta) != 0;
-		if (!full_sideband (transaction))
+		if (!fresh && !full_sideband (transaction))
 		{
 			error_a |= mdb_dbi_open (env.tx (transaction), "blocks_info", MDB_CREATE, &blocks_info) != 0;
 		}
 		if (!error_a)
 		{
-			do_upgrades (transaction, slow_upgrade);
+			for (auto i (representation_begin (transaction)), n (representation_end ()); i != n; ++i)
+			{
+				representation_cache.representation_put (i->first, i->second.number ());
+			}
+			if (fresh)
+			{
+				single_block_table = true;
+				version_put (transaction, version_current);
+			}
+			else
+			{
+				single_block_table = version_get (transaction) > 13;
+				do_upgrades (transaction, slow_upgrade);
+			}
 		}
 	}
 	if (slow_upgrade)
@@ -786,6 +918,21 @@ nano::transaction nano::mdb_store::tx_begin (bool write_a)
 	return env.tx_begin (write_a);
 }
 
+nano::transaction_counts nano::mdb_store::tx_counts ()
+{
+	return env.read_counts ();
+}
+
+nano::uniquer_counters nano::mdb_store::block_cache_counters ()
+{
+	return block_cache.take_counters ();
+}
+
+nano::uniquer_counters nano::mdb_store::account_cache_counters ()
+{
+	return account_cache.take_counters ();
+}
+
 void nano::mdb_store::initialize (nano::transaction const & transaction_a, nano::genesis const & genesis_a)
 {
 	auto hash_l (genesis_a.hash ());
@@ -888,9 +1035,12 @@ void nano::mdb_store::do_upgrades (nano::transaction const & transaction_a, bool
 			upgrade_v11_to_v12 (transaction_a);
 			// [[fallthrough]];
 		case 12:
+			// The block table merge runs on the next start, once the sideband upgrade has completed
 			slow_upgrade = true;
 			break;
 		case 13:
+			upgrade_v13_to_v14 (transaction_a);
+		case 14:
 			break;
 		default:
 			assert (false);
@@ -935,6 +1085,7 @@ void nano::mdb_store::upgrade_v2_to_v3 (nano::transaction const & transaction_a)
 {
 	version_put (transaction_a, 3);
 	mdb_drop (env.tx (transaction_a), representation, 0);
+	representation_clear (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ()));
 	for (auto i (std::make_unique<nano::mdb_iterator<nano::account, nano::account_info_v5>> (transaction_a, accounts_v0)), n (std::make_unique<nano::mdb_iterator<nano::account, nano::account_info_v5>> (nullptr)); *i != *n; ++(*i))
 	{
 		nano::account account_l ((*i)->first);
@@ -986,16 +1137,16 @@ void nano::mdb_store::upgrade_v4_to_v5 (nano::transaction const & transaction_a)
 					block->serialize (stream);
 					nano::write (stream, successor.bytes);
 				}
-				block_raw_put (transaction_a, block_database (block->type (), nano::epoch::epoch_0), hash, { vector.size (), vector.data () });
+				block_raw_put (transaction_a, hash, block->type (), nano::epoch::epoch_0, { vector.size (), vector.data () });
 				if (!block->previous ().is_zero ())
 				{
 					nano::block_type type;
-					auto value (block_raw_get (transaction_a, block->previous (), type));
-					auto version (block_version (transaction_a, block->previous ()));
+					nano::epoch version;
+					auto value (block_raw_get (transaction_a, block->previous (), type, version));
 					assert (value.mv_size != 0);
 					std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
 					std::copy (hash.bytes.begin (), hash.bytes.end (), data.end () - nano::block_sideband::size (type));
-					block_raw_put (transaction_a, block_database (type, version), block->previous (), nano::mdb_val (data.size (), data.data ()));
+					block_raw_put (transaction_a, block->previous (), type, version, nano::mdb_val (data.size (), data.data ()));
 				}
 			}
 			successor = hash;
@@ -1108,6 +1259,7 @@ void nano::mdb_store::do_slow_upgrades ()
 			upgrade_v12_to_v13 ();
 			break;
 		case 13:
+		case 14:
 			break;
 		default:
 			assert (false);
@@ -1190,11 +1342,377 @@ void nano::mdb_store::upgrade_v12_to_v13 ()
 	}
 }
 
+void nano::mdb_store::upgrade_v13_to_v14 (nano::transaction const & transaction_a)
+{
+	version_put (transaction_a, 14);
+	std::array<std::pair<nano::block_type, nano::epoch>, 6> tables{ { { nano::block_type::send, nano::epoch::epoch_0 }, { nano::block_type::receive, nano::epoch::epoch_0 }, { nano::block_type::open, nano::epoch::epoch_0 }, { nano::block_type::change, nano::epoch::epoch_0 }, { nano::block_type::state, nano::epoch::epoch_0 }, { nano::block_type::state, nano::epoch::epoch_1 } } };
+	for (auto & table : tables)
+	{
+		auto database (block_database (table.first, table.second));
+		int64_t count (0);
+		for (nano::mdb_iterator<nano::block_hash, std::shared_ptr<nano::block>> i (transaction_a, database), n (nullptr); i != n; ++i)
+		{
+			std::vector<uint8_t> data;
+			data.reserve (2 + i->second.size ());
+			data.push_back (static_cast<uint8_t> (table.first));
+			data.push_back (static_cast<uint8_t> (table.second));
+			data.insert (data.end (), reinterpret_cast<uint8_t const *> (i->second.data ()), reinterpret_cast<uint8_t const *> (i->second.data ()) + i->second.size ());
+			auto status (mdb_put (env.tx (transaction_a), blocks, i->first, nano::mdb_val (data.size (), data.data ()), 0));
+			release_assert (status == 0);
+			++count;
+		}
+		block_counts_add (transaction_a, table.first, table.second, count);
+		auto status (mdb_drop (env.tx (transaction_a), database, 0));
+		release_assert (status == 0);
+	}
+	single_block_table = true;
+	BOOST_LOG (logging.log) << boost::str (boost::format ("Merged block tables"));
+}
+
+void nano::mdb_store::block_tables_split (nano::transaction const & transaction_a)
+{
+	// Versions before 14 read blocks from the per-type tables
+	single_block_table = false;
+	for (nano::mdb_iterator<nano::block_hash, std::shared_ptr<nano::block>> i (transaction_a, blocks), n (nullptr); i != n; ++i)
+	{
+		auto data (reinterpret_cast<uint8_t const *> (i->second.data ()));
+		auto database (block_database (static_cast<nano::block_type> (data[0]), static_cast<nano::epoch> (data[1])));
+		auto status (mdb_put (env.tx (transaction_a), database, i->first, nano::mdb_val (i->second.size () - 2, const_cast<uint8_t *> (data + 2)), 0));
+		release_assert (status == 0);
+	}
+	auto status1 (mdb_drop (env.tx (transaction_a), blocks, 0));
+	release_assert (status1 == 0);
+	nano::uint256_union block_counts_key (4);
+	auto status2 (mdb_del (env.tx (transaction_a), meta, nano::mdb_val (block_counts_key), nullptr));
+	release_assert (status2 == 0 || status2 == MDB_NOTFOUND);
+	boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ())->block_counts.fill (0);
+}
+
 void nano::mdb_store::clear (MDB_dbi db_a)
 {
 	auto transaction (tx_begin_write ());
 	auto status (mdb_drop (env.tx (transaction), db_a, 0));
 	release_assert (status == 0);
+	if (db_a == representation)
+	{
+		representation_clear (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction.impl.get ()));
+	}
+	else if (db_a == blocks)
+	{
+		block_cache.clear (cache_version (transaction));
+	}
+	else if (db_a == accounts_v0 || db_a == accounts_v1)
+	{
+		account_cache.clear (cache_version (transaction));
+	}
+}
+
+namespace
+{
+/*
+ * Snapshot file layout, all integers in host byte order:
+ *   header   magic, snapshot_version, store version, section count, reserved (uint32)
+ *   section  table, reserved (uint32), record count (uint64), then per record key size, value size (uint32), key, value
+ *   trailer  blake2b-256 of everything before it
+ * Records are written in the table's key order so they can be loaded back with MDB_APPEND
+ */
+std::array<char, 8> const snapshot_magic{ { 'n', 'a', 'n', 'o', 's', 'n', 'a', 'p' } };
+uint32_t constexpr snapshot_version = 1;
+size_t constexpr snapshot_checksum_size = 32;
+
+/** Meta keys carried by snapshots, the store version and block counts. Others such as the node ID belong to the exporting node */
+bool snapshot_meta_key (MDB_val const & key_a)
+{
+	auto result (key_a.mv_size == sizeof (nano::uint256_union));
+	if (result)
+	{
+		nano::mdb_val value (key_a);
+		nano::uint256_union key (value);
+		result = key == nano::uint256_union (1) || key == nano::uint256_union (4);
+	}
+	return result;
+}
+
+enum class snapshot_table : uint32_t
+{
+	frontiers,
+	accounts_v0,
+	accounts_v1,
+	blocks,
+	pending_v0,
+	pending_v1,
+	representation,
+	meta
+};
+
+class snapshot_writer
+{
+public:
+	snapshot_writer (boost::filesystem::path const & path_a) :
+	stream (path_a.string (), std::ios::binary | std::ios::trunc)
+	{
+		buffer.reserve (buffer_size);
+		blake2b_init (&hash, snapshot_checksum_size);
+	}
+	void write (void const * data_a, size_t size_a)
+	{
+		auto data (static_cast<uint8_t const *> (data_a));
+		buffer.insert (buffer.end (), data, data + size_a);
+		if (buffer.size () >= buffer_size)
+		{
+			flush ();
+		}
+	}
+	template <typename T>
+	void write (T const & value_a)
+	{
+		static_assert (std::is_pod<T>::value, "Can't write non-standard layout types");
+		write (&value_a, sizeof (value_a));
+	}
+	void flush ()
+	{
+		blake2b_update (&hash, buffer.data (), buffer.size ());
+		stream.write (reinterpret_cast<char const *> (buffer.data ()), buffer.size ());
+		buffer.clear ();
+	}
+	bool finish ()
+	{
+		flush ();
+		std::array<uint8_t, snapshot_checksum_size> checksum;
+		blake2b_final (&hash, checksum.data (), checksum.size ());
+		stream.write (reinterpret_cast<char const *> (checksum.data ()), checksum.size ());
+		stream.close ();
+		return stream.fail ();
+	}
+	static size_t constexpr buffer_size = 1024 * 1024;
+	std::ofstream stream;
+	std::vector<uint8_t> buffer;
+	blake2b_state hash;
+};
+
+class snapshot_reader
+{
+public:
+	snapshot_reader (uint8_t const * data_a, size_t size_a) :
+	data (data_a),
+	size (size_a),
+	offset (0)
+	{
+	}
+	bool read (void * value_a, size_t size_a)
+	{
+		auto result (size - offset < size_a);
+		if (!result)
+		{
+			std::copy (data + offset, data + offset + size_a, static_cast<uint8_t *> (value_a));
+			offset += size_a;
+		}
+		return result;
+	}
+	template <typename T>
+	bool read (T & value_a)
+	{
+		static_assert (std::is_pod<T>::value, "Can't read non-standard layout types");
+		return read (&value_a, sizeof (value_a));
+	}
+	/** Points key and value in to the mapped file without copying */
+	bool record (MDB_val & key_a, MDB_val & value_a)
+	{
+		uint32_t key_size (0);
+		uint32_t value_size (0);
+		auto result (read (key_size) || read (value_size) || size - offset < static_cast<size_t> (key_size) + value_size);
+		if (!result)
+		{
+			key_a = { key_size, const_cast<uint8_t *> (data + offset) };
+			value_a = { value_size, const_cast<uint8_t *> (data + offset + key_size) };
+			offset += static_cast<size_t> (key_size) + value_size;
+		}
+		return result;
+	}
+	uint8_t const * data;
+	size_t size;
+	size_t offset;
+};
+}
+
+bool nano::mdb_store::snapshot_export (boost::filesystem::path const & path_a)
+{
+	auto transaction (tx_begin_read ());
+	auto version (version_get (transaction));
+	// Older layouts still spread blocks over several tables, they're upgraded when the node starts
+	auto result (version != version_current || !single_block_table);
+	if (!result)
+	{
+		std::vector<std::pair<snapshot_table, MDB_dbi>> tables{ { snapshot_table::frontiers, frontiers }, { snapshot_table::accounts_v0, accounts_v0 }, { snapshot_table::accounts_v1, accounts_v1 }, { snapshot_table::blocks, blocks }, { snapshot_table::pending_v0, pending_v0 }, { snapshot_table::pending_v1, pending_v1 }, { snapshot_table::representation, representation }, { snapshot_table::meta, meta } };
+		snapshot_writer writer (path_a);
+		writer.write (snapshot_magic);
+		writer.write (snapshot_version);
+		writer.write (static_cast<uint32_t> (version));
+		writer.write (static_cast<uint32_t> (tables.size ()));
+		writer.write (uint32_t (0));
+		for (auto i (tables.begin ()), n (tables.end ()); i != n && !result; ++i)
+		{
+			MDB_stat stats;
+			result = mdb_stat (env.tx (transaction), i->second, &stats) != 0;
+			MDB_cursor * cursor (nullptr);
+			result = result || mdb_cursor_open (env.tx (transaction), i->second, &cursor) != 0;
+			if (!result)
+			{
+				auto filter (i->first == snapshot_table::meta);
+				MDB_val key;
+				MDB_val value;
+				uint64_t count (stats.ms_entries);
+				if (filter)
+				{
+					count = 0;
+					for (auto status (mdb_cursor_get (cursor, &key, &value, MDB_FIRST)); status == 0; status = mdb_cursor_get (cursor, &key, &value, MDB_NEXT))
+					{
+						count += snapshot_meta_key (key) ? 1 : 0;
+					}
+				}
+				writer.write (i->first);
+				writer.write (uint32_t (0));
+				writer.write (count);
+				for (auto status (mdb_cursor_get (cursor, &key, &value, MDB_FIRST)); status == 0; status = mdb_cursor_get (cursor, &key, &value, MDB_NEXT))
+				{
+					if (!filter || snapshot_meta_key (key))
+					{
+						writer.write (static_cast<uint32_t> (key.mv_size));
+						writer.write (static_cast<uint32_t> (value.mv_size));
+						writer.write (key.mv_data, key.mv_size);
+						writer.write (value.mv_data, value.mv_size);
+					}
+				}
+				mdb_cursor_close (cursor);
+			}
+		}
+		result = writer.finish () || result;
+		BOOST_LOG (logging.log) << boost::str (boost::format ("Snapshot export to %1% %2%") % path_a.string () % (result ? "failed" : "completed"));
+	}
+	return result;
+}
+
+bool nano::mdb_store::snapshot_import (boost::filesystem::path const & path_a, unsigned threads_a)
+{
+	// Only block contents are checked against their hashes, the derived tables would need a full ledger replay to verify and are trusted from the snapshot
+	auto result (false);
+	try
+	{
+		boost::interprocess::file_mapping file (path_a.string ().c_str (), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region (file, boost::interprocess::read_only);
+		region.advise (boost::interprocess::mapped_region::advice_sequential);
+		auto data (static_cast<uint8_t const *> (region.get_address ()));
+		auto size (region.get_size ());
+		{
+			auto transaction (tx_begin_read ());
+			MDB_stat stats;
+			result = size < snapshot_checksum_size || version_get (transaction) != version_current || mdb_stat (env.tx (transaction), blocks, &stats) != 0 || stats.ms_entries != 0;
+		}
+		if (!result)
+		{
+			size -= snapshot_checksum_size;
+			std::array<uint8_t, snapshot_checksum_size> checksum;
+			blake2b_state hash;
+			blake2b_init (&hash, checksum.size ());
+			blake2b_update (&hash, data, size);
+			blake2b_final (&hash, checksum.data (), checksum.size ());
+			result = !std::equal (checksum.begin (), checksum.end (), data + size);
+		}
+		snapshot_reader reader (data, size);
+		std::array<char, 8> magic;
+		uint32_t file_version (0);
+		uint32_t store_version (0);
+		uint32_t sections (0);
+		uint32_t reserved (0);
+		result = result || reader.read (magic) || reader.read (file_version) || reader.read (store_version) || reader.read (sections) || reader.read (reserved);
+		result = result || magic != snapshot_magic || file_version != snapshot_version || store_version != version_current;
+		std::unordered_map<snapshot_table, MDB_dbi> tables{ { snapshot_table::frontiers, frontiers }, { snapshot_table::accounts_v0, accounts_v0 }, { snapshot_table::accounts_v1, accounts_v1 }, { snapshot_table::blocks, blocks }, { snapshot_table::pending_v0, pending_v0 }, { snapshot_table::pending_v1, pending_v1 }, { snapshot_table::representation, representation }, { snapshot_table::meta, meta } };
+		std::atomic<bool> invalid_block (false);
+		std::vector<std::thread> verifiers;
+		for (uint32_t section (0); section < sections && !result; ++section)
+		{
+			snapshot_table table;
+			uint64_t count (0);
+			result = reader.read (table) || reader.read (reserved) || reader.read (count) || tables.find (table) == tables.end ();
+			if (!result)
+			{
+				auto database (tables[table]);
+				if (table == snapshot_table::blocks)
+				{
+					// Hashes are checked while the main thread loads, each verifier takes every n'th record
+					for (unsigned i (0), n (std::max (1u, threads_a)); i < n; ++i)
+					{
+						verifiers.emplace_back ([reader, count, i, n, &invalid_block]() mutable {
+							MDB_val key;
+							MDB_val value;
+							for (uint64_t j (0); j < count && !invalid_block; ++j)
+							{
+								auto error (reader.record (key, value));
+								if (!error && j % n == i)
+								{
+									auto bytes (static_cast<uint8_t const *> (value.mv_data));
+									error = key.mv_size != sizeof (nano::block_hash) || value.mv_size < 2;
+									if (!error)
+									{
+										nano::bufferstream stream (bytes + 2, value.mv_size - 2);
+										auto block (nano::deserialize_block (stream, static_cast<nano::block_type> (bytes[0])));
+										error = block == nullptr || block->hash () != nano::block_hash (nano::mdb_val (key));
+									}
+								}
+								if (error)
+								{
+									invalid_block = true;
+								}
+							}
+						});
+					}
+				}
+				// Commit in batches to bound the size of each write transaction
+				uint64_t const batch (64 * 1024);
+				for (uint64_t i (0); i < count && !result && !invalid_block;)
+				{
+					auto transaction (tx_begin_write ());
+					for (auto end (std::min (count, i + batch)); i < end && !result; ++i)
+					{
+						MDB_val key;
+						MDB_val value;
+						result = reader.record (key, value);
+						if (!result)
+						{
+							if (table != snapshot_table::meta)
+							{
+								result = mdb_put (env.tx (transaction), database, &key, &value, MDB_APPEND) != 0;
+							}
+							else if (snapshot_meta_key (key))
+							{
+								// Meta already holds the version
+								result = mdb_put (env.tx (transaction), database, &key, &value, 0) != 0;
+							}
+						}
+					}
+				}
+			}
+		}
+		for (auto & verifier : verifiers)
+		{
+			verifier.join ();
+		}
+		result = result || invalid_block || reader.offset != reader.size;
+		if (!result)
+		{
+			auto transaction (tx_begin_read ());
+			for (auto i (representation_begin (transaction)), n (representation_end ()); i != n; ++i)
+			{
+				representation_cache.representation_put (i->first, i->second.number ());
+			}
+		}
+	}
+	catch (boost::interprocess::interprocess_exception const &)
+	{
+		result = true;
+	}
+	BOOST_LOG (logging.log) << boost::str (boost::format ("Snapshot import from %1% %2%") % path_a.string () % (result ? "failed" : "completed"));
+	return result;
 }
 
 nano::uint128_t nano::mdb_store::block_balance (nano::transaction const & transaction_a, nano::block_hash const & hash_a)
@@ -1232,10 +1750,20 @@ nano::uint128_t nano::mdb_store::block_balance_computed (nano::transaction const
 
 nano::epoch nano::mdb_store::block_version (nano::transaction const & transaction_a, nano::block_hash const & hash_a)
 {
-	nano::mdb_val value;
-	auto status (mdb_get (env.tx (transaction_a), state_blocks_v1, nano::mdb_val (hash_a), value));
-	release_assert (status == 0 || status == MDB_NOTFOUND);
-	return status == 0 ? nano::epoch::epoch_1 : nano::epoch::epoch_0;
+	nano::epoch result (nano::epoch::epoch_0);
+	if (single_block_table)
+	{
+		nano::block_type type;
+		block_raw_get (transaction_a, hash_a, type, result);
+	}
+	else
+	{
+		nano::mdb_val value;
+		auto status (mdb_get (env.tx (transaction_a), state_blocks_v1, nano::mdb_val (hash_a), value));
+		release_assert (status == 0 || status == MDB_NOTFOUND);
+		result = status == 0 ? nano::epoch::epoch_1 : nano::epoch::epoch_0;
+	}
+	return result;
 }
 
 void nano::mdb_store::representation_add (nano::transaction const & transaction_a, nano::block_hash const & source_a, nano::uint128_t const & amount_a)
@@ -1292,10 +1820,117 @@ MDB_dbi nano::mdb_store::block_database (nano::block_type type_a, nano::epoch ep
 	return result;
 }
 
-void nano::mdb_store::block_raw_put (nano::transaction const & transaction_a, MDB_dbi database_a, nano::block_hash const & hash_a, MDB_val value_a)
+void nano::mdb_store::block_raw_put (nano::transaction const & transaction_a, nano::block_hash const & hash_a, nano::block_type type_a, nano::epoch epoch_a, MDB_val value_a)
 {
-	auto status2 (mdb_put (env.tx (transaction_a), database_a, nano::mdb_val (hash_a), &value_a, 0));
-	release_assert (status2 == 0);
+	if (single_block_table)
+	{
+		std::vector<uint8_t> data;
+		data.reserve (2 + value_a.mv_size);
+		data.push_back (static_cast<uint8_t> (type_a));
+		data.push_back (static_cast<uint8_t> (epoch_a));
+		data.insert (data.end (), static_cast<uint8_t *> (value_a.mv_data), static_cast<uint8_t *> (value_a.mv_data) + value_a.mv_size);
+		nano::mdb_val key (hash_a);
+		nano::mdb_val value (data.size (), data.data ());
+		// Positioning a cursor once serves both the existence check for the counts and the write
+		MDB_cursor * cursor;
+		auto status1 (mdb_cursor_open (env.tx (transaction_a), blocks, &cursor));
+		release_assert (status1 == 0);
+		nano::mdb_val existing;
+		auto status2 (mdb_cursor_get (cursor, key, existing, MDB_SET));
+		release_assert (status2 == 0 || status2 == MDB_NOTFOUND);
+		if (status2 == 0)
+		{
+			// Successor updates and clears on existing blocks. A new block can't be cached by any snapshot yet, so erasing it
+			// would only raise the shard's watermark and keep readers from caching unrelated blocks
+			block_cache.erase (hash_a, cache_version (transaction_a));
+		}
+		auto status3 (mdb_cursor_put (cursor, key, value, status2 == 0 ? MDB_CURRENT : 0));
+		release_assert (status3 == 0);
+		mdb_cursor_close (cursor);
+		if (status2 == MDB_NOTFOUND)
+		{
+			block_counts_add (transaction_a, type_a, epoch_a, 1);
+		}
+	}
+	else
+	{
+		block_cache.erase (hash_a, cache_version (transaction_a));
+		auto status2 (mdb_put (env.tx (transaction_a), block_database (type_a, epoch_a), nano::mdb_val (hash_a), &value_a, 0));
+		release_assert (status2 == 0);
+	}
+}
+
+namespace
+{
+size_t block_counts_index (nano::block_type type_a, nano::epoch epoch_a)
+{
+	size_t result (0);
+	switch (type_a)
+	{
+		case nano::block_type::send:
+			result = 0;
+			break;
+		case nano::block_type::receive:
+			result = 1;
+			break;
+		case nano::block_type::open:
+			result = 2;
+			break;
+		case nano::block_type::change:
+			result = 3;
+			break;
+		case nano::block_type::state:
+			result = epoch_a == nano::epoch::epoch_1 ? 5 : 4;
+			break;
+		default:
+			assert (false);
+			break;
+	}
+	return result;
+}
+}
+
+void nano::mdb_store::block_counts_add (nano::transaction const & transaction_a, nano::block_type type_a, nano::epoch epoch_a, int64_t amount_a)
+{
+	// Every block put and delete changes the counts, they're written once per transaction rather than rewriting the key each time
+	auto & txn (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ()));
+	assert (txn.write);
+	if (!txn.block_counts_staged)
+	{
+		txn.block_counts_staged = true;
+		auto txn_l (&txn);
+		txn.precommit_callbacks.push_back ([this, txn_l]() {
+			// Splitting the tables drops the counts along with the blocks table
+			if (single_block_table && std::any_of (txn_l->block_counts.begin (), txn_l->block_counts.end (), [](int64_t count_a) { return count_a != 0; }))
+			{
+				auto counts (block_counts_get (txn_l->handle));
+				for (size_t i (0); i < counts.size (); ++i)
+				{
+					counts[i] += txn_l->block_counts[i];
+				}
+				nano::uint256_union block_counts_key (4);
+				auto status (mdb_put (txn_l->handle, meta, nano::mdb_val (block_counts_key), nano::mdb_val (sizeof (counts), counts.data ()), 0));
+				release_assert (status == 0);
+			}
+		});
+	}
+	txn.block_counts[block_counts_index (type_a, epoch_a)] += amount_a;
+}
+
+std::array<uint64_t, 6> nano::mdb_store::block_counts_get (MDB_txn * txn_a)
+{
+	// Per-type counts of the blocks table, kept under meta key 4 as they can't be read from the table statistics
+	nano::uint256_union block_counts_key (4);
+	std::array<uint64_t, 6> result{};
+	nano::mdb_val value;
+	auto status (mdb_get (txn_a, meta, nano::mdb_val (block_counts_key), value));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+	if (status == 0)
+	{
+		assert (value.size () == sizeof (result));
+		std::copy (reinterpret_cast<uint8_t const *> (value.data ()), reinterpret_cast<uint8_t const *> (value.data ()) + sizeof (result), reinterpret_cast<uint8_t *> (result.data ()));
+	}
+	return result;
 }
 
 void nano::mdb_store::block_put (nano::transaction const & transaction_a, nano::block_hash const & hash_a, nano::block const & block_a, nano::block_sideband const & sideband_a, nano::epoch epoch_a)
@@ -1308,40 +1943,68 @@ void nano::mdb_store::block_put (nano::transaction const & transaction_a, nano::
 		block_a.serialize (stream);
 		sideband_a.serialize (stream);
 	}
-	block_raw_put (transaction_a, block_database (block_a.type (), epoch_a), hash_a, { vector.size (), vector.data () });
+	block_raw_put (transaction_a, hash_a, block_a.type (), epoch_a, { vector.size (), vector.data () });
 	nano::block_predecessor_set predecessor (transaction_a, *this);
 	block_a.visit (predecessor);
 	assert (block_a.previous ().is_zero () || block_successor (transaction_a, block_a.previous ()) == hash_a);
 }
 
 MDB_val nano::mdb_store::block_raw_get (nano::transaction const & transaction_a, nano::block_hash const & hash_a, nano::block_type & type_a)
+{
+	nano::epoch epoch;
+	return block_raw_get (transaction_a, hash_a, type_a, epoch);
+}
+
+MDB_val nano::mdb_store::block_raw_get (nano::transaction const & transaction_a, nano::block_hash const & hash_a, nano::block_type & type_a, nano::epoch & epoch_a)
 {
 	nano::mdb_val result;
-	auto status (mdb_get (env.tx (transaction_a), send_blocks, nano::mdb_val (hash_a), result));
-	release_assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
+	epoch_a = nano::epoch::epoch_0;
+	if (single_block_table)
 	{
-		auto status (mdb_get (env.tx (transaction_a), receive_blocks, nano::mdb_val (hash_a), result));
+		auto status (mdb_get (env.tx (transaction_a), blocks, nano::mdb_val (hash_a), result));
+		release_assert (status == 0 || status == MDB_NOTFOUND);
+		if (status == 0)
+		{
+			assert (result.size () > 2);
+			auto data (reinterpret_cast<uint8_t *> (result.data ()));
+			type_a = static_cast<nano::block_type> (data[0]);
+			epoch_a = static_cast<nano::epoch> (data[1]);
+			result = nano::mdb_val (result.size () - 2, data + 2);
+		}
+	}
+	else
+	{
+		auto status (mdb_get (env.tx (transaction_a), send_blocks, nano::mdb_val (hash_a), result));
 		release_assert (status == 0 || status == MDB_NOTFOUND);
 		if (status != 0)
 		{
-			auto status (mdb_get (env.tx (transaction_a), open_blocks, nano::mdb_val (hash_a), result));
+			auto status (mdb_get (env.tx (transaction_a), receive_blocks, nano::mdb_val (hash_a), result));
 			release_assert (status == 0 || status == MDB_NOTFOUND);
 			if (status != 0)
 			{
-				auto status (mdb_get (env.tx (transaction_a), change_blocks, nano::mdb_val (hash_a), result));
+				auto status (mdb_get (env.tx (transaction_a), open_blocks, nano::mdb_val (hash_a), result));
 				release_assert (status == 0 || status == MDB_NOTFOUND);
 				if (status != 0)
 				{
-					auto status (mdb_get (env.tx (transaction_a), state_blocks_v0, nano::mdb_val (hash_a), result));
+					auto status (mdb_get (env.tx (transaction_a), change_blocks, nano::mdb_val (hash_a), result));
 					release_assert (status == 0 || status == MDB_NOTFOUND);
 					if (status != 0)
 					{
-						auto status (mdb_get (env.tx (transaction_a), state_blocks_v1, nano::mdb_val (hash_a), result));
+						auto status (mdb_get (env.tx (transaction_a), state_blocks_v0, nano::mdb_val (hash_a), result));
 						release_assert (status == 0 || status == MDB_NOTFOUND);
 						if (status != 0)
 						{
-							// Block not found
+							auto status (mdb_get (env.tx (transaction_a), state_blocks_v1, nano::mdb_val (hash_a), result));
+							release_assert (status == 0 || status == MDB_NOTFOUND);
+							if (status != 0)
+							{
+								// Block not found
+							}
+							else
+							{
+								type_a = nano::block_type::state;
+								epoch_a = nano::epoch::epoch_1;
+							}
 						}
 						else
 						{
@@ -1350,28 +2013,24 @@ MDB_val nano::mdb_store::block_raw_get (nano::transaction const & transaction_a,
 					}
 					else
 					{
-						type_a = nano::block_type::state;
+						type_a = nano::block_type::change;
 					}
 				}
 				else
 				{
-					type_a = nano::block_type::change;
+					type_a = nano::block_type::open;
 				}
 			}
 			else
 			{
-				type_a = nano::block_type::open;
+				type_a = nano::block_type::receive;
 			}
 		}
 		else
 		{
-			type_a = nano::block_type::receive;
+			type_a = nano::block_type::send;
 		}
 	}
-	else
-	{
-		type_a = nano::block_type::send;
-	}
 	return result;
 }
 
@@ -1390,52 +2049,96 @@ std::shared_ptr<nano::block> nano::mdb_store::block_random (nano::transaction co
 	return block_get (transaction_a, nano::block_hash (existing->first));
 }
 
+bool nano::mdb_store::block_serialize (nano::transaction const & transaction_a, nano::block_hash const & hash_a, std::vector<uint8_t> & buffer_a, nano::block_hash & previous_a)
+{
+	nano::block_type type;
+	auto value (block_raw_get (transaction_a, hash_a, type));
+	auto result (value.mv_size == 0);
+	if (!result)
+	{
+		// Stored entries are the block's own serialization followed by sideband
+		auto data (reinterpret_cast<uint8_t const *> (value.mv_data));
+		buffer_a.push_back (static_cast<uint8_t> (type));
+		buffer_a.insert (buffer_a.end (), data, data + nano::block::size (type));
+		switch (type)
+		{
+			case nano::block_type::send:
+			case nano::block_type::receive:
+			case nano::block_type::change:
+				std::copy (data, data + sizeof (previous_a), previous_a.bytes.begin ());
+				break;
+			case nano::block_type::state:
+				std::copy (data + sizeof (nano::account), data + sizeof (nano::account) + sizeof (previous_a), previous_a.bytes.begin ());
+				break;
+			default:
+				previous_a.clear ();
+				break;
+		}
+	}
+	return result;
+}
+
 std::shared_ptr<nano::block> nano::mdb_store::block_random (nano::transaction const & transaction_a)
 {
-	auto count (block_count (transaction_a));
-	auto region (nano::random_pool.GenerateWord32 (0, count.sum () - 1));
 	std::shared_ptr<nano::block> result;
-	if (region < count.send)
+	if (single_block_table)
 	{
-		result = block_random<nano::send_block> (transaction_a, send_blocks);
+		nano::block_hash hash;
+		nano::random_pool.GenerateBlock (hash.bytes.data (), hash.bytes.size ());
+		nano::mdb_iterator<nano::block_hash, std::shared_ptr<nano::block>> existing (transaction_a, blocks, nano::mdb_val (hash));
+		if (existing == nano::mdb_iterator<nano::block_hash, std::shared_ptr<nano::block>> (nullptr))
+		{
+			existing = nano::mdb_iterator<nano::block_hash, std::shared_ptr<nano::block>> (transaction_a, blocks);
+		}
+		result = block_get (transaction_a, nano::block_hash (existing->first));
+		assert (result != nullptr);
 	}
 	else
 	{
-		region -= count.send;
-		if (region < count.receive)
+		auto count (block_count (transaction_a));
+		auto region (nano::random_pool.GenerateWord32 (0, count.sum () - 1));
+		if (region < count.send)
 		{
-			result = block_random<nano::receive_block> (transaction_a, receive_blocks);
+			result = block_random<nano::send_block> (transaction_a, send_blocks);
 		}
 		else
 		{
-			region -= count.receive;
-			if (region < count.open)
+			region -= count.send;
+			if (region < count.receive)
 			{
-				result = block_random<nano::open_block> (transaction_a, open_blocks);
+				result = block_random<nano::receive_block> (transaction_a, receive_blocks);
 			}
 			else
 			{
-				region -= count.open;
-				if (region < count.change)
+				region -= count.receive;
+				if (region < count.open)
 				{
-					result = block_random<nano::change_block> (transaction_a, change_blocks);
+					result = block_random<nano::open_block> (transaction_a, open_blocks);
 				}
 				else
 				{
-					region -= count.change;
-					if (region < count.state_v0)
+					region -= count.open;
+					if (region < count.change)
 					{
-						result = block_random<nano::state_block> (transaction_a, state_blocks_v0);
+						result = block_random<nano::change_block> (transaction_a, change_blocks);
 					}
 					else
 					{
-						result = block_random<nano::state_block> (transaction_a, state_blocks_v1);
+						region -= count.change;
+						if (region < count.state_v0)
+						{
+							result = block_random<nano::state_block> (transaction_a, state_blocks_v0);
+						}
+						else
+						{
+							result = block_random<nano::state_block> (transaction_a, state_blocks_v1);
+						}
 					}
 				}
 			}
 		}
+		assert (result != nullptr);
 	}
-	assert (result != nullptr);
 	return result;
 }
 
@@ -1449,6 +2152,11 @@ bool nano::mdb_store::entry_has_sideband (MDB_val entry_a, nano::block_type type
 	return entry_a.mv_size == nano::block::size (type_a) + nano::block_sideband::size (type_a);
 }
 
+uint64_t nano::mdb_store::cache_version (nano::transaction const & transaction_a)
+{
+	return mdb_txn_id (env.tx (transaction_a));
+}
+
 size_t nano::mdb_store::block_successor_offset (nano::transaction const & transaction_a, MDB_val entry_a, nano::block_type type_a)
 {
 	size_t result;
@@ -1487,35 +2195,47 @@ nano::block_hash nano::mdb_store::block_successor (nano::transaction const & tra
 void nano::mdb_store::block_successor_clear (nano::transaction const & transaction_a, nano::block_hash const & hash_a)
 {
 	nano::block_type type;
-	auto value (block_raw_get (transaction_a, hash_a, type));
-	auto version (block_version (transaction_a, hash_a));
+	nano::epoch version;
+	auto value (block_raw_get (transaction_a, hash_a, type, version));
 	assert (value.mv_size != 0);
 	std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
 	std::fill_n (data.begin () + block_successor_offset (transaction_a, value, type), sizeof (nano::uint256_union), 0);
-	block_raw_put (transaction_a, block_database (type, version), hash_a, nano::mdb_val (data.size (), data.data ()));
+	block_raw_put (transaction_a, hash_a, type, version, nano::mdb_val (data.size (), data.data ()));
 }
 
 std::shared_ptr<nano::block> nano::mdb_store::block_get (nano::transaction const & transaction_a, nano::block_hash const & hash_a, nano::block_sideband * sideband_a)
 {
-	nano::block_type type;
-	auto value (block_raw_get (transaction_a, hash_a, type));
-	std::shared_ptr<nano::block> result;
-	if (value.mv_size != 0)
+	auto version (cache_version (transaction_a));
+	auto result (block_cache.get (hash_a, version, sideband_a));
+	if (result == nullptr)
 	{
-		nano::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
-		result = nano::deserialize_block (stream, type);
-		assert (result != nullptr);
-		if (sideband_a)
+		nano::block_type type;
+		auto value (block_raw_get (transaction_a, hash_a, type));
+		if (value.mv_size != 0)
 		{
-			sideband_a->type = type;
+			nano::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
+			result = nano::deserialize_block (stream, type);
+			assert (result != nullptr);
 			if (full_sideband (transaction_a) || entry_has_sideband (value, type))
 			{
-				auto error (sideband_a->deserialize (stream));
+				nano::block_sideband sideband;
+				sideband.type = type;
+				auto error (sideband.deserialize (stream));
 				assert (!error);
+				// Only blocks read from committed snapshots are cached, a write transaction may still be aborted
+				if (!boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ())->write)
+				{
+					result = block_cache.put (hash_a, version, result, sideband);
+				}
+				if (sideband_a)
+				{
+					*sideband_a = sideband;
+				}
 			}
-			else
+			else if (sideband_a)
 			{
 				// Reconstruct sideband data for block.
+				sideband_a->type = type;
 				sideband_a->account = block_account_computed (transaction_a, hash_a);
 				sideband_a->balance = block_balance_computed (transaction_a, hash_a);
 				sideband_a->successor = block_successor (transaction_a, hash_a);
@@ -1529,28 +2249,42 @@ std::shared_ptr<nano::block> nano::mdb_store::block_get (nano::transaction const
 
 void nano::mdb_store::block_del (nano::transaction const & transaction_a, nano::block_hash const & hash_a)
 {
-	auto status (mdb_del (env.tx (transaction_a), state_blocks_v1, nano::mdb_val (hash_a), nullptr));
-	release_assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
+	block_cache.erase (hash_a, cache_version (transaction_a));
+	if (single_block_table)
+	{
+		nano::block_type type;
+		nano::epoch version;
+		auto value (block_raw_get (transaction_a, hash_a, type, version));
+		release_assert (value.mv_size != 0);
+		auto status (mdb_del (env.tx (transaction_a), blocks, nano::mdb_val (hash_a), nullptr));
+		release_assert (status == 0);
+		block_counts_add (transaction_a, type, version, -1);
+	}
+	else
 	{
-		auto status (mdb_del (env.tx (transaction_a), state_blocks_v0, nano::mdb_val (hash_a), nullptr));
+		auto status (mdb_del (env.tx (transaction_a), state_blocks_v1, nano::mdb_val (hash_a), nullptr));
 		release_assert (status == 0 || status == MDB_NOTFOUND);
 		if (status != 0)
 		{
-			auto status (mdb_del (env.tx (transaction_a), send_blocks, nano::mdb_val (hash_a), nullptr));
+			auto status (mdb_del (env.tx (transaction_a), state_blocks_v0, nano::mdb_val (hash_a), nullptr));
 			release_assert (status == 0 || status == MDB_NOTFOUND);
 			if (status != 0)
 			{
-				auto status (mdb_del (env.tx (transaction_a), receive_blocks, nano::mdb_val (hash_a), nullptr));
+				auto status (mdb_del (env.tx (transaction_a), send_blocks, nano::mdb_val (hash_a), nullptr));
 				release_assert (status == 0 || status == MDB_NOTFOUND);
 				if (status != 0)
 				{
-					auto status (mdb_del (env.tx (transaction_a), open_blocks, nano::mdb_val (hash_a), nullptr));
+					auto status (mdb_del (env.tx (transaction_a), receive_blocks, nano::mdb_val (hash_a), nullptr));
 					release_assert (status == 0 || status == MDB_NOTFOUND);
 					if (status != 0)
 					{
-						auto status (mdb_del (env.tx (transaction_a), change_blocks, nano::mdb_val (hash_a), nullptr));
-						release_assert (status == 0);
+						auto status (mdb_del (env.tx (transaction_a), open_blocks, nano::mdb_val (hash_a), nullptr));
+						release_assert (status == 0 || status == MDB_NOTFOUND);
+						if (status != 0)
+						{
+							auto status (mdb_del (env.tx (transaction_a), change_blocks, nano::mdb_val (hash_a), nullptr));
+							release_assert (status == 0);
+						}
 					}
 				}
 			}
@@ -1563,96 +2297,136 @@ bool nano::mdb_store::block_exists (nano::transaction const & transaction_a, nan
 	auto exists (false);
 	nano::mdb_val junk;
 
-	switch (type)
+	if (single_block_table)
 	{
-		case nano::block_type::send:
-		{
-			auto status (mdb_get (env.tx (transaction_a), send_blocks, nano::mdb_val (hash_a), junk));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			break;
-		}
-		case nano::block_type::receive:
-		{
-			auto status (mdb_get (env.tx (transaction_a), receive_blocks, nano::mdb_val (hash_a), junk));
-			release_assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			break;
-		}
-		case nano::block_type::open:
-		{
-			auto status (mdb_get (env.tx (transaction_a), open_blocks, nano::mdb_val (hash_a), junk));
-			release_assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			break;
-		}
-		case nano::block_type::change:
-		{
-			auto status (mdb_get (env.tx (transaction_a), change_blocks, nano::mdb_val (hash_a), junk));
-			release_assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			break;
-		}
-		case nano::block_type::state:
+		auto status (mdb_get (env.tx (transaction_a), blocks, nano::mdb_val (hash_a), junk));
+		release_assert (status == 0 || status == MDB_NOTFOUND);
+		exists = status == 0 && static_cast<nano::block_type> (reinterpret_cast<uint8_t const *> (junk.data ())[0]) == type;
+	}
+	else
+	{
+		switch (type)
 		{
-			auto status (mdb_get (env.tx (transaction_a), state_blocks_v0, nano::mdb_val (hash_a), junk));
-			release_assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			if (!exists)
+			case nano::block_type::send:
+			{
+				auto status (mdb_get (env.tx (transaction_a), send_blocks, nano::mdb_val (hash_a), junk));
+				assert (status == 0 || status == MDB_NOTFOUND);
+				exists = status == 0;
+				break;
+			}
+			case nano::block_type::receive:
 			{
-				auto status (mdb_get (env.tx (transaction_a), state_blocks_v1, nano::mdb_val (hash_a), junk));
+				auto status (mdb_get (env.tx (transaction_a), receive_blocks, nano::mdb_val (hash_a), junk));
 				release_assert (status == 0 || status == MDB_NOTFOUND);
 				exists = status == 0;
+				break;
 			}
-			break;
+			case nano::block_type::open:
+			{
+				auto status (mdb_get (env.tx (transaction_a), open_blocks, nano::mdb_val (hash_a), junk));
+				release_assert (status == 0 || status == MDB_NOTFOUND);
+				exists = status == 0;
+				break;
+			}
+			case nano::block_type::change:
+			{
+				auto status (mdb_get (env.tx (transaction_a), change_blocks, nano::mdb_val (hash_a), junk));
+				release_assert (status == 0 || status == MDB_NOTFOUND);
+				exists = status == 0;
+				break;
+			}
+			case nano::block_type::state:
+			{
+				auto status (mdb_get (env.tx (transaction_a), state_blocks_v0, nano::mdb_val (hash_a), junk));
+				release_assert (status == 0 || status == MDB_NOTFOUND);
+				exists = status == 0;
+				if (!exists)
+				{
+					auto status (mdb_get (env.tx (transaction_a), state_blocks_v1, nano::mdb_val (hash_a), junk));
+					release_assert (status == 0 || status == MDB_NOTFOUND);
+					exists = status == 0;
+				}
+				break;
+			}
+			case nano::block_type::invalid:
+			case nano::block_type::not_a_block:
+				break;
 		}
-		case nano::block_type::invalid:
-		case nano::block_type::not_a_block:
-			break;
-	}
 
+	}
 	return exists;
 }
 
 bool nano::mdb_store::block_exists (nano::transaction const & tx_a, nano::block_hash const & hash_a)
 {
-	// clang-format off
-	return
-		block_exists (tx_a, nano::block_type::send, hash_a) ||
-		block_exists (tx_a, nano::block_type::receive, hash_a) ||
-		block_exists (tx_a, nano::block_type::open, hash_a) ||
-		block_exists (tx_a, nano::block_type::change, hash_a) ||
-		block_exists (tx_a, nano::block_type::state, hash_a);
-	// clang-format on
+	auto result (false);
+	if (single_block_table)
+	{
+		nano::mdb_val junk;
+		auto status (mdb_get (env.tx (tx_a), blocks, nano::mdb_val (hash_a), junk));
+		release_assert (status == 0 || status == MDB_NOTFOUND);
+		result = status == 0;
+	}
+	else
+	{
+		// clang-format off
+		result =
+			block_exists (tx_a, nano::block_type::send, hash_a) ||
+			block_exists (tx_a, nano::block_type::receive, hash_a) ||
+			block_exists (tx_a, nano::block_type::open, hash_a) ||
+			block_exists (tx_a, nano::block_type::change, hash_a) ||
+			block_exists (tx_a, nano::block_type::state, hash_a);
+		// clang-format on
+	}
+	return result;
 }
 
 nano::block_counts nano::mdb_store::block_count (nano::transaction const & transaction_a)
 {
 	nano::block_counts result;
-	MDB_stat send_stats;
-	auto status1 (mdb_stat (env.tx (transaction_a), send_blocks, &send_stats));
-	release_assert (status1 == 0);
-	MDB_stat receive_stats;
-	auto status2 (mdb_stat (env.tx (transaction_a), receive_blocks, &receive_stats));
-	release_assert (status2 == 0);
-	MDB_stat open_stats;
-	auto status3 (mdb_stat (env.tx (transaction_a), open_blocks, &open_stats));
-	release_assert (status3 == 0);
-	MDB_stat change_stats;
-	auto status4 (mdb_stat (env.tx (transaction_a), change_blocks, &change_stats));
-	release_assert (status4 == 0);
-	MDB_stat state_v0_stats;
-	auto status5 (mdb_stat (env.tx (transaction_a), state_blocks_v0, &state_v0_stats));
-	release_assert (status5 == 0);
-	MDB_stat state_v1_stats;
-	auto status6 (mdb_stat (env.tx (transaction_a), state_blocks_v1, &state_v1_stats));
-	release_assert (status6 == 0);
-	result.send = send_stats.ms_entries;
-	result.receive = receive_stats.ms_entries;
-	result.open = open_stats.ms_entries;
-	result.change = change_stats.ms_entries;
-	result.state_v0 = state_v0_stats.ms_entries;
-	result.state_v1 = state_v1_stats.ms_entries;
+	if (single_block_table)
+	{
+		auto & txn (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ()));
+		auto counts (block_counts_get (txn.handle));
+		// Include this transaction's own changes, they're only written to meta when it commits
+		for (size_t i (0); i < counts.size (); ++i)
+		{
+			counts[i] += txn.block_counts[i];
+		}
+		result.send = counts[block_counts_index (nano::block_type::send, nano::epoch::epoch_0)];
+		result.receive = counts[block_counts_index (nano::block_type::receive, nano::epoch::epoch_0)];
+		result.open = counts[block_counts_index (nano::block_type::open, nano::epoch::epoch_0)];
+		result.change = counts[block_counts_index (nano::block_type::change, nano::epoch::epoch_0)];
+		result.state_v0 = counts[block_counts_index (nano::block_type::state, nano::epoch::epoch_0)];
+		result.state_v1 = counts[block_counts_index (nano::block_type::state, nano::epoch::epoch_1)];
+	}
+	else
+	{
+		MDB_stat send_stats;
+		auto status1 (mdb_stat (env.tx (transaction_a), send_blocks, &send_stats));
+		release_assert (status1 == 0);
+		MDB_stat receive_stats;
+		auto status2 (mdb_stat (env.tx (transaction_a), receive_blocks, &receive_stats));
+		release_assert (status2 == 0);
+		MDB_stat open_stats;
+		auto status3 (mdb_stat (env.tx (transaction_a), open_blocks, &open_stats));
+		release_assert (status3 == 0);
+		MDB_stat change_stats;
+		auto status4 (mdb_stat (env.tx (transaction_a), change_blocks, &change_stats));
+		release_assert (status4 == 0);
+		MDB_stat state_v0_stats;
+		auto status5 (mdb_stat (env.tx (transaction_a), state_blocks_v0, &state_v0_stats));
+		release_assert (status5 == 0);
+		MDB_stat state_v1_stats;
+		auto status6 (mdb_stat (env.tx (transaction_a), state_blocks_v1, &state_v1_stats));
+		release_assert (status6 == 0);
+		result.send = send_stats.ms_entries;
+		result.receive = receive_stats.ms_entries;
+		result.open = open_stats.ms_entries;
+		result.change = change_stats.ms_entries;
+		result.state_v0 = state_v0_stats.ms_entries;
+		result.state_v1 = state_v1_stats.ms_entries;
+	}
 	return result;
 }
 
@@ -1719,13 +2493,52 @@ nano::account nano::mdb_store::block_account_computed (nano::transaction const &
 
 void nano::mdb_store::account_del (nano::transaction const & transaction_a, nano::account const & account_a)
 {
-	auto status1 (mdb_del (env.tx (transaction_a), accounts_v1, nano::mdb_val (account_a), nullptr));
+	auto & txn (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ()));
+	// Start with the table the cached epoch points to
+	nano::account_info info;
+	auto epoch_0 (!account_cache.get (account_a, mdb_txn_id (txn), info) && info.epoch == nano::epoch::epoch_0);
+	auto status1 (mdb_del (env.tx (transaction_a), epoch_0 ? accounts_v0 : accounts_v1, nano::mdb_val (account_a), nullptr));
 	if (status1 != 0)
 	{
 		release_assert (status1 == MDB_NOTFOUND);
-		auto status2 (mdb_del (env.tx (transaction_a), accounts_v0, nano::mdb_val (account_a), nullptr));
+		auto status2 (mdb_del (env.tx (transaction_a), epoch_0 ? accounts_v1 : accounts_v0, nano::mdb_val (account_a), nullptr));
 		release_assert (status2 == 0);
 	}
+	account_write (txn, account_a, boost::none);
+}
+
+void nano::mdb_store::account_write (nano::mdb_txn & txn_a, nano::account const & account_a, boost::optional<nano::account_info> const & info_a)
+{
+	assert (txn_a.write);
+	auto version (mdb_txn_id (txn_a));
+	account_cache.erase (account_a, version);
+	if (txn_a.account_writes.empty ())
+	{
+		auto txn_l (&txn_a);
+		txn_a.commit_callbacks.push_back ([this, txn_l, version]() {
+			for (auto & write : txn_l->account_writes)
+			{
+				if (write.second)
+				{
+					account_cache.put (write.first, version, *write.second);
+				}
+			}
+		});
+	}
+	auto existing (txn_a.account_writes.find (account_a));
+	if (existing != txn_a.account_writes.end ())
+	{
+		existing->second = info_a;
+	}
+	else if (txn_a.account_writes.size () < account_writes_max)
+	{
+		txn_a.account_writes[account_a] = info_a;
+	}
+	else
+	{
+		// Bulk rewrites such as upgrades would otherwise hold every account in memory
+		txn_a.account_writes_full = true;
+	}
 }
 
 bool nano::mdb_store::account_exists (nano::transaction const & transaction_a, nano::account const & account_a)
@@ -1735,6 +2548,35 @@ bool nano::mdb_store::account_exists (nano::transaction const & transaction_a, n
 }
 
 bool nano::mdb_store::account_get (nano::transaction const & transaction_a, nano::account const & account_a, nano::account_info & info_a)
+{
+	auto & txn (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ()));
+	auto result (false);
+	auto written (txn.account_writes.find (account_a));
+	if (written != txn.account_writes.end ())
+	{
+		result = !written->second;
+		if (!result)
+		{
+			info_a = *written->second;
+		}
+	}
+	else
+	{
+		auto version (mdb_txn_id (txn));
+		if (account_cache.get (account_a, version, info_a))
+		{
+			result = account_table_get (transaction_a, account_a, info_a);
+			if (!result && !txn.account_writes_full)
+			{
+				// Accounts the writer hasn't modified are read as of the last commit
+				account_cache.put (account_a, txn.write ? version - 1 : version, info_a, txn.write);
+			}
+		}
+	}
+	return result;
+}
+
+bool nano::mdb_store::account_table_get (nano::transaction const & transaction_a, nano::account const & account_a, nano::account_info & info_a)
 {
 	nano::mdb_val value;
 	auto status1 (mdb_get (env.tx (transaction_a), accounts_v1, nano::mdb_val (account_a), value));
@@ -1821,6 +2663,7 @@ void nano::mdb_store::account_put (nano::transaction const & transaction_a, nano
 	}
 	auto status (mdb_put (env.tx (transaction_a), db, nano::mdb_val (account_a), nano::mdb_val (info_a), 0));
 	release_assert (status == 0);
+	account_write (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ()), account_a, info_a);
 }
 
 void nano::mdb_store::pending_put (nano::transaction const & transaction_a, nano::pending_key const & key_a, nano::pending_info const & pending_a)
@@ -1968,17 +2811,17 @@ bool nano::mdb_store::block_info_get (nano::transaction const & transaction_a, n
 
 nano::uint128_t nano::mdb_store::representation_get (nano::transaction const & transaction_a, nano::account const & account_a)
 {
-	nano::mdb_val value;
-	auto status (mdb_get (env.tx (transaction_a), representation, nano::mdb_val (account_a), value));
-	release_assert (status == 0 || status == MDB_NOTFOUND);
-	nano::uint128_t result = 0;
-	if (status == 0)
+	// Served from memory, representation_cache holds every write to the representation table up to the last commit
+	auto & txn (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ()));
+	nano::uint128_t result (0);
+	auto written (txn.representation_writes.find (account_a));
+	if (written != txn.representation_writes.end ())
 	{
-		nano::uint128_union rep;
-		nano::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		auto error (nano::read (stream, rep));
-		assert (!error);
-		result = rep.number ();
+		result = written->second;
+	}
+	else if (!txn.representation_cleared)
+	{
+		result = representation_cache.representation_get (account_a);
 	}
 	return result;
 }
@@ -1988,6 +2831,41 @@ void nano::mdb_store::representation_put (nano::transaction const & transaction_
 	nano::uint128_union rep (representation_a);
 	auto status (mdb_put (env.tx (transaction_a), representation, nano::mdb_val (account_a), nano::mdb_val (rep), 0));
 	release_assert (status == 0);
+	representation_write (*boost::polymorphic_downcast<nano::mdb_txn *> (transaction_a.impl.get ()), account_a, representation_a);
+}
+
+void nano::mdb_store::representation_write (nano::mdb_txn & txn_a, nano::account const & account_a, nano::uint128_t const & representation_a)
+{
+	representation_stage (txn_a);
+	txn_a.representation_writes[account_a] = representation_a;
+}
+
+void nano::mdb_store::representation_clear (nano::mdb_txn & txn_a)
+{
+	representation_stage (txn_a);
+	txn_a.representation_writes.clear ();
+	txn_a.representation_cleared = true;
+}
+
+void nano::mdb_store::representation_stage (nano::mdb_txn & txn_a)
+{
+	assert (txn_a.write);
+	// Published before the writer lock is released, a writer starting after the commit would otherwise read weights
+	// from before it and overwrite this transaction's changes with stale sums
+	if (txn_a.representation_writes.empty () && !txn_a.representation_cleared)
+	{
+		auto txn_l (&txn_a);
+		txn_a.precommit_callbacks.push_back ([this, txn_l]() {
+			if (txn_l->representation_cleared)
+			{
+				representation_cache.clear ();
+			}
+			for (auto & write : txn_l->representation_writes)
+			{
+				representation_cache.representation_put (write.first, write.second);
+			}
+		});
+	}
 }
 
 void nano::mdb_store::unchecked_clear (nano::transaction const & transaction_a)
@@ -1,19 +1,30 @@
 #pragma once
 
 #include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
 
 #include <lmdb/libraries/liblmdb/lmdb.h>
 
 #include <nano/lib/numbers.hpp>
+#include <nano/node/account_cache.hpp>
+#include <nano/node/block_cache.hpp>
 #include <nano/node/logging.hpp>
 #include <nano/secure/blockstore.hpp>
 #include <nano/secure/common.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace nano
 {
 class mdb_env;
+class store_downgrade;
 class mdb_txn : public transaction_impl
 {
 public:
@@ -23,8 +34,27 @@ public:
 	~mdb_txn ();
 	nano::mdb_txn & operator= (nano::mdb_txn const &) = delete;
 	nano::mdb_txn & operator= (nano::mdb_txn &&) = default;
+	void refresh (std::chrono::milliseconds) override;
 	operator MDB_txn * () const;
 	MDB_txn * handle;
+	nano::mdb_env const * env;
+	bool write;
+	std::chrono::steady_clock::time_point start;
+	/** Account info written by this transaction, empty for deletions. Published to the account cache after commit */
+	std::unordered_map<nano::account, boost::optional<nano::account_info>> account_writes;
+	/** Set once more accounts were written than account_writes holds, reads can no longer tell which accounts are unmodified */
+	bool account_writes_full{ false };
+	/** Representation weights written by this transaction. Published to the representation cache just before commit, while the writer lock is held */
+	std::unordered_map<nano::account, nano::uint128_t> representation_writes;
+	/** Set when the representation table was dropped, the cache is emptied before the writes are published */
+	bool representation_cleared{ false };
+	/** Changes to the per-type block counts made by this transaction, folded in to the meta table once just before commit */
+	std::array<int64_t, 6> block_counts{};
+	bool block_counts_staged{ false };
+	/** Run in order just before a write transaction commits, while it still holds the writer lock */
+	std::vector<std::function<void ()>> precommit_callbacks;
+	/** Run in order once a write transaction has committed */
+	std::vector<std::function<void ()>> commit_callbacks;
 };
 /**
  * RAII wrapper for MDB_env
@@ -37,7 +67,22 @@ public:
 	operator MDB_env * () const;
 	nano::transaction tx_begin (bool = false) const;
 	MDB_txn * tx (nano::transaction const &) const;
+	MDB_txn * read_acquire () const;
+	void read_release (MDB_txn *) const;
+	nano::transaction_counts read_counts () const;
 	MDB_env * environment;
+	/** Reset read transactions waiting to be renewed. MDB_NOTLS lets them move between threads, they're sharded by thread to keep lock contention down */
+	class read_pool
+	{
+	public:
+		std::mutex mutex;
+		std::vector<MDB_txn *> txns;
+	};
+	mutable std::array<read_pool, 8> read_pools;
+	mutable std::atomic<uint64_t> read_begins{ 0 };
+	mutable std::atomic<uint64_t> read_renews{ 0 };
+	mutable std::atomic<uint64_t> read_refreshes{ 0 };
+	static size_t constexpr read_pool_size = 4;
 };
 
 /**
@@ -147,14 +192,18 @@ class logging;
 class mdb_store : public block_store
 {
 	friend class nano::block_predecessor_set;
+	friend class nano::store_downgrade;
 
 public:
-	mdb_store (bool &, nano::logging &, boost::filesystem::path const &, int lmdb_max_dbs = 128);
+	mdb_store (bool &, nano::logging &, boost::filesystem::path const &, int lmdb_max_dbs = 128, size_t block_cache_max_bytes = 0, nano::block_uniquer * = nullptr, size_t account_cache_max_bytes = 0);
 	~mdb_store ();
 
 	nano::transaction tx_begin_write () override;
 	nano::transaction tx_begin_read () override;
 	nano::transaction tx_begin (bool write = false) override;
+	nano::transaction_counts tx_counts () override;
+	nano::uniquer_counters block_cache_counters () override;
+	nano::uniquer_counters account_cache_counters () override;
 
 	void initialize (nano::transaction const &, nano::genesis const &) override;
 	void block_put (nano::transaction const &, nano::block_hash const &, nano::block const &, nano::block_sideband const &, nano::epoch version = nano::epoch::epoch_0) override;
@@ -162,6 +211,7 @@ public:
 	nano::block_hash block_successor (nano::transaction const &, nano::block_hash const &) override;
 	void block_successor_clear (nano::transaction const &, nano::block_hash const &) override;
 	std::shared_ptr<nano::block> block_get (nano::transaction const &, nano::block_hash const &, nano::block_sideband * = nullptr) override;
+	bool block_serialize (nano::transaction const &, nano::block_hash const &, std::vector<uint8_t> &, nano::block_hash &) override;
 	std::shared_ptr<nano::block> block_random (nano::transaction const &) override;
 	void block_del (nano::transaction const &, nano::block_hash const &) override;
 	bool block_exists (nano::transaction const &, nano::block_hash const &) override;
@@ -256,7 +306,9 @@ public:
 	void upgrade_v11_to_v12 (nano::transaction const &);
 	void do_slow_upgrades ();
 	void upgrade_v12_to_v13 ();
+	void upgrade_v13_to_v14 (nano::transaction const &);
 	bool full_sideband (nano::transaction const &);
+	static int constexpr version_current = 14;
 
 	// Requires a write transaction
 	nano::raw_key get_node_id (nano::transaction const &) override;
@@ -266,10 +318,24 @@ public:
 
 	void stop ();
 
+	/** Writes the ledger tables to a checksummed snapshot file in key order, returns true on error */
+	bool snapshot_export (boost::filesystem::path const &);
+	/**
+	 * Bulk loads a snapshot file in to this empty store, verifying block hashes on the given number of threads. Returns true on error
+	 * Accounts, pending, frontiers and representation are loaded as is without being checked against the blocks, the snapshot must come from a trusted source
+	 */
+	bool snapshot_import (boost::filesystem::path const &, unsigned);
+
 	nano::logging & logging;
 
 	nano::mdb_env env;
 
+	/** Blocks recently read through block_get, kept deserialized along with their sideband */
+	nano::block_cache block_cache;
+
+	/** Account info of recently used accounts, written through by account_put and account_del */
+	nano::account_cache account_cache;
+
 	/**
 	 * Maps head block to owning account
 	 * nano::block_hash -> nano::account
@@ -324,6 +390,12 @@ public:
 	 */
 	MDB_dbi state_blocks_v1;
 
+	/**
+	 * Maps block hash to block of any type, replaces the per-type block tables from version 14.
+	 * nano::block_hash -> nano::block_type, nano::epoch, nano::block, nano::block_sideband
+	 */
+	MDB_dbi blocks;
+
 	/**
 	 * Maps min_version 0 (destination account, pending block) to (source account, amount).
 	 * nano::account, nano::block_hash -> nano::account, nano::amount
@@ -348,6 +420,13 @@ public:
 	 */
 	MDB_dbi representation;
 
+	/**
+	 * In-memory copy of representation, loaded on startup.
+	 * Writes are applied just before their transaction commits so the next writer always starts from them. Readers
+	 * aren't versioned and may see weights from a transaction that's committing but newer than their snapshot.
+	 */
+	nano::rep_weights representation_cache;
+
 	/**
 	 * Unchecked bootstrap blocks.
 	 * nano::block_hash -> nano::block
@@ -368,14 +447,33 @@ public:
 
 private:
 	bool entry_has_sideband (MDB_val, nano::block_type);
+	/** LMDB transaction ID, the last committed write for readers and the pending one for writers */
+	uint64_t cache_version (nano::transaction const &);
+	bool account_table_get (nano::transaction const &, nano::account const &, nano::account_info &);
+	/** Stages an account change in the write transaction, published to the account cache once it commits */
+	void account_write (nano::mdb_txn &, nano::account const &, boost::optional<nano::account_info> const &);
+	static size_t constexpr account_writes_max = 64 * 1024;
+	/** Stages a representation weight in the write transaction, published to the representation cache once it commits */
+	void representation_write (nano::mdb_txn &, nano::account const &, nano::uint128_t const &);
+	/** Stages emptying the representation cache, for when the table is dropped */
+	void representation_clear (nano::mdb_txn &);
+	void representation_stage (nano::mdb_txn &);
 	nano::account block_account_computed (nano::transaction const &, nano::block_hash const &);
 	nano::uint128_t block_balance_computed (nano::transaction const &, nano::block_hash const &);
 	MDB_dbi block_database (nano::block_type, nano::epoch);
 	template <typename T>
 	std::shared_ptr<nano::block> block_random (nano::transaction const &, MDB_dbi);
 	MDB_val block_raw_get (nano::transaction const &, nano::block_hash const &, nano::block_type &);
-	void block_raw_put (nano::transaction const &, MDB_dbi, nano::block_hash const &, MDB_val);
+	MDB_val block_raw_get (nano::transaction const &, nano::block_hash const &, nano::block_type &, nano::epoch &);
+	void block_raw_put (nano::transaction const &, nano::block_hash const &, nano::block_type, nano::epoch, MDB_val);
+	void block_counts_add (nano::transaction const &, nano::block_type, nano::epoch, int64_t);
+	/** Per-type block counts as committed to the meta table */
+	std::array<uint64_t, 6> block_counts_get (MDB_txn *);
+	/** Moves blocks back to the per-type tables read before version 14 */
+	void block_tables_split (nano::transaction const &);
 	void clear (MDB_dbi);
+	/** Blocks are kept in the single blocks table rather than the per-type tables, true from version 14 */
+	std::atomic<bool> single_block_table;
 	bool stopped;
 	std::thread upgrades;
 };
@@ -27,6 +27,12 @@ unsigned constexpr nano::active_transactions::request_interval_ms;
 size_t constexpr nano::active_transactions::max_broadcast_queue;
 size_t constexpr nano::block_arrival::arrival_size_min;
 std::chrono::seconds constexpr nano::block_arrival::arrival_time_min;
+size_t constexpr nano::signature_checker::batch_size;
+size_t constexpr nano::signature_checker::queue_capacity;
+size_t constexpr nano::alarm::levels;
+size_t constexpr nano::alarm::slot_bits;
+size_t constexpr nano::alarm::slots;
+uint32_t constexpr nano::alarm::none;
 
 namespace nano
 {
@@ -35,8 +41,9 @@ extern size_t nano_bootstrap_weights_size;
 }
 
 nano::network::network (nano::node & node_a, uint16_t port) :
-buffer_container (node_a.stats, nano::network::buffer_size, 4096), // 2Mb receive buffer
+buffer_container (node_a.stats, nano::network::buffer_size, 4096, node_a.config.udp_shard_by_endpoint ? std::max<size_t> (1, node_a.config.network_threads) : 1), // 2Mb receive buffer
 socket (node_a.io_ctx, nano::endpoint (boost::asio::ip::address_v6::any (), port)),
+batching (node_a.config.udp_batch_size > 0 && nano::udp_batch::supported ()),
 resolver (node_a.io_ctx),
 node (node_a),
 on (true)
@@ -45,11 +52,11 @@ on (true)
 	nano::thread_attributes::set (attrs);
 	for (size_t i = 0; i < node.config.network_threads; ++i)
 	{
-		packet_processing_threads.push_back (boost::thread (attrs, [this]() {
+		packet_processing_threads.push_back (boost::thread (attrs, [this, i]() {
 			nano::thread_role::set (nano::thread_role::name::packet_processing);
 			try
 			{
-				process_packets ();
+				process_packets (i % buffer_container.shards);
 			}
 			catch (boost::system::error_code & ec)
 			{
@@ -91,7 +98,14 @@ void nano::network::start ()
 {
 	for (size_t i = 0; i < node.config.io_threads; ++i)
 	{
-		receive ();
+		if (batching)
+		{
+			receive_batch ();
+		}
+		else
+		{
+			receive ();
+		}
 	}
 }
 
@@ -128,18 +142,58 @@ void nano::network::receive ()
 	});
 }
 
-void nano::network::process_packets ()
+void nano::network::receive_batch ()
 {
+	std::unique_lock<std::mutex> lock (socket_mutex);
+	socket.async_wait (boost::asio::ip::udp::socket::wait_read, [this](boost::system::error_code const & error) {
+		if (!error && this->on)
+		{
+			std::array<nano::udp_data *, nano::network::batch_max> data;
+			auto allocated (this->buffer_container.allocate (data.data (), std::min<size_t> (this->node.config.udp_batch_size, data.size ())));
+			boost::system::error_code ec;
+			// Other waiting threads may already have drained the socket, in which case nothing is received
+			auto received (allocated > 0 ? nano::udp_batch::receive (this->socket, data.data (), allocated, nano::network::buffer_size, ec) : 0);
+			this->buffer_container.enqueue (data.data (), received);
+			this->buffer_container.release (data.data () + received, allocated - received);
+			if (received > 0)
+			{
+				this->node.stats.add_histogram (nano::stat::type::udp, "receive_batch", received);
+			}
+			if (ec && ec != boost::asio::error::would_block && this->node.config.logging.network_logging ())
+			{
+				BOOST_LOG (this->node.log) << boost::str (boost::format ("UDP Receive error: %1%") % ec.message ());
+			}
+			this->receive_batch ();
+		}
+		else
+		{
+			if (error)
+			{
+				if (this->node.config.logging.network_logging ())
+				{
+					BOOST_LOG (this->node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
+				}
+			}
+			if (this->on)
+			{
+				this->node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this]() { this->receive_batch (); });
+			}
+		}
+	});
+}
+
+void nano::network::process_packets (size_t shard_a)
+{
+	std::array<nano::udp_data *, nano::network::dequeue_batch> data;
 	while (on)
 	{
-		auto data (buffer_container.dequeue ());
-		if (data == nullptr)
+		auto count (buffer_container.dequeue (data.data (), data.size (), shard_a));
+		if (count == 0)
 		{
 			break;
 		}
-		//std::cerr << data->endpoint.address ().to_string ();
-		receive_action (data);
-		buffer_container.release (data);
+		receive_action (data.data (), count);
+		buffer_container.release (data.data (), count);
 	}
 }
 
@@ -313,10 +367,11 @@ void nano::network::republish_block_batch (std::deque<std::shared_ptr<nano::bloc
 	if (!blocks_a.empty ())
 	{
 		std::weak_ptr<nano::node> node_w (node.shared ());
-		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a + std::rand () % delay_a), [node_w, blocks_a, delay_a]() {
+		// The remaining blocks are moved along with each step rather than copied, the operation only runs once
+		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a + std::rand () % delay_a), [node_w, blocks = std::move (blocks_a), delay_a]() mutable {
 			if (auto node_l = node_w.lock ())
 			{
-				node_l->network.republish_block_batch (blocks_a, delay_a);
+				node_l->network.republish_block_batch (std::move (blocks), delay_a);
 			}
 		});
 	}
@@ -410,10 +465,10 @@ void nano::network::broadcast_confirm_req_batch (std::deque<std::pair<std::share
 	if (!deque_a.empty ())
 	{
 		std::weak_ptr<nano::node> node_w (node.shared ());
-		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a + std::rand () % delay_a), [node_w, deque_a, delay_a]() {
+		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a + std::rand () % delay_a), [node_w, deque = std::move (deque_a), delay_a]() mutable {
 			if (auto node_l = node_w.lock ())
 			{
-				node_l->network.broadcast_confirm_req_batch (deque_a, delay_a);
+				node_l->network.broadcast_confirm_req_batch (std::move (deque), delay_a);
 			}
 		});
 	}
@@ -507,7 +562,7 @@ public:
 		node.peers.contacted (sender, message_a.header.version_using);
 		if (!node.block_processor.full ())
 		{
-			node.process_active (message_a.block);
+			node.process_active (message_a.block, true);
 		}
 		node.active.publish (message_a.block);
 	}
@@ -546,7 +601,7 @@ public:
 				auto block (boost::get<std::shared_ptr<nano::block>> (vote_block));
 				if (!node.block_processor.full ())
 				{
-					node.process_active (block);
+					node.process_active (block, true);
 				}
 				node.active.publish (block);
 			}
@@ -611,88 +666,228 @@ public:
 	nano::node & node;
 	nano::endpoint sender;
 };
-}
 
-void nano::network::receive_action (nano::udp_data * data_a)
+/**
+ * Holds back messages carrying blocks while a batch of datagrams is parsed so the work of all their blocks can be checked with one nano::work_validate_batch.
+ * Messages without blocks are passed straight on to network_message_visitor.
+ */
+class deferred_work_visitor : public nano::message_visitor
 {
-	auto allowed_sender (true);
-	if (data_a->endpoint == endpoint ())
+public:
+	deferred_work_visitor (nano::node & node_a) :
+	node (node_a),
+	size (0)
+	{
+	}
+	virtual ~deferred_work_visitor () = default;
+	void keepalive (nano::keepalive const & message_a) override
 	{
-		allowed_sender = false;
+		network_message_visitor visitor (node, sender);
+		visitor.keepalive (message_a);
 	}
-	else if (nano::reserved_address (data_a->endpoint, false) && !node.config.allow_local_peers)
+	void publish (nano::publish const & message_a) override
 	{
-		allowed_sender = false;
+		defer (std::make_unique<nano::publish> (message_a));
+		add_work (*message_a.block);
 	}
-	if (allowed_sender)
+	void confirm_req (nano::confirm_req const & message_a) override
 	{
-		network_message_visitor visitor (node, data_a->endpoint);
-		nano::message_parser parser (node.block_uniquer, node.vote_uniquer, visitor, node.work);
-		parser.deserialize_buffer (data_a->buffer, data_a->size);
-		if (parser.status != nano::message_parser::parse_status::success)
+		defer (std::make_unique<nano::confirm_req> (message_a));
+		add_work (*message_a.block);
+	}
+	void confirm_ack (nano::confirm_ack const & message_a) override
+	{
+		defer (std::make_unique<nano::confirm_ack> (message_a));
+		for (auto & vote_block : message_a.vote->blocks)
 		{
-			node.stats.inc (nano::stat::type::error);
-
-			switch (parser.status)
+			if (!vote_block.which ())
 			{
-				case nano::message_parser::parse_status::insufficient_work:
-					// We've already increment error count, update detail only
-					node.stats.inc_detail_only (nano::stat::type::error, nano::stat::detail::insufficient_work);
-					break;
-				case nano::message_parser::parse_status::invalid_magic:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_magic);
-					break;
-				case nano::message_parser::parse_status::invalid_network:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_network);
-					break;
-				case nano::message_parser::parse_status::invalid_header:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_header);
-					break;
-				case nano::message_parser::parse_status::invalid_message_type:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_message_type);
-					break;
-				case nano::message_parser::parse_status::invalid_keepalive_message:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_keepalive_message);
-					break;
-				case nano::message_parser::parse_status::invalid_publish_message:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_publish_message);
-					break;
-				case nano::message_parser::parse_status::invalid_confirm_req_message:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_confirm_req_message);
-					break;
-				case nano::message_parser::parse_status::invalid_confirm_ack_message:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_confirm_ack_message);
-					break;
-				case nano::message_parser::parse_status::invalid_node_id_handshake_message:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_node_id_handshake_message);
-					break;
-				case nano::message_parser::parse_status::outdated_version:
-					node.stats.inc (nano::stat::type::udp, nano::stat::detail::outdated_version);
-					break;
-				case nano::message_parser::parse_status::success:
-					/* Already checked, unreachable */
-					break;
+				add_work (*boost::get<std::shared_ptr<nano::block>> (vote_block));
 			}
-
-			if (node.config.logging.network_logging () && parser.status != nano::message_parser::parse_status::outdated_version)
+		}
+	}
+	void bulk_pull (nano::bulk_pull const &) override
+	{
+		assert (false);
+	}
+	void bulk_pull_account (nano::bulk_pull_account const &) override
+	{
+		assert (false);
+	}
+	void bulk_push (nano::bulk_push const &) override
+	{
+		assert (false);
+	}
+	void frontier_req (nano::frontier_req const &) override
+	{
+		assert (false);
+	}
+	void node_id_handshake (nano::node_id_handshake const & message_a) override
+	{
+		network_message_visitor visitor (node, sender);
+		visitor.node_id_handshake (message_a);
+	}
+	// Validates the work of every deferred block and visits the messages whose blocks all passed
+	void flush ()
+	{
+		std::unique_ptr<bool[]> errors (new bool[roots.size ()]);
+		nano::work_validate_batch (roots.data (), works.data (), roots.size (), errors.get ());
+		for (size_t i (0), n (roots.size ()); i < n; ++i)
+		{
+			if (errors[i])
 			{
-				BOOST_LOG (node.log) << "Could not parse message.  Error: " << parser.status_string ();
+				messages[owners[i]].insufficient_work = true;
 			}
 		}
-		else
+		for (auto & deferred : messages)
 		{
-			node.stats.add (nano::stat::type::traffic, nano::stat::dir::in, data_a->size);
+			if (!deferred.insufficient_work)
+			{
+				network_message_visitor visitor (node, deferred.sender);
+				deferred.message->visit (visitor);
+				node.stats.add (nano::stat::type::traffic, nano::stat::dir::in, deferred.size);
+			}
+			else
+			{
+				node.stats.inc (nano::stat::type::error);
+				node.stats.inc_detail_only (nano::stat::type::error, nano::stat::detail::insufficient_work);
+				if (node.config.logging.network_logging ())
+				{
+					BOOST_LOG (node.log) << "Could not parse message.  Error: insufficient_work";
+				}
+			}
 		}
+		messages.clear ();
+		roots.clear ();
+		works.clear ();
+		owners.clear ();
 	}
-	else
+	class deferred_message
+	{
+	public:
+		std::unique_ptr<nano::message> message;
+		nano::endpoint sender;
+		size_t size;
+		bool insufficient_work;
+	};
+	nano::node & node;
+	// Sender and size of the datagram currently being parsed
+	nano::endpoint sender;
+	size_t size;
+	std::vector<deferred_message> messages;
+	std::vector<nano::block_hash> roots;
+	std::vector<uint64_t> works;
+	// Index into messages of the message each root and work came from
+	std::vector<size_t> owners;
+
+private:
+	void defer (std::unique_ptr<nano::message> message_a)
 	{
-		if (node.config.logging.network_logging ())
+		messages.push_back ({ std::move (message_a), sender, size, false });
+	}
+	void add_work (nano::block const & block_a)
+	{
+		roots.push_back (block_a.root ());
+		works.push_back (block_a.block_work ());
+		owners.push_back (messages.size () - 1);
+	}
+};
+}
+
+void nano::network::receive_action (nano::udp_data * data_a)
+{
+	receive_action (&data_a, 1);
+}
+
+void nano::network::receive_action (nano::udp_data * const * data_a, size_t count_a)
+{
+	deferred_work_visitor visitor (node);
+	for (size_t i (0); i < count_a; ++i)
+	{
+		auto data (data_a[i]);
+		auto allowed_sender (true);
+		if (data->endpoint == endpoint ())
 		{
-			BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % data_a->endpoint.address ().to_string ());
+			allowed_sender = false;
 		}
+		else if (nano::reserved_address (data->endpoint, false) && !node.config.allow_local_peers)
+		{
+			allowed_sender = false;
+		}
+		if (allowed_sender)
+		{
+			visitor.sender = data->endpoint;
+			visitor.size = data->size;
+			auto deferred (visitor.messages.size ());
+			nano::message_parser parser (node.block_uniquer, node.vote_uniquer, visitor, node.work, false);
+			parser.deserialize_buffer (data->buffer, data->size);
+			if (parser.status != nano::message_parser::parse_status::success)
+			{
+				node.stats.inc (nano::stat::type::error);
 
-		node.stats.inc_detail_only (nano::stat::type::error, nano::stat::detail::bad_sender);
+				switch (parser.status)
+				{
+					case nano::message_parser::parse_status::insufficient_work:
+						// We've already increment error count, update detail only
+						node.stats.inc_detail_only (nano::stat::type::error, nano::stat::detail::insufficient_work);
+						break;
+					case nano::message_parser::parse_status::invalid_magic:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_magic);
+						break;
+					case nano::message_parser::parse_status::invalid_network:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_network);
+						break;
+					case nano::message_parser::parse_status::invalid_header:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_header);
+						break;
+					case nano::message_parser::parse_status::invalid_message_type:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_message_type);
+						break;
+					case nano::message_parser::parse_status::invalid_keepalive_message:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_keepalive_message);
+						break;
+					case nano::message_parser::parse_status::invalid_publish_message:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_publish_message);
+						break;
+					case nano::message_parser::parse_status::invalid_confirm_req_message:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_confirm_req_message);
+						break;
+					case nano::message_parser::parse_status::invalid_confirm_ack_message:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_confirm_ack_message);
+						break;
+					case nano::message_parser::parse_status::invalid_node_id_handshake_message:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::invalid_node_id_handshake_message);
+						break;
+					case nano::message_parser::parse_status::outdated_version:
+						node.stats.inc (nano::stat::type::udp, nano::stat::detail::outdated_version);
+						break;
+					case nano::message_parser::parse_status::success:
+						/* Already checked, unreachable */
+						break;
+				}
+
+				if (node.config.logging.network_logging () && parser.status != nano::message_parser::parse_status::outdated_version)
+				{
+					BOOST_LOG (node.log) << "Could not parse message.  Error: " << parser.status_string ();
+				}
+			}
+			else if (visitor.messages.size () == deferred)
+			{
+				// Deferred messages are counted once their work has been validated
+				node.stats.add (nano::stat::type::traffic, nano::stat::dir::in, data->size);
+			}
+		}
+		else
+		{
+			if (node.config.logging.network_logging ())
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % data->endpoint.address ().to_string ());
+			}
+
+			node.stats.inc_detail_only (nano::stat::type::error, nano::stat::detail::bad_sender);
+		}
 	}
+	visitor.flush ();
 }
 
 // Send keepalives to all the peers we've been notified of
@@ -707,13 +902,22 @@ void nano::network::merge_peers (std::array<nano::endpoint, 8> const & peers_a)
 	}
 }
 
-bool nano::operation::operator> (nano::operation const & other_a) const
-{
-	return wakeup > other_a.wakeup;
-}
-
 nano::alarm::alarm (boost::asio::io_context & io_ctx_a) :
 io_ctx (io_ctx_a),
+start (std::chrono::steady_clock::now ()),
+current (0),
+wakeup_tick (0),
+pending (0),
+free_head (none),
+wheel ([]() {
+	std::array<std::array<uint32_t, slots>, levels> result;
+	for (auto & level : result)
+	{
+		level.fill (none);
+	}
+	return result;
+}()),
+stopped (false),
 thread ([this]() {
 	nano::thread_role::set (nano::thread_role::name::alarm);
 	run ();
@@ -723,51 +927,247 @@ thread ([this]() {
 
 nano::alarm::~alarm ()
 {
-	add (std::chrono::steady_clock::now (), nullptr);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
 	thread.join ();
 }
 
 void nano::alarm::run ()
 {
+	std::vector<std::function<void()>> expired;
 	std::unique_lock<std::mutex> lock (mutex);
 	auto done (false);
 	while (!done)
 	{
-		if (!operations.empty ())
+		done = stopped;
+		advance (std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - start).count (), expired);
+		if (!expired.empty ())
+		{
+			// Post the whole batch outside the lock so adding new operations isn't held up by io_ctx
+			lock.unlock ();
+			for (auto & function : expired)
+			{
+				io_ctx.post (std::move (function));
+			}
+			expired.clear ();
+			lock.lock ();
+		}
+		else if (!done)
 		{
-			auto & operation (operations.top ());
-			if (operation.function)
+			wakeup_tick = next_tick ();
+			if (wakeup_tick == std::numeric_limits<uint64_t>::max ())
 			{
-				if (operation.wakeup <= std::chrono::steady_clock::now ())
+				condition.wait (lock);
+			}
+			else
+			{
+				condition.wait_until (lock, start + std::chrono::milliseconds (wakeup_tick));
+			}
+			// Awake, operations added from here on are picked up by next_tick
+			wakeup_tick = 0;
+		}
+	}
+}
+
+nano::alarm_handle nano::alarm::add (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> operation)
+{
+	nano::alarm_handle result;
+	auto now (std::chrono::steady_clock::now ());
+	std::unique_lock<std::mutex> lock (mutex);
+	if (pending == 0)
+	{
+		// The wheel doesn't advance while it's empty, catch up so new operations are placed relative to the current time
+		current = std::max<uint64_t> (current, std::chrono::duration_cast<std::chrono::milliseconds> (now - start).count ());
+	}
+	auto tick (ticks (wakeup_a));
+	if (wakeup_a <= now || tick <= current)
+	{
+		// Already due, skip the wheel
+		lock.unlock ();
+		io_ctx.post (std::move (operation));
+	}
+	else
+	{
+		if (free_head == none)
+		{
+			entries.push_back (nano::operation ());
+			entries.back ().generation = 0;
+			free_head = static_cast<uint32_t> (entries.size () - 1);
+			entries.back ().next = none;
+		}
+		auto index (free_head);
+		auto & entry (entries[index]);
+		free_head = entry.next;
+		entry.wakeup = wakeup_a;
+		entry.function = std::move (operation);
+		entry.tick = tick;
+		insert (index);
+		++pending;
+		result = { index, entry.generation };
+		auto notify (tick < wakeup_tick);
+		lock.unlock ();
+		if (notify)
+		{
+			condition.notify_one ();
+		}
+	}
+	return result;
+}
+
+bool nano::alarm::cancel (nano::alarm_handle const & handle_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto result (handle_a.index >= entries.size () || entries[handle_a.index].generation != handle_a.generation);
+	if (!result)
+	{
+		unlink (handle_a.index);
+		release (handle_a.index);
+		--pending;
+	}
+	return result;
+}
+
+nano::stat_histogram nano::alarm::lateness ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return late;
+}
+
+uint64_t nano::alarm::ticks (std::chrono::steady_clock::time_point const & time_a) const
+{
+	uint64_t result (0);
+	if (time_a > start)
+	{
+		// Round up so operations never fire before their wakeup time
+		auto elapsed (std::chrono::duration_cast<std::chrono::microseconds> (time_a - start).count ());
+		result = (elapsed + 999) / 1000;
+	}
+	return result;
+}
+
+void nano::alarm::insert (uint32_t index_a)
+{
+	auto & entry (entries[index_a]);
+	assert (entry.tick > current);
+	auto delta (entry.tick - current);
+	size_t level (0);
+	while (level < levels - 1 && delta >= (uint64_t (1) << (slot_bits * (level + 1))))
+	{
+		++level;
+	}
+	// Operations beyond the range of the top level are parked in its furthest slot and reinserted when it cascades
+	auto tick (std::min (entry.tick, current + (uint64_t (1) << (slot_bits * levels)) - 1));
+	entry.level = static_cast<uint8_t> (level);
+	entry.slot = static_cast<uint8_t> ((tick >> (slot_bits * level)) & (slots - 1));
+	auto & head (wheel[entry.level][entry.slot]);
+	entry.previous = none;
+	entry.next = head;
+	if (head != none)
+	{
+		entries[head].previous = index_a;
+	}
+	head = index_a;
+}
+
+void nano::alarm::unlink (uint32_t index_a)
+{
+	auto & entry (entries[index_a]);
+	if (entry.previous != none)
+	{
+		entries[entry.previous].next = entry.next;
+	}
+	else
+	{
+		wheel[entry.level][entry.slot] = entry.next;
+	}
+	if (entry.next != none)
+	{
+		entries[entry.next].previous = entry.previous;
+	}
+}
+
+void nano::alarm::release (uint32_t index_a)
+{
+	auto & entry (entries[index_a]);
+	entry.function = nullptr;
+	++entry.generation;
+	entry.next = free_head;
+	free_head = index_a;
+}
+
+void nano::alarm::expire (uint32_t index_a, std::chrono::steady_clock::time_point const & now_a, std::vector<std::function<void()>> & expired_a)
+{
+	auto & entry (entries[index_a]);
+	late.add (now_a > entry.wakeup ? std::chrono::duration_cast<std::chrono::microseconds> (now_a - entry.wakeup).count () : 0);
+	expired_a.push_back (std::move (entry.function));
+	release (index_a);
+	--pending;
+}
+
+void nano::alarm::advance (uint64_t target_a, std::vector<std::function<void()>> & expired_a)
+{
+	auto now (std::chrono::steady_clock::now ());
+	if (pending == 0)
+	{
+		current = std::max (current, target_a);
+	}
+	while (current < target_a)
+	{
+		++current;
+		// Find the highest level whose slot just came around, cascading from the top so operations can drop several levels in one tick
+		size_t top (0);
+		while (top < levels - 1 && (current & ((uint64_t (1) << (slot_bits * (top + 1))) - 1)) == 0)
+		{
+			++top;
+		}
+		for (auto level (top); level > 0; --level)
+		{
+			auto & head (wheel[level][(current >> (slot_bits * level)) & (slots - 1)]);
+			auto index (head);
+			head = none;
+			while (index != none)
+			{
+				auto next (entries[index].next);
+				if (entries[index].tick <= current)
 				{
-					io_ctx.post (operation.function);
-					operations.pop ();
+					expire (index, now, expired_a);
 				}
 				else
 				{
-					auto wakeup (operation.wakeup);
-					condition.wait_until (lock, wakeup);
+					insert (index);
 				}
-			}
-			else
-			{
-				done = true;
+				index = next;
 			}
 		}
-		else
+		auto & head (wheel[0][current & (slots - 1)]);
+		auto index (head);
+		head = none;
+		while (index != none)
 		{
-			condition.wait (lock);
+			auto next (entries[index].next);
+			expire (index, now, expired_a);
+			index = next;
 		}
 	}
 }
 
-void nano::alarm::add (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> const & operation)
+uint64_t nano::alarm::next_tick () const
 {
+	auto result (std::numeric_limits<uint64_t>::max ());
+	if (pending > 0)
 	{
-		std::lock_guard<std::mutex> lock (mutex);
-		operations.push (nano::operation ({ wakeup_a, operation }));
+		// Wake for the next occupied slot on the lowest level, or when the next level cascades
+		auto boundary ((current | (slots - 1)) + 1);
+		result = current + 1;
+		while (result < boundary && wheel[0][result & (slots - 1)] == none)
+		{
+			++result;
+		}
 	}
-	condition.notify_all ();
+	return result;
 }
 
 nano::node_init::node_init () :
@@ -1103,15 +1503,15 @@ bool nano::rep_crawler::exists (nano::block_hash const & hash_a)
 	return active.count (hash_a) != 0;
 }
 
-nano::signature_checker::signature_checker () :
-started (false),
-stopped (false),
-thread ([this]() { run (); })
+nano::signature_checker::signature_checker (unsigned num_threads) :
+pending (0),
+idle (0),
+producers (0),
+stopped (false)
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (!started)
+	for (auto i (0u); i < num_threads; ++i)
 	{
-		condition.wait (lock);
+		threads.push_back (std::thread ([this]() { run (); }));
 	}
 }
 
@@ -1122,68 +1522,121 @@ nano::signature_checker::~signature_checker ()
 
 void nano::signature_checker::add (nano::signature_check_set & check_a)
 {
+	if (check_a.size == 0)
 	{
-		std::lock_guard<std::mutex> lock (mutex);
-		checks.push_back (check_a);
+		check_a.promise->set_value ();
+	}
+	else
+	{
+		auto count ((check_a.size + batch_size - 1) / batch_size);
+		auto task_l (new nano::signature_checker::task);
+		task_l->check = check_a;
+		task_l->remaining = count;
+		pending += count;
+		// Registering before checking stopped means stop either sees this producer and waits for it, or we see stopped
+		++producers;
+		auto inline_l (threads.empty () || stopped);
+		for (size_t i (0); i < count; ++i)
+		{
+			auto offset (i * batch_size);
+			nano::signature_checker::chunk chunk_l{ task_l, offset, std::min (batch_size, check_a.size - offset) };
+			// Verify on the calling thread if there are no checker threads or the queue is full, this applies backpressure to producers
+			if (inline_l || !chunks.bounded_push (chunk_l))
+			{
+				verify (chunk_l);
+			}
+		}
+		--producers;
+		// Pairs with the fence in run () so either a worker sees the new chunks or we see the idle worker
+		std::atomic_thread_fence (std::memory_order_seq_cst);
+		if (idle > 0)
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			condition.notify_all ();
+		}
 	}
-	condition.notify_all ();
 }
 
 void nano::signature_checker::stop ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	stopped = true;
-	lock.unlock ();
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
 	condition.notify_all ();
-	if (thread.joinable ())
+	for (auto & thread : threads)
 	{
-		thread.join ();
+		if (thread.joinable ())
+		{
+			thread.join ();
+		}
+	}
+	// Chunks pushed by producers that checked stopped before it was set are verified here
+	while (producers > 0)
+	{
+		std::this_thread::yield ();
+	}
+	nano::signature_checker::chunk chunk_l;
+	while (chunks.pop (chunk_l))
+	{
+		verify (chunk_l);
 	}
 }
 
 void nano::signature_checker::flush ()
 {
 	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && !checks.empty ())
+	while (!stopped && pending > 0)
 	{
 		condition.wait (lock);
 	}
 }
 
-void nano::signature_checker::verify (nano::signature_check_set & check_a)
+void nano::signature_checker::verify (nano::signature_checker::chunk const & chunk_a)
 {
+	auto & check (chunk_a.owner->check);
 	/* Verifications is vector if signatures check results
 	 validate_message_batch returing "true" if there are at least 1 invalid signature */
-	auto code (nano::validate_message_batch (check_a.messages, check_a.message_lengths, check_a.pub_keys, check_a.signatures, check_a.size, check_a.verifications));
+	auto code (nano::validate_message_batch (check.messages + chunk_a.offset, check.message_lengths + chunk_a.offset, check.pub_keys + chunk_a.offset, check.signatures + chunk_a.offset, chunk_a.size, check.verifications + chunk_a.offset));
 	(void)code;
-	release_assert (std::all_of (check_a.verifications, check_a.verifications + check_a.size, [](int verification) { return verification == 0 || verification == 1; }));
-	check_a.promise->set_value ();
+	release_assert (std::all_of (check.verifications + chunk_a.offset, check.verifications + chunk_a.offset + chunk_a.size, [](int verification) { return verification == 0 || verification == 1; }));
+	if (--chunk_a.owner->remaining == 0)
+	{
+		check.promise->set_value ();
+		delete chunk_a.owner;
+	}
+	if (--pending == 0)
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		condition.notify_all ();
+	}
 }
 
 void nano::signature_checker::run ()
 {
 	nano::thread_role::set (nano::thread_role::name::signature_checking);
-	std::unique_lock<std::mutex> lock (mutex);
-	started = true;
-
-	lock.unlock ();
-	condition.notify_all ();
-	lock.lock ();
-
-	while (!stopped)
+	nano::signature_checker::chunk chunk_l;
+	while (true)
 	{
-		if (!checks.empty ())
+		if (chunks.pop (chunk_l))
 		{
-			auto check (checks.front ());
-			checks.pop_front ();
-			lock.unlock ();
-			verify (check);
-			condition.notify_all ();
-			lock.lock ();
+			verify (chunk_l);
 		}
 		else
 		{
-			condition.wait (lock);
+			std::unique_lock<std::mutex> lock (mutex);
+			++idle;
+			std::atomic_thread_fence (std::memory_order_seq_cst);
+			// Remaining chunks are drained before exiting so no caller is left waiting on its promise
+			while (!stopped && chunks.empty ())
+			{
+				condition.wait (lock);
+			}
+			--idle;
+			if (stopped && chunks.empty ())
+			{
+				break;
+			}
 		}
 	}
 }
@@ -1191,9 +1644,14 @@ void nano::signature_checker::run ()
 nano::block_processor::block_processor (nano::node & node_a) :
 stopped (false),
 active (false),
+verifying (false),
 next_log (std::chrono::steady_clock::now ()),
 node (node_a),
-generator (node_a, nano::nano_network == nano::nano_networks::nano_test_network ? std::chrono::milliseconds (10) : std::chrono::milliseconds (500))
+generator (node_a, nano::nano_network == nano::nano_networks::nano_test_network ? std::chrono::milliseconds (10) : std::chrono::milliseconds (500)),
+verification_thread ([this]() {
+	nano::thread_role::set (nano::thread_role::name::block_verification);
+	this->verify_blocks ();
+})
 {
 }
 
@@ -1210,13 +1668,17 @@ void nano::block_processor::stop ()
 		stopped = true;
 	}
 	condition.notify_all ();
+	if (verification_thread.joinable ())
+	{
+		verification_thread.join ();
+	}
 }
 
 void nano::block_processor::flush ()
 {
 	node.checker.flush ();
 	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && (have_blocks () || active))
+	while (!stopped && (have_blocks () || active || verifying))
 	{
 		condition.wait (lock);
 	}
@@ -1228,9 +1690,10 @@ bool nano::block_processor::full ()
 	return (blocks.size () + state_blocks.size ()) > 65536;
 }
 
-void nano::block_processor::add (std::shared_ptr<nano::block> block_a, std::chrono::steady_clock::time_point origination)
+void nano::block_processor::add (std::shared_ptr<nano::block> block_a, std::chrono::steady_clock::time_point origination, bool work_validated_a)
 {
-	if (!nano::work_validate (block_a->root (), block_a->block_work ()))
+	assert (!work_validated_a || !nano::work_validate (*block_a));
+	if (work_validated_a || !nano::work_validate (block_a->root (), block_a->block_work ()))
 	{
 		{
 			auto hash (block_a->hash ());
@@ -1240,10 +1703,12 @@ void nano::block_processor::add (std::shared_ptr<nano::block> block_a, std::chro
 				if (block_a->type () == nano::block_type::state && !node.ledger.is_epoch_link (block_a->link ()))
 				{
 					state_blocks.push_back (std::make_pair (block_a, origination));
+					node.stats.inc (nano::stat::type::block_processor, nano::stat::detail::signature_verification, nano::stat::dir::in);
 				}
 				else
 				{
 					blocks.push_back (std::make_pair (block_a, origination));
+					node.stats.inc (nano::stat::type::block_processor, nano::stat::detail::ledger_apply, nano::stat::dir::in);
 				}
 				blocks_hashes.insert (hash);
 			}
@@ -1271,12 +1736,10 @@ void nano::block_processor::process_blocks ()
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!stopped)
 	{
-		if (have_blocks ())
+		if (have_verified_blocks ())
 		{
 			active = true;
-			lock.unlock ();
 			process_batch (lock);
-			lock.lock ();
 			active = false;
 		}
 		else
@@ -1308,21 +1771,54 @@ bool nano::block_processor::have_blocks ()
 	return !blocks.empty () || !forced.empty () || !state_blocks.empty ();
 }
 
-void nano::block_processor::verify_state_blocks (nano::transaction const & transaction_a, std::unique_lock<std::mutex> & lock_a, size_t max_count)
+bool nano::block_processor::have_verified_blocks ()
+{
+	assert (!mutex.try_lock ());
+	return !blocks.empty () || !forced.empty ();
+}
+
+void nano::block_processor::verify_blocks ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		// Apply backpressure from the ledger stage so verified blocks do not pile up in memory
+		if (!state_blocks.empty () && blocks.size () < verified_max)
+		{
+			verifying = true;
+			verify_state_blocks (lock, verification_batch_size);
+			verifying = false;
+			lock.unlock ();
+			condition.notify_all ();
+			lock.lock ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+void nano::block_processor::verify_state_blocks (std::unique_lock<std::mutex> & lock_a, size_t max_count)
 {
 	assert (!mutex.try_lock ());
 	nano::timer<std::chrono::milliseconds> timer_l (nano::timer_state::started);
 	std::deque<std::pair<std::shared_ptr<nano::block>, std::chrono::steady_clock::time_point>> items;
 	for (auto i (0); i < max_count && !state_blocks.empty (); i++)
 	{
-		auto item (state_blocks.front ());
+		items.push_back (state_blocks.front ());
 		state_blocks.pop_front ();
-		if (!node.ledger.store.block_exists (transaction_a, item.first->type (), item.first->hash ()))
-		{
-			items.push_back (item);
-		}
 	}
+	node.stats.add (nano::stat::type::block_processor, nano::stat::detail::signature_verification, nano::stat::dir::out, items.size ());
 	lock_a.unlock ();
+	{
+		// Skip blocks already in the ledger, this read transaction runs concurrently with the ledger stage's write transaction
+		auto transaction (node.store.tx_begin_read ());
+		items.erase (std::remove_if (items.begin (), items.end (), [this, &transaction](auto const & item_a) {
+			return node.ledger.store.block_exists (transaction, item_a.first->type (), item_a.first->hash ());
+		}),
+		items.end ());
+	}
 	if (!items.empty ())
 	{
 		auto size (items.size ());
@@ -1358,6 +1854,7 @@ void nano::block_processor::verify_state_blocks (nano::transaction const & trans
 			if (verifications[i] == 1)
 			{
 				blocks.push_back (items.front ());
+				node.stats.inc (nano::stat::type::block_processor, nano::stat::detail::ledger_apply, nano::stat::dir::in);
 			}
 			items.pop_front ();
 		}
@@ -1374,109 +1871,101 @@ void nano::block_processor::verify_state_blocks (nano::transaction const & trans
 
 void nano::block_processor::process_batch (std::unique_lock<std::mutex> & lock_a)
 {
-	nano::timer<std::chrono::milliseconds> timer_l;
-	lock_a.lock ();
-	timer_l.start ();
-	// Limit state blocks verification time
-	if (!state_blocks.empty ())
+	assert (lock_a.owns_lock ());
+	// The batch is taken out of the queues here and applied on the store writer thread, the mutex stays owned by this thread
+	auto log_this_record (false);
+	if (node.config.logging.timing_logging ())
 	{
-		auto transaction (node.store.tx_begin_read ());
-		while (!state_blocks.empty () && timer_l.before_deadline (std::chrono::seconds (2)))
-		{
-			verify_state_blocks (transaction, lock_a, 2048);
-		}
+		log_this_record = should_log (true);
 	}
-	lock_a.unlock ();
-	auto transaction (node.store.tx_begin_write ());
-	timer_l.restart ();
-	lock_a.lock ();
-	// Processing blocks
-	auto first_time (true);
-	unsigned number_of_blocks_processed (0), number_of_forced_processed (0);
-	while ((!blocks.empty () || !forced.empty ()) && timer_l.before_deadline (node.config.block_processor_batch_max_time))
+	else
 	{
-		auto log_this_record (false);
-		if (node.config.logging.timing_logging ())
-		{
-			if (should_log (first_time))
-			{
-				log_this_record = true;
-			}
-		}
-		else
-		{
-			if (((blocks.size () + state_blocks.size () + forced.size ()) > 64 && should_log (false)))
-			{
-				log_this_record = true;
-			}
-		}
-
-		if (log_this_record)
-		{
-			first_time = false;
-			BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks (+ %2% state blocks) (+ %3% forced) in processing queue") % blocks.size () % state_blocks.size () % forced.size ());
-		}
-		std::pair<std::shared_ptr<nano::block>, std::chrono::steady_clock::time_point> block;
-		bool force (false);
-		if (forced.empty ())
-		{
-			block = blocks.front ();
-			blocks.pop_front ();
-			blocks_hashes.erase (block.first->hash ());
-		}
-		else
-		{
-			block = std::make_pair (forced.front (), std::chrono::steady_clock::now ());
-			forced.pop_front ();
-			force = true;
-			number_of_forced_processed++;
-		}
-		lock_a.unlock ();
-		auto hash (block.first->hash ());
-		if (force)
-		{
-			auto successor (node.ledger.successor (transaction, nano::uint512_union (block.first->previous (), block.first->root ())));
-			if (successor != nullptr && successor->hash () != hash)
-			{
-				// Replace our block with the winner and roll back any dependent blocks
-				BOOST_LOG (node.log) << boost::str (boost::format ("Rolling back %1% and replacing with %2%") % successor->hash ().to_string () % hash.to_string ());
-				node.ledger.rollback (transaction, successor->hash ());
-				lock_a.lock ();
-				// Prevent rolled back blocks second insertion
-				auto inserted (rolled_back.insert (nano::rolled_hash{ std::chrono::steady_clock::now (), successor->hash () }));
-				if (inserted.second)
+		log_this_record = (blocks.size () + state_blocks.size () + forced.size ()) > 64 && should_log (false);
+	}
+	if (log_this_record)
+	{
+		BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks (+ %2% state blocks) (+ %3% forced) in processing queue") % blocks.size () % state_blocks.size () % forced.size ());
+	}
+	std::deque<std::shared_ptr<nano::block>> forced_l;
+	forced_l.swap (forced);
+	std::deque<std::pair<std::shared_ptr<nano::block>, std::chrono::steady_clock::time_point>> blocks_l;
+	// Bootstrap pulls add blocks without an origination time, a batch holding only those yields to live writes
+	auto live (!forced_l.empty ());
+	while (!blocks.empty () && blocks_l.size () < process_batch_max)
+	{
+		live = live || blocks.front ().second != std::chrono::steady_clock::time_point ();
+		blocks_l.push_back (std::move (blocks.front ()));
+		blocks.pop_front ();
+	}
+	lock_a.unlock ();
+	nano::timer<std::chrono::milliseconds> timer_l (nano::timer_state::started);
+	size_t number_of_forced_processed (0), number_of_blocks_processed (0);
+	auto max_time (std::min (node.config.block_processor_batch_max_time, node.config.write_batch_max_time));
+	node.write_scheduler.run (live ? nano::write_priority::live : nano::write_priority::bootstrap, [this, &forced_l, &blocks_l, &number_of_forced_processed, &number_of_blocks_processed, max_time](nano::transaction const & transaction_a) {
+		// State block signatures are checked on verification_thread so the write transaction never waits on crypto
+		nano::timer<std::chrono::milliseconds> deadline_l (nano::timer_state::started);
+		while ((number_of_forced_processed < forced_l.size () || number_of_blocks_processed < blocks_l.size ()) && deadline_l.before_deadline (max_time))
+		{
+			std::pair<std::shared_ptr<nano::block>, std::chrono::steady_clock::time_point> block;
+			auto force (number_of_forced_processed < forced_l.size ());
+			if (force)
+			{
+				block = std::make_pair (forced_l[number_of_forced_processed], std::chrono::steady_clock::now ());
+				++number_of_forced_processed;
+			}
+			else
+			{
+				block = blocks_l[number_of_blocks_processed];
+				++number_of_blocks_processed;
+			}
+			auto hash (block.first->hash ());
+			if (force)
+			{
+				auto successor (node.ledger.successor (transaction_a, nano::uint512_union (block.first->previous (), block.first->root ())));
+				if (successor != nullptr && successor->hash () != hash)
 				{
-					// Possible election winner change
-					rolled_back.get<1> ().erase (hash);
-					// Prevent overflow
-					if (rolled_back.size () > rolled_back_max)
+					// Replace our block with the winner and roll back any dependent blocks
+					BOOST_LOG (node.log) << boost::str (boost::format ("Rolling back %1% and replacing with %2%") % successor->hash ().to_string () % hash.to_string ());
+					node.ledger.rollback (transaction_a, successor->hash ());
+					std::lock_guard<std::mutex> lock (mutex);
+					// Prevent rolled back blocks second insertion
+					auto inserted (rolled_back.insert (nano::rolled_hash{ std::chrono::steady_clock::now (), successor->hash () }));
+					if (inserted.second)
 					{
-						rolled_back.erase (rolled_back.begin ());
+						// Possible election winner change
+						rolled_back.get<1> ().erase (hash);
+						// Prevent overflow
+						if (rolled_back.size () > rolled_back_max)
+						{
+							rolled_back.erase (rolled_back.begin ());
+						}
 					}
 				}
-				lock_a.unlock ();
 			}
+			/* Forced state blocks are not validated in verify_state_blocks () function
+			Because of that we should set set validated_state_block as "false" for forced state blocks (!force) */
+			bool validated_state_block (!force && block.first->type () == nano::block_type::state);
+			auto process_result (process_one (transaction_a, block.first, block.second, validated_state_block));
+			(void)process_result;
 		}
-		/* Forced state blocks are not validated in verify_state_blocks () function
-		Because of that we should set set validated_state_block as "false" for forced state blocks (!force) */
-		bool validated_state_block (!force && block.first->type () == nano::block_type::state);
-		auto process_result (process_one (transaction, block.first, block.second, validated_state_block));
-		number_of_blocks_processed++;
-		(void)process_result;
-		lock_a.lock ();
-		/* Verify more state blocks if blocks deque is empty
-		Because verification is long process, avoid large deque verification inside of write transaction */
-		if (blocks.empty () && !state_blocks.empty ())
-		{
-			verify_state_blocks (transaction, lock_a, 256);
-		}
+	});
+	lock_a.lock ();
+	// Blocks left when the deadline passed go back to the front of the queues in their original order
+	forced.insert (forced.begin (), forced_l.begin () + number_of_forced_processed, forced_l.end ());
+	for (auto i (blocks_l.begin ()), n (blocks_l.begin () + number_of_blocks_processed); i != n; ++i)
+	{
+		blocks_hashes.erase (i->first->hash ());
 	}
+	blocks.insert (blocks.begin (), blocks_l.begin () + number_of_blocks_processed, blocks_l.end ());
+	node.stats.add (nano::stat::type::block_processor, nano::stat::detail::ledger_apply, nano::stat::dir::out, number_of_blocks_processed);
 	lock_a.unlock ();
-
+	// Wake the verification stage in case it is waiting for the verified queue to drain
+	condition.notify_all ();
 	if (node.config.logging.timing_logging ())
 	{
-		BOOST_LOG (node.log) << boost::str (boost::format ("Processed %1% blocks (%2% blocks were forced) in %3% %4%") % number_of_blocks_processed % number_of_forced_processed % timer_l.stop ().count () % timer_l.unit ());
+		BOOST_LOG (node.log) << boost::str (boost::format ("Processed %1% blocks (%2% blocks were forced) in %3% %4%") % (number_of_blocks_processed + number_of_forced_processed) % number_of_forced_processed % timer_l.stop ().count () % timer_l.unit ());
 	}
+	lock_a.lock ();
 }
 
 nano::process_return nano::block_processor::process_one (nano::transaction const & transaction_a, std::shared_ptr<nano::block> block_a, std::chrono::steady_clock::time_point origination, bool validated_state_block)
@@ -1628,7 +2117,9 @@ io_ctx (io_ctx_a),
 config (config_a),
 alarm (alarm_a),
 work (work_a),
-store_impl (std::make_unique<nano::mdb_store> (init_a.block_store_init, config.logging, application_path_a / "data.ldb", config_a.lmdb_max_dbs)),
+block_uniquer (nano::block_uniquer::entries_for (config.uniquer_memory_max_mb * 1024ULL * 1024 / 2, sizeof (nano::state_block))),
+vote_uniquer (block_uniquer, nano::uniquer<nano::vote>::entries_for (config.uniquer_memory_max_mb * 1024ULL * 1024 / 2, sizeof (nano::vote))),
+store_impl (std::make_unique<nano::mdb_store> (init_a.block_store_init, config.logging, application_path_a / "data.ldb", config_a.lmdb_max_dbs, config_a.block_cache_max_mb * 1024ULL * 1024, &block_uniquer, config_a.account_cache_max_mb * 1024ULL * 1024)),
 store (*store_impl),
 wallets_store_impl (std::make_unique<nano::mdb_wallets_store> (init_a.wallets_store_init, application_path_a / "wallets.ldb", config_a.lmdb_max_dbs)),
 wallets_store (*wallets_store_impl),
@@ -1642,6 +2133,7 @@ peers (network.endpoint ()),
 application_path (application_path_a),
 wallets (init_a.wallet_init, *this),
 port_mapping (*this),
+checker (config.signature_checker_threads),
 vote_processor (*this),
 warmed_up (0),
 block_processor (*this),
@@ -1651,7 +2143,9 @@ block_processor_thread ([this]() {
 }),
 online_reps (*this),
 stats (config.stat_config),
-vote_uniquer (block_uniquer),
+http_callbacks (*this),
+work_cache (init_a.wallet_init, *this),
+write_scheduler (store, stats, config.write_batch_max_time, config.write_batch_max_size),
 startup_time (std::chrono::steady_clock::now ())
 {
 	wallets.observer = [this](bool active) {
@@ -1684,29 +2178,14 @@ startup_time (std::chrono::steady_clock::now ())
 					std::stringstream ostream;
 					boost::property_tree::write_json (ostream, event);
 					ostream.flush ();
-					auto body (std::make_shared<std::string> (ostream.str ()));
-					auto address (node_l->config.callback_address);
-					auto port (node_l->config.callback_port);
-					auto target (std::make_shared<std::string> (node_l->config.callback_target));
-					auto resolver (std::make_shared<boost::asio::ip::tcp::resolver> (node_l->io_ctx));
-					resolver->async_resolve (boost::asio::ip::tcp::resolver::query (address, std::to_string (port)), [node_l, address, port, target, body, resolver](boost::system::error_code const & ec, boost::asio::ip::tcp::resolver::iterator i_a) {
-						if (!ec)
-						{
-							node_l->do_rpc_callback (i_a, address, port, target, body, resolver);
-						}
-						else
-						{
-							if (node_l->config.logging.callback_logging ())
-							{
-								BOOST_LOG (node_l->log) << boost::str (boost::format ("Error resolving callback: %1%:%2%: %3%") % address % port % ec.message ());
-							}
-							node_l->stats.inc (nano::stat::type::error, nano::stat::detail::http_callback, nano::stat::dir::out);
-						}
-					});
+					node_l->http_callbacks.add (ostream.str ());
 				});
 			}
 		});
 	}
+	observers.blocks.add ([this](std::shared_ptr<nano::block> block_a, nano::account const & account_a, nano::uint128_t const &, bool) {
+		this->work_cache.block_confirmed (block_a, account_a);
+	});
 	observers.endpoint.add ([this](nano::endpoint const & endpoint_a) {
 		this->network.send_keepalive (endpoint_a);
 		rep_query (*this, endpoint_a);
@@ -1816,78 +2295,6 @@ nano::node::~node ()
 	stop ();
 }
 
-void nano::node::do_rpc_callback (boost::asio::ip::tcp::resolver::iterator i_a, std::string const & address, uint16_t port, std::shared_ptr<std::string> target, std::shared_ptr<std::string> body, std::shared_ptr<boost::asio::ip::tcp::resolver> resolver)
-{
-	if (i_a != boost::asio::ip::tcp::resolver::iterator{})
-	{
-		auto node_l (shared_from_this ());
-		auto sock (std::make_shared<boost::asio::ip::tcp::socket> (node_l->io_ctx));
-		sock->async_connect (i_a->endpoint (), [node_l, target, body, sock, address, port, i_a, resolver](boost::system::error_code const & ec) mutable {
-			if (!ec)
-			{
-				auto req (std::make_shared<boost::beast::http::request<boost::beast::http::string_body>> ());
-				req->method (boost::beast::http::verb::post);
-				req->target (*target);
-				req->version (11);
-				req->insert (boost::beast::http::field::host, address);
-				req->insert (boost::beast::http::field::content_type, "application/json");
-				req->body () = *body;
-				req->prepare_payload ();
-				boost::beast::http::async_write (*sock, *req, [node_l, sock, address, port, req, i_a, target, body, resolver](boost::system::error_code const & ec, size_t bytes_transferred) mutable {
-					if (!ec)
-					{
-						auto sb (std::make_shared<boost::beast::flat_buffer> ());
-						auto resp (std::make_shared<boost::beast::http::response<boost::beast::http::string_body>> ());
-						boost::beast::http::async_read (*sock, *sb, *resp, [node_l, sb, resp, sock, address, port, i_a, target, body, resolver](boost::system::error_code const & ec, size_t bytes_transferred) mutable {
-							if (!ec)
-							{
-								if (resp->result () == boost::beast::http::status::ok)
-								{
-									node_l->stats.inc (nano::stat::type::http_callback, nano::stat::detail::initiate, nano::stat::dir::out);
-								}
-								else
-								{
-									if (node_l->config.logging.callback_logging ())
-									{
-										BOOST_LOG (node_l->log) << boost::str (boost::format ("Callback to %1%:%2% failed with status: %3%") % address % port % resp->result ());
-									}
-									node_l->stats.inc (nano::stat::type::error, nano::stat::detail::http_callback, nano::stat::dir::out);
-								}
-							}
-							else
-							{
-								if (node_l->config.logging.callback_logging ())
-								{
-									BOOST_LOG (node_l->log) << boost::str (boost::format ("Unable complete callback: %1%:%2%: %3%") % address % port % ec.message ());
-								}
-								node_l->stats.inc (nano::stat::type::error, nano::stat::detail::http_callback, nano::stat::dir::out);
-							};
-						});
-					}
-					else
-					{
-						if (node_l->config.logging.callback_logging ())
-						{
-							BOOST_LOG (node_l->log) << boost::str (boost::format ("Unable to send callback: %1%:%2%: %3%") % address % port % ec.message ());
-						}
-						node_l->stats.inc (nano::stat::type::error, nano::stat::detail::http_callback, nano::stat::dir::out);
-					}
-				});
-			}
-			else
-			{
-				if (node_l->config.logging.callback_logging ())
-				{
-					BOOST_LOG (node_l->log) << boost::str (boost::format ("Unable to connect to callback address: %1%:%2%: %3%") % address % port % ec.message ());
-				}
-				node_l->stats.inc (nano::stat::type::error, nano::stat::detail::http_callback, nano::stat::dir::out);
-				++i_a;
-				node_l->do_rpc_callback (i_a, address, port, target, body, resolver);
-			}
-		});
-	}
-}
-
 bool nano::node::copy_with_compaction (boost::filesystem::path const & destination_file)
 {
 	return !mdb_env_copy2 (boost::polymorphic_downcast<nano::mdb_store *> (store_impl.get ())->env.environment, destination_file.string ().c_str (), MDB_CP_COMPACT);
@@ -2045,16 +2452,18 @@ void nano::network::confirm_send (nano::confirm_ack const & confirm_a, std::shar
 	});
 }
 
-void nano::node::process_active (std::shared_ptr<nano::block> incoming)
+void nano::node::process_active (std::shared_ptr<nano::block> incoming, bool work_validated_a)
 {
 	block_arrival.add (incoming->hash ());
-	block_processor.add (incoming, std::chrono::steady_clock::now ());
+	block_processor.add (incoming, std::chrono::steady_clock::now (), work_validated_a);
 }
 
 nano::process_return nano::node::process (nano::block const & block_a)
 {
-	auto transaction (store.tx_begin_write ());
-	auto result (ledger.process (transaction, block_a));
+	nano::process_return result;
+	write_scheduler.run (nano::write_priority::live, [this, &block_a, &result](nano::transaction const & transaction_a) {
+		result = ledger.process (transaction_a, block_a);
+	});
 	return result;
 }
 
@@ -2068,6 +2477,7 @@ void nano::node::start ()
 		ongoing_bootstrap ();
 	}
 	ongoing_store_flush ();
+	ongoing_uniquer_stats ();
 	ongoing_rep_crawl ();
 	ongoing_rep_calculation ();
 	if (!flags.disable_bootstrap_listener)
@@ -2079,6 +2489,7 @@ void nano::node::start ()
 		backup_wallet ();
 	}
 	search_pending ();
+	work_cache.start ();
 	if (!flags.disable_wallet_bootstrap)
 	{
 		// Delay to start wallet lazy bootstrap
@@ -2108,6 +2519,8 @@ void nano::node::stop ()
 	port_mapping.stop ();
 	checker.stop ();
 	wallets.stop ();
+	http_callbacks.stop ();
+	write_scheduler.stop ();
 }
 
 void nano::node::keepalive_preconfigured (std::vector<std::string> const & peers_a)
@@ -2246,10 +2659,9 @@ void nano::node::ongoing_bootstrap ()
 
 void nano::node::ongoing_store_flush ()
 {
-	{
-		auto transaction (store.tx_begin_write ());
-		store.flush (transaction);
-	}
+	write_scheduler.add (nano::write_priority::maintenance, [this](nano::transaction const & transaction_a) {
+		store.flush (transaction_a);
+	});
 	std::weak_ptr<nano::node> node_w (shared_from_this ());
 	alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [node_w]() {
 		if (auto node_l = node_w.lock ())
@@ -2259,6 +2671,34 @@ void nano::node::ongoing_store_flush ()
 	});
 }
 
+void nano::node::ongoing_uniquer_stats ()
+{
+	// Uniquers count with atomics on the packet processing path, move the totals into stats periodically
+	auto blocks (block_uniquer.take_counters ());
+	stats.add (nano::stat::type::block_uniquer, nano::stat::detail::hit, nano::stat::dir::in, blocks.hits);
+	stats.add (nano::stat::type::block_uniquer, nano::stat::detail::miss, nano::stat::dir::in, blocks.misses);
+	stats.add (nano::stat::type::block_uniquer, nano::stat::detail::eviction, nano::stat::dir::in, blocks.evictions);
+	auto votes (vote_uniquer.take_counters ());
+	stats.add (nano::stat::type::vote_uniquer, nano::stat::detail::hit, nano::stat::dir::in, votes.hits);
+	stats.add (nano::stat::type::vote_uniquer, nano::stat::detail::miss, nano::stat::dir::in, votes.misses);
+	stats.add (nano::stat::type::vote_uniquer, nano::stat::detail::eviction, nano::stat::dir::in, votes.evictions);
+	auto cached (store.block_cache_counters ());
+	stats.add (nano::stat::type::block_cache, nano::stat::detail::hit, nano::stat::dir::in, cached.hits);
+	stats.add (nano::stat::type::block_cache, nano::stat::detail::miss, nano::stat::dir::in, cached.misses);
+	stats.add (nano::stat::type::block_cache, nano::stat::detail::eviction, nano::stat::dir::in, cached.evictions);
+	auto accounts (store.account_cache_counters ());
+	stats.add (nano::stat::type::account_cache, nano::stat::detail::hit, nano::stat::dir::in, accounts.hits);
+	stats.add (nano::stat::type::account_cache, nano::stat::detail::miss, nano::stat::dir::in, accounts.misses);
+	stats.add (nano::stat::type::account_cache, nano::stat::detail::eviction, nano::stat::dir::in, accounts.evictions);
+	std::weak_ptr<nano::node> node_w (shared_from_this ());
+	alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [node_w]() {
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->ongoing_uniquer_stats ();
+		}
+	});
+}
+
 void nano::node::backup_wallet ()
 {
 	auto transaction (wallets.tx_begin_read ());
@@ -2345,18 +2785,19 @@ public:
 class distributed_work : public std::enable_shared_from_this<distributed_work>
 {
 public:
-	distributed_work (std::shared_ptr<nano::node> const & node_a, nano::block_hash const & root_a, std::function<void(uint64_t)> callback_a, uint64_t difficulty_a) :
-	distributed_work (1, node_a, root_a, callback_a, difficulty_a)
+	distributed_work (std::shared_ptr<nano::node> const & node_a, nano::block_hash const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, uint64_t difficulty_a, nano::work_priority priority_a) :
+	distributed_work (1, node_a, root_a, callback_a, difficulty_a, priority_a)
 	{
 		assert (node_a != nullptr);
 	}
-	distributed_work (unsigned int backoff_a, std::shared_ptr<nano::node> const & node_a, nano::block_hash const & root_a, std::function<void(uint64_t)> callback_a, uint64_t difficulty_a) :
+	distributed_work (unsigned int backoff_a, std::shared_ptr<nano::node> const & node_a, nano::block_hash const & root_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, uint64_t difficulty_a, nano::work_priority priority_a) :
 	callback (callback_a),
 	backoff (backoff_a),
 	node (node_a),
 	root (root_a),
 	need_resolve (node_a->config.work_peers),
-	difficulty (difficulty_a)
+	difficulty (difficulty_a),
+	priority (priority_a)
 	{
 		assert (node_a != nullptr);
 		completed.clear ();
@@ -2558,11 +2999,8 @@ public:
 			{
 				if (node->config.work_threads != 0 || node->work.opencl)
 				{
-					auto callback_l (callback);
-					node->work.generate (root, [callback_l](boost::optional<uint64_t> const & work_a) {
-						callback_l (work_a.value ());
-					},
-					difficulty);
+					// Cancelling the local generation reports boost::none to the callback
+					node->work.generate (root, callback, difficulty, priority);
 				}
 				else
 				{
@@ -2576,10 +3014,10 @@ public:
 					std::weak_ptr<nano::node> node_w (node);
 					auto next_backoff (std::min (backoff * 2, (unsigned int)60 * 5));
 					// clang-format off
-					node->alarm.add (now + std::chrono::seconds (backoff), [ node_w, root_l, callback_l, next_backoff, difficulty = difficulty ] {
+					node->alarm.add (now + std::chrono::seconds (backoff), [ node_w, root_l, callback_l, next_backoff, difficulty = difficulty, priority = priority ] {
 						if (auto node_l = node_w.lock ())
 						{
-							auto work_generation (std::make_shared<distributed_work> (next_backoff, node_l, root_l, callback_l, difficulty));
+							auto work_generation (std::make_shared<distributed_work> (next_backoff, node_l, root_l, callback_l, difficulty, priority));
 							work_generation->start ();
 						}
 					});
@@ -2594,7 +3032,7 @@ public:
 		outstanding.erase (address);
 		return outstanding.empty ();
 	}
-	std::function<void(uint64_t)> callback;
+	std::function<void(boost::optional<uint64_t> const &)> callback;
 	unsigned int backoff; // in seconds
 	std::shared_ptr<nano::node> node;
 	nano::block_hash root;
@@ -2603,6 +3041,7 @@ public:
 	std::vector<std::pair<std::string, uint16_t>> need_resolve;
 	std::atomic_flag completed;
 	uint64_t difficulty;
+	nano::work_priority priority;
 };
 }
 
@@ -2611,20 +3050,28 @@ void nano::node::work_generate_blocking (nano::block & block_a, uint64_t difficu
 	block_a.block_work_set (work_generate_blocking (block_a.root (), difficulty_a));
 }
 
-void nano::node::work_generate (nano::uint256_union const & hash_a, std::function<void(uint64_t)> callback_a, uint64_t difficulty_a)
+void nano::node::work_generate (nano::uint256_union const & hash_a, std::function<void(boost::optional<uint64_t> const &)> callback_a, uint64_t difficulty_a, nano::work_priority priority_a)
 {
-	auto work_generation (std::make_shared<distributed_work> (shared (), hash_a, callback_a, difficulty_a));
-	work_generation->start ();
+	auto cached (work_cache.get (hash_a, difficulty_a));
+	if (cached)
+	{
+		callback_a (*cached);
+	}
+	else
+	{
+		auto work_generation (std::make_shared<distributed_work> (shared (), hash_a, callback_a, difficulty_a, priority_a));
+		work_generation->start ();
+	}
 }
 
-uint64_t nano::node::work_generate_blocking (nano::uint256_union const & hash_a, uint64_t difficulty_a)
+uint64_t nano::node::work_generate_blocking (nano::uint256_union const & hash_a, uint64_t difficulty_a, nano::work_priority priority_a)
 {
-	std::promise<uint64_t> promise;
-	work_generate (hash_a, [&promise](uint64_t work_a) {
+	std::promise<boost::optional<uint64_t>> promise;
+	work_generate (hash_a, [&promise](boost::optional<uint64_t> const & work_a) {
 		promise.set_value (work_a);
 	},
-	difficulty_a);
-	return promise.get_future ().get ();
+	difficulty_a, priority_a);
+	return promise.get_future ().get ().value ();
 }
 
 void nano::node::add_initial_peers ()
@@ -2720,9 +3167,10 @@ void nano::node::process_confirmed (std::shared_ptr<nano::block> block_a)
 	// Attempt to process confirmed block if it's not in ledger yet
 	if (!exists)
 	{
-		auto transaction (store.tx_begin_write ());
-		block_processor.process_one (transaction, block_a);
-		exists = store.block_exists (transaction, block_a->type (), hash);
+		write_scheduler.run (nano::write_priority::live, [this, &block_a, &hash, &exists](nano::transaction const & transaction_a) {
+			block_processor.process_one (transaction_a, block_a);
+			exists = store.block_exists (transaction_a, block_a->type (), hash);
+		});
 	}
 	if (exists)
 	{
@@ -2827,46 +3275,365 @@ void nano::online_reps::vote (std::shared_ptr<nano::vote> const & vote_a)
 		}
 		reps.insert (info);
 	}
-	else
+	else
+	{
+		reps.get<1> ().replace (rep_it, info);
+	}
+}
+
+void nano::online_reps::recalculate_stake ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	online_stake_total = 0;
+	auto transaction (node.store.tx_begin_read ());
+	for (auto it : reps)
+	{
+		online_stake_total += node.ledger.weight (transaction, it.representative);
+	}
+	auto now (std::chrono::steady_clock::now ());
+	std::weak_ptr<nano::node> node_w (node.shared ());
+	node.alarm.add (now + std::chrono::minutes (5), [node_w]() {
+		if (auto node_l = node_w.lock ())
+		{
+			node_l->online_reps.recalculate_stake ();
+		}
+	});
+}
+
+nano::uint128_t nano::online_reps::online_stake ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return std::max (online_stake_total, node.config.online_weight_minimum.number ());
+}
+
+std::vector<nano::account> nano::online_reps::list ()
+{
+	std::vector<nano::account> result;
+	std::lock_guard<std::mutex> lock (mutex);
+	for (auto i (reps.begin ()), n (reps.end ()); i != n; ++i)
+	{
+		result.push_back (i->representative);
+	}
+	return result;
+}
+
+std::chrono::seconds constexpr nano::work_cache::cancelled_retry;
+
+nano::work_cache::work_cache (bool & error_a, nano::node & node_a) :
+node (node_a)
+{
+	if (!error_a)
+	{
+		auto transaction (node.wallets.tx_begin_write ());
+		auto status (mdb_dbi_open (node.wallets.env.tx (transaction), "work_cache", MDB_CREATE, &handle));
+		status |= mdb_dbi_open (node.wallets.env.tx (transaction), "work_watch", MDB_CREATE, &watch_handle);
+		error_a = status != 0;
+		if (!error_a)
+		{
+			for (nano::store_iterator<nano::account, nano::wallet_value> i (std::make_unique<nano::mdb_iterator<nano::account, nano::wallet_value>> (transaction, handle)), n (nullptr); i != n; ++i)
+			{
+				entries.insert ({ i->first, i->second.key, i->second.work });
+			}
+			for (nano::store_iterator<nano::account, nano::account> i (std::make_unique<nano::mdb_iterator<nano::account, nano::account>> (transaction, watch_handle)), n (nullptr); i != n; ++i)
+			{
+				watch_list.insert (i->first);
+			}
+			wallet_accounts = wallet_accounts_read (transaction);
+		}
+	}
+}
+
+void nano::work_cache::start ()
+{
+	{
+		// Accounts removed from every wallet while the node was stopped would otherwise get work generated on each start
+		std::lock_guard<std::mutex> wallets_lock (node.wallets.mutex);
+		auto transaction (node.wallets.tx_begin_write ());
+		std::lock_guard<std::mutex> lock (mutex);
+		prune (transaction);
+	}
+	std::vector<std::pair<nano::account, nano::block_hash>> stale;
+	{
+		auto transaction (node.store.tx_begin_read ());
+		std::lock_guard<std::mutex> lock (mutex);
+		for (auto & entry : entries)
+		{
+			auto root (node.ledger.latest_root (transaction, entry.account));
+			if (root != entry.root || entry.work == 0)
+			{
+				stale.push_back (std::make_pair (entry.account, root));
+			}
+		}
+		for (auto & account : watch_list)
+		{
+			if (entries.find (account) == entries.end ())
+			{
+				stale.push_back (std::make_pair (account, node.ledger.latest_root (transaction, account)));
+			}
+		}
+	}
+	for (auto & item : stale)
+	{
+		ensure (item.first, item.second);
+	}
+}
+
+void nano::work_cache::watch (nano::account const & account_a)
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		watch_list.insert (account_a);
+	}
+	{
+		auto transaction (node.wallets.tx_begin_write ());
+		auto status (mdb_put (node.wallets.env.tx (transaction), watch_handle, nano::mdb_val (account_a), nano::mdb_val (account_a), 0));
+		assert (status == 0);
+	}
+	nano::block_hash root;
+	{
+		auto transaction (node.store.tx_begin_read ());
+		root = node.ledger.latest_root (transaction, account_a);
+	}
+	ensure (account_a, root);
+}
+
+void nano::work_cache::unwatch (nano::account const & account_a)
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		watch_list.erase (account_a);
+		entries.erase (account_a);
+	}
+	auto transaction (node.wallets.tx_begin_write ());
+	mdb_del (node.wallets.env.tx (transaction), watch_handle, nano::mdb_val (account_a), nullptr);
+	mdb_del (node.wallets.env.tx (transaction), handle, nano::mdb_val (account_a), nullptr);
+}
+
+std::vector<nano::account> nano::work_cache::watched ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return std::vector<nano::account> (watch_list.begin (), watch_list.end ());
+}
+
+bool nano::work_cache::tracked (nano::account const & account_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return watch_list.find (account_a) != watch_list.end () || wallet_accounts.find (account_a) != wallet_accounts.end ();
+}
+
+void nano::work_cache::wallet_insert (nano::account const & account_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	wallet_accounts.insert (account_a);
+}
+
+void nano::work_cache::wallets_changed ()
+{
+	auto node_l (node.shared ());
+	node.background ([node_l]() {
+		node_l->work_cache.wallets_reload ();
+	});
+}
+
+std::unordered_set<nano::account> nano::work_cache::wallet_accounts_read (nano::transaction const & transaction_a)
+{
+	std::unordered_set<nano::account> result;
+	for (auto & wallet : node.wallets.items)
+	{
+		for (auto i (wallet.second->store.begin (transaction_a)), n (wallet.second->store.end ()); i != n; ++i)
+		{
+			result.insert (i->first);
+		}
+	}
+	return result;
+}
+
+void nano::work_cache::wallets_reload ()
+{
+	// Same lock order as nano::wallets, mutex before the write transaction. Holding the write transaction while
+	// swapping means accounts inserted by other transactions are either in the snapshot or added after the swap
+	std::lock_guard<std::mutex> wallets_lock (node.wallets.mutex);
+	auto transaction (node.wallets.tx_begin_write ());
+	auto accounts (wallet_accounts_read (transaction));
+	std::lock_guard<std::mutex> lock (mutex);
+	wallet_accounts.swap (accounts);
+	prune (transaction);
+}
+
+void nano::work_cache::prune (nano::transaction const & transaction_a)
+{
+	assert (!mutex.try_lock ());
+	for (auto i (entries.begin ()), n (entries.end ()); i != n;)
+	{
+		if (watch_list.find (i->account) == watch_list.end () && wallet_accounts.find (i->account) == wallet_accounts.end ())
+		{
+			mdb_del (node.wallets.env.tx (transaction_a), handle, nano::mdb_val (i->account), nullptr);
+			i = entries.erase (i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void nano::work_cache::ensure (nano::account const & account_a, nano::block_hash const & root_a)
+{
+	auto generate (false);
+	uint64_t cached (0);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto existing (entries.find (account_a));
+		if (existing == entries.end ())
+		{
+			entries.insert ({ account_a, root_a, 0 });
+			generate = true;
+		}
+		else if (existing->root != root_a)
+		{
+			entries.modify (existing, [&root_a](nano::work_cache_entry & entry_a) {
+				entry_a.root = root_a;
+				entry_a.work = 0;
+			});
+			generate = true;
+		}
+		else
+		{
+			// Already cached or being generated
+			cached = existing->work;
+		}
+	}
+	if (cached != 0)
+	{
+		// A wallet may have just added the account, make sure its store has the work too
+		auto node_l (node.shared ());
+		node.background ([node_l, account_a, root_a, cached]() {
+			node_l->work_cache.generated (account_a, root_a, cached);
+		});
+	}
+	if (generate)
+	{
+		std::weak_ptr<nano::node> node_w (node.shared ());
+		node.work_generate (root_a, [node_w, account_a, root_a](boost::optional<uint64_t> const & work_a) {
+			if (auto node_l = node_w.lock ())
+			{
+				if (work_a)
+				{
+					// Storing writes to the wallets environment so keep it off the work threads
+					auto work_l (*work_a);
+					node_l->background ([node_l, account_a, root_a, work_l]() {
+						node_l->work_cache.generated (account_a, root_a, work_l);
+					});
+				}
+				else
+				{
+					node_l->background ([node_l, account_a, root_a]() {
+						node_l->work_cache.cancelled (account_a, root_a);
+					});
+				}
+			}
+		},
+		nano::work_pool::publish_threshold, nano::work_priority::background);
+	}
+}
+
+void nano::work_cache::generated (nano::account const & account_a, nano::block_hash const & root_a, uint64_t work_a)
+{
+	auto current (false);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto existing (entries.find (account_a));
+		// Otherwise it was unwatched or the account moved on while generating
+		if (existing != entries.end () && existing->root == root_a)
+		{
+			entries.modify (existing, [work_a](nano::work_cache_entry & entry_a) {
+				entry_a.work = work_a;
+			});
+			current = true;
+		}
+	}
+	if (current)
 	{
-		reps.get<1> ().replace (rep_it, info);
+		// Same lock order as nano::wallets, mutex before the write transaction
+		std::lock_guard<std::mutex> lock (node.wallets.mutex);
+		auto transaction (node.wallets.tx_begin_write ());
+		auto status (mdb_put (node.wallets.env.tx (transaction), handle, nano::mdb_val (account_a), nano::wallet_value (root_a, work_a).val (), 0));
+		assert (status == 0);
+		// Wallets building the next block read work from their own store
+		for (auto & wallet : node.wallets.items)
+		{
+			if (wallet.second->store.exists (transaction, account_a))
+			{
+				wallet.second->work_update (transaction, account_a, root_a, work_a);
+			}
+		}
 	}
 }
 
-void nano::online_reps::recalculate_stake ()
+void nano::work_cache::cancelled (nano::account const & account_a, nano::block_hash const & root_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	online_stake_total = 0;
-	auto transaction (node.store.tx_begin_read ());
-	for (auto it : reps)
 	{
-		online_stake_total += node.ledger.weight (transaction, it.representative);
+		std::lock_guard<std::mutex> lock (mutex);
+		auto existing (entries.find (account_a));
+		// An entry left at zero work would be taken as still being generated and never retried
+		if (existing != entries.end () && existing->root == root_a && existing->work == 0)
+		{
+			entries.erase (existing);
+		}
 	}
-	auto now (std::chrono::steady_clock::now ());
 	std::weak_ptr<nano::node> node_w (node.shared ());
-	node.alarm.add (now + std::chrono::minutes (5), [node_w]() {
+	node.alarm.add (std::chrono::steady_clock::now () + cancelled_retry, [node_w, account_a]() {
 		if (auto node_l = node_w.lock ())
 		{
-			node_l->online_reps.recalculate_stake ();
+			if (node_l->work_cache.tracked (account_a))
+			{
+				nano::block_hash root;
+				{
+					auto transaction (node_l->store.tx_begin_read ());
+					root = node_l->ledger.latest_root (transaction, account_a);
+				}
+				node_l->work_cache.ensure (account_a, root);
+			}
 		}
 	});
 }
 
-nano::uint128_t nano::online_reps::online_stake ()
+boost::optional<uint64_t> nano::work_cache::get (nano::block_hash const & root_a, uint64_t difficulty_a)
 {
+	boost::optional<uint64_t> result;
 	std::lock_guard<std::mutex> lock (mutex);
-	return std::max (online_stake_total, node.config.online_weight_minimum.number ());
+	auto range (entries.get<1> ().equal_range (root_a));
+	for (auto i (range.first); i != range.second && !result; ++i)
+	{
+		if (i->work != 0 && nano::work_value (root_a, i->work) >= difficulty_a)
+		{
+			result = i->work;
+		}
+	}
+	return result;
 }
 
-std::vector<nano::account> nano::online_reps::list ()
+void nano::work_cache::block_confirmed (std::shared_ptr<nano::block> block_a, nano::account const & account_a)
 {
-	std::vector<nano::account> result;
-	std::lock_guard<std::mutex> lock (mutex);
-	for (auto i (reps.begin ()), n (reps.end ()); i != n; ++i)
+	if (tracked (account_a))
 	{
-		result.push_back (i->representative);
+		auto hash (block_a->hash ());
+		auto latest (false);
+		{
+			auto transaction (node.store.tx_begin_read ());
+			latest = node.ledger.latest (transaction, account_a) == hash;
+		}
+		if (latest)
+		{
+			ensure (account_a, hash);
+		}
 	}
-	return result;
+}
+
+size_t nano::work_cache::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return entries.size ();
 }
 
 namespace
@@ -2984,12 +3751,11 @@ bool nano::reserved_address (nano::endpoint const & endpoint_a, bool blacklist_l
 
 void nano::network::send_buffer (uint8_t const * data_a, size_t size_a, nano::endpoint const & endpoint_a, std::function<void(boost::system::error_code const &, size_t)> callback_a)
 {
-	std::unique_lock<std::mutex> lock (socket_mutex);
 	if (node.config.logging.network_packet_logging ())
 	{
 		BOOST_LOG (node.log) << "Sending packet";
 	}
-	socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, [this, callback_a](boost::system::error_code const & ec, size_t size_a) {
+	auto completion ([this, callback_a](boost::system::error_code const & ec, size_t size_a) {
 		callback_a (ec, size_a);
 		this->node.stats.add (nano::stat::type::traffic, nano::stat::dir::out, size_a);
 		if (ec == boost::system::errc::host_unreachable)
@@ -3001,6 +3767,71 @@ void nano::network::send_buffer (uint8_t const * data_a, size_t size_a, nano::en
 			BOOST_LOG (this->node.log) << "Packet send complete";
 		}
 	});
+	if (batching)
+	{
+		// Sends made while a flush is pending, such as the fan-out of a republish, go out in the same system call
+		auto flush (false);
+		{
+			std::lock_guard<std::mutex> lock (send_mutex);
+			flush = send_queue.empty ();
+			send_queue.push_back ({ data_a, size_a, endpoint_a, completion });
+		}
+		if (flush)
+		{
+			node.background ([this]() { this->send_flush (); });
+		}
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock (socket_mutex);
+		socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, completion);
+	}
+}
+
+void nano::network::send_flush ()
+{
+	std::vector<nano::udp_send> sends;
+	{
+		std::lock_guard<std::mutex> lock (send_mutex);
+		sends.swap (send_queue);
+	}
+	std::array<size_t, nano::network::batch_max> sizes;
+	size_t begin (0);
+	while (begin < sends.size ())
+	{
+		auto count (std::min<size_t> ({ sends.size () - begin, node.config.udp_batch_size, sizes.size () }));
+		boost::system::error_code ec;
+		auto sent (on ? nano::udp_batch::send (socket, sends.data () + begin, sizes.data (), count, ec) : 0);
+		if (!on)
+		{
+			ec = boost::asio::error::operation_aborted;
+		}
+		if (sent > 0)
+		{
+			node.stats.add_histogram (nano::stat::type::udp, "send_batch", sent);
+		}
+		for (size_t i (0); i < sent; ++i)
+		{
+			sends[begin + i].callback (boost::system::error_code (), sizes[i]);
+		}
+		begin += sent;
+		if (begin < sends.size () && (ec == boost::asio::error::would_block || (!ec && sent == 0)))
+		{
+			// The socket buffer is full, the rest is handed to Asio which waits for the socket to become writable
+			std::unique_lock<std::mutex> lock (socket_mutex);
+			for (; begin < sends.size (); ++begin)
+			{
+				auto & send (sends[begin]);
+				socket.async_send_to (boost::asio::buffer (send.data, send.size), send.endpoint, send.callback);
+			}
+		}
+		else if (ec)
+		{
+			// The error belongs to the first datagram that wasn't sent, the ones after it are tried again
+			sends[begin].callback (ec, 0);
+			++begin;
+		}
+	}
 }
 
 std::shared_ptr<nano::node> nano::node::shared ()
@@ -3027,10 +3858,12 @@ election_start (std::chrono::steady_clock::now ()),
 status ({ block_a, 0 }),
 confirmed (false),
 stopped (false),
+tally_sum (0),
 announcements (0)
 {
-	last_votes.insert (std::make_pair (nano::not_an_account, nano::vote_info{ std::chrono::steady_clock::now (), 0, block_a->hash () }));
+	last_votes.insert (std::make_pair (nano::not_an_account, nano::vote_info{ std::chrono::steady_clock::now (), 0, block_a->hash (), 0 }));
 	blocks.insert (std::make_pair (block_a->hash (), block_a));
+	last_tally[block_a->hash ()] = 0;
 }
 
 void nano::election::compute_rep_votes (nano::transaction const & transaction_a)
@@ -3084,36 +3917,63 @@ void nano::election::stop ()
 	stopped = true;
 }
 
-bool nano::election::have_quorum (nano::tally_t const & tally_a, nano::uint128_t tally_sum)
+bool nano::election::have_quorum (nano::uint128_t first_a, nano::uint128_t second_a, nano::uint128_t tally_sum_a)
 {
 	bool result = false;
-	if (tally_sum >= node.config.online_weight_minimum.number ())
+	if (tally_sum_a >= node.config.online_weight_minimum.number ())
 	{
-		auto i (tally_a.begin ());
-		auto first (i->first);
-		++i;
-		auto second (i != tally_a.end () ? i->first : 0);
 		auto delta_l (node.delta ());
-		result = tally_a.begin ()->first > (second + delta_l);
+		result = first_a > (second_a + delta_l);
 	}
 	return result;
 }
 
+void nano::election::tally_add (nano::block_hash const & hash_a, nano::uint128_t const & weight_a)
+{
+	last_tally[hash_a] += weight_a;
+	if (blocks.find (hash_a) != blocks.end ())
+	{
+		tally_sum += weight_a;
+	}
+}
+
+void nano::election::tally_remove (nano::block_hash const & hash_a, nano::uint128_t const & weight_a)
+{
+	auto existing (last_tally.find (hash_a));
+	assert (existing != last_tally.end () && existing->second >= weight_a);
+	existing->second -= weight_a;
+	if (blocks.find (hash_a) != blocks.end ())
+	{
+		tally_sum -= weight_a;
+	}
+	if (existing->second == 0 && blocks.find (hash_a) == blocks.end ())
+	{
+		last_tally.erase (existing);
+	}
+}
+
 nano::tally_t nano::election::tally (nano::transaction const & transaction_a)
 {
-	std::unordered_map<nano::block_hash, nano::uint128_t> block_weights;
-	for (auto vote_info : last_votes)
+	// Representative weights change as the ledger moves, refresh the weight counted for every vote
+	last_tally.clear ();
+	tally_sum = 0;
+	for (auto & block : blocks)
+	{
+		last_tally[block.first] = 0;
+	}
+	std::unordered_set<nano::block_hash> voted;
+	for (auto & vote_info : last_votes)
 	{
-		block_weights[vote_info.second.hash] += node.ledger.weight (transaction_a, vote_info.first);
+		vote_info.second.weight = node.ledger.weight (transaction_a, vote_info.first);
+		tally_add (vote_info.second.hash, vote_info.second.weight);
+		voted.insert (vote_info.second.hash);
 	}
-	last_tally = block_weights;
 	nano::tally_t result;
-	for (auto item : block_weights)
+	for (auto & block : blocks)
 	{
-		auto block (blocks.find (item.first));
-		if (block != blocks.end ())
+		if (voted.find (block.first) != voted.end ())
 		{
-			result.insert (std::make_pair (item.second, block->second));
+			result.insert (std::make_pair (last_tally[block.first], block.second));
 		}
 	}
 	return result;
@@ -3121,27 +3981,38 @@ nano::tally_t nano::election::tally (nano::transaction const & transaction_a)
 
 void nano::election::confirm_if_quorum (nano::transaction const & transaction_a)
 {
-	auto tally_l (tally (transaction_a));
-	assert (tally_l.size () > 0);
-	auto winner (tally_l.begin ());
-	auto block_l (winner->second);
-	status.tally = winner->first;
-	nano::uint128_t sum (0);
-	for (auto & i : tally_l)
+	assert (!blocks.empty ());
+	// Find the leader and runner up, this is bounded by the number of competing blocks rather than the number of representatives
+	std::shared_ptr<nano::block> block_l;
+	nano::uint128_t first (0);
+	nano::uint128_t second (0);
+	for (auto & block : blocks)
 	{
-		sum += i.first;
+		auto existing (last_tally.find (block.first));
+		auto weight (existing != last_tally.end () ? existing->second : 0);
+		if (block_l == nullptr || weight > first)
+		{
+			second = first;
+			first = weight;
+			block_l = block.second;
+		}
+		else if (weight > second)
+		{
+			second = weight;
+		}
 	}
-	if (sum >= node.config.online_weight_minimum.number () && block_l->hash () != status.winner->hash ())
+	status.tally = first;
+	if (tally_sum >= node.config.online_weight_minimum.number () && block_l->hash () != status.winner->hash ())
 	{
 		auto node_l (node.shared ());
 		node_l->block_processor.force (block_l);
 		status.winner = block_l;
 	}
-	if (have_quorum (tally_l, sum))
+	if (have_quorum (first, second, tally_sum))
 	{
 		if (node.config.logging.vote_logging () || blocks.size () > 1)
 		{
-			log_votes (tally_l);
+			log_votes (tally (transaction_a));
 		}
 		uint8_t depth (0);
 		confirm_once (transaction_a, depth);
@@ -3208,7 +4079,12 @@ nano::election_vote_result nano::election::vote (nano::account rep, uint64_t seq
 		}
 		if (should_process)
 		{
-			last_votes[rep] = { std::chrono::steady_clock::now (), sequence, block_hash };
+			if (last_vote_it != last_votes.end ())
+			{
+				tally_remove (last_vote_it->second.hash, last_vote_it->second.weight);
+			}
+			last_votes[rep] = { std::chrono::steady_clock::now (), sequence, block_hash, weight };
+			tally_add (block_hash, weight);
 			if (!confirmed)
 			{
 				confirm_if_quorum (transaction);
@@ -3272,7 +4148,8 @@ bool nano::election::publish (std::shared_ptr<nano::block> block_a)
 	auto result (false);
 	if (blocks.size () >= 10)
 	{
-		if (last_tally[block_a->hash ()] < node.online_reps.online_stake () / 10)
+		auto existing (last_tally.find (block_a->hash ()));
+		if (existing == last_tally.end () || existing->second < node.online_reps.online_stake () / 10)
 		{
 			result = true;
 		}
@@ -3286,6 +4163,8 @@ bool nano::election::publish (std::shared_ptr<nano::block> block_a)
 			if (blocks.find (block_a->hash ()) == blocks.end ())
 			{
 				blocks.insert (std::make_pair (block_a->hash (), block_a));
+				// Votes which arrived before the block now count towards the total
+				tally_sum += last_tally[block_a->hash ()];
 				confirm_if_quorum (transaction);
 				node.network.republish_block (block_a);
 			}
@@ -3807,3 +4686,295 @@ void nano::udp_buffer::stop ()
 	}
 	condition.notify_all ();
 }
+
+nano::udp_ring_buffer::ring::ring (size_t count_a) :
+mask (1),
+head (0),
+tail (0)
+{
+	// Round capacity up to a power of two so positions can be masked in to cells
+	while (mask < count_a)
+	{
+		mask <<= 1;
+	}
+	--mask;
+	cells.reset (new cell[mask + 1]);
+	for (size_t i (0); i <= mask; ++i)
+	{
+		cells[i].sequence.store (i, std::memory_order_relaxed);
+		cells[i].data = nullptr;
+	}
+}
+
+void nano::udp_ring_buffer::ring::push (nano::udp_data * data_a)
+{
+	auto position (tail.load (std::memory_order_relaxed));
+	while (true)
+	{
+		auto & cell_l (cells[position & mask]);
+		auto sequence (cell_l.sequence.load (std::memory_order_acquire));
+		auto difference (static_cast<intptr_t> (sequence) - static_cast<intptr_t> (position));
+		if (difference == 0)
+		{
+			if (tail.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+			{
+				cell_l.data = data_a;
+				cell_l.sequence.store (position + 1, std::memory_order_release);
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Rings have room for every buffer so this cell is only waiting on a consumer from the previous lap to finish popping it
+			std::this_thread::yield ();
+			position = tail.load (std::memory_order_relaxed);
+		}
+		else
+		{
+			position = tail.load (std::memory_order_relaxed);
+		}
+	}
+}
+
+bool nano::udp_ring_buffer::ring::pop (nano::udp_data *& data_a)
+{
+	auto result (false);
+	auto position (head.load (std::memory_order_relaxed));
+	while (true)
+	{
+		auto & cell_l (cells[position & mask]);
+		auto sequence (cell_l.sequence.load (std::memory_order_acquire));
+		auto difference (static_cast<intptr_t> (sequence) - static_cast<intptr_t> (position + 1));
+		if (difference == 0)
+		{
+			if (head.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+			{
+				data_a = cell_l.data;
+				cell_l.sequence.store (position + mask + 1, std::memory_order_release);
+				result = true;
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Empty
+			break;
+		}
+		else
+		{
+			position = head.load (std::memory_order_relaxed);
+		}
+	}
+	return result;
+}
+
+bool nano::udp_ring_buffer::ring::empty () const
+{
+	return head.load (std::memory_order_relaxed) == tail.load (std::memory_order_relaxed);
+}
+
+nano::udp_ring_buffer::udp_ring_buffer (nano::stat & stats, size_t size, size_t count, size_t shards_a) :
+shards (shards_a),
+stats (stats),
+free (count),
+steal_shard (0),
+slab (size * count),
+entries (count),
+stopped (false)
+{
+	assert (count > 0);
+	assert (size > 0);
+	assert (shards > 0);
+	for (size_t i (0); i < shards; ++i)
+	{
+		full.push_back (std::make_unique<ring> (count));
+		consumers.push_back (std::make_unique<waiters> ());
+	}
+	auto slab_data (slab.data ());
+	auto entry_data (entries.data ());
+	for (size_t i (0); i < count; ++i, ++entry_data)
+	{
+		*entry_data = { slab_data + i * size, 0, nano::endpoint () };
+		free.push (entry_data);
+	}
+}
+
+size_t nano::udp_ring_buffer::shard (nano::endpoint const & endpoint_a) const
+{
+	return shards == 1 ? 0 : std::hash<nano::endpoint> () (endpoint_a) % shards;
+}
+
+void nano::udp_ring_buffer::notify (nano::udp_ring_buffer::waiters & waiters_a, size_t count_a)
+{
+	// Pairs with the fence in the waiting thread so either it sees the new buffers or we see it sleeping
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	if (waiters_a.sleeping > 0)
+	{
+		std::lock_guard<std::mutex> lock (waiters_a.mutex);
+		if (count_a >= waiters_a.sleeping)
+		{
+			waiters_a.condition.notify_all ();
+		}
+		else
+		{
+			for (size_t i (0); i < count_a; ++i)
+			{
+				waiters_a.condition.notify_one ();
+			}
+		}
+	}
+}
+
+bool nano::udp_ring_buffer::steal (nano::udp_data *& data_a)
+{
+	auto result (false);
+	auto start (steal_shard++);
+	for (size_t i (0); !result && i < shards; ++i)
+	{
+		result = full[(start + i) % shards]->pop (data_a);
+	}
+	return result;
+}
+
+nano::udp_data * nano::udp_ring_buffer::allocate ()
+{
+	nano::udp_data * result (nullptr);
+	allocate (&result, 1);
+	return result;
+}
+
+size_t nano::udp_ring_buffer::allocate (nano::udp_data ** data_a, size_t count_a)
+{
+	size_t result (0);
+	for (; result < count_a && free.pop (data_a[result]); ++result)
+	{
+	}
+	while (result == 0 && !stopped)
+	{
+		if (steal (data_a[0]))
+		{
+			result = 1;
+			stats.inc (nano::stat::type::udp, nano::stat::detail::overflow, nano::stat::dir::in);
+		}
+		else
+		{
+			{
+				// Every buffer is being serviced, wait for one to be released or enqueued
+				std::unique_lock<std::mutex> lock (allocators.mutex);
+				++allocators.sleeping;
+				std::atomic_thread_fence (std::memory_order_seq_cst);
+				if (!stopped && free.empty () && std::all_of (full.begin (), full.end (), [](std::unique_ptr<ring> const & ring_a) { return ring_a->empty (); }))
+				{
+					stats.inc (nano::stat::type::udp, nano::stat::detail::blocking, nano::stat::dir::in);
+					allocators.condition.wait (lock);
+				}
+				--allocators.sleeping;
+			}
+			for (; result < count_a && free.pop (data_a[result]); ++result)
+			{
+			}
+		}
+	}
+	return result;
+}
+
+void nano::udp_ring_buffer::enqueue (nano::udp_data * data_a)
+{
+	enqueue (&data_a, 1);
+}
+
+void nano::udp_ring_buffer::enqueue (nano::udp_data * const * data_a, size_t count_a)
+{
+	if (shards == 1)
+	{
+		for (size_t i (0); i < count_a; ++i)
+		{
+			assert (data_a[i] != nullptr);
+			full[0]->push (data_a[i]);
+		}
+		if (count_a > 0)
+		{
+			notify (*consumers[0], count_a);
+		}
+	}
+	else
+	{
+		for (size_t i (0); i < count_a; ++i)
+		{
+			assert (data_a[i] != nullptr);
+			auto shard_l (shard (data_a[i]->endpoint));
+			full[shard_l]->push (data_a[i]);
+			notify (*consumers[shard_l], 1);
+		}
+	}
+	if (count_a > 0)
+	{
+		notify (allocators, count_a);
+	}
+}
+
+nano::udp_data * nano::udp_ring_buffer::dequeue (size_t shard_a)
+{
+	nano::udp_data * result (nullptr);
+	dequeue (&result, 1, shard_a);
+	return result;
+}
+
+size_t nano::udp_ring_buffer::dequeue (nano::udp_data ** data_a, size_t count_a, size_t shard_a)
+{
+	assert (shard_a < shards);
+	auto & ring_l (*full[shard_a]);
+	auto & waiters_l (*consumers[shard_a]);
+	size_t result (0);
+	while (true)
+	{
+		for (; result < count_a && ring_l.pop (data_a[result]); ++result)
+		{
+		}
+		if (result > 0 || stopped)
+		{
+			break;
+		}
+		std::unique_lock<std::mutex> lock (waiters_l.mutex);
+		++waiters_l.sleeping;
+		std::atomic_thread_fence (std::memory_order_seq_cst);
+		if (!stopped && ring_l.empty ())
+		{
+			waiters_l.condition.wait (lock);
+		}
+		--waiters_l.sleeping;
+	}
+	return result;
+}
+
+void nano::udp_ring_buffer::release (nano::udp_data * data_a)
+{
+	release (&data_a, 1);
+}
+
+void nano::udp_ring_buffer::release (nano::udp_data * const * data_a, size_t count_a)
+{
+	for (size_t i (0); i < count_a; ++i)
+	{
+		assert (data_a[i] != nullptr);
+		free.push (data_a[i]);
+	}
+	if (count_a > 0)
+	{
+		notify (allocators, count_a);
+	}
+}
+
+void nano::udp_ring_buffer::stop ()
+{
+	stopped = true;
+	{
+		std::lock_guard<std::mutex> lock (allocators.mutex);
+		allocators.condition.notify_all ();
+	}
+	for (auto & waiters_l : consumers)
+	{
+		std::lock_guard<std::mutex> lock (waiters_l->mutex);
+		waiters_l->condition.notify_all ();
+	}
+}
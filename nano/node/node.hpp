@@ -2,19 +2,24 @@
 
 #include <nano/lib/work.hpp>
 #include <nano/node/bootstrap.hpp>
+#include <nano/node/http_callbacks.hpp>
 #include <nano/node/logging.hpp>
 #include <nano/node/nodeconfig.hpp>
 #include <nano/node/peers.hpp>
 #include <nano/node/portmapping.hpp>
 #include <nano/node/stats.hpp>
+#include <nano/node/udp_batch.hpp>
 #include <nano/node/voting.hpp>
 #include <nano/node/wallet.hpp>
+#include <nano/node/write_scheduler.hpp>
 #include <nano/secure/ledger.hpp>
 
 #include <condition_variable>
 #include <queue>
+#include <unordered_set>
 
 #include <boost/iostreams/device/array.hpp>
+#include <boost/lockfree/queue.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -39,6 +44,8 @@ public:
 	std::chrono::steady_clock::time_point time;
 	uint64_t sequence;
 	nano::block_hash hash;
+	// Representative weight counted towards the tally for this vote
+	nano::uint128_t weight;
 };
 class election_vote_result
 {
@@ -57,9 +64,10 @@ class election : public std::enable_shared_from_this<nano::election>
 public:
 	election (nano::node &, std::shared_ptr<nano::block>, std::function<void(std::shared_ptr<nano::block>)> const &);
 	nano::election_vote_result vote (nano::account, uint64_t, nano::block_hash);
+	// Recompute the tally from current representative weights
 	nano::tally_t tally (nano::transaction const &);
-	// Check if we have vote quorum
-	bool have_quorum (nano::tally_t const &, nano::uint128_t);
+	// Check if we have vote quorum given the two highest block tallies
+	bool have_quorum (nano::uint128_t, nano::uint128_t, nano::uint128_t);
 	// Change our winner to agree with the network
 	void compute_rep_votes (nano::transaction const &);
 	// Confirm this block if quorum is met
@@ -74,8 +82,15 @@ public:
 	nano::election_status status;
 	std::atomic<bool> confirmed;
 	bool stopped;
+	// Running tally per block hash, adjusted by the weight delta of each vote
 	std::unordered_map<nano::block_hash, nano::uint128_t> last_tally;
+	// Sum of last_tally over the blocks in this election
+	nano::uint128_t tally_sum;
 	unsigned announcements;
+
+private:
+	void tally_add (nano::block_hash const &, nano::uint128_t const &);
+	void tally_remove (nano::block_hash const &, nano::uint128_t const &);
 };
 class conflict_info
 {
@@ -137,24 +152,67 @@ private:
 	bool stopped;
 	boost::thread thread;
 };
+class alarm_handle
+{
+public:
+	uint32_t index{ std::numeric_limits<uint32_t>::max () };
+	uint32_t generation{ 0 };
+};
 class operation
 {
 public:
-	bool operator> (nano::operation const &) const;
 	std::chrono::steady_clock::time_point wakeup;
 	std::function<void()> function;
+	// Tick the operation is due on, rounded up so it never fires early
+	uint64_t tick;
+	// Incremented each time the entry is reused so stale handles can't cancel the new operation
+	uint32_t generation;
+	uint32_t previous;
+	uint32_t next;
+	uint8_t level;
+	uint8_t slot;
 };
+/**
+ * Posts operations to io_ctx once their wakeup time has passed.
+ * Pending operations are held in a hierarchical timing wheel, each level has 256 slots and the lowest level advances every millisecond.
+ * Operations cascade down a level as their slot comes around, so adding and cancelling are O(1) regardless of how many are pending.
+ */
 class alarm
 {
 public:
 	alarm (boost::asio::io_context &);
 	~alarm ();
-	void add (std::chrono::steady_clock::time_point const &, std::function<void()> const &);
+	nano::alarm_handle add (std::chrono::steady_clock::time_point const &, std::function<void()>);
+	// Returns true if the operation has already been posted or cancelled
+	bool cancel (nano::alarm_handle const &);
+	// Microseconds between the wakeup time and posting for operations that waited in the wheel
+	nano::stat_histogram lateness ();
 	void run ();
 	boost::asio::io_context & io_ctx;
 	std::mutex mutex;
 	std::condition_variable condition;
-	std::priority_queue<operation, std::vector<operation>, std::greater<operation>> operations;
+	static size_t constexpr levels = 4;
+	static size_t constexpr slot_bits = 8;
+	static size_t constexpr slots = 1 << slot_bits;
+	static uint32_t constexpr none = std::numeric_limits<uint32_t>::max ();
+
+private:
+	uint64_t ticks (std::chrono::steady_clock::time_point const &) const;
+	void insert (uint32_t);
+	void unlink (uint32_t);
+	void release (uint32_t);
+	void advance (uint64_t, std::vector<std::function<void()>> &);
+	void expire (uint32_t, std::chrono::steady_clock::time_point const &, std::vector<std::function<void()>> &);
+	uint64_t next_tick () const;
+	std::chrono::steady_clock::time_point const start;
+	uint64_t current;
+	uint64_t wakeup_tick;
+	size_t pending;
+	std::vector<nano::operation> entries;
+	uint32_t free_head;
+	std::array<std::array<uint32_t, slots>, levels> wheel;
+	nano::stat_histogram late;
+	bool stopped;
 	boost::thread thread;
 };
 class gap_information
@@ -240,6 +298,66 @@ private:
 	std::mutex mutex;
 	nano::node & node;
 };
+class work_cache_entry
+{
+public:
+	nano::account account;
+	// Root the next block of the account will be built on
+	nano::block_hash root;
+	// Zero while being generated
+	uint64_t work;
+};
+/**
+ * Keeps work ready for the next block of tracked accounts so publishing doesn't wait on generation.
+ * Tracked accounts are wallet accounts plus a watch list registered through RPC. When a block for one of them is confirmed
+ * work for the new frontier is generated at background priority. Entries and the watch list are persisted in the wallets environment.
+ */
+class work_cache
+{
+public:
+	work_cache (bool &, nano::node &);
+	/** Drops entries of untracked accounts and generates work for any entry whose account moved on, e.g. while the node was stopped */
+	void start ();
+	void watch (nano::account const &);
+	void unwatch (nano::account const &);
+	std::vector<nano::account> watched ();
+	/** Generates work on top of root for account unless it's already cached or being generated */
+	void ensure (nano::account const &, nano::block_hash const &);
+	/** Cached work for root which meets difficulty */
+	boost::optional<uint64_t> get (nano::block_hash const &, uint64_t = nano::work_pool::publish_threshold);
+	void block_confirmed (std::shared_ptr<nano::block>, nano::account const &);
+	/** Tracks an account just added to a wallet */
+	void wallet_insert (nano::account const &);
+	/** Reloads the wallet accounts in the background after accounts were removed or imported */
+	void wallets_changed ();
+	size_t size ();
+	boost::multi_index_container<
+	nano::work_cache_entry,
+	boost::multi_index::indexed_by<
+	boost::multi_index::hashed_unique<boost::multi_index::member<nano::work_cache_entry, nano::account, &nano::work_cache_entry::account>>,
+	boost::multi_index::hashed_non_unique<boost::multi_index::member<nano::work_cache_entry, nano::block_hash, &nano::work_cache_entry::root>>>>
+	entries;
+	std::unordered_set<nano::account> watch_list;
+	/** Accounts held by any wallet, kept in memory so confirmations don't need a wallets transaction */
+	std::unordered_set<nano::account> wallet_accounts;
+
+private:
+	void generated (nano::account const &, nano::block_hash const &, uint64_t);
+	/** Drops the entry of a cancelled generation and generates it again after cancelled_retry */
+	void cancelled (nano::account const &, nano::block_hash const &);
+	bool tracked (nano::account const &);
+	/** Removes entries of accounts no longer in any wallet or the watch list, the caller holds mutex and a wallets write transaction */
+	void prune (nano::transaction const &);
+	std::unordered_set<nano::account> wallet_accounts_read (nano::transaction const &);
+	void wallets_reload ();
+	std::mutex mutex;
+	nano::node & node;
+	// Account to wallet_value of root and work
+	MDB_dbi handle;
+	// Watched accounts, no values
+	MDB_dbi watch_handle;
+	static std::chrono::seconds constexpr cancelled_retry = std::chrono::seconds (60);
+};
 class udp_data
 {
 public:
@@ -287,16 +405,101 @@ private:
 	std::vector<nano::udp_data> entries;
 	bool stopped;
 };
+/**
+  * Lock-free version of udp_buffer with the same allocate/enqueue/dequeue/release contract.
+  * Free and filled buffers move through bounded MPMC rings, threads only touch a mutex when they have to sleep
+  * and producers wake a single sleeping consumer instead of every thread.
+  * Filled buffers can be split in to shards by sender endpoint so all datagrams from one peer are serviced by the same thread.
+  * All public methods are thread-safe
+*/
+class udp_ring_buffer
+{
+public:
+	// Stats - Statistics
+	// Size - Size of each individual buffer
+	// Count - Number of buffers to allocate
+	// Shards - Number of queues filled buffers are split in to by sender endpoint
+	udp_ring_buffer (nano::stat & stats, size_t, size_t, size_t = 1);
+	nano::udp_data * allocate ();
+	void enqueue (nano::udp_data *);
+	// Return a buffer filled with UDP data from the given shard
+	// Function will block until a buffer has been added
+	// Return nullptr if the container has stopped
+	nano::udp_data * dequeue (size_t = 0);
+	void release (nano::udp_data *);
+	// Batched versions of the above for receiving several datagrams per system call
+	// Allocation takes up to count free buffers, an unserviced buffer is only dequeued when none are free
+	// Returns the number of buffers allocated, 0 if the container has stopped
+	size_t allocate (nano::udp_data **, size_t);
+	void enqueue (nano::udp_data * const *, size_t);
+	// Take up to count filled buffers from the given shard, blocking until there is at least one
+	// Returns the number of buffers taken, 0 if the container has stopped
+	size_t dequeue (nano::udp_data **, size_t, size_t = 0);
+	void release (nano::udp_data * const *, size_t);
+	void stop ();
+	// Shard that datagrams from this endpoint are queued on
+	size_t shard (nano::endpoint const &) const;
+	size_t const shards;
+
+private:
+	// Bounded multi-producer multi-consumer ring, each cell carries a sequence number saying whether it's ready to be written or read
+	class ring
+	{
+	public:
+		ring (size_t);
+		void push (nano::udp_data *);
+		bool pop (nano::udp_data *&);
+		bool empty () const;
+
+	private:
+		class cell
+		{
+		public:
+			std::atomic<size_t> sequence;
+			nano::udp_data * data;
+		};
+		std::unique_ptr<cell[]> cells;
+		size_t mask;
+		// Producers and consumers advance different counters, keep them on separate cache lines
+		std::atomic<size_t> head;
+		uint8_t padding[64 - sizeof (std::atomic<size_t>)];
+		std::atomic<size_t> tail;
+	};
+	// Threads blocked on a ring park here, the count lets the other side skip the mutex when nobody is asleep
+	class waiters
+	{
+	public:
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::atomic<unsigned> sleeping{ 0 };
+	};
+	void notify (nano::udp_ring_buffer::waiters &, size_t);
+	bool steal (nano::udp_data *&);
+	nano::stat & stats;
+	ring free;
+	waiters allocators;
+	std::vector<std::unique_ptr<ring>> full;
+	std::vector<std::unique_ptr<waiters>> consumers;
+	std::atomic<size_t> steal_shard;
+	std::vector<uint8_t> slab;
+	std::vector<nano::udp_data> entries;
+	std::atomic<bool> stopped;
+};
 class network
 {
 public:
 	network (nano::node &, uint16_t);
 	~network ();
 	void receive ();
-	void process_packets ();
+	/** Receives with nano::udp_batch, waiting for the socket to be readable and then draining several datagrams at once */
+	void receive_batch ();
+	/** Services filled buffers from one udp_ring_buffer shard */
+	void process_packets (size_t);
 	void start ();
 	void stop ();
 	void receive_action (nano::udp_data *);
+	/** Parses a batch of datagrams and validates the work of all the blocks they carry together before acting on them */
+	void receive_action (nano::udp_data * const *, size_t);
 	void rpc_action (boost::system::error_code const &, size_t);
 	void republish_vote (std::shared_ptr<nano::vote>);
 	void republish_block (std::shared_ptr<nano::block>);
@@ -312,16 +515,24 @@ public:
 	void broadcast_confirm_req_batch (std::deque<std::pair<std::shared_ptr<nano::block>, std::shared_ptr<std::vector<nano::peer_information>>>>, unsigned = broadcast_interval_ms);
 	void send_confirm_req (nano::endpoint const &, std::shared_ptr<nano::block>);
 	void send_buffer (uint8_t const *, size_t, nano::endpoint const &, std::function<void(boost::system::error_code const &, size_t)>);
+	/** Sends everything queued by send_buffer with nano::udp_batch */
+	void send_flush ();
 	nano::endpoint endpoint ();
-	nano::udp_buffer buffer_container;
+	nano::udp_ring_buffer buffer_container;
 	boost::asio::ip::udp::socket socket;
 	std::mutex socket_mutex;
+	/** Datagrams are read and written in batches of node_config::udp_batch_size, otherwise one Asio operation is used per datagram */
+	bool const batching;
+	std::mutex send_mutex;
+	std::vector<nano::udp_send> send_queue;
 	boost::asio::ip::udp::resolver resolver;
 	std::vector<boost::thread> packet_processing_threads;
 	nano::node & node;
 	bool on;
 	static uint16_t const node_port = nano::nano_network == nano::nano_networks::nano_live_network ? 7075 : 54000;
 	static size_t const buffer_size = 512;
+	static size_t const batch_max = 64;
+	static size_t const dequeue_batch = 8;
 };
 
 class node_init
@@ -392,24 +603,46 @@ public:
 	int * verifications;
 	std::promise<void> * promise;
 };
+/**
+ * Verifies signature check sets on a pool of threads.
+ * Sets larger than batch_size are split into chunks which are verified in parallel, work is handed to the pool through a bounded lock-free queue.
+ */
 class signature_checker
 {
 public:
-	signature_checker ();
+	signature_checker (unsigned = 1);
 	~signature_checker ();
 	void add (signature_check_set &);
 	void stop ();
 	void flush ();
+	static size_t constexpr batch_size = 256;
+	static size_t constexpr queue_capacity = 4096;
 
 private:
+	class task
+	{
+	public:
+		nano::signature_check_set check;
+		std::atomic<size_t> remaining;
+	};
+	class chunk
+	{
+	public:
+		nano::signature_checker::task * owner;
+		size_t offset;
+		size_t size;
+	};
 	void run ();
-	void verify (nano::signature_check_set & check_a);
-	std::deque<nano::signature_check_set> checks;
-	bool started;
-	bool stopped;
+	void verify (nano::signature_checker::chunk const &);
+	boost::lockfree::queue<nano::signature_checker::chunk, boost::lockfree::capacity<queue_capacity>> chunks;
+	std::atomic<size_t> pending;
+	std::atomic<unsigned> idle;
+	/** Threads in add between checking stopped and finishing their pushes, stop waits for them before its final drain */
+	std::atomic<unsigned> producers;
+	std::atomic<bool> stopped;
 	std::mutex mutex;
 	std::condition_variable condition;
-	std::thread thread;
+	std::vector<std::thread> threads;
 };
 class rolled_hash
 {
@@ -419,6 +652,8 @@ public:
 };
 // Processing blocks is a potentially long IO operation
 // This class isolates block insertion from other operations like servicing network operations
+// Blocks flow through a pipeline: work is checked in add (), state block signatures are batch verified on verification_thread,
+// and verified blocks are applied to the ledger by process_blocks () inside a write transaction
 class block_processor
 {
 public:
@@ -427,7 +662,8 @@ public:
 	void stop ();
 	void flush ();
 	bool full ();
-	void add (std::shared_ptr<nano::block>, std::chrono::steady_clock::time_point);
+	/** Blocks whose work the caller has already checked, e.g. in a batch while parsing, pass true to skip validating it again */
+	void add (std::shared_ptr<nano::block>, std::chrono::steady_clock::time_point, bool = false);
 	void force (std::shared_ptr<nano::block>);
 	bool should_log (bool);
 	bool have_blocks ();
@@ -436,10 +672,14 @@ public:
 
 private:
 	void queue_unchecked (nano::transaction const &, nano::block_hash const &, std::chrono::steady_clock::time_point = std::chrono::steady_clock::time_point ());
-	void verify_state_blocks (nano::transaction const & transaction_a, std::unique_lock<std::mutex> &, size_t = std::numeric_limits<size_t>::max ());
+	bool have_verified_blocks ();
+	void verify_blocks ();
+	void verify_state_blocks (std::unique_lock<std::mutex> &, size_t = std::numeric_limits<size_t>::max ());
+	/** Takes a batch out of the queues and applies it in a write, blocks not applied within the write batch time are queued again */
 	void process_batch (std::unique_lock<std::mutex> &);
 	bool stopped;
 	bool active;
+	bool verifying;
 	std::chrono::steady_clock::time_point next_log;
 	std::deque<std::pair<std::shared_ptr<nano::block>, std::chrono::steady_clock::time_point>> state_blocks;
 	std::deque<std::pair<std::shared_ptr<nano::block>, std::chrono::steady_clock::time_point>> blocks;
@@ -452,10 +692,16 @@ private:
 	boost::multi_index::hashed_unique<boost::multi_index::member<nano::rolled_hash, nano::block_hash, &nano::rolled_hash::hash>>>>
 	rolled_back;
 	static size_t const rolled_back_max = 1024;
+	static size_t const verification_batch_size = 2048;
+	// Maximum number of verified blocks waiting for the ledger stage before verification pauses
+	static size_t const verified_max = 16384;
+	// Maximum number of blocks taken out of the queues for one write
+	static size_t const process_batch_max = 4096;
 	std::condition_variable condition;
 	nano::node & node;
 	nano::vote_generator generator;
 	std::mutex mutex;
+	boost::thread verification_thread;
 };
 class node : public std::enable_shared_from_this<nano::node>
 {
@@ -477,7 +723,7 @@ public:
 	int store_version ();
 	void process_confirmed (std::shared_ptr<nano::block>);
 	void process_message (nano::message &, nano::endpoint const &);
-	void process_active (std::shared_ptr<nano::block>);
+	void process_active (std::shared_ptr<nano::block>, bool = false);
 	nano::process_return process (nano::block const &);
 	void keepalive_preconfigured (std::vector<std::string> const &);
 	nano::block_hash latest (nano::account const &);
@@ -492,18 +738,19 @@ public:
 	void ongoing_rep_calculation ();
 	void ongoing_bootstrap ();
 	void ongoing_store_flush ();
+	void ongoing_uniquer_stats ();
 	void backup_wallet ();
 	void search_pending ();
 	void bootstrap_wallet ();
 	int price (nano::uint128_t const &, int);
 	void work_generate_blocking (nano::block &, uint64_t = nano::work_pool::publish_threshold);
-	uint64_t work_generate_blocking (nano::uint256_union const &, uint64_t = nano::work_pool::publish_threshold);
-	void work_generate (nano::uint256_union const &, std::function<void(uint64_t)>, uint64_t = nano::work_pool::publish_threshold);
+	uint64_t work_generate_blocking (nano::uint256_union const &, uint64_t = nano::work_pool::publish_threshold, nano::work_priority = nano::work_priority::interactive);
+	/** The callback gets boost::none if the local generation was cancelled */
+	void work_generate (nano::uint256_union const &, std::function<void(boost::optional<uint64_t> const &)>, uint64_t = nano::work_pool::publish_threshold, nano::work_priority = nano::work_priority::interactive);
 	void add_initial_peers ();
 	void block_confirm (std::shared_ptr<nano::block>);
 	void process_fork (nano::transaction const &, std::shared_ptr<nano::block>);
 	bool validate_block_by_previous (nano::transaction const &, std::shared_ptr<nano::block>);
-	void do_rpc_callback (boost::asio::ip::tcp::resolver::iterator i_a, std::string const &, uint16_t, std::shared_ptr<std::string>, std::shared_ptr<std::string>, std::shared_ptr<boost::asio::ip::tcp::resolver>);
 	nano::uint128_t delta ();
 	boost::asio::io_context & io_ctx;
 	nano::node_config config;
@@ -511,6 +758,8 @@ public:
 	nano::alarm & alarm;
 	nano::work_pool & work;
 	boost::log::sources::logger_mt log;
+	nano::block_uniquer block_uniquer;
+	nano::vote_uniquer vote_uniquer;
 	std::unique_ptr<nano::block_store> store_impl;
 	nano::block_store & store;
 	std::unique_ptr<nano::wallets_store> wallets_store_impl;
@@ -536,8 +785,10 @@ public:
 	nano::online_reps online_reps;
 	nano::stat stats;
 	nano::keypair node_id;
-	nano::block_uniquer block_uniquer;
-	nano::vote_uniquer vote_uniquer;
+	nano::http_callbacks http_callbacks;
+	nano::work_cache work_cache;
+	/** Declared after everything its writes use, its thread starts running queued writes as soon as it's constructed */
+	nano::write_scheduler write_scheduler;
 	const std::chrono::steady_clock::time_point startup_time;
 	static double constexpr price_max = 16.0;
 	static double constexpr free_cutoff = 1024.0;
@@ -26,14 +26,25 @@ online_weight_quorum (50),
 password_fanout (1024),
 io_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
 network_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
+udp_batch_size (0),
+udp_shard_by_endpoint (false),
 work_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
+signature_checker_threads (std::max<unsigned> (1, boost::thread::hardware_concurrency () / 2)),
+uniquer_memory_max_mb (64),
+block_cache_max_mb (32),
+account_cache_max_mb (16),
 enable_voting (false),
 bootstrap_connections (4),
 bootstrap_connections_max (64),
 callback_port (0),
+callback_connections (4),
+callback_queue_max (4096),
+callback_batch_max (1),
 lmdb_max_dbs (128),
 allow_local_peers (false),
-block_processor_batch_max_time (std::chrono::milliseconds (5000))
+block_processor_batch_max_time (std::chrono::milliseconds (5000)),
+write_batch_max_time (std::chrono::milliseconds (100)),
+write_batch_max_size (256)
 {
 	const char * epoch_message ("epoch v1 block");
 	strncpy ((char *)epoch_block_link.bytes.data (), epoch_message, epoch_block_link.bytes.size ());
@@ -105,15 +116,26 @@ nano::error nano::node_config::serialize_json (nano::jsonconfig & json) const
 	json.put ("password_fanout", password_fanout);
 	json.put ("io_threads", io_threads);
 	json.put ("network_threads", network_threads);
+	json.put ("udp_batch_size", udp_batch_size);
+	json.put ("udp_shard_by_endpoint", udp_shard_by_endpoint);
 	json.put ("work_threads", work_threads);
+	json.put ("signature_checker_threads", signature_checker_threads);
+	json.put ("uniquer_memory_max_mb", uniquer_memory_max_mb);
+	json.put ("block_cache_max_mb", block_cache_max_mb);
+	json.put ("account_cache_max_mb", account_cache_max_mb);
 	json.put ("enable_voting", enable_voting);
 	json.put ("bootstrap_connections", bootstrap_connections);
 	json.put ("bootstrap_connections_max", bootstrap_connections_max);
 	json.put ("callback_address", callback_address);
 	json.put ("callback_port", callback_port);
 	json.put ("callback_target", callback_target);
+	json.put ("callback_connections", callback_connections);
+	json.put ("callback_queue_max", callback_queue_max);
+	json.put ("callback_batch_max", callback_batch_max);
 	json.put ("lmdb_max_dbs", lmdb_max_dbs);
 	json.put ("block_processor_batch_max_time", block_processor_batch_max_time.count ());
+	json.put ("write_batch_max_time", write_batch_max_time.count ());
+	json.put ("write_batch_max_size", write_batch_max_size);
 	json.put ("allow_local_peers", allow_local_peers);
 	return json.get_error ();
 }
@@ -225,6 +247,19 @@ bool nano::node_config::upgrade_json (unsigned version_a, nano::jsonconfig & jso
 			upgraded = true;
 		}
 		case 16:
+			json.put ("signature_checker_threads", signature_checker_threads);
+			json.put ("uniquer_memory_max_mb", uniquer_memory_max_mb);
+			json.put ("block_cache_max_mb", block_cache_max_mb);
+			json.put ("account_cache_max_mb", account_cache_max_mb);
+			json.put ("write_batch_max_time", write_batch_max_time.count ());
+			json.put ("write_batch_max_size", write_batch_max_size);
+			json.put ("callback_connections", callback_connections);
+			json.put ("callback_queue_max", callback_queue_max);
+			json.put ("callback_batch_max", callback_batch_max);
+			json.put ("udp_batch_size", udp_batch_size);
+			json.put ("udp_shard_by_endpoint", udp_shard_by_endpoint);
+			upgraded = true;
+		case 17:
 			break;
 		default:
 			throw std::runtime_error ("Unknown node_config version");
@@ -314,6 +349,9 @@ nano::error nano::node_config::deserialize_json (bool & upgraded_a, nano::jsonco
 
 		auto block_processor_batch_max_time_l (json.get<unsigned long> ("block_processor_batch_max_time"));
 		block_processor_batch_max_time = std::chrono::milliseconds (block_processor_batch_max_time_l);
+		auto write_batch_max_time_l (json.get<unsigned long> ("write_batch_max_time"));
+		write_batch_max_time = std::chrono::milliseconds (write_batch_max_time_l);
+		json.get<unsigned> ("write_batch_max_size", write_batch_max_size);
 
 		json.get<uint16_t> ("peering_port", peering_port);
 		json.get<unsigned> ("bootstrap_fraction_numerator", bootstrap_fraction_numerator);
@@ -322,11 +360,20 @@ nano::error nano::node_config::deserialize_json (bool & upgraded_a, nano::jsonco
 		json.get<unsigned> ("io_threads", io_threads);
 		json.get<unsigned> ("work_threads", work_threads);
 		json.get<unsigned> ("network_threads", network_threads);
+		json.get<unsigned> ("udp_batch_size", udp_batch_size);
+		json.get<bool> ("udp_shard_by_endpoint", udp_shard_by_endpoint);
+		json.get<unsigned> ("signature_checker_threads", signature_checker_threads);
+		json.get<unsigned> ("uniquer_memory_max_mb", uniquer_memory_max_mb);
+		json.get<unsigned> ("block_cache_max_mb", block_cache_max_mb);
+		json.get<unsigned> ("account_cache_max_mb", account_cache_max_mb);
 		json.get<unsigned> ("bootstrap_connections", bootstrap_connections);
 		json.get<unsigned> ("bootstrap_connections_max", bootstrap_connections_max);
 		json.get<std::string> ("callback_address", callback_address);
 		json.get<uint16_t> ("callback_port", callback_port);
 		json.get<std::string> ("callback_target", callback_target);
+		json.get<unsigned> ("callback_connections", callback_connections);
+		json.get<unsigned> ("callback_queue_max", callback_queue_max);
+		json.get<unsigned> ("callback_batch_max", callback_batch_max);
 		json.get<int> ("lmdb_max_dbs", lmdb_max_dbs);
 		json.get<bool> ("enable_voting", enable_voting);
 		json.get<bool> ("allow_local_peers", allow_local_peers);
@@ -345,6 +392,10 @@ nano::error nano::node_config::deserialize_json (bool & upgraded_a, nano::jsonco
 		{
 			json.get_error ().set ("io_threads must be non-zero");
 		}
+		if (callback_connections == 0)
+		{
+			json.get_error ().set ("callback_connections must be non-zero");
+		}
 	}
 	catch (std::runtime_error const & ex)
 	{
@@ -34,25 +34,46 @@ public:
 	unsigned password_fanout;
 	unsigned io_threads;
 	unsigned network_threads;
+	/** Datagrams read or written per system call where supported (Linux), 0 uses one call per datagram */
+	unsigned udp_batch_size;
+	/** Queue datagrams from each peer to the same packet processing thread */
+	bool udp_shard_by_endpoint;
 	unsigned work_threads;
+	unsigned signature_checker_threads;
+	/** Memory held by the block and vote uniquers combined, in megabytes */
+	unsigned uniquer_memory_max_mb;
+	/** Memory held by deserialized blocks cached in front of the block store, in megabytes. Zero disables the cache */
+	unsigned block_cache_max_mb;
+	/** Memory held by cached account info, in megabytes. Zero disables the cache */
+	unsigned account_cache_max_mb;
 	bool enable_voting;
 	unsigned bootstrap_connections;
 	unsigned bootstrap_connections_max;
 	std::string callback_address;
 	uint16_t callback_port;
 	std::string callback_target;
+	/** Persistent connections used to post callbacks */
+	unsigned callback_connections;
+	/** Callbacks waiting for a connection before new ones are dropped */
+	unsigned callback_queue_max;
+	/** Callbacks posted together as a JSON array, 1 posts each as its own object */
+	unsigned callback_batch_max;
 	int lmdb_max_dbs;
 	bool allow_local_peers;
 	nano::stat_config stat_config;
 	nano::uint256_union epoch_block_link;
 	nano::account epoch_block_signer;
 	std::chrono::milliseconds block_processor_batch_max_time;
+	/** Longest a group commit keeps taking queued writes before committing */
+	std::chrono::milliseconds write_batch_max_time;
+	/** Most writes run in one group commit */
+	unsigned write_batch_max_size;
 	static std::chrono::seconds constexpr keepalive_period = std::chrono::seconds (60);
 	static std::chrono::seconds constexpr keepalive_cutoff = keepalive_period * 5;
 	static std::chrono::minutes constexpr wallet_backup_interval = std::chrono::minutes (5);
 	static int json_version ()
 	{
-		return 16;
+		return 17;
 	}
 };
 
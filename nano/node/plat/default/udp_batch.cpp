@@ -0,0 +1,18 @@
+#include <nano/node/udp_batch.hpp>
+
+bool nano::udp_batch::supported ()
+{
+	return false;
+}
+
+size_t nano::udp_batch::receive (boost::asio::ip::udp::socket &, nano::udp_data * const *, size_t, size_t, boost::system::error_code & ec_a)
+{
+	ec_a = boost::asio::error::operation_not_supported;
+	return 0;
+}
+
+size_t nano::udp_batch::send (boost::asio::ip::udp::socket &, nano::udp_send const *, size_t *, size_t, boost::system::error_code & ec_a)
+{
+	ec_a = boost::asio::error::operation_not_supported;
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include <nano/node/node.hpp>
+#include <nano/node/udp_batch.hpp>
+
+#include <sys/socket.h>
+
+#include <array>
+#include <cerrno>
+
+namespace
+{
+size_t constexpr max_batch = 64;
+}
+
+bool nano::udp_batch::supported ()
+{
+	return true;
+}
+
+size_t nano::udp_batch::receive (boost::asio::ip::udp::socket & socket_a, nano::udp_data * const * data_a, size_t count_a, size_t size_a, boost::system::error_code & ec_a)
+{
+	std::array<mmsghdr, max_batch> messages;
+	std::array<iovec, max_batch> buffers;
+	auto count (std::min (count_a, max_batch));
+	for (size_t i (0); i < count; ++i)
+	{
+		buffers[i].iov_base = data_a[i]->buffer;
+		buffers[i].iov_len = size_a;
+		messages[i] = mmsghdr{};
+		// Sender addresses are written straight into each slot's endpoint
+		messages[i].msg_hdr.msg_name = data_a[i]->endpoint.data ();
+		messages[i].msg_hdr.msg_namelen = data_a[i]->endpoint.capacity ();
+		messages[i].msg_hdr.msg_iov = &buffers[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+	size_t result (0);
+	auto received (recvmmsg (socket_a.native_handle (), messages.data (), count, MSG_DONTWAIT, nullptr));
+	if (received >= 0)
+	{
+		result = received;
+		for (size_t i (0); i < result; ++i)
+		{
+			data_a[i]->size = messages[i].msg_len;
+			data_a[i]->endpoint.resize (messages[i].msg_hdr.msg_namelen);
+		}
+	}
+	else
+	{
+		ec_a = boost::system::error_code (errno, boost::asio::error::get_system_category ());
+	}
+	return result;
+}
+
+size_t nano::udp_batch::send (boost::asio::ip::udp::socket & socket_a, nano::udp_send const * send_a, size_t * sent_a, size_t count_a, boost::system::error_code & ec_a)
+{
+	std::array<mmsghdr, max_batch> messages;
+	std::array<iovec, max_batch> buffers;
+	auto count (std::min (count_a, max_batch));
+	for (size_t i (0); i < count; ++i)
+	{
+		buffers[i].iov_base = const_cast<uint8_t *> (send_a[i].data);
+		buffers[i].iov_len = send_a[i].size;
+		messages[i] = mmsghdr{};
+		messages[i].msg_hdr.msg_name = const_cast<sockaddr *> (send_a[i].endpoint.data ());
+		messages[i].msg_hdr.msg_namelen = send_a[i].endpoint.size ();
+		messages[i].msg_hdr.msg_iov = &buffers[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+	size_t result (0);
+	auto sent (sendmmsg (socket_a.native_handle (), messages.data (), count, MSG_DONTWAIT));
+	if (sent >= 0)
+	{
+		result = sent;
+		for (size_t i (0); i < result; ++i)
+		{
+			sent_a[i] = messages[i].msg_len;
+		}
+	}
+	else
+	{
+		ec_a = boost::system::error_code (errno, boost::asio::error::get_system_category ());
+	}
+	return result;
+}
@@ -1,5 +1,6 @@
 #include <boost/algorithm/string.hpp>
 #include <nano/lib/interface.h>
+#include <nano/lib/json_writer.hpp>
 #include <nano/node/node.hpp>
 #include <nano/node/rpc.hpp>
 
@@ -45,7 +46,10 @@ port (nano::rpc::rpc_port),
 enable_control (false),
 frontier_request_limit (16384),
 chain_request_limit (16384),
-max_json_depth (20)
+max_json_depth (20),
+keep_alive_timeout (std::chrono::seconds (30)),
+max_requests_per_connection (1000),
+max_idle_connections (256)
 {
 }
 
@@ -55,7 +59,10 @@ port (nano::rpc::rpc_port),
 enable_control (enable_control_a),
 frontier_request_limit (16384),
 chain_request_limit (16384),
-max_json_depth (20)
+max_json_depth (20),
+keep_alive_timeout (std::chrono::seconds (30)),
+max_requests_per_connection (1000),
+max_idle_connections (256)
 {
 }
 
@@ -67,6 +74,9 @@ nano::error nano::rpc_config::serialize_json (nano::jsonconfig & json) const
 	json.put ("frontier_request_limit", frontier_request_limit);
 	json.put ("chain_request_limit", chain_request_limit);
 	json.put ("max_json_depth", max_json_depth);
+	json.put ("keep_alive_timeout", keep_alive_timeout.count ());
+	json.put ("max_requests_per_connection", max_requests_per_connection);
+	json.put ("max_idle_connections", max_idle_connections);
 	return json.get_error ();
 }
 
@@ -84,13 +94,19 @@ nano::error nano::rpc_config::deserialize_json (nano::jsonconfig & json)
 	json.get_optional<uint64_t> ("frontier_request_limit", frontier_request_limit);
 	json.get_optional<uint64_t> ("chain_request_limit", chain_request_limit);
 	json.get_optional<uint8_t> ("max_json_depth", max_json_depth);
+	auto keep_alive_timeout_l (static_cast<unsigned long> (keep_alive_timeout.count ()));
+	json.get_optional<unsigned long> ("keep_alive_timeout", keep_alive_timeout_l);
+	keep_alive_timeout = std::chrono::seconds (keep_alive_timeout_l);
+	json.get_optional<unsigned> ("max_requests_per_connection", max_requests_per_connection);
+	json.get_optional<unsigned> ("max_idle_connections", max_idle_connections);
 	return json.get_error ();
 }
 
 nano::rpc::rpc (boost::asio::io_context & io_ctx_a, nano::node & node_a, nano::rpc_config const & config_a) :
 acceptor (io_ctx_a),
 config (config_a),
-node (node_a)
+node (node_a),
+stopped (false)
 {
 }
 
@@ -138,14 +154,49 @@ void nano::rpc::accept ()
 void nano::rpc::stop ()
 {
 	acceptor.close ();
+	std::vector<std::shared_ptr<nano::rpc_connection>> idle_l;
+	{
+		std::lock_guard<std::mutex> lock (idle_mutex);
+		stopped = true;
+		for (auto & i : idle_connections)
+		{
+			if (auto connection_l = i.second.lock ())
+			{
+				idle_l.push_back (connection_l);
+			}
+		}
+	}
+	for (auto & i : idle_l)
+	{
+		i->close ();
+	}
 }
 
-nano::rpc_handler::rpc_handler (nano::node & node_a, nano::rpc & rpc_a, std::string const & body_a, std::string const & request_id_a, std::function<void(boost::property_tree::ptree const &)> const & response_a) :
+bool nano::rpc::idle_add (std::shared_ptr<nano::rpc_connection> const & connection_a)
+{
+	auto result (false);
+	std::lock_guard<std::mutex> lock (idle_mutex);
+	if (!stopped && idle_connections.size () < config.max_idle_connections)
+	{
+		idle_connections[connection_a.get ()] = connection_a;
+		result = true;
+	}
+	return result;
+}
+
+void nano::rpc::idle_remove (nano::rpc_connection * connection_a)
+{
+	std::lock_guard<std::mutex> lock (idle_mutex);
+	idle_connections.erase (connection_a);
+}
+
+nano::rpc_handler::rpc_handler (nano::node & node_a, nano::rpc & rpc_a, std::string const & body_a, std::string const & request_id_a, std::function<void(boost::property_tree::ptree const &)> const & response_a, std::function<void(std::string)> const & response_body_a) :
 body (body_a),
 request_id (request_id_a),
 node (node_a),
 rpc (rpc_a),
-response (response_a)
+response (response_a),
+response_body (response_body_a)
 {
 }
 
@@ -187,6 +238,18 @@ void nano::rpc_handler::response_errors ()
 	}
 }
 
+void nano::rpc_handler::response_json (std::string json_a)
+{
+	if (ec)
+	{
+		response_errors ();
+	}
+	else
+	{
+		response_body (std::move (json_a));
+	}
+}
+
 std::shared_ptr<nano::wallet> nano::rpc_handler::wallet_impl ()
 {
 	if (!ec)
@@ -580,6 +643,7 @@ void nano::rpc_handler::account_remove ()
 			if (wallet->store.find (transaction, account) != wallet->store.end ())
 			{
 				wallet->store.erase (transaction, account);
+				node.work_cache.wallets_changed ();
 				response_l.put ("removed", "1");
 			}
 			else
@@ -760,25 +824,33 @@ void nano::rpc_handler::accounts_pending ()
 	auto threshold (threshold_optional_impl ());
 	const bool source = request.get<bool> ("source", false);
 	const bool include_active = request.get<bool> ("include_active", false);
-	boost::property_tree::ptree pending;
+	std::string json;
+	nano::json_writer writer (json);
+	writer.begin_object ("blocks");
 	auto transaction (node.store.tx_begin_read ());
 	for (auto & accounts : request.get_child ("accounts"))
 	{
 		auto account (account_impl (accounts.second.data ()));
 		if (!ec)
 		{
-			boost::property_tree::ptree peers_l;
-			for (auto i (node.store.pending_begin (transaction, nano::pending_key (account, 0))); nano::pending_key (i->first).account == account && peers_l.size () < count; ++i)
+			auto simple (threshold.is_zero () && !source);
+			if (simple)
+			{
+				writer.begin_array (account.to_account ());
+			}
+			else
+			{
+				writer.begin_object (account.to_account ());
+			}
+			for (auto i (node.store.pending_begin (transaction, nano::pending_key (account, 0))); nano::pending_key (i->first).account == account && writer.size () < count; ++i)
 			{
 				nano::pending_key key (i->first);
 				std::shared_ptr<nano::block> block (include_active ? nullptr : node.store.block_get (transaction, key.hash));
 				if (include_active || (block && !node.active.active (*block)))
 				{
-					if (threshold.is_zero () && !source)
+					if (simple)
 					{
-						boost::property_tree::ptree entry;
-						entry.put ("", key.hash.to_string ());
-						peers_l.push_back (std::make_pair ("", entry));
+						writer.push_back (key.hash.to_string ());
 					}
 					else
 					{
@@ -787,24 +859,25 @@ void nano::rpc_handler::accounts_pending ()
 						{
 							if (source)
 							{
-								boost::property_tree::ptree pending_tree;
-								pending_tree.put ("amount", info.amount.number ().convert_to<std::string> ());
-								pending_tree.put ("source", info.source.to_account ());
-								peers_l.add_child (key.hash.to_string (), pending_tree);
+								writer.begin_object (key.hash.to_string ());
+								writer.put ("amount", info.amount.number ().convert_to<std::string> ());
+								writer.put ("source", info.source.to_account ());
+								writer.end ();
 							}
 							else
 							{
-								peers_l.put (key.hash.to_string (), info.amount.number ().convert_to<std::string> ());
+								writer.put (key.hash.to_string (), info.amount.number ().convert_to<std::string> ());
 							}
 						}
 					}
 				}
 			}
-			pending.add_child (account.to_account (), peers_l);
+			writer.end ();
 		}
 	}
-	response_l.add_child ("blocks", pending);
-	response_errors ();
+	writer.end ();
+	writer.end ();
+	response_json (std::move (json));
 }
 
 void nano::rpc_handler::available_supply ()
@@ -1373,8 +1446,29 @@ void nano::rpc_handler::bootstrap_status ()
 		response_l.put ("pulling", std::to_string (attempt->pulling));
 		response_l.put ("connections", std::to_string (attempt->connections));
 		response_l.put ("idle", std::to_string (attempt->idle.size ()));
-		response_l.put ("target_connections", std::to_string (attempt->target_connections (attempt->pulls.size ())));
+		response_l.put ("target_connections", std::to_string (attempt->target_connections ()));
 		response_l.put ("total_blocks", std::to_string (attempt->total_blocks));
+		boost::property_tree::ptree peers_l;
+		{
+			std::lock_guard<std::mutex> lock (attempt->mutex);
+			response_l.put ("aggregate_rate", std::to_string (attempt->connections_rate));
+			for (auto & client : attempt->clients)
+			{
+				if (auto client_l = client.lock ())
+				{
+					boost::property_tree::ptree entry;
+					entry.put ("endpoint", boost::str (boost::format ("%1%") % client_l->endpoint));
+					entry.put ("blocks", std::to_string (client_l->block_count));
+					entry.put ("rate", std::to_string (client_l->block_rate ()));
+					entry.put ("recent_rate", std::to_string (client_l->recent_rate));
+					entry.put ("pulls", std::to_string (client_l->pulls_succeeded));
+					entry.put ("failures", std::to_string (client_l->pulls_failed));
+					entry.put ("score", std::to_string (client_l->score ()));
+					peers_l.push_back (std::make_pair ("", entry));
+				}
+			}
+		}
+		response_l.add_child ("peers", peers_l);
 		std::string mode_text;
 		if (attempt->mode == nano::bootstrap_mode::legacy)
 		{
@@ -1602,7 +1696,9 @@ void nano::rpc_handler::delegators ()
 	auto account (account_impl ());
 	if (!ec)
 	{
-		boost::property_tree::ptree delegators;
+		std::string json;
+		nano::json_writer writer (json);
+		writer.begin_object ("delegators");
 		auto transaction (node.store.tx_begin_read ());
 		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
 		{
@@ -1613,12 +1709,17 @@ void nano::rpc_handler::delegators ()
 			{
 				std::string balance;
 				nano::uint128_union (info.balance).encode_dec (balance);
-				delegators.put (nano::account (i->first).to_account (), balance);
+				writer.put (nano::account (i->first).to_account (), balance);
 			}
 		}
-		response_l.add_child ("delegators", delegators);
+		writer.end ();
+		writer.end ();
+		response_json (std::move (json));
+	}
+	else
+	{
+		response_errors ();
 	}
-	response_errors ();
 }
 
 void nano::rpc_handler::delegators_count ()
@@ -1678,15 +1779,22 @@ void nano::rpc_handler::frontiers ()
 	auto count (count_impl ());
 	if (!ec)
 	{
-		boost::property_tree::ptree frontiers;
+		std::string json;
+		nano::json_writer writer (json);
+		writer.begin_object ("frontiers");
 		auto transaction (node.store.tx_begin_read ());
-		for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && frontiers.size () < count; ++i)
+		for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && writer.size () < count; ++i)
 		{
-			frontiers.put (nano::account (i->first).to_account (), nano::account_info (i->second).head.to_string ());
+			writer.put (nano::account (i->first).to_account (), nano::account_info (i->second).head.to_string ());
 		}
-		response_l.add_child ("frontiers", frontiers);
+		writer.end ();
+		writer.end ();
+		response_json (std::move (json));
+	}
+	else
+	{
+		response_errors ();
 	}
-	response_errors ();
 }
 
 void nano::rpc_handler::account_count ()
@@ -1987,42 +2095,44 @@ void nano::rpc_handler::ledger ()
 		const bool representative = request.get<bool> ("representative", false);
 		const bool weight = request.get<bool> ("weight", false);
 		const bool pending = request.get<bool> ("pending", false);
-		boost::property_tree::ptree accounts;
+		std::string json;
+		nano::json_writer writer (json);
+		writer.begin_object ("accounts");
 		auto transaction (node.store.tx_begin_read ());
 		if (!ec && !sorting) // Simple
 		{
-			for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && accounts.size () < count; ++i)
+			for (auto i (node.store.latest_begin (transaction, start)), n (node.store.latest_end ()); i != n && writer.size () < count; ++i)
 			{
 				nano::account_info info (i->second);
 				if (info.modified >= modified_since)
 				{
 					nano::account account (i->first);
-					boost::property_tree::ptree response_a;
-					response_a.put ("frontier", info.head.to_string ());
-					response_a.put ("open_block", info.open_block.to_string ());
-					response_a.put ("representative_block", info.rep_block.to_string ());
+					writer.begin_object (account.to_account ());
+					writer.put ("frontier", info.head.to_string ());
+					writer.put ("open_block", info.open_block.to_string ());
+					writer.put ("representative_block", info.rep_block.to_string ());
 					std::string balance;
 					nano::uint128_union (info.balance).encode_dec (balance);
-					response_a.put ("balance", balance);
-					response_a.put ("modified_timestamp", std::to_string (info.modified));
-					response_a.put ("block_count", std::to_string (info.block_count));
+					writer.put ("balance", balance);
+					writer.put ("modified_timestamp", std::to_string (info.modified));
+					writer.put ("block_count", std::to_string (info.block_count));
 					if (representative)
 					{
 						auto block (node.store.block_get (transaction, info.rep_block));
 						assert (block != nullptr);
-						response_a.put ("representative", block->representative ().to_account ());
+						writer.put ("representative", block->representative ().to_account ());
 					}
 					if (weight)
 					{
 						auto account_weight (node.ledger.weight (transaction, account));
-						response_a.put ("weight", account_weight.convert_to<std::string> ());
+						writer.put ("weight", account_weight.convert_to<std::string> ());
 					}
 					if (pending)
 					{
 						auto account_pending (node.ledger.account_pending (transaction, account));
-						response_a.put ("pending", account_pending.convert_to<std::string> ());
+						writer.put ("pending", account_pending.convert_to<std::string> ());
 					}
-					accounts.push_back (std::make_pair (account.to_account (), response_a));
+					writer.end ();
 				}
 			}
 		}
@@ -2041,41 +2151,46 @@ void nano::rpc_handler::ledger ()
 			std::sort (ledger_l.begin (), ledger_l.end ());
 			std::reverse (ledger_l.begin (), ledger_l.end ());
 			nano::account_info info;
-			for (auto i (ledger_l.begin ()), n (ledger_l.end ()); i != n && accounts.size () < count; ++i)
+			for (auto i (ledger_l.begin ()), n (ledger_l.end ()); i != n && writer.size () < count; ++i)
 			{
 				node.store.account_get (transaction, i->second, info);
 				nano::account account (i->second);
-				boost::property_tree::ptree response_a;
-				response_a.put ("frontier", info.head.to_string ());
-				response_a.put ("open_block", info.open_block.to_string ());
-				response_a.put ("representative_block", info.rep_block.to_string ());
+				writer.begin_object (account.to_account ());
+				writer.put ("frontier", info.head.to_string ());
+				writer.put ("open_block", info.open_block.to_string ());
+				writer.put ("representative_block", info.rep_block.to_string ());
 				std::string balance;
 				(i->first).encode_dec (balance);
-				response_a.put ("balance", balance);
-				response_a.put ("modified_timestamp", std::to_string (info.modified));
-				response_a.put ("block_count", std::to_string (info.block_count));
+				writer.put ("balance", balance);
+				writer.put ("modified_timestamp", std::to_string (info.modified));
+				writer.put ("block_count", std::to_string (info.block_count));
 				if (representative)
 				{
 					auto block (node.store.block_get (transaction, info.rep_block));
 					assert (block != nullptr);
-					response_a.put ("representative", block->representative ().to_account ());
+					writer.put ("representative", block->representative ().to_account ());
 				}
 				if (weight)
 				{
 					auto account_weight (node.ledger.weight (transaction, account));
-					response_a.put ("weight", account_weight.convert_to<std::string> ());
+					writer.put ("weight", account_weight.convert_to<std::string> ());
 				}
 				if (pending)
 				{
 					auto account_pending (node.ledger.account_pending (transaction, account));
-					response_a.put ("pending", account_pending.convert_to<std::string> ());
+					writer.put ("pending", account_pending.convert_to<std::string> ());
 				}
-				accounts.push_back (std::make_pair (account.to_account (), response_a));
+				writer.end ();
 			}
 		}
-		response_l.add_child ("accounts", accounts);
+		writer.end ();
+		writer.end ();
+		response_json (std::move (json));
+	}
+	else
+	{
+		response_errors ();
 	}
-	response_errors ();
 }
 
 void nano::rpc_handler::mrai_from_raw (nano::uint128_t ratio)
@@ -2130,8 +2245,9 @@ void nano::rpc_handler::node_id_delete ()
 	rpc_control_impl ();
 	if (!ec)
 	{
-		auto transaction (node.store.tx_begin_write ());
-		node.store.delete_node_id (transaction);
+		node.write_scheduler.run (nano::write_priority::maintenance, [this](nano::transaction const & transaction_a) {
+			node.store.delete_node_id (transaction_a);
+		});
 		response_l.put ("deleted", "1");
 	}
 	response_errors ();
@@ -2440,10 +2556,9 @@ void nano::rpc_handler::process ()
 			auto hash (block->hash ());
 			node.block_arrival.add (hash);
 			nano::process_return result;
-			{
-				auto transaction (node.store.tx_begin_write ());
-				result = node.block_processor.process_one (transaction, block, std::chrono::steady_clock::time_point ());
-			}
+			node.write_scheduler.run (nano::write_priority::live, [this, &block, &result](nano::transaction const & transaction_a) {
+				result = node.block_processor.process_one (transaction_a, block, std::chrono::steady_clock::time_point ());
+			});
 			switch (result.code)
 			{
 				case nano::process_result::progress:
@@ -2968,6 +3083,7 @@ void nano::rpc_handler::stats ()
 {
 	auto sink = node.stats.log_sink_json ();
 	std::string type (request.get<std::string> ("type", ""));
+	auto use_sink (true);
 	if (type == "counters")
 	{
 		node.stats.log_counters (*sink);
@@ -2976,11 +3092,41 @@ void nano::rpc_handler::stats ()
 	{
 		node.stats.log_samples (*sink);
 	}
+	else if (type == "store")
+	{
+		auto counts (node.store.tx_counts ());
+		response_l.put ("type", "store");
+		response_l.put ("read_begin", std::to_string (counts.begin));
+		response_l.put ("read_renew", std::to_string (counts.renew));
+		response_l.put ("read_refresh", std::to_string (counts.refresh));
+		use_sink = false;
+	}
+	else if (type == "histograms")
+	{
+		// Percentiles are in the unit of the histogram, microseconds for RPC latencies
+		boost::property_tree::ptree entries;
+		auto add_entry ([&entries](std::string const & type_a, std::string const & detail_a, nano::stat_histogram const & histogram_a) {
+			boost::property_tree::ptree entry;
+			entry.put ("type", type_a);
+			entry.put ("detail", detail_a);
+			entry.put ("count", std::to_string (histogram_a.count));
+			entry.put ("p50", std::to_string (histogram_a.percentile (0.50)));
+			entry.put ("p90", std::to_string (histogram_a.percentile (0.90)));
+			entry.put ("p99", std::to_string (histogram_a.percentile (0.99)));
+			entry.put ("max", std::to_string (histogram_a.max));
+			entries.push_back (std::make_pair ("", entry));
+		});
+		node.stats.histograms (add_entry);
+		add_entry ("alarm", "late", node.alarm.lateness ());
+		response_l.put ("type", "histograms");
+		response_l.add_child ("entries", entries);
+		use_sink = false;
+	}
 	else
 	{
 		ec = nano::error_rpc::invalid_missing_type;
 	}
-	if (!ec)
+	if (!ec && use_sink)
 	{
 		response (*static_cast<boost::property_tree::ptree *> (sink->to_object ()));
 	}
@@ -3010,18 +3156,30 @@ void nano::rpc_handler::unchecked ()
 	auto count (count_optional_impl ());
 	if (!ec)
 	{
-		boost::property_tree::ptree unchecked;
+		std::string json;
+		nano::json_writer writer (json);
+		writer.begin_object ("blocks");
+		// A block waiting on several dependencies is listed once
+		std::unordered_set<nano::block_hash> written;
 		auto transaction (node.store.tx_begin_read ());
-		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n && unchecked.size () < count; ++i)
+		for (auto i (node.store.unchecked_begin (transaction)), n (node.store.unchecked_end ()); i != n && writer.size () < count; ++i)
 		{
 			auto block (i->second);
-			std::string contents;
-			block->serialize_json (contents);
-			unchecked.put (block->hash ().to_string (), contents);
+			if (written.insert (block->hash ()).second)
+			{
+				std::string contents;
+				block->serialize_json (contents);
+				writer.put (block->hash ().to_string (), contents);
+			}
 		}
-		response_l.add_child ("blocks", unchecked);
+		writer.end ();
+		writer.end ();
+		response_json (std::move (json));
+	}
+	else
+	{
+		response_errors ();
 	}
-	response_errors ();
 }
 
 void nano::rpc_handler::unchecked_clear ()
@@ -3029,8 +3187,9 @@ void nano::rpc_handler::unchecked_clear ()
 	rpc_control_impl ();
 	if (!ec)
 	{
-		auto transaction (node.store.tx_begin_write ());
-		node.store.unchecked_clear (transaction);
+		node.write_scheduler.run (nano::write_priority::maintenance, [this](nano::transaction const & transaction_a) {
+			node.store.unchecked_clear (transaction_a);
+		});
 		response_l.put ("success", "");
 	}
 	response_errors ();
@@ -3407,7 +3566,9 @@ void nano::rpc_handler::wallet_ledger ()
 	auto wallet (wallet_impl ());
 	if (!ec)
 	{
-		boost::property_tree::ptree accounts;
+		std::string json;
+		nano::json_writer writer (json);
+		writer.begin_object ("accounts");
 		auto transaction (node.wallets.tx_begin_read ());
 		auto block_transaction (node.store.tx_begin_read ());
 		for (auto i (wallet->store.begin (transaction)), n (wallet->store.end ()); i != n; ++i)
@@ -3418,38 +3579,43 @@ void nano::rpc_handler::wallet_ledger ()
 			{
 				if (info.modified >= modified_since)
 				{
-					boost::property_tree::ptree entry;
-					entry.put ("frontier", info.head.to_string ());
-					entry.put ("open_block", info.open_block.to_string ());
-					entry.put ("representative_block", info.rep_block.to_string ());
+					writer.begin_object (account.to_account ());
+					writer.put ("frontier", info.head.to_string ());
+					writer.put ("open_block", info.open_block.to_string ());
+					writer.put ("representative_block", info.rep_block.to_string ());
 					std::string balance;
 					nano::uint128_union (info.balance).encode_dec (balance);
-					entry.put ("balance", balance);
-					entry.put ("modified_timestamp", std::to_string (info.modified));
-					entry.put ("block_count", std::to_string (info.block_count));
+					writer.put ("balance", balance);
+					writer.put ("modified_timestamp", std::to_string (info.modified));
+					writer.put ("block_count", std::to_string (info.block_count));
 					if (representative)
 					{
 						auto block (node.store.block_get (block_transaction, info.rep_block));
 						assert (block != nullptr);
-						entry.put ("representative", block->representative ().to_account ());
+						writer.put ("representative", block->representative ().to_account ());
 					}
 					if (weight)
 					{
 						auto account_weight (node.ledger.weight (block_transaction, account));
-						entry.put ("weight", account_weight.convert_to<std::string> ());
+						writer.put ("weight", account_weight.convert_to<std::string> ());
 					}
 					if (pending)
 					{
 						auto account_pending (node.ledger.account_pending (block_transaction, account));
-						entry.put ("pending", account_pending.convert_to<std::string> ());
+						writer.put ("pending", account_pending.convert_to<std::string> ());
 					}
-					accounts.push_back (std::make_pair (account.to_account (), entry));
+					writer.end ();
 				}
 			}
 		}
-		response_l.add_child ("accounts", accounts);
+		writer.end ();
+		writer.end ();
+		response_json (std::move (json));
+	}
+	else
+	{
+		response_errors ();
 	}
-	response_errors ();
 }
 
 void nano::rpc_handler::wallet_lock ()
@@ -3682,7 +3848,12 @@ void nano::rpc_handler::work_generate ()
 				error_response (rpc_l->response, "Cancelled");
 			}
 		};
-		if (!use_peers)
+		auto cached (node.work_cache.get (hash));
+		if (cached)
+		{
+			callback (cached);
+		}
+		else if (!use_peers)
 		{
 			node.work.generate (hash, callback);
 		}
@@ -3815,10 +3986,98 @@ void nano::rpc_handler::work_peers_clear ()
 	response_errors ();
 }
 
+void nano::rpc_handler::work_queue ()
+{
+	rpc_control_impl ();
+	if (!ec)
+	{
+		auto priority_name ([](nano::work_priority priority_a) {
+			return std::string (priority_a == nano::work_priority::interactive ? "interactive" : "background");
+		});
+		auto now (std::chrono::steady_clock::now ());
+		std::array<size_t, 2> depth{ { 0, 0 } };
+		boost::property_tree::ptree queue_l;
+		std::lock_guard<std::mutex> lock (node.work.mutex);
+		// In the order requests are scheduled
+		for (auto & item : node.work.pending.get<0> ())
+		{
+			++depth[static_cast<size_t> (item->priority)];
+			boost::property_tree::ptree entry;
+			entry.put ("root", item->item.to_string ());
+			entry.put ("difficulty", nano::to_string_hex (item->difficulty));
+			entry.put ("priority", priority_name (item->priority));
+			entry.put ("queued_ms", std::to_string (std::chrono::duration_cast<std::chrono::milliseconds> (now - item->queued).count ()));
+			// Negative once the deadline has passed
+			entry.put ("deadline_ms", std::to_string (std::chrono::duration_cast<std::chrono::milliseconds> (item->deadline - now).count ()));
+			entry.put ("threads", std::to_string (item->workers));
+			queue_l.push_back (std::make_pair ("", entry));
+		}
+		for (auto priority : { nano::work_priority::interactive, nano::work_priority::background })
+		{
+			auto & metrics (node.work.metrics[static_cast<size_t> (priority)]);
+			boost::property_tree::ptree entry;
+			entry.put ("depth", std::to_string (depth[static_cast<size_t> (priority)]));
+			entry.put ("solved", std::to_string (metrics.solved));
+			entry.put ("cancelled", std::to_string (metrics.cancelled));
+			// Time to solution in microseconds
+			entry.put ("average", std::to_string (metrics.solved != 0 ? metrics.total.count () / metrics.solved : 0));
+			entry.put ("max", std::to_string (metrics.max.count ()));
+			response_l.add_child (priority_name (priority), entry);
+		}
+		response_l.put ("threads", std::to_string (node.work.threads.size ()));
+		response_l.add_child ("queue", queue_l);
+	}
+	response_errors ();
+}
+
+void nano::rpc_handler::work_watch_add ()
+{
+	rpc_control_impl ();
+	auto account (account_impl ());
+	if (!ec)
+	{
+		node.work_cache.watch (account);
+		response_l.put ("success", "");
+	}
+	response_errors ();
+}
+
+void nano::rpc_handler::work_watch_list ()
+{
+	rpc_control_impl ();
+	if (!ec)
+	{
+		boost::property_tree::ptree accounts;
+		for (auto & account : node.work_cache.watched ())
+		{
+			boost::property_tree::ptree entry;
+			entry.put ("", account.to_account ());
+			accounts.push_back (std::make_pair ("", entry));
+		}
+		response_l.add_child ("accounts", accounts);
+	}
+	response_errors ();
+}
+
+void nano::rpc_handler::work_watch_remove ()
+{
+	rpc_control_impl ();
+	auto account (account_impl ());
+	if (!ec)
+	{
+		node.work_cache.unwatch (account);
+		response_l.put ("success", "");
+	}
+	response_errors ();
+}
+
 nano::rpc_connection::rpc_connection (nano::node & node_a, nano::rpc & rpc_a) :
 node (node_a.shared ()),
 rpc (rpc_a),
-socket (node_a.io_ctx)
+socket (node_a.io_ctx),
+requests (0),
+keep_alive (false),
+cutoff (std::numeric_limits<uint64_t>::max ())
 {
 	responded.clear ();
 }
@@ -3832,13 +4091,15 @@ void nano::rpc_connection::write_result (std::string body, unsigned version)
 {
 	if (!responded.test_and_set ())
 	{
+		// A connection is only kept open while it can be registered as idle, registration is released once the next request arrives
+		keep_alive = request.keep_alive () && requests < rpc.config.max_requests_per_connection && rpc.idle_add (shared_from_this ());
 		res.set ("Content-Type", "application/json");
 		res.set ("Access-Control-Allow-Origin", "*");
 		res.set ("Access-Control-Allow-Headers", "Accept, Accept-Language, Content-Language, Content-Type");
-		res.set ("Connection", "close");
 		res.result (boost::beast::http::status::ok);
-		res.body () = body;
+		res.body () = std::move (body);
 		res.version (version);
+		res.keep_alive (keep_alive);
 		res.prepare_payload ();
 	}
 	else
@@ -3848,48 +4109,121 @@ void nano::rpc_connection::write_result (std::string body, unsigned version)
 	}
 }
 
+void nano::rpc_connection::write_response ()
+{
+	auto this_l (shared_from_this ());
+	boost::beast::http::async_write (socket, res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		if (!ec && this_l->keep_alive)
+		{
+			this_l->next_request ();
+		}
+		else
+		{
+			this_l->rpc.idle_remove (this_l.get ());
+			this_l->close ();
+		}
+	});
+}
+
 void nano::rpc_connection::read ()
 {
 	auto this_l (shared_from_this ());
 	boost::beast::http::async_read (socket, buffer, request, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		if (this_l->requests > 0)
+		{
+			this_l->rpc.idle_remove (this_l.get ());
+		}
 		if (!ec)
 		{
+			this_l->cutoff = std::numeric_limits<uint64_t>::max ();
 			this_l->node->background ([this_l]() {
-				auto start (std::chrono::steady_clock::now ());
-				auto version (this_l->request.version ());
-				std::string request_id (boost::str (boost::format ("%1%") % boost::io::group (std::hex, std::showbase, reinterpret_cast<uintptr_t> (this_l.get ()))));
-				auto response_handler ([this_l, version, start, request_id](boost::property_tree::ptree const & tree_a) {
-					std::stringstream ostream;
-					boost::property_tree::write_json (ostream, tree_a);
-					ostream.flush ();
-					auto body (ostream.str ());
-					this_l->write_result (body, version);
-					boost::beast::http::async_write (this_l->socket, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
-					});
-
-					if (this_l->node->config.logging.log_rpc ())
-					{
-						BOOST_LOG (this_l->node->log) << boost::str (boost::format ("RPC request %2% completed in: %1% microseconds") % std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count () % request_id);
-					}
-				});
-				if (this_l->request.method () == boost::beast::http::verb::post)
-				{
-					auto handler (std::make_shared<nano::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), request_id, response_handler));
-					handler->process_request ();
-				}
-				else
-				{
-					error_response (response_handler, "Can only POST requests");
-				}
+				this_l->process_request ();
 			});
 		}
-		else
+		else if (ec != boost::beast::http::error::end_of_stream && ec != boost::asio::error::operation_aborted)
 		{
 			BOOST_LOG (this_l->node->log) << "RPC read error: " << ec.message ();
 		}
 	});
 }
 
+void nano::rpc_connection::process_request ()
+{
+	++requests;
+	auto start (std::chrono::steady_clock::now ());
+	auto version (request.version ());
+	std::string request_id (boost::str (boost::format ("%1%") % boost::io::group (std::hex, std::showbase, reinterpret_cast<uintptr_t> (this))));
+	auto this_l (shared_from_this ());
+	auto body_handler ([this_l, version, start, request_id](std::string body_a) {
+		this_l->write_result (std::move (body_a), version);
+		this_l->write_response ();
+
+		if (this_l->node->config.logging.log_rpc ())
+		{
+			BOOST_LOG (this_l->node->log) << boost::str (boost::format ("RPC request %2% completed in: %1% microseconds") % std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count () % request_id);
+		}
+	});
+	auto response_handler ([body_handler](boost::property_tree::ptree const & tree_a) {
+		std::stringstream ostream;
+		boost::property_tree::write_json (ostream, tree_a);
+		ostream.flush ();
+		body_handler (ostream.str ());
+	});
+	if (request.method () == boost::beast::http::verb::post)
+	{
+		auto handler (std::make_shared<nano::rpc_handler> (*node, rpc, request.body (), request_id, response_handler, body_handler));
+		handler->process_request ();
+	}
+	else
+	{
+		error_response (response_handler, "Can only POST requests");
+	}
+}
+
+void nano::rpc_connection::next_request ()
+{
+	// Pipelined requests already received stay in `buffer' and are read one at a time, so responses go out in request order
+	request = {};
+	res = {};
+	responded.clear ();
+	cutoff = (std::chrono::steady_clock::now () + rpc.config.keep_alive_timeout).time_since_epoch ().count ();
+	if (requests == 1)
+	{
+		checkup ();
+	}
+	read ();
+}
+
+void nano::rpc_connection::checkup ()
+{
+	// Wake up when an idle connection would expire, or one timeout from now while a request is being served
+	auto now (std::chrono::steady_clock::now ());
+	uint64_t cutoff_l (cutoff);
+	auto wakeup (cutoff_l != std::numeric_limits<uint64_t>::max () ? std::max (now, std::chrono::steady_clock::time_point (std::chrono::steady_clock::duration (cutoff_l))) : now + rpc.config.keep_alive_timeout);
+	std::weak_ptr<nano::rpc_connection> this_w (shared_from_this ());
+	node->alarm.add (wakeup, [this_w]() {
+		if (auto this_l = this_w.lock ())
+		{
+			uint64_t cutoff_l (this_l->cutoff);
+			if (cutoff_l != std::numeric_limits<uint64_t>::max () && cutoff_l <= static_cast<uint64_t> (std::chrono::steady_clock::now ().time_since_epoch ().count ()))
+			{
+				this_l->close ();
+			}
+			else
+			{
+				this_l->checkup ();
+			}
+		}
+	});
+}
+
+void nano::rpc_connection::close ()
+{
+	boost::system::error_code ignored;
+	socket.shutdown (boost::asio::ip::tcp::socket::shutdown_both, ignored);
+	socket.close (ignored);
+}
+
 namespace
 {
 std::string filter_request (boost::property_tree::ptree tree_a)
@@ -3929,6 +4263,140 @@ std::string filter_request (boost::property_tree::ptree tree_a)
 }
 }
 
+namespace
+{
+using rpc_handler_map = std::unordered_map<std::string, std::function<void(nano::rpc_handler &)>>;
+
+/** Maps each RPC action to its handler, built once so dispatch is a single lookup */
+rpc_handler_map create_rpc_handler_map ()
+{
+	rpc_handler_map result;
+	result.emplace ("account_balance", &nano::rpc_handler::account_balance);
+	result.emplace ("account_block_count", &nano::rpc_handler::account_block_count);
+	result.emplace ("account_count", &nano::rpc_handler::account_count);
+	result.emplace ("account_create", &nano::rpc_handler::account_create);
+	result.emplace ("account_get", &nano::rpc_handler::account_get);
+	result.emplace ("account_history", &nano::rpc_handler::account_history);
+	result.emplace ("account_info", &nano::rpc_handler::account_info);
+	result.emplace ("account_key", &nano::rpc_handler::account_key);
+	result.emplace ("account_list", &nano::rpc_handler::account_list);
+	result.emplace ("account_move", &nano::rpc_handler::account_move);
+	result.emplace ("account_remove", &nano::rpc_handler::account_remove);
+	result.emplace ("account_representative", &nano::rpc_handler::account_representative);
+	result.emplace ("account_representative_set", &nano::rpc_handler::account_representative_set);
+	result.emplace ("account_weight", &nano::rpc_handler::account_weight);
+	result.emplace ("accounts_balances", &nano::rpc_handler::accounts_balances);
+	result.emplace ("accounts_create", &nano::rpc_handler::accounts_create);
+	result.emplace ("accounts_frontiers", &nano::rpc_handler::accounts_frontiers);
+	result.emplace ("accounts_pending", &nano::rpc_handler::accounts_pending);
+	result.emplace ("available_supply", &nano::rpc_handler::available_supply);
+	result.emplace ("block", &nano::rpc_handler::block_info);
+	result.emplace ("block_info", &nano::rpc_handler::block_info);
+	result.emplace ("block_confirm", &nano::rpc_handler::block_confirm);
+	result.emplace ("blocks", &nano::rpc_handler::blocks);
+	result.emplace ("blocks_info", &nano::rpc_handler::blocks_info);
+	result.emplace ("block_account", &nano::rpc_handler::block_account);
+	result.emplace ("block_count", &nano::rpc_handler::block_count);
+	result.emplace ("block_count_type", &nano::rpc_handler::block_count_type);
+	result.emplace ("block_create", &nano::rpc_handler::block_create);
+	result.emplace ("block_hash", &nano::rpc_handler::block_hash);
+	result.emplace ("successors", [](nano::rpc_handler & handler_a) { handler_a.chain (true); });
+	result.emplace ("bootstrap", &nano::rpc_handler::bootstrap);
+	result.emplace ("bootstrap_any", &nano::rpc_handler::bootstrap_any);
+	result.emplace ("bootstrap_lazy", &nano::rpc_handler::bootstrap_lazy);
+	result.emplace ("bootstrap_status", &nano::rpc_handler::bootstrap_status);
+	result.emplace ("chain", [](nano::rpc_handler & handler_a) { handler_a.chain (); });
+	result.emplace ("delegators", &nano::rpc_handler::delegators);
+	result.emplace ("delegators_count", &nano::rpc_handler::delegators_count);
+	result.emplace ("deterministic_key", &nano::rpc_handler::deterministic_key);
+	result.emplace ("confirmation_active", &nano::rpc_handler::confirmation_active);
+	result.emplace ("confirmation_history", &nano::rpc_handler::confirmation_history);
+	result.emplace ("confirmation_info", &nano::rpc_handler::confirmation_info);
+	result.emplace ("confirmation_quorum", &nano::rpc_handler::confirmation_quorum);
+	result.emplace ("frontiers", &nano::rpc_handler::frontiers);
+	result.emplace ("frontier_count", &nano::rpc_handler::account_count);
+	result.emplace ("history", [](nano::rpc_handler & handler_a) { handler_a.request.put ("head", handler_a.request.get<std::string> ("hash")); handler_a.account_history (); });
+	result.emplace ("keepalive", &nano::rpc_handler::keepalive);
+	result.emplace ("key_create", &nano::rpc_handler::key_create);
+	result.emplace ("key_expand", &nano::rpc_handler::key_expand);
+	result.emplace ("krai_from_raw", [](nano::rpc_handler & handler_a) { handler_a.mrai_from_raw (nano::kxrb_ratio); });
+	result.emplace ("krai_to_raw", [](nano::rpc_handler & handler_a) { handler_a.mrai_to_raw (nano::kxrb_ratio); });
+	result.emplace ("ledger", &nano::rpc_handler::ledger);
+	result.emplace ("mrai_from_raw", [](nano::rpc_handler & handler_a) { handler_a.mrai_from_raw (); });
+	result.emplace ("mrai_to_raw", [](nano::rpc_handler & handler_a) { handler_a.mrai_to_raw (); });
+	result.emplace ("node_id", &nano::rpc_handler::node_id);
+	result.emplace ("node_id_delete", &nano::rpc_handler::node_id_delete);
+	result.emplace ("password_change", &nano::rpc_handler::password_change);
+	result.emplace ("password_enter", &nano::rpc_handler::password_enter);
+	result.emplace ("password_valid", [](nano::rpc_handler & handler_a) { handler_a.password_valid (); });
+	result.emplace ("payment_begin", &nano::rpc_handler::payment_begin);
+	result.emplace ("payment_init", &nano::rpc_handler::payment_init);
+	result.emplace ("payment_end", &nano::rpc_handler::payment_end);
+	result.emplace ("payment_wait", &nano::rpc_handler::payment_wait);
+	result.emplace ("peers", &nano::rpc_handler::peers);
+	result.emplace ("pending", &nano::rpc_handler::pending);
+	result.emplace ("pending_exists", &nano::rpc_handler::pending_exists);
+	result.emplace ("process", &nano::rpc_handler::process);
+	result.emplace ("nano_from_raw", [](nano::rpc_handler & handler_a) { handler_a.mrai_from_raw (nano::xrb_ratio); });
+	result.emplace ("nano_to_raw", [](nano::rpc_handler & handler_a) { handler_a.mrai_to_raw (nano::xrb_ratio); });
+	result.emplace ("receive", &nano::rpc_handler::receive);
+	result.emplace ("receive_minimum", &nano::rpc_handler::receive_minimum);
+	result.emplace ("receive_minimum_set", &nano::rpc_handler::receive_minimum_set);
+	result.emplace ("representatives", &nano::rpc_handler::representatives);
+	result.emplace ("representatives_online", &nano::rpc_handler::representatives_online);
+	result.emplace ("republish", &nano::rpc_handler::republish);
+	result.emplace ("search_pending", &nano::rpc_handler::search_pending);
+	result.emplace ("search_pending_all", &nano::rpc_handler::search_pending_all);
+	result.emplace ("send", &nano::rpc_handler::send);
+	result.emplace ("stats", &nano::rpc_handler::stats);
+	result.emplace ("stop", &nano::rpc_handler::stop);
+	result.emplace ("unchecked", &nano::rpc_handler::unchecked);
+	result.emplace ("unchecked_clear", &nano::rpc_handler::unchecked_clear);
+	result.emplace ("unchecked_get", &nano::rpc_handler::unchecked_get);
+	result.emplace ("unchecked_keys", &nano::rpc_handler::unchecked_keys);
+	result.emplace ("uptime", &nano::rpc_handler::uptime);
+	result.emplace ("validate_account_number", &nano::rpc_handler::validate_account_number);
+	result.emplace ("version", &nano::rpc_handler::version);
+	result.emplace ("wallet_add", &nano::rpc_handler::wallet_add);
+	result.emplace ("wallet_add_watch", &nano::rpc_handler::wallet_add_watch);
+	// Obsolete
+	result.emplace ("wallet_balance_total", &nano::rpc_handler::wallet_info);
+	result.emplace ("wallet_balances", &nano::rpc_handler::wallet_balances);
+	result.emplace ("wallet_change_seed", &nano::rpc_handler::wallet_change_seed);
+	result.emplace ("wallet_contains", &nano::rpc_handler::wallet_contains);
+	result.emplace ("wallet_create", &nano::rpc_handler::wallet_create);
+	result.emplace ("wallet_destroy", &nano::rpc_handler::wallet_destroy);
+	result.emplace ("wallet_export", &nano::rpc_handler::wallet_export);
+	result.emplace ("wallet_frontiers", &nano::rpc_handler::wallet_frontiers);
+	result.emplace ("wallet_info", &nano::rpc_handler::wallet_info);
+	result.emplace ("wallet_key_valid", &nano::rpc_handler::wallet_key_valid);
+	result.emplace ("wallet_ledger", &nano::rpc_handler::wallet_ledger);
+	result.emplace ("wallet_lock", &nano::rpc_handler::wallet_lock);
+	result.emplace ("wallet_locked", [](nano::rpc_handler & handler_a) { handler_a.password_valid (true); });
+	result.emplace ("wallet_pending", &nano::rpc_handler::wallet_pending);
+	result.emplace ("wallet_representative", &nano::rpc_handler::wallet_representative);
+	result.emplace ("wallet_representative_set", &nano::rpc_handler::wallet_representative_set);
+	result.emplace ("wallet_republish", &nano::rpc_handler::wallet_republish);
+	result.emplace ("wallet_unlock", &nano::rpc_handler::password_enter);
+	result.emplace ("wallet_work_get", &nano::rpc_handler::wallet_work_get);
+	result.emplace ("work_generate", &nano::rpc_handler::work_generate);
+	result.emplace ("work_cancel", &nano::rpc_handler::work_cancel);
+	result.emplace ("work_get", &nano::rpc_handler::work_get);
+	result.emplace ("work_set", &nano::rpc_handler::work_set);
+	result.emplace ("work_validate", &nano::rpc_handler::work_validate);
+	result.emplace ("work_peer_add", &nano::rpc_handler::work_peer_add);
+	result.emplace ("work_peers", &nano::rpc_handler::work_peers);
+	result.emplace ("work_peers_clear", &nano::rpc_handler::work_peers_clear);
+	result.emplace ("work_queue", &nano::rpc_handler::work_queue);
+	result.emplace ("work_watch_add", &nano::rpc_handler::work_watch_add);
+	result.emplace ("work_watch_list", &nano::rpc_handler::work_watch_list);
+	result.emplace ("work_watch_remove", &nano::rpc_handler::work_watch_remove);
+	return result;
+}
+
+rpc_handler_map const rpc_handlers (create_rpc_handler_map ());
+}
+
 void nano::rpc_handler::process_request ()
 {
 	try
@@ -3960,467 +4428,26 @@ void nano::rpc_handler::process_request ()
 			{
 				BOOST_LOG (node.log) << boost::str (boost::format ("%1% ") % request_id) << filter_request (request);
 			}
-			if (action == "account_balance")
-			{
-				account_balance ();
-			}
-			else if (action == "account_block_count")
-			{
-				account_block_count ();
-			}
-			else if (action == "account_count")
-			{
-				account_count ();
-			}
-			else if (action == "account_create")
+			auto handler_l (rpc_handlers.find (action));
+			if (handler_l != rpc_handlers.end ())
 			{
-				account_create ();
-			}
-			else if (action == "account_get")
-			{
-				account_get ();
-			}
-			else if (action == "account_history")
-			{
-				account_history ();
-			}
-			else if (action == "account_info")
-			{
-				account_info ();
-			}
-			else if (action == "account_key")
-			{
-				account_key ();
-			}
-			else if (action == "account_list")
-			{
-				account_list ();
-			}
-			else if (action == "account_move")
-			{
-				account_move ();
-			}
-			else if (action == "account_remove")
-			{
-				account_remove ();
-			}
-			else if (action == "account_representative")
-			{
-				account_representative ();
-			}
-			else if (action == "account_representative_set")
-			{
-				account_representative_set ();
-			}
-			else if (action == "account_weight")
-			{
-				account_weight ();
-			}
-			else if (action == "accounts_balances")
-			{
-				accounts_balances ();
-			}
-			else if (action == "accounts_create")
-			{
-				accounts_create ();
-			}
-			else if (action == "accounts_frontiers")
-			{
-				accounts_frontiers ();
-			}
-			else if (action == "accounts_pending")
-			{
-				accounts_pending ();
-			}
-			else if (action == "available_supply")
-			{
-				available_supply ();
-			}
-			else if (action == "block")
-			{
-				block_info ();
-			}
-			else if (action == "block_info")
-			{
-				block_info ();
-			}
-			else if (action == "block_confirm")
-			{
-				block_confirm ();
-			}
-			else if (action == "blocks")
-			{
-				blocks ();
-			}
-			else if (action == "blocks_info")
-			{
-				blocks_info ();
-			}
-			else if (action == "block_account")
-			{
-				block_account ();
-			}
-			else if (action == "block_count")
-			{
-				block_count ();
-			}
-			else if (action == "block_count_type")
-			{
-				block_count_type ();
-			}
-			else if (action == "block_create")
-			{
-				block_create ();
-			}
-			else if (action == "block_hash")
-			{
-				block_hash ();
-			}
-			else if (action == "successors")
-			{
-				chain (true);
-			}
-			else if (action == "bootstrap")
-			{
-				bootstrap ();
-			}
-			else if (action == "bootstrap_any")
-			{
-				bootstrap_any ();
-			}
-			else if (action == "bootstrap_lazy")
-			{
-				bootstrap_lazy ();
-			}
-			else if (action == "bootstrap_status")
-			{
-				bootstrap_status ();
-			}
-			else if (action == "chain")
-			{
-				chain ();
-			}
-			else if (action == "delegators")
-			{
-				delegators ();
-			}
-			else if (action == "delegators_count")
-			{
-				delegators_count ();
-			}
-			else if (action == "deterministic_key")
-			{
-				deterministic_key ();
-			}
-			else if (action == "confirmation_active")
-			{
-				confirmation_active ();
-			}
-			else if (action == "confirmation_history")
-			{
-				confirmation_history ();
-			}
-			else if (action == "confirmation_info")
-			{
-				confirmation_info ();
-			}
-			else if (action == "confirmation_quorum")
-			{
-				confirmation_quorum ();
-			}
-			else if (action == "frontiers")
-			{
-				frontiers ();
-			}
-			else if (action == "frontier_count")
-			{
-				account_count ();
-			}
-			else if (action == "history")
-			{
-				request.put ("head", request.get<std::string> ("hash"));
-				account_history ();
-			}
-			else if (action == "keepalive")
-			{
-				keepalive ();
-			}
-			else if (action == "key_create")
-			{
-				key_create ();
-			}
-			else if (action == "key_expand")
-			{
-				key_expand ();
-			}
-			else if (action == "krai_from_raw")
-			{
-				mrai_from_raw (nano::kxrb_ratio);
-			}
-			else if (action == "krai_to_raw")
-			{
-				mrai_to_raw (nano::kxrb_ratio);
-			}
-			else if (action == "ledger")
-			{
-				ledger ();
-			}
-			else if (action == "mrai_from_raw")
-			{
-				mrai_from_raw ();
-			}
-			else if (action == "mrai_to_raw")
-			{
-				mrai_to_raw ();
-			}
-			else if (action == "node_id")
-			{
-				node_id ();
-			}
-			else if (action == "node_id_delete")
-			{
-				node_id_delete ();
-			}
-			else if (action == "password_change")
-			{
-				password_change ();
-			}
-			else if (action == "password_enter")
-			{
-				password_enter ();
-			}
-			else if (action == "password_valid")
-			{
-				password_valid ();
-			}
-			else if (action == "payment_begin")
-			{
-				payment_begin ();
-			}
-			else if (action == "payment_init")
-			{
-				payment_init ();
-			}
-			else if (action == "payment_end")
-			{
-				payment_end ();
-			}
-			else if (action == "payment_wait")
-			{
-				payment_wait ();
-			}
-			else if (action == "peers")
-			{
-				peers ();
-			}
-			else if (action == "pending")
-			{
-				pending ();
-			}
-			else if (action == "pending_exists")
-			{
-				pending_exists ();
-			}
-			else if (action == "process")
-			{
-				process ();
-			}
-			else if (action == "nano_from_raw")
-			{
-				mrai_from_raw (nano::xrb_ratio);
-			}
-			else if (action == "nano_to_raw")
-			{
-				mrai_to_raw (nano::xrb_ratio);
-			}
-			else if (action == "receive")
-			{
-				receive ();
-			}
-			else if (action == "receive_minimum")
-			{
-				receive_minimum ();
-			}
-			else if (action == "receive_minimum_set")
-			{
-				receive_minimum_set ();
-			}
-			else if (action == "representatives")
-			{
-				representatives ();
-			}
-			else if (action == "representatives_online")
-			{
-				representatives_online ();
-			}
-			else if (action == "republish")
-			{
-				republish ();
-			}
-			else if (action == "search_pending")
-			{
-				search_pending ();
-			}
-			else if (action == "search_pending_all")
-			{
-				search_pending_all ();
-			}
-			else if (action == "send")
-			{
-				send ();
-			}
-			else if (action == "stats")
-			{
-				stats ();
-			}
-			else if (action == "stop")
-			{
-				stop ();
-			}
-			else if (action == "unchecked")
-			{
-				unchecked ();
-			}
-			else if (action == "unchecked_clear")
-			{
-				unchecked_clear ();
-			}
-			else if (action == "unchecked_get")
-			{
-				unchecked_get ();
-			}
-			else if (action == "unchecked_keys")
-			{
-				unchecked_keys ();
-			}
-			else if (action == "uptime")
-			{
-				uptime ();
-			}
-			else if (action == "validate_account_number")
-			{
-				validate_account_number ();
-			}
-			else if (action == "version")
-			{
-				version ();
-			}
-			else if (action == "wallet_add")
-			{
-				wallet_add ();
-			}
-			else if (action == "wallet_add_watch")
-			{
-				wallet_add_watch ();
-			}
-			// Obsolete
-			else if (action == "wallet_balance_total")
-			{
-				wallet_info ();
-			}
-			else if (action == "wallet_balances")
-			{
-				wallet_balances ();
-			}
-			else if (action == "wallet_change_seed")
-			{
-				wallet_change_seed ();
-			}
-			else if (action == "wallet_contains")
-			{
-				wallet_contains ();
-			}
-			else if (action == "wallet_create")
-			{
-				wallet_create ();
-			}
-			else if (action == "wallet_destroy")
-			{
-				wallet_destroy ();
-			}
-			else if (action == "wallet_export")
-			{
-				wallet_export ();
-			}
-			else if (action == "wallet_frontiers")
-			{
-				wallet_frontiers ();
-			}
-			else if (action == "wallet_info")
-			{
-				wallet_info ();
-			}
-			else if (action == "wallet_key_valid")
-			{
-				wallet_key_valid ();
-			}
-			else if (action == "wallet_ledger")
-			{
-				wallet_ledger ();
-			}
-			else if (action == "wallet_lock")
-			{
-				wallet_lock ();
-			}
-			else if (action == "wallet_locked")
-			{
-				password_valid (true);
-			}
-			else if (action == "wallet_pending")
-			{
-				wallet_pending ();
-			}
-			else if (action == "wallet_representative")
-			{
-				wallet_representative ();
-			}
-			else if (action == "wallet_representative_set")
-			{
-				wallet_representative_set ();
-			}
-			else if (action == "wallet_republish")
-			{
-				wallet_republish ();
-			}
-			else if (action == "wallet_unlock")
-			{
-				password_enter ();
-			}
-			else if (action == "wallet_work_get")
-			{
-				wallet_work_get ();
-			}
-			else if (action == "work_generate")
-			{
-				work_generate ();
-			}
-			else if (action == "work_cancel")
-			{
-				work_cancel ();
-			}
-			else if (action == "work_get")
-			{
-				work_get ();
-			}
-			else if (action == "work_set")
-			{
-				work_set ();
-			}
-			else if (action == "work_validate")
-			{
-				work_validate ();
-			}
-			else if (action == "work_peer_add")
-			{
-				work_peer_add ();
-			}
-			else if (action == "work_peers")
-			{
-				work_peers ();
-			}
-			else if (action == "work_peers_clear")
-			{
-				work_peers_clear ();
+				// Latency is recorded when the response is sent so handlers which respond asynchronously are measured too
+				auto start (std::chrono::steady_clock::now ());
+				auto node_l (node.shared ());
+				auto record ([node_l, action, start]() {
+					node_l->stats.add_histogram (nano::stat::type::rpc, action, std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count ());
+				});
+				auto response_a (response);
+				response = [response_a, record](boost::property_tree::ptree const & tree_a) {
+					record ();
+					response_a (tree_a);
+				};
+				auto response_body_a (response_body);
+				response_body = [response_body_a, record](std::string body_a) {
+					record ();
+					response_body_a (std::move (body_a));
+				};
+				handler_l->second (*this);
 			}
 			else
 			{
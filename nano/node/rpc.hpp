@@ -51,6 +51,12 @@ public:
 	uint64_t chain_request_limit;
 	rpc_secure_config secure;
 	uint8_t max_json_depth;
+	/** Time a persistent connection may wait for its next request before it is closed */
+	std::chrono::seconds keep_alive_timeout;
+	/** Requests served on a single connection before it is closed */
+	unsigned max_requests_per_connection;
+	/** Persistent connections allowed to wait for a next request at once, 0 disables keep-alive */
+	unsigned max_idle_connections;
 };
 enum class payment_status
 {
@@ -64,6 +70,7 @@ enum class payment_status
 };
 class wallet;
 class payment_observer;
+class rpc_connection;
 class rpc
 {
 public:
@@ -73,9 +80,15 @@ public:
 	virtual void accept ();
 	void stop ();
 	void observer_action (nano::account const &);
+	/** Registers a connection waiting for its next request, returns false if the idle connection limit is reached */
+	bool idle_add (std::shared_ptr<nano::rpc_connection> const &);
+	void idle_remove (nano::rpc_connection *);
 	boost::asio::ip::tcp::acceptor acceptor;
 	std::mutex mutex;
 	std::unordered_map<nano::account, std::shared_ptr<nano::payment_observer>> payment_observers;
+	std::mutex idle_mutex;
+	std::unordered_map<nano::rpc_connection *, std::weak_ptr<nano::rpc_connection>> idle_connections;
+	bool stopped;
 	nano::rpc_config config;
 	nano::node & node;
 	bool on;
@@ -89,6 +102,15 @@ public:
 	virtual void parse_connection ();
 	virtual void read ();
 	virtual void write_result (std::string body, unsigned version);
+	/** Sends `res' and either waits for the next request or closes the connection */
+	virtual void write_response ();
+	/** Handles the request just read, called from a background thread */
+	void process_request ();
+	/** Resets the request state and reads the next request on a persistent connection */
+	void next_request ();
+	/** Closes connections which stay idle past the keep-alive timeout */
+	void checkup ();
+	void close ();
 	std::shared_ptr<nano::node> node;
 	nano::rpc & rpc;
 	boost::asio::ip::tcp::socket socket;
@@ -96,6 +118,12 @@ public:
 	boost::beast::http::request<boost::beast::http::string_body> request;
 	boost::beast::http::response<boost::beast::http::string_body> res;
 	std::atomic_flag responded;
+	/** Requests read on this connection, requests are answered one at a time so pipelined responses keep their order */
+	std::atomic<unsigned> requests;
+	/** Set by write_result when the connection stays open after the response */
+	bool keep_alive;
+	/** Steady clock tick after which an idle connection is closed, max while a request is being served */
+	std::atomic<uint64_t> cutoff;
 };
 class payment_observer : public std::enable_shared_from_this<nano::payment_observer>
 {
@@ -117,7 +145,7 @@ public:
 class rpc_handler : public std::enable_shared_from_this<nano::rpc_handler>
 {
 public:
-	rpc_handler (nano::node &, nano::rpc &, std::string const &, std::string const &, std::function<void(boost::property_tree::ptree const &)> const &);
+	rpc_handler (nano::node &, nano::rpc &, std::string const &, std::string const &, std::function<void(boost::property_tree::ptree const &)> const &, std::function<void(std::string)> const &);
 	void process_request ();
 	void account_balance ();
 	void account_block_count ();
@@ -224,13 +252,21 @@ public:
 	void work_peer_add ();
 	void work_peers ();
 	void work_peers_clear ();
+	void work_queue ();
+	void work_watch_add ();
+	void work_watch_list ();
+	void work_watch_remove ();
 	std::string body;
 	std::string request_id;
 	nano::node & node;
 	nano::rpc & rpc;
 	boost::property_tree::ptree request;
 	std::function<void(boost::property_tree::ptree const &)> response;
+	/** Receives a response body which is already serialized */
+	std::function<void(std::string)> response_body;
 	void response_errors ();
+	/** Sends a body written with nano::json_writer, or the error response if ec is set */
+	void response_json (std::string);
 	std::error_code ec;
 	boost::property_tree::ptree response_l;
 	std::shared_ptr<nano::wallet> wallet_impl ();
@@ -132,7 +132,7 @@ void nano::rpc_connection_secure::parse_connection ()
 
 void nano::rpc_connection_secure::on_shutdown (const boost::system::error_code & error)
 {
-	// No-op. We initiate the shutdown (since the RPC server kills the connection after each request)
+	// No-op. We initiate the shutdown (when the connection isn't kept alive after a response)
 	// and we'll thus get an expected EOF error. If the client disconnects, a short-read error will be expected.
 }
 
@@ -152,45 +152,39 @@ void nano::rpc_connection_secure::read ()
 {
 	auto this_l (std::static_pointer_cast<nano::rpc_connection_secure> (shared_from_this ()));
 	boost::beast::http::async_read (stream, buffer, request, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		if (this_l->requests > 0)
+		{
+			this_l->rpc.idle_remove (this_l.get ());
+		}
 		if (!ec)
 		{
+			this_l->cutoff = std::numeric_limits<uint64_t>::max ();
 			this_l->node->background ([this_l]() {
-				auto start (std::chrono::steady_clock::now ());
-				auto version (this_l->request.version ());
-				std::string request_id (boost::str (boost::format ("%1%") % boost::io::group (std::hex, std::showbase, reinterpret_cast<uintptr_t> (this_l.get ()))));
-				auto response_handler ([this_l, version, start, request_id](boost::property_tree::ptree const & tree_a) {
-					std::stringstream ostream;
-					boost::property_tree::write_json (ostream, tree_a);
-					ostream.flush ();
-					auto body (ostream.str ());
-					this_l->write_result (body, version);
-					boost::beast::http::async_write (this_l->stream, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
-						// Perform the SSL shutdown
-						this_l->stream.async_shutdown ([this_l](auto const & ec_shutdown) {
-							this_l->on_shutdown (ec_shutdown);
-						});
-					});
-
-					if (this_l->node->config.logging.log_rpc ())
-					{
-						BOOST_LOG (this_l->node->log) << boost::str (boost::format ("TLS: RPC request %2% completed in: %1% microseconds") % std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - start).count () % request_id);
-					}
-				});
-
-				if (this_l->request.method () == boost::beast::http::verb::post)
-				{
-					auto handler (std::make_shared<nano::rpc_handler> (*this_l->node, this_l->rpc, this_l->request.body (), request_id, response_handler));
-					handler->process_request ();
-				}
-				else
-				{
-					error_response (response_handler, "Can only POST requests");
-				}
+				this_l->process_request ();
 			});
 		}
-		else
+		else if (ec != boost::beast::http::error::end_of_stream && ec != boost::asio::error::operation_aborted)
 		{
 			BOOST_LOG (this_l->node->log) << "TLS: Read error: " << ec.message () << std::endl;
 		}
 	});
 }
+
+void nano::rpc_connection_secure::write_response ()
+{
+	auto this_l (std::static_pointer_cast<nano::rpc_connection_secure> (shared_from_this ()));
+	boost::beast::http::async_write (stream, res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+		if (!ec && this_l->keep_alive)
+		{
+			this_l->next_request ();
+		}
+		else
+		{
+			this_l->rpc.idle_remove (this_l.get ());
+			// Perform the SSL shutdown
+			this_l->stream.async_shutdown ([this_l](auto const & ec_shutdown) {
+				this_l->on_shutdown (ec_shutdown);
+			});
+		}
+	});
+}
@@ -39,6 +39,7 @@ public:
 	rpc_connection_secure (nano::node &, nano::rpc_secure &);
 	void parse_connection () override;
 	void read () override;
+	void write_response () override;
 	/** The TLS handshake callback */
 	void handle_handshake (const boost::system::error_code & error);
 	/** The TLS async shutdown callback */
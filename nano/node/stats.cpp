@@ -3,6 +3,7 @@
 #include <boost/asio.hpp>
 #include <boost/format.hpp>
 #include <boost/property_tree/json_parser.hpp>
+#include <cmath>
 #include <ctime>
 #include <fstream>
 #include <iostream>
@@ -256,6 +257,25 @@ void nano::stat::log_samples_impl (stat_log_sink & sink)
 	sink.finalize ();
 }
 
+void nano::stat::add_histogram (stat::type type, std::string const & detail, uint64_t value)
+{
+	std::lock_guard<std::mutex> lock (histogram_mutex);
+	histogram_entries[std::make_pair (type, detail)].add (value);
+}
+
+void nano::stat::histograms (std::function<void(std::string const &, std::string const &, nano::stat_histogram const &)> const & action)
+{
+	std::vector<std::pair<std::pair<stat::type, std::string>, nano::stat_histogram>> snapshot;
+	{
+		std::lock_guard<std::mutex> lock (histogram_mutex);
+		snapshot.assign (histogram_entries.begin (), histogram_entries.end ());
+	}
+	for (auto & i : snapshot)
+	{
+		action (type_to_string (key_of (i.first.first, stat::detail::all, stat::dir::in)), i.first.second, i.second);
+	}
+}
+
 void nano::stat::update (uint32_t key_a, uint64_t value)
 {
 	static file_writer log_count (config.log_counters_filename);
@@ -352,6 +372,27 @@ std::string nano::stat::type_to_string (uint32_t key)
 		case nano::stat::type::message:
 			res = "message";
 			break;
+		case nano::stat::type::block_processor:
+			res = "block_processor";
+			break;
+		case nano::stat::type::block_uniquer:
+			res = "block_uniquer";
+			break;
+		case nano::stat::type::vote_uniquer:
+			res = "vote_uniquer";
+			break;
+		case nano::stat::type::rpc:
+			res = "rpc";
+			break;
+		case nano::stat::type::block_cache:
+			res = "block_cache";
+			break;
+		case nano::stat::type::account_cache:
+			res = "account_cache";
+			break;
+		case nano::stat::type::write_scheduler:
+			res = "write_scheduler";
+			break;
 	}
 	return res;
 }
@@ -410,6 +451,9 @@ std::string nano::stat::detail_to_string (uint32_t key)
 		case nano::stat::detail::initiate_wallet_lazy:
 			res = "initiate_wallet_lazy";
 			break;
+		case nano::stat::detail::timeout:
+			res = "timeout";
+			break;
 		case nano::stat::detail::insufficient_work:
 			res = "insufficient_work";
 			break;
@@ -488,6 +532,21 @@ std::string nano::stat::detail_to_string (uint32_t key)
 		case nano::stat::detail::outdated_version:
 			res = "outdated_version";
 			break;
+		case nano::stat::detail::signature_verification:
+			res = "signature_verification";
+			break;
+		case nano::stat::detail::ledger_apply:
+			res = "ledger_apply";
+			break;
+		case nano::stat::detail::hit:
+			res = "hit";
+			break;
+		case nano::stat::detail::miss:
+			res = "miss";
+			break;
+		case nano::stat::detail::eviction:
+			res = "eviction";
+			break;
 	}
 	return res;
 }
@@ -507,3 +566,57 @@ std::string nano::stat::dir_to_string (uint32_t key)
 	}
 	return res;
 }
+
+size_t constexpr nano::stat_histogram::bucket_count;
+
+void nano::stat_histogram::add (uint64_t value_a)
+{
+	++buckets[bucket_of (value_a)];
+	++count;
+	max = std::max (max, value_a);
+}
+
+uint64_t nano::stat_histogram::percentile (double fraction_a) const
+{
+	uint64_t result (0);
+	if (count > 0)
+	{
+		auto target (std::max<uint64_t> (1, static_cast<uint64_t> (std::ceil (fraction_a * count))));
+		uint64_t seen (0);
+		size_t bucket (0);
+		for (; bucket < bucket_count - 1 && seen + buckets[bucket] < target; ++bucket)
+		{
+			seen += buckets[bucket];
+		}
+		result = std::min (max, bucket_upper (bucket));
+	}
+	return result;
+}
+
+size_t nano::stat_histogram::bucket_of (uint64_t value_a)
+{
+	size_t result (value_a);
+	if (value_a >= 4)
+	{
+		// Bucket by the highest set bit and the two bits below it
+		size_t high (63);
+		while ((value_a >> high) == 0)
+		{
+			--high;
+		}
+		result = (high - 1) * 4 + ((value_a >> (high - 2)) & 3);
+	}
+	return result;
+}
+
+uint64_t nano::stat_histogram::bucket_upper (size_t bucket_a)
+{
+	uint64_t result (bucket_a);
+	if (bucket_a >= 4)
+	{
+		auto high (bucket_a / 4 + 1);
+		uint64_t lower ((4 + bucket_a % 4) << (high - 2));
+		result = lower + (uint64_t (1) << (high - 2)) - 1;
+	}
+	return result;
+}
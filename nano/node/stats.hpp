@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <boost/circular_buffer.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -106,6 +107,24 @@ public:
 	nano::observer_set<uint64_t, uint64_t> count_observers;
 };
 
+/**
+ * Histogram with four buckets per power of two, so percentiles are reported within 25% of the actual value.
+ * Memory use is fixed regardless of how many values are added.
+ */
+class stat_histogram
+{
+public:
+	static size_t constexpr bucket_count = 252;
+	void add (uint64_t);
+	/** Upper bound of the bucket reached by the given fraction of values, capped at max */
+	uint64_t percentile (double) const;
+	static size_t bucket_of (uint64_t);
+	static uint64_t bucket_upper (size_t);
+	uint64_t count{ 0 };
+	uint64_t max{ 0 };
+	std::array<uint64_t, bucket_count> buckets{ {} };
+};
+
 /** Log sink interface */
 class stat_log_sink
 {
@@ -188,7 +207,14 @@ public:
 		vote,
 		http_callback,
 		peering,
-		udp
+		udp,
+		block_processor,
+		block_uniquer,
+		vote_uniquer,
+		rpc,
+		block_cache,
+		account_cache,
+		write_scheduler
 	};
 
 	/** Optional detail type */
@@ -224,6 +250,9 @@ public:
 		initiate_lazy,
 		initiate_wallet_lazy,
 
+		// callback specific
+		timeout,
+
 		// bootstrap specific
 		bulk_pull,
 		bulk_push,
@@ -252,6 +281,15 @@ public:
 
 		// peering
 		handshake,
+
+		// block_processor, in is enqueued and out is dequeued for each pipeline stage
+		signature_verification,
+		ledger_apply,
+
+		// block_uniquer, vote_uniquer, block_cache, account_cache
+		hit,
+		miss,
+		eviction,
 	};
 
 	/** Direction of the stat. If the direction is irrelevant, use in */
@@ -388,6 +426,15 @@ public:
 	/** Log samples to the given log sink */
 	void log_samples (stat_log_sink & sink);
 
+	/**
+	 * Add \p value to the histogram for \p type and a free-form detail, such as the name of an RPC action.
+	 * Details are not limited to stat::detail so callers must only pass a bounded set of names.
+	 */
+	void add_histogram (stat::type type, std::string const & detail, uint64_t value);
+
+	/** Calls \p action with the type, detail and a snapshot of each histogram */
+	void histograms (std::function<void(std::string const &, std::string const &, nano::stat_histogram const &)> const & action);
+
 	/** Returns a new JSON log sink */
 	std::unique_ptr<stat_log_sink> log_sink_json ();
 
@@ -437,5 +484,9 @@ private:
 
 	/** All access to stat is thread safe, including calls from observers on the same thread */
 	std::mutex stat_mutex;
+
+	/** Histograms are updated on request paths, so they don't contend with stat_mutex */
+	std::map<std::pair<stat::type, std::string>, nano::stat_histogram> histogram_entries;
+	std::mutex histogram_mutex;
 };
 }
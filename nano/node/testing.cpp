@@ -354,6 +354,11 @@ void nano::system::stop ()
 	work.stop ();
 }
 
+void nano::store_downgrade::block_tables_split (nano::mdb_store & store_a, nano::transaction const & transaction_a)
+{
+	store_a.block_tables_split (transaction_a);
+}
+
 nano::landing_store::landing_store ()
 {
 }
@@ -46,6 +46,13 @@ public:
 	std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<double>> deadline{ std::chrono::steady_clock::time_point::max () };
 	double deadline_scaling_factor{ 1.0 };
 };
+/** Rewrites parts of a store in the layout of older versions, for building fixtures of the upgrades */
+class store_downgrade
+{
+public:
+	/** Moves blocks back to the per-type tables read before version 14 */
+	static void block_tables_split (nano::mdb_store &, nano::transaction const &);
+};
 class landing_store
 {
 public:
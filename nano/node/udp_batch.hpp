@@ -0,0 +1,38 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <functional>
+
+namespace nano
+{
+class udp_data;
+/** A datagram waiting to be sent, data must stay valid until callback is called */
+class udp_send
+{
+public:
+	uint8_t const * data;
+	size_t size;
+	boost::asio::ip::udp::endpoint endpoint;
+	std::function<void(boost::system::error_code const &, size_t)> callback;
+};
+/**
+ * Reads and writes several datagrams per system call where the platform supports it (recvmmsg and sendmmsg on Linux).
+ * Both calls are non-blocking and run directly on the socket's native handle.
+ */
+namespace udp_batch
+{
+	/** Returns false if the platform has no batched datagram calls, the other functions must not be used then */
+	bool supported ();
+	/**
+	 * Receives up to count_a datagrams of at most size_a bytes into data_a, setting the size and endpoint of each one filled.
+	 * Returns the number received, 0 with ec_a set to would_block if nothing is waiting.
+	 */
+	size_t receive (boost::asio::ip::udp::socket &, nano::udp_data * const * data_a, size_t count_a, size_t size_a, boost::system::error_code & ec_a);
+	/**
+	 * Sends up to count_a datagrams, returning how many were sent and setting their sizes in sent_a.
+	 * Like sendmmsg, an error is only reported through ec_a when nothing was sent, it then applies to the first datagram.
+	 */
+	size_t send (boost::asio::ip::udp::socket &, nano::udp_send const * send_a, size_t * sent_a, size_t count_a, boost::system::error_code & ec_a);
+}
+}
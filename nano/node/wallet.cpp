@@ -796,6 +796,7 @@ nano::public_key nano::wallet::deterministic_insert (nano::transaction const & t
 	if (store.valid_password (transaction_a))
 	{
 		key = store.deterministic_insert (transaction_a);
+		wallets.node.work_cache.wallet_insert (key);
 		if (generate_work_a)
 		{
 			work_ensure (key, key);
@@ -811,6 +812,7 @@ nano::public_key nano::wallet::deterministic_insert (uint32_t const index, bool
 	if (store.valid_password (transaction))
 	{
 		key = store.deterministic_insert (transaction, index);
+		wallets.node.work_cache.wallet_insert (key);
 		if (generate_work_a)
 		{
 			work_ensure (key, key);
@@ -832,6 +834,7 @@ nano::public_key nano::wallet::insert_adhoc (nano::transaction const & transacti
 	if (store.valid_password (transaction_a))
 	{
 		key = store.insert_adhoc (transaction_a, key_a);
+		wallets.node.work_cache.wallet_insert (key);
 		if (generate_work_a)
 		{
 			auto block_transaction (wallets.node.store.tx_begin_read ());
@@ -851,6 +854,7 @@ nano::public_key nano::wallet::insert_adhoc (nano::raw_key const & account_a, bo
 void nano::wallet::insert_watch (nano::transaction const & transaction_a, nano::public_key const & pub_a)
 {
 	store.insert_watch (transaction_a, pub_a);
+	wallets.node.work_cache.wallet_insert (pub_a);
 }
 
 bool nano::wallet::exists (nano::public_key const & account_a)
@@ -878,6 +882,7 @@ bool nano::wallet::import (std::string const & json_a, std::string const & passw
 	if (!error)
 	{
 		error = store.import (transaction, *temp);
+		wallets.node.work_cache.wallets_changed ();
 	}
 	temp->destroy (transaction);
 	return error;
@@ -958,7 +963,7 @@ std::shared_ptr<nano::block> nano::wallet::receive_action (nano::block const & s
 			BOOST_LOG (wallets.node.log) << boost::str (boost::format ("Cached or provided work for block %1% account %2% is invalid, regenerating") % block->hash ().to_string () % account.to_account ());
 			wallets.node.work_generate_blocking (*block);
 		}
-		wallets.node.process_active (block);
+		wallets.node.process_active (block, true);
 		wallets.node.block_processor.flush ();
 		if (generate_work_a)
 		{
@@ -1000,7 +1005,7 @@ std::shared_ptr<nano::block> nano::wallet::change_action (nano::account const &
 			BOOST_LOG (wallets.node.log) << boost::str (boost::format ("Cached or provided work for block %1% account %2% is invalid, regenerating") % block->hash ().to_string () % source_a.to_account ());
 			wallets.node.work_generate_blocking (*block);
 		}
-		wallets.node.process_active (block);
+		wallets.node.process_active (block, true);
 		wallets.node.block_processor.flush ();
 		if (generate_work_a)
 		{
@@ -1086,7 +1091,7 @@ std::shared_ptr<nano::block> nano::wallet::send_action (nano::account const & so
 			BOOST_LOG (wallets.node.log) << boost::str (boost::format ("Cached or provided work for block %1% account %2% is invalid, regenerating") % block->hash ().to_string () % account_a.to_account ());
 			wallets.node.work_generate_blocking (*block);
 		}
-		wallets.node.process_active (block);
+		wallets.node.process_active (block, true);
 		wallets.node.block_processor.flush ();
 		if (generate_work_a)
 		{
@@ -1170,9 +1175,8 @@ void nano::wallet::work_update (nano::transaction const & transaction_a, nano::a
 
 void nano::wallet::work_ensure (nano::account const & account_a, nano::block_hash const & hash_a)
 {
-	wallets.node.wallets.queue_wallet_action (nano::wallets::generate_priority, shared_from_this (), [account_a, hash_a](nano::wallet & wallet_a) {
-		wallet_a.work_cache_blocking (account_a, hash_a);
-	});
+	// The node's work cache generates in the background and updates this wallet's store when done
+	wallets.node.work_cache.ensure (account_a, hash_a);
 }
 
 bool nano::wallet::search_pending ()
@@ -1182,9 +1186,11 @@ bool nano::wallet::search_pending ()
 	if (!result)
 	{
 		BOOST_LOG (wallets.node.log) << "Beginning pending block search";
+		auto block_transaction (wallets.node.store.tx_begin_read ());
 		for (auto i (store.begin (transaction)), n (store.end ()); i != n; ++i)
 		{
-			auto block_transaction (wallets.node.store.tx_begin_read ());
+			// Pending iterators don't outlive an account, so the snapshot can be moved forward between them
+			block_transaction.refresh (std::chrono::milliseconds (500));
 			nano::account account (i->first);
 			// Don't search pending for watch-only accounts
 			if (!nano::wallet_value (i->second).key.is_zero ())
@@ -1255,6 +1261,8 @@ uint32_t nano::wallet::deterministic_check (nano::transaction const & transactio
 nano::public_key nano::wallet::change_seed (nano::transaction const & transaction_a, nano::raw_key const & prv_a, uint32_t count)
 {
 	store.seed_set (transaction_a, prv_a);
+	// Deterministic keys of the previous seed were removed
+	wallets.node.work_cache.wallets_changed ();
 	auto account = deterministic_insert (transaction_a);
 	if (count == 0)
 	{
@@ -1284,27 +1292,6 @@ bool nano::wallet::live ()
 	return store.handle != 0;
 }
 
-void nano::wallet::work_cache_blocking (nano::account const & account_a, nano::block_hash const & root_a)
-{
-	auto begin (std::chrono::steady_clock::now ());
-	auto work (wallets.node.work_generate_blocking (root_a));
-	if (wallets.node.config.logging.work_generation_time ())
-	{
-		/*
-		 * The difficulty parameter is the second parameter for `work_generate_blocking()`,
-		 * currently we don't supply one so we must fetch the default value.
-		 */
-		auto difficulty (nano::work_pool::publish_threshold);
-
-		BOOST_LOG (wallets.node.log) << "Work generation for " << root_a.to_string () << ", with a difficulty of " << difficulty << " complete: " << (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - begin).count ()) << " us";
-	}
-	auto transaction (wallets.tx_begin_write ());
-	if (store.exists (transaction, account_a))
-	{
-		work_update (transaction, account_a, root_a, work);
-	}
-}
-
 nano::wallets::wallets (bool & error_a, nano::node & node_a) :
 observer ([](bool) {}),
 node (node_a),
@@ -1418,6 +1405,7 @@ void nano::wallets::destroy (nano::uint256_union const & id_a)
 	auto wallet (existing->second);
 	items.erase (existing);
 	wallet->store.destroy (transaction);
+	node.work_cache.wallets_changed ();
 }
 
 void nano::wallets::reload ()
@@ -1461,6 +1449,8 @@ void nano::wallets::reload ()
 		assert (items.find (i) == items.end ());
 		items.erase (i);
 	}
+	// Other processes sharing the wallets may have changed accounts of any wallet
+	node.work_cache.wallets_changed ();
 }
 
 void nano::wallets::do_wallet_actions ()
@@ -142,7 +142,6 @@ public:
 	nano::block_hash send_sync (nano::account const &, nano::account const &, nano::uint128_t const &);
 	void send_async (nano::account const &, nano::account const &, nano::uint128_t const &, std::function<void(std::shared_ptr<nano::block>)> const &, uint64_t = 0, bool = true, boost::optional<std::string> = {});
 	void work_apply (nano::account const &, std::function<void(uint64_t)>);
-	void work_cache_blocking (nano::account const &, nano::block_hash const &);
 	void work_update (nano::transaction const &, nano::account const &, nano::block_hash const &, uint64_t);
 	void work_ensure (nano::account const &, nano::block_hash const &);
 	bool search_pending ();
@@ -0,0 +1,228 @@
+#include <nano/node/write_scheduler.hpp>
+
+#include <nano/lib/utility.hpp>
+
+#include <algorithm>
+#include <future>
+
+namespace
+{
+std::string latency_detail (nano::write_priority priority_a)
+{
+	std::string result;
+	switch (priority_a)
+	{
+		case nano::write_priority::live:
+			result = "latency_live";
+			break;
+		case nano::write_priority::bootstrap:
+			result = "latency_bootstrap";
+			break;
+		case nano::write_priority::maintenance:
+			result = "latency_maintenance";
+			break;
+	}
+	return result;
+}
+}
+
+nano::write_scheduler::write_scheduler (nano::block_store & store_a, nano::stat & stats_a, std::chrono::milliseconds batch_time_a, size_t batch_size_a) :
+store (store_a),
+stats (stats_a),
+batch_time (batch_time_a),
+batch_size (std::max<size_t> (1, batch_size_a)),
+current (nullptr),
+stopped (false),
+thread ([this]() {
+	nano::thread_role::set (nano::thread_role::name::store_writer);
+	process ();
+})
+{
+}
+
+nano::write_scheduler::~write_scheduler ()
+{
+	stop ();
+}
+
+void nano::write_scheduler::add (nano::write_priority priority_a, std::function<void(nano::transaction const &)> const & action_a, std::function<void()> const & done_a)
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	if (!stopped)
+	{
+		queues[static_cast<size_t> (priority_a)].push_back (item{ action_a, done_a, priority_a, std::chrono::steady_clock::now () });
+		condition.notify_all ();
+	}
+	else
+	{
+		// Writes still arriving during shutdown run on the caller with their own transaction
+		auto id (std::this_thread::get_id ());
+		auto existing (fallbacks.find (id));
+		if (existing != fallbacks.end ())
+		{
+			// Opening a second write transaction on this thread would deadlock, join the one already open
+			auto transaction (existing->second.transaction);
+			if (done_a)
+			{
+				existing->second.done.push_back (done_a);
+			}
+			lock.unlock ();
+			action_a (*transaction);
+		}
+		else
+		{
+			lock.unlock ();
+			std::vector<std::function<void()>> done;
+			if (done_a)
+			{
+				done.push_back (done_a);
+			}
+			{
+				auto transaction (store.tx_begin_write ());
+				lock.lock ();
+				fallbacks[id] = fallback{ &transaction, {} };
+				lock.unlock ();
+				action_a (transaction);
+				lock.lock ();
+				existing = fallbacks.find (id);
+				assert (existing != fallbacks.end ());
+				done.insert (done.end (), existing->second.done.begin (), existing->second.done.end ());
+				fallbacks.erase (existing);
+				lock.unlock ();
+			}
+			for (auto & i : done)
+			{
+				i ();
+			}
+		}
+	}
+}
+
+void nano::write_scheduler::run (nano::write_priority priority_a, std::function<void(nano::transaction const &)> const & action_a)
+{
+	nano::transaction const * transaction (nullptr);
+	if (std::this_thread::get_id () == thread.get_id ())
+	{
+		assert (current != nullptr);
+		transaction = current;
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		auto existing (fallbacks.find (std::this_thread::get_id ()));
+		if (existing != fallbacks.end ())
+		{
+			transaction = existing->second.transaction;
+		}
+	}
+	if (transaction != nullptr)
+	{
+		// Waiting for a commit that can only happen once this write returns would deadlock, the transaction is already open
+		action_a (*transaction);
+	}
+	else
+	{
+		std::promise<void> committed;
+		auto future (committed.get_future ());
+		add (priority_a, action_a, [&committed]() {
+			committed.set_value ();
+		});
+		future.wait ();
+	}
+}
+
+void nano::write_scheduler::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+size_t nano::write_scheduler::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	size_t result (0);
+	for (auto & queue : queues)
+	{
+		result += queue.size ();
+	}
+	return result;
+}
+
+bool nano::write_scheduler::next (nano::write_scheduler::item & item_a)
+{
+	auto result (true);
+	for (auto i (queues.begin ()), n (queues.end ()); i != n && result; ++i)
+	{
+		if (!i->empty ())
+		{
+			item_a = std::move (i->front ());
+			i->pop_front ();
+			result = false;
+		}
+	}
+	return result;
+}
+
+void nano::write_scheduler::process ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	auto done (false);
+	while (!done)
+	{
+		item first;
+		if (!next (first))
+		{
+			lock.unlock ();
+			std::vector<item> group;
+			std::chrono::steady_clock::time_point commit_start;
+			{
+				auto transaction (store.tx_begin_write ());
+				current = &transaction;
+				auto start (std::chrono::steady_clock::now ());
+				first.action (transaction);
+				group.push_back (std::move (first));
+				// Everything queued while the previous group committed joins this one
+				lock.lock ();
+				item item_l;
+				while (group.size () < batch_size && std::chrono::steady_clock::now () - start < batch_time && !next (item_l))
+				{
+					lock.unlock ();
+					item_l.action (transaction);
+					group.push_back (std::move (item_l));
+					lock.lock ();
+				}
+				lock.unlock ();
+				current = nullptr;
+				commit_start = std::chrono::steady_clock::now ();
+			}
+			auto now (std::chrono::steady_clock::now ());
+			stats.add_histogram (nano::stat::type::write_scheduler, "commit", std::chrono::duration_cast<std::chrono::microseconds> (now - commit_start).count ());
+			stats.add_histogram (nano::stat::type::write_scheduler, "batch_size", group.size ());
+			for (auto & i : group)
+			{
+				stats.add_histogram (nano::stat::type::write_scheduler, latency_detail (i.priority), std::chrono::duration_cast<std::chrono::microseconds> (now - i.queued).count ());
+				if (i.done)
+				{
+					i.done ();
+				}
+			}
+			lock.lock ();
+		}
+		else if (!stopped)
+		{
+			condition.wait (lock);
+		}
+		else
+		{
+			// Queues are drained before exiting so nobody waiting on run is left hanging
+			done = true;
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <nano/node/stats.hpp>
+#include <nano/secure/blockstore.hpp>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace nano
+{
+/** Order in which queued writes are taken in to a group commit */
+enum class write_priority : uint8_t
+{
+	live,
+	bootstrap,
+	maintenance
+};
+/**
+ * Runs writes to the block store from any component on a single thread, grouping whatever is queued in to one
+ * transaction so writers share a commit rather than each waiting on the LMDB writer lock and paying for its own sync.
+ * A group takes writes in priority order until it has run for the batch time or holds the batch size, then commits.
+ */
+class write_scheduler
+{
+public:
+	write_scheduler (nano::block_store &, nano::stat &, std::chrono::milliseconds, size_t);
+	~write_scheduler ();
+	/** Queues a write, done is called on the writer thread once the group it ran in has committed */
+	void add (nano::write_priority, std::function<void(nano::transaction const &)> const &, std::function<void()> const & = nullptr);
+	/** Runs a write in a group commit and waits until it's committed. Writes nested inside another write run in its transaction */
+	void run (nano::write_priority, std::function<void(nano::transaction const &)> const &);
+	void stop ();
+	size_t size ();
+
+private:
+	class item
+	{
+	public:
+		std::function<void(nano::transaction const &)> action;
+		std::function<void()> done;
+		nano::write_priority priority;
+		std::chrono::steady_clock::time_point queued;
+	};
+	/** Write run on its caller after stopping, along with the done callbacks of writes nested inside it */
+	class fallback
+	{
+	public:
+		nano::transaction const * transaction;
+		std::vector<std::function<void()>> done;
+	};
+	void process ();
+	bool next (item &);
+	nano::block_store & store;
+	nano::stat & stats;
+	std::chrono::milliseconds const batch_time;
+	size_t const batch_size;
+	std::array<std::deque<item>, 3> queues;
+	/** Transaction of the group being run, only used on the writer thread */
+	nano::transaction const * current;
+	/** Transactions of writes run on their callers after stopping, by thread so writes nested inside them can reuse them */
+	std::unordered_map<std::thread::id, fallback> fallbacks;
+	bool stopped;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::thread thread;
+};
+}
@@ -6,6 +6,11 @@
 
 #include <boost/endian/conversion.hpp>
 
+void nano::transaction::refresh (std::chrono::milliseconds max_age_a) const
+{
+	impl->refresh (max_age_a);
+}
+
 nano::block_sideband::block_sideband (nano::block_type type_a, nano::account const & account_a, nano::block_hash const & successor_a, nano::amount const & balance_a, uint64_t height_a, uint64_t timestamp_a) :
 type (type_a),
 successor (successor_a),
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <nano/secure/common.hpp>
+#include <chrono>
 #include <stack>
 
 namespace nano
@@ -189,6 +190,7 @@ class transaction_impl
 {
 public:
 	virtual ~transaction_impl () = default;
+	virtual void refresh (std::chrono::milliseconds) = 0;
 };
 /**
  * RAII wrapper of MDB_txn where the constructor starts the transaction
@@ -197,8 +199,21 @@ public:
 class transaction
 {
 public:
+	/**
+	 * Moves a read transaction on to the latest snapshot once it is older than max_age, cheap enough to call every loop iteration.
+	 * Iterators opened on the transaction must not be used afterwards.
+	 */
+	void refresh (std::chrono::milliseconds max_age = std::chrono::milliseconds (0)) const;
 	std::unique_ptr<nano::transaction_impl> impl;
 };
+/** Read transactions started from scratch versus renewed from the reuse pool */
+class transaction_counts
+{
+public:
+	uint64_t begin{ 0 };
+	uint64_t renew{ 0 };
+	uint64_t refresh{ 0 };
+};
 
 /**
  * Manages block storage and iteration
@@ -212,6 +227,8 @@ public:
 	virtual nano::block_hash block_successor (nano::transaction const &, nano::block_hash const &) = 0;
 	virtual void block_successor_clear (nano::transaction const &, nano::block_hash const &) = 0;
 	virtual std::shared_ptr<nano::block> block_get (nano::transaction const &, nano::block_hash const &, nano::block_sideband * = nullptr) = 0;
+	/** Appends the block's network serialization copied from the stored bytes and sets its previous hash, returns true if it doesn't exist */
+	virtual bool block_serialize (nano::transaction const &, nano::block_hash const &, std::vector<uint8_t> &, nano::block_hash &) = 0;
 	virtual std::shared_ptr<nano::block> block_random (nano::transaction const &) = 0;
 	virtual void block_del (nano::transaction const &, nano::block_hash const &) = 0;
 	virtual bool block_exists (nano::transaction const &, nano::block_hash const &) = 0;
@@ -307,5 +324,14 @@ public:
 	 * @param write If true, start a read-write transaction
 	 */
 	virtual nano::transaction tx_begin (bool write = false) = 0;
+
+	/** Counts of read transactions begun, renewed and refreshed */
+	virtual nano::transaction_counts tx_counts () = 0;
+
+	/** Block cache activity since the counters were last taken */
+	virtual nano::uniquer_counters block_cache_counters () = 0;
+
+	/** Account cache activity since the counters were last taken */
+	virtual nano::uniquer_counters account_cache_counters () = 0;
 };
 }
@@ -654,8 +654,9 @@ boost::transform_iterator<nano::iterate_vote_blocks_as_hash, nano::vote_blocks_v
 	return boost::transform_iterator<nano::iterate_vote_blocks_as_hash, nano::vote_blocks_vec_iter> (blocks.end (), nano::iterate_vote_blocks_as_hash ());
 }
 
-nano::vote_uniquer::vote_uniquer (nano::block_uniquer & uniquer_a) :
-uniquer (uniquer_a)
+nano::vote_uniquer::vote_uniquer (nano::block_uniquer & uniquer_a, size_t max_entries_a) :
+uniquer (uniquer_a),
+votes (max_entries_a)
 {
 }
 
@@ -668,47 +669,59 @@ std::shared_ptr<nano::vote> nano::vote_uniquer::unique (std::shared_ptr<nano::vo
 		{
 			result->blocks[0] = uniquer.unique (boost::get<std::shared_ptr<nano::block>> (result->blocks[0]));
 		}
-		nano::uint256_union key (vote_a->full_hash ());
-		std::lock_guard<std::mutex> lock (mutex);
-		auto & existing (votes[key]);
-		if (auto block_l = existing.lock ())
-		{
-			result = block_l;
-		}
-		else
-		{
-			existing = vote_a;
-		}
-		for (auto i (0); i < cleanup_count && votes.size () > 0; ++i)
-		{
-			auto random_offset (nano::random_pool.GenerateWord32 (0, votes.size () - 1));
-			auto existing (std::next (votes.begin (), random_offset));
-			if (existing == votes.end ())
-			{
-				existing = votes.begin ();
-			}
-			if (existing != votes.end ())
-			{
-				if (auto block_l = existing->second.lock ())
-				{
-					// Still live
-				}
-				else
-				{
-					votes.erase (existing);
-				}
-			}
-		}
+		result = votes.unique (vote_a);
 	}
 	return result;
 }
 
 size_t nano::vote_uniquer::size ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
 	return votes.size ();
 }
 
+nano::uniquer_counters nano::vote_uniquer::take_counters ()
+{
+	return votes.take_counters ();
+}
+
+void nano::rep_weights::representation_put (nano::account const & account_a, nano::uint128_t const & representation_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	put (account_a, representation_a);
+}
+
+nano::uint128_t nano::rep_weights::representation_get (nano::account const & account_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto existing (weights.find (account_a));
+	return existing != weights.end () ? existing->second : 0;
+}
+
+void nano::rep_weights::clear ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	weights.clear ();
+}
+
+size_t nano::rep_weights::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return weights.size ();
+}
+
+void nano::rep_weights::put (nano::account const & account_a, nano::uint128_t const & representation_a)
+{
+	// Only non-zero weights are kept, the table stays as small as the set of active representatives
+	if (representation_a == 0)
+	{
+		weights.erase (account_a);
+	}
+	else
+	{
+		weights[account_a] = representation_a;
+	}
+}
+
 nano::genesis::genesis ()
 {
 	boost::property_tree::ptree tree;
@@ -192,15 +192,30 @@ public:
 class vote_uniquer
 {
 public:
-	vote_uniquer (nano::block_uniquer &);
+	vote_uniquer (nano::block_uniquer &, size_t = nano::uniquer<nano::vote>::default_max_entries);
 	std::shared_ptr<nano::vote> unique (std::shared_ptr<nano::vote>);
 	size_t size ();
+	nano::uniquer_counters take_counters ();
 
 private:
 	nano::block_uniquer & uniquer;
+	nano::uniquer<nano::vote> votes;
+};
+/**
+ * In-memory copy of the representation table so vote weight lookups don't touch the store
+ */
+class rep_weights
+{
+public:
+	void representation_put (nano::account const &, nano::uint128_t const &);
+	nano::uint128_t representation_get (nano::account const &);
+	void clear ();
+	size_t size ();
+
+private:
+	void put (nano::account const &, nano::uint128_t const &);
 	std::mutex mutex;
-	std::unordered_map<nano::uint256_union, std::weak_ptr<nano::vote>> votes;
-	static unsigned constexpr cleanup_count = 2;
+	std::unordered_map<nano::account, nano::uint128_t> weights;
 };
 enum class vote_code
 {
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <nano/node/testing.hpp>
 
+#include <numeric>
 #include <thread>
 
 TEST (system, generate_mass_activity)
@@ -425,3 +426,177 @@ TEST (node, mass_vote_by_hash)
 		system.nodes[0]->block_processor.add (*i, std::chrono::steady_clock::now ());
 	}
 }
+
+TEST (election, tally_1000_reps)
+{
+	nano::system system (24000, 1);
+	auto & node (*system.nodes[0]);
+	nano::genesis genesis;
+	nano::keypair key1;
+	nano::keypair key2;
+	auto send1 (std::make_shared<nano::send_block> (genesis.hash (), key1.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0));
+	auto send2 (std::make_shared<nano::send_block> (genesis.hash (), key2.pub, nano::genesis_amount - nano::Gxrb_ratio, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0));
+	std::vector<nano::account> reps;
+	{
+		auto transaction (node.store.tx_begin (true));
+		ASSERT_EQ (nano::process_result::progress, node.ledger.process (transaction, *send1).code);
+		for (auto i (0); i < 1000; ++i)
+		{
+			nano::keypair rep;
+			node.store.representation_put (transaction, rep.pub, nano::Gxrb_ratio);
+			reps.push_back (rep.pub);
+		}
+	}
+	node.active.start (send1);
+	std::lock_guard<std::mutex> lock (node.active.mutex);
+	auto election (node.active.roots.find (nano::uint512_union (send1->previous (), send1->root ()))->election);
+	ASSERT_FALSE (election->publish (send2));
+	auto rounds (100);
+	size_t count (0);
+	auto begin (std::chrono::steady_clock::now ());
+	for (auto round (0); round < rounds; ++round)
+	{
+		for (auto & last_vote : election->last_votes)
+		{
+			last_vote.second.time = std::chrono::steady_clock::now () - std::chrono::seconds (20);
+		}
+		for (size_t i (0); i < reps.size (); ++i)
+		{
+			election->vote (reps[i], round + 1, ((i + round) % 2) ? send1->hash () : send2->hash ());
+			++count;
+		}
+	}
+	auto elapsed (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - begin));
+	std::cerr << boost::str (boost::format ("%1% votes on %2% representatives in %3%us, %4% votes/s\n") % count % reps.size () % elapsed.count () % (count * 1000000 / std::max<uint64_t> (1, elapsed.count ())));
+	// Every representative has the same weight and they split evenly between the two blocks
+	ASSERT_EQ (reps.size () / 2 * nano::Gxrb_ratio, election->last_tally[send1->hash ()]);
+	ASSERT_EQ (reps.size () / 2 * nano::Gxrb_ratio, election->last_tally[send2->hash ()]);
+}
+
+TEST (store, block_table_migration)
+{
+	auto path (nano::unique_path ());
+	nano::genesis genesis;
+	std::vector<nano::block_hash> hashes;
+	auto lookups ([&hashes](nano::mdb_store & store_a) {
+		auto transaction (store_a.tx_begin_read ());
+		auto begin (std::chrono::steady_clock::now ());
+		size_t found (0);
+		for (auto & hash : hashes)
+		{
+			// Every existing block is followed by a lookup which misses
+			found += store_a.block_exists (transaction, hash);
+			found += store_a.block_exists (transaction, hash.number () + 1);
+		}
+		auto elapsed (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - begin));
+		EXPECT_EQ (hashes.size (), found);
+		return elapsed.count ();
+	});
+	{
+		nano::logging logging;
+		auto error (false);
+		nano::mdb_store store (error, logging, path);
+		ASSERT_FALSE (error);
+		{
+			auto transaction (store.tx_begin_write ());
+			store.version_put (transaction, 13);
+			nano::store_downgrade::block_tables_split (store, transaction);
+			store.initialize (transaction, genesis);
+			auto previous (genesis.hash ());
+			auto balance (nano::genesis_amount);
+			for (auto i (0); i < 100000; ++i)
+			{
+				balance -= 1;
+				nano::state_block block (nano::test_genesis_key.pub, previous, nano::test_genesis_key.pub, balance, 0, nano::test_genesis_key.prv, nano::test_genesis_key.pub, 0);
+				nano::block_sideband sideband (nano::block_type::state, nano::test_genesis_key.pub, 0, balance, i + 1, nano::seconds_since_epoch ());
+				previous = block.hash ();
+				store.block_put (transaction, previous, block, sideband);
+				hashes.push_back (previous);
+			}
+		}
+		std::cerr << boost::str (boost::format ("Per-type tables: %1%us for %2% lookups\n") % lookups (store) % (hashes.size () * 2));
+	}
+	nano::logging logging;
+	auto error (false);
+	auto begin (std::chrono::steady_clock::now ());
+	nano::mdb_store store (error, logging, path);
+	auto elapsed (std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - begin));
+	ASSERT_FALSE (error);
+	std::cerr << boost::str (boost::format ("Merged %1% blocks in %2%ms\n") % (hashes.size () + 1) % elapsed.count ());
+	std::cerr << boost::str (boost::format ("Single table: %1%us for %2% lookups\n") % lookups (store) % (hashes.size () * 2));
+	auto transaction (store.tx_begin_read ());
+	ASSERT_EQ (hashes.size () + 1, store.block_count (transaction).sum ());
+}
+
+TEST (udp_buffer, throughput)
+{
+	// Two producers stand in for the io threads receiving datagrams, consumers checksum each datagram as a small amount of work
+	auto run ([](auto & buffer_a, nano::stat & stats_a, auto dequeue_a, size_t threads_a, std::string const & name_a) {
+		auto const datagrams (1000000);
+		std::atomic<uint64_t> serviced (0);
+		std::atomic<uint64_t> checksum (0);
+		std::vector<std::thread> consumers;
+		for (size_t i (0); i < threads_a; ++i)
+		{
+			consumers.push_back (std::thread ([&buffer_a, &dequeue_a, &serviced, &checksum, i]() {
+				uint64_t sum (0);
+				nano::udp_data * data;
+				while ((data = dequeue_a (i)) != nullptr)
+				{
+					sum = std::accumulate (data->buffer, data->buffer + data->size, sum);
+					++serviced;
+					buffer_a.release (data);
+				}
+				checksum += sum;
+			}));
+		}
+		auto begin (std::chrono::steady_clock::now ());
+		std::vector<std::thread> producers;
+		for (auto i (0); i < 2; ++i)
+		{
+			producers.push_back (std::thread ([&buffer_a, datagrams, i]() {
+				for (auto j (0); j < datagrams / 2; ++j)
+				{
+					auto data (buffer_a.allocate ());
+					data->size = 256;
+					std::fill (data->buffer, data->buffer + data->size, uint8_t (j));
+					data->endpoint = nano::endpoint (boost::asio::ip::address_v6::loopback (), 24000 + (i * datagrams + j) % 1024);
+					buffer_a.enqueue (data);
+				}
+			}));
+		}
+		for (auto & producer : producers)
+		{
+			producer.join ();
+		}
+		while (serviced + stats_a.count (nano::stat::type::udp, nano::stat::detail::overflow) < datagrams)
+		{
+			std::this_thread::yield ();
+		}
+		auto elapsed (std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - begin));
+		buffer_a.stop ();
+		for (auto & consumer : consumers)
+		{
+			consumer.join ();
+		}
+		std::cerr << boost::str (boost::format ("%1% with %2% network_threads: %3% serviced, %4% overflowed in %5%us, %6% datagrams/s\n") % name_a % threads_a % serviced % stats_a.count (nano::stat::type::udp, nano::stat::detail::overflow) % elapsed.count () % (serviced * 1000000 / std::max<uint64_t> (1, elapsed.count ())));
+	});
+	for (size_t threads : { 1, 4, 16 })
+	{
+		{
+			nano::stat stats;
+			nano::udp_buffer buffer (stats, 512, 4096);
+			run (buffer, stats, [&buffer](size_t) { return buffer.dequeue (); }, threads, "mutex");
+		}
+		{
+			nano::stat stats;
+			nano::udp_ring_buffer buffer (stats, 512, 4096);
+			run (buffer, stats, [&buffer](size_t) { return buffer.dequeue (); }, threads, "ring");
+		}
+		{
+			nano::stat stats;
+			nano::udp_ring_buffer buffer (stats, 512, 4096, threads);
+			run (buffer, stats, [&buffer](size_t shard_a) { return buffer.dequeue (shard_a); }, threads, "ring sharded");
+		}
+	}
+}